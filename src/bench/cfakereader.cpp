@@ -0,0 +1,232 @@
+//********************************************************************
+//    created:    2026-10-18 10:45 AM
+//    file:       cfakereader.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cfakereader.h"
+
+#include <memory>
+
+#include <QDateTime>
+#include <QHostAddress>
+#include <QTimer>
+
+namespace LLRPLaps
+{
+    const quint16 CFakeReader::LLRP_PORT = 5084;
+
+    namespace
+    {
+        // LLRP message header: Rsvd/Ver/Type (2), Length (4), MessageID (4)
+        const unsigned int LLRP_HEADER_SIZE = 10u;
+
+        unsigned int readU32(const unsigned char *p)
+        {
+            return (static_cast<unsigned int>(p[0]) << 24) | (static_cast<unsigned int>(p[1]) << 16) |
+                   (static_cast<unsigned int>(p[2]) << 8) | static_cast<unsigned int>(p[3]);
+        }
+    }
+
+    CFakeReader::CFakeReader(const Load &load, QObject *parent) : QObject(parent), _socket(nullptr), _typeRegistry(LLRP::getTheTypeRegistry()),
+                                                                  _load(load), _reportsSent(0)
+    {
+        _synthetic.setRiderCount(static_cast<std::uint32_t>(load.riderCount));
+        connect(&_server, &QTcpServer::newConnection, this, &CFakeReader::onNewConnection);
+    }
+
+
+    CFakeReader::~CFakeReader()
+    {
+        delete _typeRegistry;
+    }
+
+
+    bool CFakeReader::listen(quint16 port)
+    {
+        return _server.listen(QHostAddress::LocalHost, port);
+    }
+
+
+    void CFakeReader::onNewConnection()
+    {
+        QTcpSocket *socket = _server.nextPendingConnection();
+
+        if (nullptr != _socket)
+        {
+            // Like a real reader, one LLRP client at a time
+            socket->close();
+            socket->deleteLater();
+            return;
+        }
+
+        _socket = socket;
+        _socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(_socket, &QTcpSocket::readyRead, this, &CFakeReader::onReadyRead);
+        connect(_socket, &QTcpSocket::disconnected, this, [this]()
+        {
+            _socket->deleteLater();
+            _socket = nullptr;
+            _inbound.clear();
+        });
+
+        sendConnectionAttemptEvent();
+    }
+
+
+    void CFakeReader::onReadyRead()
+    {
+        _inbound.append(_socket->readAll());
+
+        while (static_cast<unsigned int>(_inbound.size()) >= LLRP_HEADER_SIZE)
+        {
+            auto *bytes = reinterpret_cast<const unsigned char *>(_inbound.constData());
+            unsigned int length = readU32(bytes + 2);
+
+            if (length < LLRP_HEADER_SIZE)
+            {
+                // Garbage, a real reader would drop the connection
+                _socket->abort();
+                return;
+            }
+            if (static_cast<unsigned int>(_inbound.size()) < length)
+            {
+                break;
+            }
+
+            handleFrame(bytes, length);
+            _inbound.remove(0, static_cast<int>(length));
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Answer one command from the client
+ **
+ ** Every command succeeds. START_ROSPEC also schedules the
+ ** report the ROSpec would produce.
+ **
+ *****************************************************************************/
+
+    void CFakeReader::handleFrame(const unsigned char *frame, unsigned int length)
+    {
+        LLRP::CFrameDecoder decoder(_typeRegistry, const_cast<unsigned char *>(frame), length);
+        std::unique_ptr<LLRP::CMessage> message(decoder.decodeMessage());
+
+        if (nullptr == message.get())
+        {
+            return;
+        }
+
+        const LLRP::CTypeDescriptor *pType = message->m_pType;
+        LLRP::llrp_u32_t messageId = message->getMessageID();
+
+        if (&LLRP::CSET_READER_CONFIG::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CSET_READER_CONFIG_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CDELETE_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CDELETE_ROSPEC_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CADD_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CADD_ROSPEC_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CENABLE_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CENABLE_ROSPEC_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CDISABLE_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CDISABLE_ROSPEC_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CSTOP_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CSTOP_ROSPEC_RESPONSE>(messageId);
+        }
+        else if (&LLRP::CSTART_ROSPEC::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CSTART_ROSPEC_RESPONSE>(messageId);
+            QTimer::singleShot(_load.reportDelayMS, this, &CFakeReader::onSendReport);
+        }
+        else if (&LLRP::CCLOSE_CONNECTION::s_typeDescriptor == pType)
+        {
+            respond<LLRP::CCLOSE_CONNECTION_RESPONSE>(messageId);
+            _socket->disconnectFromHost();
+        }
+    }
+
+
+    template <class TResponse>
+    void CFakeReader::respond(LLRP::llrp_u32_t messageId)
+    {
+        TResponse response;
+        response.setMessageID(messageId);
+
+        auto *status = new LLRP::CLLRPStatus();
+        status->setStatusCode(LLRP::StatusCode_M_Success);
+        response.setLLRPStatus(status);
+
+        sendMessage(&response);
+    }
+
+
+    void CFakeReader::sendConnectionAttemptEvent()
+    {
+        auto *timestamp = new LLRP::CUTCTimestamp();
+        timestamp->setMicroseconds(static_cast<LLRP::llrp_u64_t>(QDateTime::currentMSecsSinceEpoch()) * 1000u);
+
+        auto *connectionAttemptEvent = new LLRP::CConnectionAttemptEvent();
+        connectionAttemptEvent->setStatus(LLRP::ConnectionAttemptStatusType_Success);
+
+        auto *readerEventNotificationData = new LLRP::CReaderEventNotificationData();
+        readerEventNotificationData->setTimestamp(timestamp);
+        readerEventNotificationData->setConnectionAttemptEvent(connectionAttemptEvent);
+
+        LLRP::CREADER_EVENT_NOTIFICATION notification;
+        notification.setMessageID(0);
+        notification.setReaderEventNotificationData(readerEventNotificationData);
+
+        sendMessage(&notification);
+    }
+
+
+    void CFakeReader::onSendReport()
+    {
+        if (nullptr == _socket)
+        {
+            return;
+        }
+
+        std::vector<unsigned char> frame = _synthetic.makeFrame(_load.tagsPerReport, _load.format);
+        _socket->write(reinterpret_cast<const char *>(frame.data()), static_cast<qint64>(frame.size()));
+        _reportsSent++;
+    }
+
+
+    void CFakeReader::sendMessage(LLRP::CMessage *message)
+    {
+        if (nullptr == _socket)
+        {
+            return;
+        }
+
+        std::vector<unsigned char> frame = _synthetic.encodeFrame(message);
+        _socket->write(reinterpret_cast<const char *>(frame.data()), static_cast<qint64>(frame.size()));
+    }
+}
@@ -0,0 +1,93 @@
+//********************************************************************
+//    created:    2026-10-18 10:45 AM
+//    file:       cfakereader.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CFAKEREADER_H
+#define LLRPLAPS_CFAKEREADER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <ltkcpp.h>
+#include "csyntheticreport.h"
+
+namespace LLRPLaps
+{
+    /*
+     * A local stand in for an LLRP reader. It accepts one client,
+     * announces a successful connection, answers every command
+     * CReader sends with M_Success and sends a synthetic
+     * RO_ACCESS_REPORT some time after each START_ROSPEC.
+     *
+     * Runs on the Qt event loop of the thread it lives in.
+     */
+    class CFakeReader : public QObject
+    {
+    Q_OBJECT
+    public:
+        struct Load
+        {
+            int tagsPerReport;
+            int riderCount;
+            int reportDelayMS;          // START_ROSPEC to report, stands in for the AISpec duration
+            CSyntheticReport::EpcFormat format;
+        };
+
+        explicit CFakeReader(const Load &load, QObject *parent = nullptr);
+
+        ~CFakeReader() override;
+
+        bool listen(quint16 port);
+
+        quint64 getReportsSent() const { return _reportsSent; }
+
+        const static quint16 LLRP_PORT;
+
+    private slots:
+
+        void onNewConnection();
+
+        void onReadyRead();
+
+        void onSendReport();
+
+    private:
+        void handleFrame(const unsigned char *frame, unsigned int length);
+
+        void sendMessage(LLRP::CMessage *message);
+
+        void sendConnectionAttemptEvent();
+
+        template <class TResponse>
+        void respond(LLRP::llrp_u32_t messageId);
+
+        QTcpServer _server;
+        QTcpSocket *_socket;
+        QByteArray _inbound;
+        LLRP::CTypeRegistry *_typeRegistry;
+        CSyntheticReport _synthetic;
+        Load _load;
+        quint64 _reportsSent;
+    };
+}
+#endif //LLRPLAPS_CFAKEREADER_H
@@ -0,0 +1,141 @@
+//********************************************************************
+//    created:    2026-10-18 09:12 AM
+//    file:       csyntheticreport.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "csyntheticreport.h"
+#include "exceptions.h"
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        // A 500 tag report with EPCData is roughly 20 KB, leave plenty of room
+        const unsigned int MAX_FRAME_SIZE = 256u * 1024u;
+
+        // Riders' chips share a company prefix, only the serial varies
+        const unsigned char EPC_PREFIX[] = { 0x30, 0x08, 0x33, 0xb2, 0xdd, 0xd9, 0x01, 0x40 };
+    }
+
+    CSyntheticReport::CSyntheticReport(std::uint32_t seed) : _state(seed ? seed : 1u), _timeStampUSec(1500000000000000ULL), _messageId(1),
+                                                           _riderCount(1000)
+    {
+    }
+
+
+    std::uint32_t CSyntheticReport::nextRandom()
+    {
+        // xorshift32, good enough to spread EPC serials and antennas
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+
+    LLRP::CTagReportData *CSyntheticReport::makeTagReportData(EpcFormat format)
+    {
+        std::uint32_t serial = nextRandom() % _riderCount;
+        unsigned char epc[12];
+
+        for (unsigned int i = 0; i < sizeof EPC_PREFIX; i++)
+        {
+            epc[i] = EPC_PREFIX[i];
+        }
+        epc[8] = 0;
+        epc[9] = 0;
+        epc[10] = static_cast<unsigned char>(serial >> 8);
+        epc[11] = static_cast<unsigned char>(serial);
+
+        auto *tagReportData = new LLRP::CTagReportData();
+
+        if (Epc96 == format)
+        {
+            LLRP::llrp_u96_t epc96;
+            for (int i = 0; i < 12; i++)
+            {
+                epc96.m_aValue[i] = epc[i];
+            }
+            auto *pEPC_96 = new LLRP::CEPC_96();
+            pEPC_96->setEPC(epc96);
+            tagReportData->setEPCParameter(pEPC_96);
+        }
+        else
+        {
+            LLRP::llrp_u1v_t epcBits(96);
+            for (int i = 0; i < 12; i++)
+            {
+                epcBits.m_pValue[i] = epc[i];
+            }
+            auto *pEPCData = new LLRP::CEPCData();
+            pEPCData->setEPC(epcBits);
+            tagReportData->setEPCParameter(pEPCData);
+        }
+
+        auto *antennaId = new LLRP::CAntennaID();
+        antennaId->setAntennaID(static_cast<LLRP::llrp_u16_t>(1u + nextRandom() % 4u));
+        tagReportData->setAntennaID(antennaId);
+
+        _timeStampUSec += 250u + nextRandom() % 1000u;
+        auto *firstSeen = new LLRP::CFirstSeenTimestampUTC();
+        firstSeen->setMicroseconds(_timeStampUSec);
+        tagReportData->setFirstSeenTimestampUTC(firstSeen);
+
+        return tagReportData;
+    }
+
+
+    std::shared_ptr<LLRP::CRO_ACCESS_REPORT> CSyntheticReport::makeReport(int tagCount, EpcFormat format)
+    {
+        std::shared_ptr<LLRP::CRO_ACCESS_REPORT> report(new LLRP::CRO_ACCESS_REPORT());
+        report->setMessageID(_messageId++);
+
+        for (int i = 0; i < tagCount; i++)
+        {
+            report->addTagReportData(makeTagReportData(format));
+        }
+        return report;
+    }
+
+
+    std::vector<unsigned char> CSyntheticReport::encodeFrame(LLRP::CMessage *message)
+    {
+        std::vector<unsigned char> frame(MAX_FRAME_SIZE);
+        LLRP::CFrameEncoder encoder(frame.data(), static_cast<unsigned int>(frame.size()));
+
+        encoder.encodeElement(message);
+        if (LLRP::RC_OK != encoder.m_ErrorDetails.m_eResultCode)
+        {
+            throw ReaderErrorDetailsException(ReaderErrorDetailsException::CErrorDetailsToString(
+                    &encoder.m_ErrorDetails, message->m_pType->m_pName, "encodeFrame"));
+        }
+        frame.resize(encoder.getLength());
+        return frame;
+    }
+
+
+    std::vector<unsigned char> CSyntheticReport::makeFrame(int tagCount, EpcFormat format)
+    {
+        std::shared_ptr<LLRP::CRO_ACCESS_REPORT> report = makeReport(tagCount, format);
+        return encodeFrame(report.get());
+    }
+
+
+    const char *CSyntheticReport::formatName(EpcFormat format)
+    {
+        return Epc96 == format ? "EPC_96" : "EPCData";
+    }
+}
@@ -0,0 +1,71 @@
+//********************************************************************
+//    created:    2026-10-18 09:12 AM
+//    file:       csyntheticreport.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CSYNTHETICREPORT_H
+#define LLRPLAPS_CSYNTHETICREPORT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <ltkcpp.h>
+
+namespace LLRPLaps
+{
+    /*
+     * Builds RO_ACCESS_REPORT messages and their encoded LLRP frames
+     * that look like what a reader sends us with the ROSpec from
+     * CReader::addROSpec (EPC, AntennaID and FirstSeenTimestampUTC).
+     * Tag EPCs and timestamps are deterministic for a given seed so
+     * runs can be compared.
+     */
+    class CSyntheticReport
+    {
+    public:
+        enum EpcFormat
+        {
+            Epc96,          // CEPC_96 (TV encoded, fixed 96 bits)
+            EpcData         // CEPCData (TLV encoded, variable length)
+        };
+
+        explicit CSyntheticReport(std::uint32_t seed = 1);
+
+        std::shared_ptr<LLRP::CRO_ACCESS_REPORT> makeReport(int tagCount, EpcFormat format);
+
+        std::vector<unsigned char> encodeFrame(LLRP::CMessage *message);
+
+        std::vector<unsigned char> makeFrame(int tagCount, EpcFormat format);
+
+        // Number of distinct chips the EPC serials are drawn from
+        void setRiderCount(std::uint32_t riderCount) { _riderCount = riderCount ? riderCount : 1u; }
+
+        static const char *formatName(EpcFormat format);
+
+    private:
+        LLRP::CTagReportData *makeTagReportData(EpcFormat format);
+
+        std::uint32_t nextRandom();
+
+        std::uint32_t _state;
+        std::uint64_t _timeStampUSec;
+        std::uint32_t _messageId;
+        std::uint32_t _riderCount;
+    };
+}
+#endif //LLRPLAPS_CSYNTHETICREPORT_H
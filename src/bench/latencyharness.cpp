@@ -0,0 +1,172 @@
+//********************************************************************
+//    created:    2026-10-18 11:10 AM
+//    file:       latencyharness.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * End to end latency from the LLRP frame being read off the socket
+ * to a lap being published, against a CFakeReader on localhost.
+ *
+ *   main thread      CFakeReader event loop, publish sink (queued,
+ *                    like the GUI receiving laps)
+ *   reader thread    CReader -> CLapCounter (direct)
+ *
+ * Example:
+ *      laps_latency --reports 2000 --tags 200 --riders 40 --epc-format data
+ */
+
+#include <cstdio>
+#include <exception>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QThread>
+
+#include "cfakereader.h"
+#include "clapcounter.h"
+#include "clatencyrecorder.h"
+#include "creader.h"
+
+namespace LLRPLaps
+{
+    class CPublishSink : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CPublishSink(CLatencyRecorder *recorder) : laps(0), _recorder(recorder)
+        {
+        }
+
+        quint64 laps;
+
+    public slots:
+        void onNewLap(const LLRPLaps::CLapInfo &lapInfo)
+        {
+            _recorder->record(CLatencyRecorder::Publish, lapInfo.hostReceivedNSec);
+            laps++;
+        }
+
+    private:
+        CLatencyRecorder *_recorder;
+    };
+
+
+    class CReaderDriver : public QThread
+    {
+    Q_OBJECT
+    public:
+        CReaderDriver(int reports, u_int64_t minLapUSec, const QString &captureFile, CLatencyRecorder *recorder, CPublishSink *sink)
+                : failed(false), _reports(reports), _minLapUSec(minLapUSec), _captureFile(captureFile), _recorder(recorder), _sink(sink)
+        {
+        }
+
+        bool failed;
+
+    protected:
+        void run() override
+        {
+            try
+            {
+                CReader reader("127.0.0.1");
+                CLapCounter lapCounter(_minLapUSec);
+
+                reader.setLatencyRecorder(_recorder);
+                reader.setCaptureFile(_captureFile);
+                lapCounter.setLatencyRecorder(_recorder);
+                connect(&reader, &CReader::newTag, &lapCounter, &CLapCounter::onNewTag, Qt::DirectConnection);
+                connect(&lapCounter, &CLapCounter::newLap, _sink, &CPublishSink::onNewLap, Qt::QueuedConnection);
+
+                reader.Connect();
+
+                // Connect() made a few frames, only the reports are of interest
+                _recorder->clear();
+
+                for (int i = 0; i < _reports; i++)
+                {
+                    reader.ProcessRecentChipsSeen().raiseOnError();
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::fprintf(stderr, "%s\n", e.what());
+                failed = true;
+            }
+        }
+
+    private:
+        int _reports;
+        u_int64_t _minLapUSec;
+        QString _captureFile;
+        CLatencyRecorder *_recorder;
+        CPublishSink *_sink;
+    };
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("LLRP frame to lap latency harness");
+    parser.addHelpOption();
+    parser.addOption({"reports", "Number of RO_ACCESS_REPORTs to process.", "n", "1000"});
+    parser.addOption({"tags", "Tags per report.", "n", "100"});
+    parser.addOption({"riders", "Distinct chips in the reports.", "n", "40"});
+    parser.addOption({"epc-format", "EPC encoding, 96 (EPC_96) or data (EPCData).", "format", "96"});
+    parser.addOption({"report-delay-ms", "Delay from START_ROSPEC to the report.", "ms", "1"});
+    parser.addOption({"min-lap-ms", "Minimum lap time in the tag timebase.", "ms", "100"});
+    parser.addOption({"capture", "Record the LLRP traffic to a capture file.", "file"});
+    parser.process(app);
+
+    qRegisterMetaType<LLRPLaps::CTagInfo>("LLRPLaps::CTagInfo");
+    qRegisterMetaType<LLRPLaps::CLapInfo>("LLRPLaps::CLapInfo");
+
+    LLRPLaps::CFakeReader::Load load;
+    load.tagsPerReport = parser.value("tags").toInt();
+    load.riderCount = parser.value("riders").toInt();
+    load.reportDelayMS = parser.value("report-delay-ms").toInt();
+    load.format = ("data" == parser.value("epc-format")) ? LLRPLaps::CSyntheticReport::EpcData : LLRPLaps::CSyntheticReport::Epc96;
+
+    LLRPLaps::CFakeReader fakeReader(load);
+    if (!fakeReader.listen(LLRPLaps::CFakeReader::LLRP_PORT))
+    {
+        std::fprintf(stderr, "Cannot listen on port %u\n", LLRPLaps::CFakeReader::LLRP_PORT);
+        return 1;
+    }
+
+    LLRPLaps::CLatencyRecorder recorder;
+    LLRPLaps::CPublishSink sink(&recorder);
+    LLRPLaps::CReaderDriver driver(parser.value("reports").toInt(), parser.value("min-lap-ms").toULongLong() * 1000u,
+                                   parser.value("capture"), &recorder, &sink);
+
+    QObject::connect(&driver, &QThread::finished, &app, &QCoreApplication::quit);
+    driver.start();
+    app.exec();
+    driver.wait();
+
+    // Laps still queued for the sink when the driver stopped
+    QCoreApplication::processEvents();
+
+    std::printf("%d tags/report, %d riders, %s, %llu reports, %llu laps\n", load.tagsPerReport, load.riderCount,
+                LLRPLaps::CSyntheticReport::formatName(load.format),
+                static_cast<unsigned long long>(fakeReader.getReportsSent()), static_cast<unsigned long long>(sink.laps));
+    std::printf("%s", recorder.report().c_str());
+
+    return driver.failed ? 1 : 0;
+}
+
+#include "latencyharness.moc"
@@ -0,0 +1,784 @@
+//********************************************************************
+//    created:    2026-10-18 09:40 AM
+//    file:       tagpathbench.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Benchmarks for the path a tag read takes from the wire to the
+ * newTag signal:
+ *
+ *      raw LLRP frame -> LTK decode -> processTagList -> processTagInfo
+ *                     -> CTagInfo -> emit newTag -> consumer slot
+ *                     -> CLapCounter or CLapPipeline -> CLapDatabase
+ *
+ *      raw LLRP frame -> CROAccessReportDecoder -> processTagRecords
+ *                     -> CTagInfo -> emit newTag
+ *
+ * Every benchmark is data driven over the report size (1 to 500 tags)
+ * and the EPC encoding (EPC_96 versus EPCData) so a result table can
+ * be compared between builds. Reports are built by CSyntheticReport.
+ */
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QtTest>
+
+#include <ltkcpp.h>
+#include "creader.h"
+#include "ctaginfo.h"
+#include "clapcounter.h"
+#include "clappipeline.h"
+#include "clapdatabase.h"
+#include "cepcinterner.h"
+#include "cchipregistry.h"
+#include "cframecapture.h"
+#include "cframecapturereader.h"
+#include "cllrpconnection.h"
+#include "croaccessreportdecoder.h"
+#include "csyntheticreport.h"
+
+namespace LLRPLaps
+{
+    class CTagCounter : public QObject
+    {
+    Q_OBJECT
+    public:
+        quint64 count = 0;
+        quint64 checksum = 0;
+
+    public slots:
+        void onNewTag(const LLRPLaps::CTagInfo &tagInfo)
+        {
+            // Touch the data like a real consumer so the call is not free
+            count++;
+            checksum += tagInfo.data.back() + static_cast<quint64>(tagInfo.AntennaId);
+        }
+    };
+
+
+    class CTagPathBenchmark : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void decodeFrame_data();
+        void decodeFrame();
+
+        void fastDecodeFrame_data();
+        void fastDecodeFrame();
+
+        void processReportFrame_data();
+        void processReportFrame();
+
+        void processTagList_data();
+        void processTagList();
+
+        void constructTagInfo_data();
+        void constructTagInfo();
+
+        void directDispatch_data();
+        void directDispatch();
+
+        void queuedDispatch_data();
+        void queuedDispatch();
+
+        void lapCounting_data();
+        void lapCounting();
+
+        void pipelineLapCounting_data();
+        void pipelineLapCounting();
+
+        void databaseLapInserts_data();
+        void databaseLapInserts();
+
+        void epcLookup_data();
+        void epcLookup();
+
+        void rosterResolve_data();
+        void rosterResolve();
+
+        void decodeCapture();
+
+    private:
+        void addReportRows(bool withFormats = true);
+
+        LLRP::CTypeRegistry *_typeRegistry = nullptr;
+    };
+
+
+    void CTagPathBenchmark::initTestCase()
+    {
+        qRegisterMetaType<LLRPLaps::CTagInfo>("LLRPLaps::CTagInfo");
+        _typeRegistry = LLRP::getTheTypeRegistry();
+        QVERIFY(nullptr != _typeRegistry);
+    }
+
+
+    void CTagPathBenchmark::cleanupTestCase()
+    {
+        delete _typeRegistry;
+        _typeRegistry = nullptr;
+    }
+
+
+    void CTagPathBenchmark::addReportRows(bool withFormats)
+    {
+        static const int sizes[] = { 1, 10, 50, 100, 250, 500 };
+        static const CSyntheticReport::EpcFormat formats[] = { CSyntheticReport::Epc96, CSyntheticReport::EpcData };
+
+        QTest::addColumn<int>("tagCount");
+        QTest::addColumn<int>("epcFormat");
+
+        for (auto format : formats)
+        {
+            if (!withFormats && CSyntheticReport::Epc96 != format)
+            {
+                continue;
+            }
+            for (auto size : sizes)
+            {
+                QByteArray name = QByteArray(CSyntheticReport::formatName(format)) + "/" + QByteArray::number(size);
+                QTest::newRow(name.constData()) << size << static_cast<int>(format);
+            }
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  LTK decode of a complete RO_ACCESS_REPORT frame
+ **
+ ** This is the work CConnection::recvMessage does once the frame
+ ** is in its buffer: build the CRO_ACCESS_REPORT object tree.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::decodeFrame_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::decodeFrame()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        std::vector<unsigned char> frame = synthetic.makeFrame(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+
+        QBENCHMARK
+        {
+            LLRP::CFrameDecoder decoder(_typeRegistry, frame.data(), static_cast<unsigned int>(frame.size()));
+            std::unique_ptr<LLRP::CMessage> message(decoder.decodeMessage());
+            QVERIFY(nullptr != message.get());
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Fast path decode of the same frame into flat tag records
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::fastDecodeFrame_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::fastDecodeFrame()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        std::vector<unsigned char> frame = synthetic.makeFrame(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+        std::vector<CTagRecord> records(static_cast<std::size_t>(tagCount));
+        CROAccessReportDecoder decoder;
+
+        QBENCHMARK
+        {
+            auto result = decoder.decode(frame.data(), static_cast<unsigned int>(frame.size()), records.data(), records.size());
+            QCOMPARE(result, CROAccessReportDecoder::Ok);
+        }
+        QCOMPARE(decoder.getTagCount(), static_cast<std::size_t>(tagCount));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Raw frame to emitted tags through the fast path
+ **
+ ** Compare with decodeFrame + processTagList for the LTK path.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::processReportFrame_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::processReportFrame()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        std::vector<unsigned char> bytes = synthetic.makeFrame(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+        CLLRPFrame frame = { bytes.data(), static_cast<unsigned int>(bytes.size()), CROAccessReportDecoder::RO_ACCESS_REPORT_TYPE, 1, 0 };
+        CReader reader("bench");
+
+        QBENCHMARK
+        {
+            QVERIFY(reader.processReportFrame(&frame));
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  processTagList over a decoded report, nobody connected
+ **
+ ** Covers the list walk, the EPC type dispatch and the CTagInfo
+ ** construction. The emit is close to free with no receivers.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::processTagList_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::processTagList()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        auto report = synthetic.makeReport(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+        CReader reader("bench");
+
+        QBENCHMARK
+        {
+            reader.processTagList(report);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  CTagInfo construction alone
+ **
+ ** The same copy processTagInfo does, without the LTK accessors,
+ ** to see how much of the per tag cost is the vector allocation.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::constructTagInfo_data()
+    {
+        addReportRows(false);
+    }
+
+    void CTagPathBenchmark::constructTagInfo()
+    {
+        QFETCH(int, tagCount);
+
+        // Both synthetic EPC formats carry 96 bits, the copy is the same
+        const int n = 12;
+        unsigned char epc[12] = { 0x30, 0x08, 0x33, 0xb2, 0xdd, 0xd9, 0x01, 0x40, 0, 0, 0x01, 0x2c };
+        quint64 checksum = 0;
+
+        QBENCHMARK
+        {
+            for (int t = 0; t < tagCount; t++)
+            {
+                LLRPLaps::CTagInfo tagInfo;
+                tagInfo.setTimeStampUSec(1500000000000000ULL + t);
+                tagInfo.AntennaId = 1 + (t & 3);
+                tagInfo.data.reserve(n);
+                for (int i = 0; i < n; i++)
+                {
+                    tagInfo.data.push_back(epc[i]);
+                }
+                checksum += tagInfo.data.back();
+            }
+        }
+        QVERIFY(checksum > 0);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  processTagList with a consumer on a direct connection
+ **
+ ** This is what MainWindow sees today (same thread, AutoConnection).
+ ** The difference to processTagList is the signal dispatch cost.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::directDispatch_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::directDispatch()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        auto report = synthetic.makeReport(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+        CReader reader("bench");
+        CTagCounter counter;
+        connect(&reader, &CReader::newTag, &counter, &CTagCounter::onNewTag, Qt::DirectConnection);
+
+        QBENCHMARK
+        {
+            reader.processTagList(report);
+        }
+        QVERIFY(counter.count >= static_cast<quint64>(tagCount));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  processTagList with a consumer on a queued connection
+ **
+ ** A consumer in another thread gets a copy of every CTagInfo
+ ** posted as an event. The loop drains the queue so the cost
+ ** of delivering the events is included.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::queuedDispatch_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::queuedDispatch()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        auto report = synthetic.makeReport(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat));
+        CReader reader("bench");
+        CTagCounter counter;
+        connect(&reader, &CReader::newTag, &counter, &CTagCounter::onNewTag, Qt::QueuedConnection);
+
+        QBENCHMARK
+        {
+            reader.processTagList(report);
+            QCoreApplication::processEvents();
+        }
+        QVERIFY(counter.count >= static_cast<quint64>(tagCount));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  processTagList feeding the lap counter
+ **
+ ** 40 riders and a short minimum lap so the counter both filters
+ ** reads of a pass and completes laps within one report.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::lapCounting_data()
+    {
+        addReportRows();
+    }
+
+    void CTagPathBenchmark::lapCounting()
+    {
+        QFETCH(int, tagCount);
+        QFETCH(int, epcFormat);
+
+        CSyntheticReport synthetic;
+        synthetic.setRiderCount(40);
+        CReader reader("bench");
+        CLapCounter lapCounter(20000);
+        connect(&reader, &CReader::newTag, &lapCounter, &CLapCounter::onNewTag, Qt::DirectConnection);
+
+        // Fresh timestamps every iteration, replaying one report would only hit the pass filter
+        std::vector<std::shared_ptr<LLRP::CRO_ACCESS_REPORT>> reports;
+        for (int i = 0; i < 64; i++)
+        {
+            reports.push_back(synthetic.makeReport(tagCount, static_cast<CSyntheticReport::EpcFormat>(epcFormat)));
+        }
+        std::size_t next = 0;
+
+        QBENCHMARK
+        {
+            if (reports.size() == next)
+            {
+                lapCounter.clear();
+                next = 0;
+            }
+            reader.processTagList(reports[next++]);
+        }
+        QVERIFY(lapCounter.getRiderCount() > 0);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Lap counting spread over 1 to 8 shards
+ **
+ ** 200 riders in turn, a read every 100 microseconds, so with a
+ ** 20ms minimum lap every read of a rider completes a lap. Each
+ ** iteration runs the reads through and flushes, so the merge is
+ ** part of the cost. Afterwards the same reads go to one
+ ** CLapCounter as well, the pipeline must give the same laps in
+ ** the same order for every rider.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::pipelineLapCounting_data()
+    {
+        QTest::addColumn<int>("shardCount");
+
+        for (int shardCount : { 1, 2, 4, 8 })
+        {
+            QTest::newRow(QByteArray::number(shardCount).constData()) << shardCount;
+        }
+    }
+
+    void CTagPathBenchmark::pipelineLapCounting()
+    {
+        QFETCH(int, shardCount);
+
+        const int riders = 200;
+        const int reads = 100000;
+        std::vector<LLRPLaps::CTagInfo> tags(reads);
+        for (int i = 0; i < reads; i++)
+        {
+            tags[i].data = { 0xE2, 0x80, 0x11, static_cast<unsigned char>(i % riders) };
+            tags[i].AntennaId = 1 + (i & 3);
+        }
+
+        CLapPipeline pipeline(static_cast<unsigned int>(shardCount), 20000);
+        quint64 laps = 0;
+        connect(&pipeline, &CLapPipeline::newLap, [&laps](const LLRPLaps::CLapInfo &)
+        { laps++; });
+        u_int64_t now = 1500000000000000ULL;
+
+        QBENCHMARK
+        {
+            for (auto &tagInfo : tags)
+            {
+                now += 100;
+                tagInfo.setTimeStampUSec(now);
+                pipeline.onNewTag(tagInfo);
+            }
+            pipeline.flush();
+        }
+        QCoreApplication::processEvents();
+        QVERIFY(laps > 0);
+
+        /* The merged laps come out in the order and with the times one counter gives them */
+        pipeline.clear();
+        CLapCounter reference(20000);
+        std::vector<LLRPLaps::CLapInfo> expected;
+        std::vector<LLRPLaps::CLapInfo> actual;
+        connect(&reference, &CLapCounter::newLap, [&expected](const LLRPLaps::CLapInfo &lapInfo)
+        { expected.push_back(lapInfo); });
+        connect(&pipeline, &CLapPipeline::newLap, [&actual](const LLRPLaps::CLapInfo &lapInfo)
+        { actual.push_back(lapInfo); });
+
+        typedef std::pair<std::vector<unsigned char>, u_int64_t> OffTrack;
+        std::vector<OffTrack> expectedOffTrack;
+        std::vector<OffTrack> actualOffTrack;
+        connect(&reference, &CLapCounter::riderOffTrack,
+                [&expectedOffTrack](const std::vector<unsigned char> &epc, u_int64_t lastSeenUSec)
+        { expectedOffTrack.emplace_back(epc, lastSeenUSec); });
+        connect(&pipeline, &CLapPipeline::riderOffTrack,
+                [&actualOffTrack](const std::vector<unsigned char> &epc, u_int64_t lastSeenUSec)
+        { actualOffTrack.emplace_back(epc, lastSeenUSec); });
+
+        for (auto &tagInfo : tags)
+        {
+            now += 100;
+            tagInfo.setTimeStampUSec(now);
+            reference.onNewTag(tagInfo);
+            pipeline.onNewTag(tagInfo);
+        }
+        pipeline.flush();
+        QCoreApplication::processEvents();
+
+        QVERIFY(!expected.empty());
+        QCOMPARE(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); i++)
+        {
+            QVERIFY(actual[i].epc == expected[i].epc);
+            QCOMPARE(actual[i].lapNumber, expected[i].lapNumber);
+            QCOMPARE(actual[i].antennaId, expected[i].antennaId);
+            QCOMPARE(actual[i].crossingUSec, expected[i].crossingUSec);
+            QCOMPARE(actual[i].lapTimeUSec, expected[i].lapTimeUSec);
+        }
+
+        /* Every rider goes off track once the reads stop, in whatever order the shards report it */
+        now += CLapCounter::DEFAULT_OFF_TRACK_USEC + 1000000;
+        reference.advanceTo(now);
+        pipeline.advanceTo(now);
+        pipeline.flush();
+        QCoreApplication::processEvents();
+
+        QCOMPARE(expectedOffTrack.size(), static_cast<std::size_t>(riders));
+        std::sort(expectedOffTrack.begin(), expectedOffTrack.end());
+        std::sort(actualOffTrack.begin(), actualOffTrack.end());
+        QVERIFY(actualOffTrack == expectedOffTrack);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Laps queued to CLapDatabase and committed
+ **
+ ** Each iteration queues a burst of laps and flushes, so the time is
+ ** that of the transactions on the writer thread. Divide the burst by
+ ** it for laps per second. The database is in a temporary directory,
+ ** point TMPDIR at the disk the real one lives on.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::databaseLapInserts_data()
+    {
+        QTest::addColumn<int>("lapCount");
+
+        for (int lapCount : { 1, 100, 1000, 10000 })
+        {
+            QTest::newRow(QByteArray::number(lapCount).constData()) << lapCount;
+        }
+    }
+
+    void CTagPathBenchmark::databaseLapInserts()
+    {
+        QFETCH(int, lapCount);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        CLapDatabase database;
+        QVERIFY2(database.open(dir.filePath("laps.sqlite")), qPrintable(database.getErrorString()));
+        qint64 sessionId = database.startSession("bench", 0);
+
+        CLapInfo lap;
+        lap.epc = { 0xE2, 0x80, 0x11, 0x05, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+        lap.antennaId = 1;
+        lap.lapTimeUSec = 15000000;
+
+        QBENCHMARK
+        {
+            for (int i = 0; i < lapCount; i++)
+            {
+                lap.epc.back() = static_cast<unsigned char>(i);
+                lap.lapNumber++;
+                lap.crossingUSec += 75000;
+                database.addLap(sessionId, lap);
+            }
+            database.flush();
+        }
+        QCOMPARE(database.getFailedCount(), std::uint64_t(0));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Finding the rider of a read, by EPC bytes or interned id
+ **
+ ** The map is how CLapCounter finds a rider without an id: compares
+ ** of 12 byte vectors down a tree. intern() is what CReader pays per
+ ** read for the id instead.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::epcLookup_data()
+    {
+        QTest::addColumn<int>("riderCount");
+        QTest::addColumn<bool>("interned");
+
+        for (int riderCount : { 40, 1000, 100000 })
+        {
+            QTest::newRow(qPrintable(QString("%1/map").arg(riderCount))) << riderCount << false;
+            QTest::newRow(qPrintable(QString("%1/interner").arg(riderCount))) << riderCount << true;
+        }
+    }
+
+    void CTagPathBenchmark::epcLookup()
+    {
+        QFETCH(int, riderCount);
+        QFETCH(bool, interned);
+
+        std::vector<std::vector<unsigned char>> epcs(riderCount);
+        std::map<std::vector<unsigned char>, int> riders;
+        CEpcInterner interner;
+        for (int i = 0; i < riderCount; i++)
+        {
+            epcs[i] = { 0xE2, 0x80, 0x11, 0x05, 0x20, 0x00, 0x00, 0x00, 0x00,
+                        static_cast<unsigned char>(i >> 16), static_cast<unsigned char>(i >> 8),
+                        static_cast<unsigned char>(i) };
+            riders[epcs[i]] = i;
+            interner.intern(epcs[i]);
+        }
+
+        std::size_t found = 0;
+        QBENCHMARK
+        {
+            for (const auto &epc : epcs)
+            {
+                if (interned)
+                {
+                    found += (CTagInfo::NO_EPC_ID != interner.intern(epc.data(), epc.size()));
+                }
+                else
+                {
+                    found += (riders.end() != riders.find(epc));
+                }
+            }
+        }
+        QVERIFY(found > 0);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  A 500 tag report checked against a roster of 1000 chips
+ **
+ ** One at a time through CChipRegistry::contains(), or all of it
+ ** through CRosterIndex::resolve(), with none, half or all of the
+ ** reads from registered chips.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::rosterResolve_data()
+    {
+        QTest::addColumn<int>("registeredPercent");
+        QTest::addColumn<bool>("batched");
+
+        for (int registeredPercent : { 0, 50, 100 })
+        {
+            QTest::newRow(qPrintable(QString("%1%/contains").arg(registeredPercent))) << registeredPercent << false;
+            QTest::newRow(qPrintable(QString("%1%/resolve").arg(registeredPercent))) << registeredPercent << true;
+        }
+    }
+
+    void CTagPathBenchmark::rosterResolve()
+    {
+        QFETCH(int, registeredPercent);
+        QFETCH(bool, batched);
+
+        const int chips = 1000;
+        const int reads = 500;
+        CChipRegistry registry;
+        for (int i = 0; i < chips; i++)
+        {
+            registry.add({ 0xE2, 0x80, 0x11, 0x05, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00,
+                           static_cast<unsigned char>(i >> 8), static_cast<unsigned char>(i) }, i + 1);
+        }
+        std::shared_ptr<const CRosterIndex> roster = registry.getRoster();
+
+        // Unregistered reads are of the same batch, past the reader's prefix filter
+        std::vector<std::vector<unsigned char>> epcs(reads);
+        std::vector<CTagRecord> records(reads);
+        for (int i = 0; i < reads; i++)
+        {
+            int chip = (i % 100 < registeredPercent) ? (i * 7) % chips : chips + i;
+            epcs[i] = { 0xE2, 0x80, 0x11, 0x05, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00,
+                        static_cast<unsigned char>(chip >> 8), static_cast<unsigned char>(chip) };
+            records[i] = CTagRecord();
+            records[i].epc = epcs[i].data();
+            records[i].epcBits = 96;
+        }
+        std::vector<std::int64_t> riderIds(reads);
+
+        std::size_t registered = 0;
+        QBENCHMARK
+        {
+            if (batched)
+            {
+                registered += roster->resolve(records.data(), records.size(), riderIds.data());
+            }
+            else
+            {
+                for (const auto &epc : epcs)
+                {
+                    registered += registry.contains(epc);
+                }
+            }
+        }
+        QVERIFY(0 == registeredPercent || registered > 0);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  LTK decode of every inbound frame of a real capture
+ **
+ ** Set LAPS_BENCH_CAPTURE to a file written by
+ ** CReader::setCaptureFile to benchmark with a reader's actual
+ ** traffic instead of synthetic reports.
+ **
+ *****************************************************************************/
+
+    void CTagPathBenchmark::decodeCapture()
+    {
+        QString path = QString::fromLocal8Bit(qgetenv("LAPS_BENCH_CAPTURE"));
+        if (path.isEmpty())
+        {
+            QSKIP("LAPS_BENCH_CAPTURE not set");
+        }
+
+        CFrameCaptureReader capture;
+        QVERIFY2(capture.open(path), qPrintable(capture.getErrorString()));
+
+        QBENCHMARK
+        {
+            for (std::size_t i = 0; i < capture.getRecordCount(); i++)
+            {
+                CFrameCaptureReader::Record record = capture.getRecord(i);
+                if (CFrameCapture::Inbound != record.direction)
+                {
+                    continue;
+                }
+                LLRP::CFrameDecoder decoder(_typeRegistry, const_cast<unsigned char *>(record.frame), record.length);
+                std::unique_ptr<LLRP::CMessage> message(decoder.decodeMessage());
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CTagPathBenchmark)
+
+#include "tagpathbench.moc"
@@ -0,0 +1,425 @@
+//********************************************************************
+//    created:    2026-10-19 04:40 AM
+//    file:       cantennaanalytics.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstring>
+
+#include "cantennaanalytics.h"
+#include "creader.h"
+
+namespace LLRPLaps
+{
+    const u_int64_t CAntennaAnalytics::BUCKET_USEC = 10000000ULL;
+    const int CAntennaAnalytics::WINDOW_BUCKETS = 30;
+    const u_int64_t CAntennaAnalytics::PASS_GAP_USEC = 2000000ULL;
+    const std::uint32_t CAntennaAnalytics::MIN_PASSES = 10;
+    const double CAntennaAnalytics::PEER_RATIO = 0.5;
+    const double CAntennaAnalytics::BASELINE_RATIO = 0.5;
+    const double CAntennaAnalytics::BASELINE_WEIGHT = 0.01;
+
+    namespace
+    {
+        const u_int64_t NO_BUCKET = ~0ULL;
+
+        // The bin holding fraction of the counts, 0 for none
+        int percentile(const std::uint32_t *bins, int binCount, std::uint64_t total, double fraction)
+        {
+            if (0 == total)
+            {
+                return 0;
+            }
+
+            std::uint64_t wanted = static_cast<std::uint64_t>(fraction * static_cast<double>(total - 1));
+            std::uint64_t seen = 0;
+            for (int bin = 0; bin < binCount; bin++)
+            {
+                seen += bins[bin];
+                if (seen > wanted)
+                {
+                    return bin;
+                }
+            }
+            return binCount - 1;
+        }
+
+        double median(std::vector<double> values)
+        {
+            if (values.empty())
+            {
+                return 0.0;
+            }
+            std::sort(values.begin(), values.end());
+            std::size_t middle = values.size() / 2;
+            return (values.size() % 2) ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+        }
+    }
+
+    CAntennaAnalytics::CAntennaAnalytics(QObject *parent) : QObject(parent), _currentBucket(NO_BUCKET), _version(0)
+    {
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Count the reads and antenna events of a reader
+ **
+ ** Connected directly, the counting runs in the reader's thread.
+ **
+ *****************************************************************************/
+
+    void CAntennaAnalytics::addReader(CReader *reader)
+    {
+        int readerIndex = addReaderName(reader->getHostName());
+
+        connect(reader, &CReader::newTag, this, [this, readerIndex](const LLRPLaps::CTagInfo &tagInfo)
+        { record(readerIndex, tagInfo); }, Qt::DirectConnection);
+        connect(reader, &CReader::antennaChanged, this, [this, readerIndex](int antennaId, bool connected)
+        { setAntennaConnected(readerIndex, antennaId, connected); }, Qt::DirectConnection);
+    }
+
+
+    int CAntennaAnalytics::addReaderName(const QString &name)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _readers.push_back(name);
+        return static_cast<int>(_readers.size()) - 1;
+    }
+
+
+    void CAntennaAnalytics::record(int readerIndex, const CTagInfo &tagInfo)
+    {
+        std::vector<CChange> changes;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            u_int64_t timeStampUSec = tagInfo.getTimeStampUSec();
+            u_int64_t index = timeStampUSec / BUCKET_USEC;
+            if (NO_BUCKET == _currentBucket)
+            {
+                _currentBucket = index;
+            }
+            else if (index > _currentBucket)
+            {
+                closeBucket(changes);
+                _currentBucket = index;
+            }
+
+            CAntenna &entry = antenna(readerIndex, tagInfo.AntennaId);
+            CBucket *counts = bucket(entry, timeStampUSec);
+            if (nullptr != counts)
+            {
+                counts->reads++;
+                if (tagInfo.getPeakRSSI() < 0)
+                {
+                    counts->rssi[tagInfo.getPeakRSSI() + RSSI_BINS]++;
+                }
+
+                auto pass = entry.passes.find(tagInfo.data);
+                if (entry.passes.end() == pass)
+                {
+                    entry.passes.emplace(tagInfo.data, CPass{ timeStampUSec, 1 });
+                }
+                else if (timeStampUSec > pass->second.lastUSec + PASS_GAP_USEC)
+                {
+                    closePass(entry, pass->second);
+                    pass->second = CPass{ timeStampUSec, 1 };
+                }
+                else
+                {
+                    pass->second.lastUSec = std::max(pass->second.lastUSec, timeStampUSec);
+                    pass->second.reads++;
+                }
+            }
+        }
+
+        for (const CChange &change : changes)
+        {
+            if (change.degraded)
+            {
+                emit antennaDegraded(change.reader, change.antennaId, change.reason);
+            }
+            else
+            {
+                emit antennaRecovered(change.reader, change.antennaId);
+            }
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  An AntennaEvent from the reader
+ **
+ ** A disconnect is reported at once, there will be no reads to close
+ ** a bucket with. A reconnected antenna is judged again by the next.
+ **
+ *****************************************************************************/
+
+    void CAntennaAnalytics::setAntennaConnected(int readerIndex, int antennaId, bool connected)
+    {
+        bool disconnected = false;
+        QString reader;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            CAntenna &entry = antenna(readerIndex, antennaId);
+            disconnected = entry.connected && !connected;
+            entry.connected = connected;
+            if (disconnected)
+            {
+                entry.degraded = true;
+                entry.reason = "disconnected";
+            }
+
+            for (CAntennaStats &stats : _stats)
+            {
+                if (stats.reader == _readers[readerIndex] && stats.antennaId == antennaId)
+                {
+                    stats.connected = connected;
+                    stats.degraded = entry.degraded;
+                    stats.reason = entry.reason;
+                }
+            }
+            reader = _readers[readerIndex];
+        }
+
+        if (disconnected)
+        {
+            emit antennaDegraded(reader, antennaId, "disconnected");
+        }
+    }
+
+
+    std::vector<CAntennaAnalytics::CAntennaStats> CAntennaAnalytics::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        return _stats;
+    }
+
+
+    CAntennaAnalytics::CAntenna &CAntennaAnalytics::antenna(int readerIndex, int antennaId)
+    {
+        for (CAntenna &entry : _antennas)
+        {
+            if (entry.readerIndex == readerIndex && entry.antennaId == antennaId)
+            {
+                return entry;
+            }
+        }
+
+        CAntenna entry;
+        entry.readerIndex = readerIndex;
+        entry.antennaId = antennaId;
+        entry.connected = true;
+        entry.buckets.resize(static_cast<std::size_t>(WINDOW_BUCKETS));
+        for (CBucket &counts : entry.buckets)
+        {
+            counts.index = NO_BUCKET;
+        }
+        entry.baseline = 0.0;
+        entry.degraded = false;
+        _antennas.push_back(std::move(entry));
+        return _antennas.back();
+    }
+
+
+    CAntennaAnalytics::CBucket *CAntennaAnalytics::bucket(CAntenna &antenna, u_int64_t timeStampUSec)
+    {
+        u_int64_t index = timeStampUSec / BUCKET_USEC;
+        if (index + static_cast<u_int64_t>(WINDOW_BUCKETS) <= _currentBucket)
+        {
+            // Older than the window, a reader far behind the others
+            return nullptr;
+        }
+
+        CBucket &counts = antenna.buckets[index % static_cast<u_int64_t>(WINDOW_BUCKETS)];
+        if (counts.index != index)
+        {
+            std::memset(&counts, 0, sizeof counts);
+            counts.index = index;
+        }
+        return &counts;
+    }
+
+
+    void CAntennaAnalytics::closePass(CAntenna &antenna, const CPass &pass)
+    {
+        CBucket *counts = bucket(antenna, pass.lastUSec);
+        if (nullptr != counts)
+        {
+            counts->passes++;
+            counts->passReads += pass.reads;
+            counts->readsPerPass[std::min<std::uint32_t>(pass.reads, PASS_BINS - 1)]++;
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Evaluate every antenna as the current bucket is done
+ **
+ ** Passes over by the end of the bucket are counted first. Peers are
+ ** the other antennas of the same reader, which see the same riders.
+ ** The baseline only learns from windows judged healthy, so a slow
+ ** decline does not become the new normal.
+ **
+ *****************************************************************************/
+
+    void CAntennaAnalytics::closeBucket(std::vector<CChange> &changes)
+    {
+        u_int64_t endUSec = (_currentBucket + 1) * BUCKET_USEC;
+        std::vector<CAntennaStats> stats;
+
+        for (CAntenna &entry : _antennas)
+        {
+            for (auto pass = entry.passes.begin(); pass != entry.passes.end();)
+            {
+                if (pass->second.lastUSec + PASS_GAP_USEC < endUSec)
+                {
+                    closePass(entry, pass->second);
+                    pass = entry.passes.erase(pass);
+                }
+                else
+                {
+                    ++pass;
+                }
+            }
+            stats.push_back(evaluate(entry));
+        }
+
+        for (std::size_t i = 0; i < _antennas.size(); i++)
+        {
+            CAntenna &entry = _antennas[i];
+            CAntennaStats &own = stats[i];
+
+            std::vector<double> peerMeans;
+            std::vector<double> peerPasses;
+            for (std::size_t j = 0; j < _antennas.size(); j++)
+            {
+                if (j != i && _antennas[j].readerIndex == entry.readerIndex && _antennas[j].connected)
+                {
+                    peerPasses.push_back(stats[j].passes);
+                    if (stats[j].passes >= MIN_PASSES)
+                    {
+                        peerMeans.push_back(stats[j].meanReadsPerPass);
+                    }
+                }
+            }
+            own.peerReadsPerPass = median(peerMeans);
+            double passesOfPeers = median(peerPasses);
+
+            QString reason;
+            if (!entry.connected)
+            {
+                reason = "disconnected";
+            }
+            else if (passesOfPeers >= MIN_PASSES && own.passes < PEER_RATIO * passesOfPeers)
+            {
+                reason = QString("%1 passes, its peers %2").arg(own.passes).arg(passesOfPeers);
+            }
+            else if (own.passes >= MIN_PASSES && own.peerReadsPerPass > 0.0 &&
+                     own.meanReadsPerPass < PEER_RATIO * own.peerReadsPerPass)
+            {
+                reason = QString("%1 reads a pass, its peers %2").arg(own.meanReadsPerPass, 0, 'f', 1)
+                                                                 .arg(own.peerReadsPerPass, 0, 'f', 1);
+            }
+            else if (own.passes >= MIN_PASSES && entry.baseline > 0.0 &&
+                     own.meanReadsPerPass < BASELINE_RATIO * entry.baseline)
+            {
+                reason = QString("%1 reads a pass, usually %2").arg(own.meanReadsPerPass, 0, 'f', 1)
+                                                               .arg(entry.baseline, 0, 'f', 1);
+            }
+
+            if (reason.isEmpty() && own.passes >= MIN_PASSES)
+            {
+                entry.baseline = (0.0 == entry.baseline) ? own.meanReadsPerPass
+                                 : entry.baseline + BASELINE_WEIGHT * (own.meanReadsPerPass - entry.baseline);
+            }
+            own.baselineReadsPerPass = entry.baseline;
+
+            bool degraded = !reason.isEmpty();
+            if (degraded != entry.degraded)
+            {
+                changes.push_back({ _readers[entry.readerIndex], entry.antennaId, degraded, reason });
+            }
+            entry.degraded = degraded;
+            entry.reason = reason;
+            own.degraded = degraded;
+            own.reason = reason;
+        }
+
+        _stats.swap(stats);
+        _version.fetch_add(1, std::memory_order_release);
+    }
+
+
+    CAntennaAnalytics::CAntennaStats CAntennaAnalytics::evaluate(const CAntenna &antenna) const
+    {
+        std::uint64_t reads = 0;
+        std::uint64_t passes = 0;
+        std::uint64_t passReads = 0;
+        std::uint32_t readsPerPass[PASS_BINS] = {};
+        std::uint32_t rssi[RSSI_BINS] = {};
+        std::uint64_t rssiReads = 0;
+
+        for (const CBucket &counts : antenna.buckets)
+        {
+            if (NO_BUCKET == counts.index || counts.index > _currentBucket ||
+                counts.index + static_cast<u_int64_t>(WINDOW_BUCKETS) <= _currentBucket)
+            {
+                continue;
+            }
+
+            reads += counts.reads;
+            passes += counts.passes;
+            passReads += counts.passReads;
+            for (int bin = 0; bin < PASS_BINS; bin++)
+            {
+                readsPerPass[bin] += counts.readsPerPass[bin];
+            }
+            for (int bin = 0; bin < RSSI_BINS; bin++)
+            {
+                rssi[bin] += counts.rssi[bin];
+                rssiReads += counts.rssi[bin];
+            }
+        }
+
+        CAntennaStats stats;
+        stats.reader = _readers[antenna.readerIndex];
+        stats.antennaId = antenna.antennaId;
+        stats.connected = antenna.connected;
+        stats.readsPerSec = static_cast<double>(reads) * 1000000.0 / (WINDOW_BUCKETS * static_cast<double>(BUCKET_USEC));
+        stats.passes = static_cast<std::uint32_t>(passes);
+        stats.meanReadsPerPass = passes ? static_cast<double>(passReads) / static_cast<double>(passes) : 0.0;
+        stats.readsPerPassP50 = percentile(readsPerPass, PASS_BINS, passes, 0.5);
+        stats.readsPerPassP90 = percentile(readsPerPass, PASS_BINS, passes, 0.9);
+        stats.rssiP10 = rssiReads ? percentile(rssi, RSSI_BINS, rssiReads, 0.1) - RSSI_BINS : 0;
+        stats.rssiP50 = rssiReads ? percentile(rssi, RSSI_BINS, rssiReads, 0.5) - RSSI_BINS : 0;
+        stats.rssiP90 = rssiReads ? percentile(rssi, RSSI_BINS, rssiReads, 0.9) - RSSI_BINS : 0;
+        stats.baselineReadsPerPass = antenna.baseline;
+        stats.peerReadsPerPass = 0.0;
+        stats.degraded = antenna.degraded;
+        stats.reason = antenna.reason;
+        return stats;
+    }
+}
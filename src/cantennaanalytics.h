@@ -0,0 +1,175 @@
+//********************************************************************
+//    created:    2026-10-19 04:40 AM
+//    file:       cantennaanalytics.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CANTENNAANALYTICS_H
+#define LLRPLAPS_CANTENNAANALYTICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    class CReader;
+
+    /*
+     * Read rates, reads per pass and RSSI of every antenna of every
+     * reader over a rolling window, to catch a failing antenna or
+     * cable before riders miss laps.
+     *
+     * A pass is a run of reads of one chip on one antenna with no gap
+     * of PASS_GAP_USEC. Reads per pass is what an antenna is judged
+     * by: unlike the read rate it does not fall when riders leave the
+     * track. Reads land in buckets of BUCKET_USEC of reader time; when
+     * a bucket is done every antenna is evaluated over the last
+     * WINDOW_BUCKETS of them. With MIN_PASSES seen on its peers, an
+     * antenna is degraded when its reads per pass fall below
+     * PEER_RATIO of the median of the other antennas of its reader, or
+     * below BASELINE_RATIO of its own average over healthy windows.
+     * One that stops seeing passes while its peers see them is
+     * degraded too.
+     *
+     * record() is a few counter bumps under a lock, safe from any
+     * thread. Signals come from the thread of the read that closed a
+     * bucket.
+     */
+    class CAntennaAnalytics : public QObject
+    {
+    Q_OBJECT
+    public:
+        struct CAntennaStats
+        {
+            QString reader;
+            int antennaId;
+            bool connected;
+            double readsPerSec;
+            std::uint32_t passes;
+            double meanReadsPerPass;
+            int readsPerPassP50;
+            int readsPerPassP90;
+            int rssiP10;                        // dBm, 0 when the reader reports none
+            int rssiP50;
+            int rssiP90;
+            double baselineReadsPerPass;        // 0 until learnt
+            double peerReadsPerPass;            // 0 without peers to compare with
+            bool degraded;
+            QString reason;
+        };
+
+        explicit CAntennaAnalytics(QObject *parent = nullptr);
+
+        // Counts the reads of reader from now on, under its host name
+        void addReader(CReader *reader);
+
+        // readerIndex as returned by addReaderName()
+        void record(int readerIndex, const CTagInfo &tagInfo);
+
+        int addReaderName(const QString &name);
+
+        void setAntennaConnected(int readerIndex, int antennaId, bool connected);
+
+        // As of the last bucket closed
+        std::vector<CAntennaStats> getStats() const;
+
+        // Bumped with every bucket closed
+        std::uint64_t getVersion() const { return _version.load(std::memory_order_acquire); }
+
+        const static u_int64_t BUCKET_USEC;
+        const static int WINDOW_BUCKETS;
+        const static u_int64_t PASS_GAP_USEC;
+        const static std::uint32_t MIN_PASSES;
+        const static double PEER_RATIO;
+        const static double BASELINE_RATIO;
+        const static double BASELINE_WEIGHT;
+
+    signals:
+
+        void antennaDegraded(const QString &reader, int antennaId, const QString &reason);
+
+        void antennaRecovered(const QString &reader, int antennaId);
+
+    private:
+        enum
+        {
+            PASS_BINS = 64,                     // 1 to 63 reads, then 63 and over
+            RSSI_BINS = 128                     // -128 to -1 dBm
+        };
+
+        struct CBucket
+        {
+            u_int64_t index;
+            std::uint32_t reads;
+            std::uint32_t passes;
+            std::uint64_t passReads;
+            std::uint32_t readsPerPass[PASS_BINS];
+            std::uint32_t rssi[RSSI_BINS];
+        };
+
+        struct CPass
+        {
+            u_int64_t lastUSec;
+            std::uint32_t reads;
+        };
+
+        struct CAntenna
+        {
+            int readerIndex;
+            int antennaId;
+            bool connected;
+            std::vector<CBucket> buckets;       // WINDOW_BUCKETS, by bucket index modulo
+            std::map<std::vector<unsigned char>, CPass> passes;
+            double baseline;
+            bool degraded;
+            QString reason;
+        };
+
+        struct CChange
+        {
+            QString reader;
+            int antennaId;
+            bool degraded;
+            QString reason;
+        };
+
+        CAntenna &antenna(int readerIndex, int antennaId);
+
+        CBucket *bucket(CAntenna &antenna, u_int64_t timeStampUSec);
+
+        void closePass(CAntenna &antenna, const CPass &pass);
+
+        void closeBucket(std::vector<CChange> &changes);
+
+        CAntennaStats evaluate(const CAntenna &antenna) const;
+
+        mutable std::mutex _mutex;
+        std::vector<QString> _readers;
+        std::vector<CAntenna> _antennas;
+        std::vector<CAntennaStats> _stats;
+        u_int64_t _currentBucket;
+        std::atomic<std::uint64_t> _version;
+    };
+}
+#endif //LLRPLAPS_CANTENNAANALYTICS_H
@@ -0,0 +1,324 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ccheckpointer.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstring>
+
+#include <QFile>
+#include <QSaveFile>
+
+#include "ccheckpointer.h"
+#include "clapcounter.h"
+#include "ctaginfo.h"
+#include "ctagjournal.h"
+#include "ctagjournalreader.h"
+
+namespace LLRPLaps
+{
+    const int CCheckpointer::DEFAULT_INTERVAL_MS = 1000;
+    const char CCheckpointer::MAGIC[8] = { 'L', 'A', 'P', 'S', 'N', 'A', 'P', '\0' };
+    const std::uint32_t CCheckpointer::VERSION = 1;
+    const unsigned int CCheckpointer::HEADER_SIZE = 40;
+
+    namespace
+    {
+        void putU32(unsigned char *p, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void putU64(unsigned char *p, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::uint64_t getU64(const unsigned char *p)
+        {
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        // FNV-1a, catches a snapshot damaged on disk
+        std::uint32_t checksum(const unsigned char *p, std::size_t size)
+        {
+            std::uint32_t hash = 2166136261u;
+            for (std::size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ p[i]) * 16777619u;
+            }
+            return hash;
+        }
+    }
+
+    CCheckpointer::CCheckpointer(CLapCounter &lapCounter, CTagJournal &journal, const QString &snapshotPath,
+                                 QObject *parent) : QObject(parent), _lapCounter(lapCounter), _journal(journal),
+                                                    _snapshotPath(snapshotPath), _timer(this), _replayedCount(0),
+                                                    _hasPending(false), _stopRequested(false), _snapshotCount(0)
+    {
+        connect(&_timer, &QTimer::timeout, this, &CCheckpointer::checkpoint);
+        _thread = std::thread(&CCheckpointer::run, this);
+    }
+
+
+    CCheckpointer::~CCheckpointer()
+    {
+        _timer.stop();
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stopRequested = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+    }
+
+
+    void CCheckpointer::start(int intervalMS)
+    {
+        _timer.start(intervalMS);
+    }
+
+
+    void CCheckpointer::stop()
+    {
+        _timer.stop();
+    }
+
+
+    std::uint64_t CCheckpointer::getSnapshotCount() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _snapshotCount;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Take a snapshot and hand it to the writer thread
+ **
+ ** The journal is flushed first so the snapshot never points past
+ ** what is on disk. A snapshot the writer has not started on yet is
+ ** replaced by this one.
+ **
+ *****************************************************************************/
+
+    void CCheckpointer::checkpoint()
+    {
+        _journal.flush();
+        _lapCounter.saveState(_state);
+
+        _filling.resize(HEADER_SIZE + _state.size());
+        unsigned char *header = _filling.data();
+        std::copy(MAGIC, MAGIC + sizeof MAGIC, header);
+        putU32(header + 8, VERSION);
+        putU32(header + 12, checksum(_state.data(), _state.size()));
+        putU64(header + 16, _journal.getRecordCount());
+        putU64(header + 24, _journal.getOffset());
+        putU64(header + 32, _state.size());
+        std::copy(_state.begin(), _state.end(), _filling.begin() + HEADER_SIZE);
+
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _pending.swap(_filling);
+            _hasPending = true;
+        }
+        _wake.notify_one();
+    }
+
+
+    void CCheckpointer::run()
+    {
+        std::vector<unsigned char> writing;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _wake.wait(lock, [this]
+                { return _stopRequested || _hasPending; });
+
+                /* The last snapshot taken still goes to disk on the way out */
+                if (!_hasPending)
+                {
+                    return;
+                }
+
+                writing.swap(_pending);
+                _hasPending = false;
+            }
+
+            QSaveFile file(_snapshotPath);
+            if (file.open(QIODevice::WriteOnly) &&
+                static_cast<qint64>(writing.size()) == file.write(reinterpret_cast<const char *>(writing.data()),
+                                                                  static_cast<qint64>(writing.size())) &&
+                file.commit())
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                _snapshotCount++;
+            }
+        }
+    }
+
+
+    bool CCheckpointer::loadSnapshot(const unsigned char *data, std::size_t size, CLapCounter &lapCounter,
+                                     std::uint64_t &journalRecords, std::uint64_t &journalOffset)
+    {
+        if (size < HEADER_SIZE)
+        {
+            return false;
+        }
+
+        std::uint64_t stateSize = getU64(data + 32);
+        if ((0 != std::memcmp(data, MAGIC, sizeof MAGIC)) ||
+            (VERSION != getU32(data + 8)) ||
+            (HEADER_SIZE + stateSize != size) ||
+            (getU32(data + 12) != checksum(data + HEADER_SIZE, static_cast<std::size_t>(stateSize))) ||
+            !lapCounter.loadState(data + HEADER_SIZE, static_cast<std::size_t>(stateSize)))
+        {
+            return false;
+        }
+
+        journalRecords = getU64(data + 16);
+        journalOffset = getU64(data + 24);
+        return true;
+    }
+
+
+    bool CCheckpointer::loadSnapshotFile(std::uint64_t &journalRecords, std::uint64_t &journalOffset)
+    {
+        journalRecords = 0;
+        journalOffset = 0;
+
+        QFile file(_snapshotPath);
+        if (!file.exists())
+        {
+            return true;
+        }
+
+        if (!file.open(QIODevice::ReadOnly) || file.size() < HEADER_SIZE)
+        {
+            _errorString = "Snapshot unreadable: " + file.errorString();
+            return false;
+        }
+
+        const unsigned char *data = file.map(0, file.size());
+        if (nullptr == data)
+        {
+            _errorString = "Snapshot unreadable: " + file.errorString();
+            return false;
+        }
+
+        bool loaded = loadSnapshot(data, static_cast<std::size_t>(file.size()), _lapCounter, journalRecords,
+                                   journalOffset);
+        if (!loaded)
+        {
+            _errorString = "Snapshot damaged, replaying the whole journal";
+        }
+
+        file.unmap(const_cast<uchar *>(data));
+        return loaded;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Bring the counter back to where it was before a restart
+ **
+ ** A damaged snapshot falls back to replaying the journal from its
+ ** start. A snapshot ahead of the journal, which was lost or
+ ** replaced, is kept and a new journal started.
+ **
+ *****************************************************************************/
+
+    bool CCheckpointer::restore(const QString &journalPath)
+    {
+        _errorString.clear();
+        _replayedCount = 0;
+        _lapCounter.setJournal(nullptr);
+
+        std::uint64_t journalRecords;
+        std::uint64_t journalOffset;
+        if (!loadSnapshotFile(journalRecords, journalOffset))
+        {
+            _lapCounter.clear();
+            journalRecords = 0;
+            journalOffset = CTagJournal::HEADER_SIZE;
+        }
+
+        bool opened;
+        CTagJournalReader reader;
+
+        if (!QFile::exists(journalPath))
+        {
+            opened = _journal.open(journalPath.toStdString());
+        }
+        else if (!reader.open(journalPath))
+        {
+            /* Leave it for someone to look at rather than write over it */
+            _errorString = "Journal unreadable: " + reader.getErrorString();
+            return false;
+        }
+        else if (journalOffset > reader.getSize())
+        {
+            reader.close();
+            opened = _journal.open(journalPath.toStdString());
+        }
+        else
+        {
+            std::uint64_t offset = std::max<std::uint64_t>(journalOffset, CTagJournal::HEADER_SIZE);
+            CTagInfo tagInfo;
+            while (reader.next(offset, tagInfo))
+            {
+                _lapCounter.onNewTag(tagInfo);
+                _replayedCount++;
+            }
+            reader.close();
+            opened = _journal.open(journalPath.toStdString(), journalRecords + _replayedCount, offset);
+        }
+
+        if (!opened)
+        {
+            _errorString = "Journal cannot be written: " + journalPath;
+            return false;
+        }
+
+        _lapCounter.setJournal(&_journal);
+        return true;
+    }
+}
@@ -0,0 +1,118 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ccheckpointer.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CCHECKPOINTER_H
+#define LLRPLAPS_CCHECKPOINTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+namespace LLRPLaps
+{
+    class CLapCounter;
+    class CTagJournal;
+
+    /*
+     * Snapshots of a CLapCounter and the journal that carries on
+     * from them, so a restart loads the snapshot and replays seconds
+     * of reads instead of the whole race.
+     *
+     *  snapshot  "LAPSNAP\0", u32 version, u32 state checksum,
+     *            u64 journal records, u64 journal offset,
+     *            u64 state length, CLapCounter::saveState()
+     *
+     * A snapshot is taken on the counter's thread, between two reads,
+     * into one buffer while the writer thread may still be saving the
+     * previous one from the other. The file is replaced atomically,
+     * a crash leaves the old snapshot or the new one.
+     *
+     * Lives in the counter's thread.
+     */
+    class CCheckpointer : public QObject
+    {
+    Q_OBJECT
+    public:
+        CCheckpointer(CLapCounter &lapCounter, CTagJournal &journal, const QString &snapshotPath,
+                      QObject *parent = nullptr);
+
+        ~CCheckpointer() override;
+
+        /*
+         * Load the snapshot, replay the journal after it into the
+         * counter and open the journal to carry on. Either file may be
+         * missing, a new journal is started then. Laps found replaying
+         * are signalled again, connect to the counter afterwards.
+         */
+        bool restore(const QString &journalPath);
+
+        void start(int intervalMS = DEFAULT_INTERVAL_MS);
+
+        void stop();
+
+        const QString &getErrorString() const { return _errorString; }
+
+        std::uint64_t getSnapshotCount() const;
+
+        // Reads replayed by the last restore()
+        std::uint64_t getReplayedCount() const { return _replayedCount; }
+
+        // Load a snapshot held in memory into lapCounter, false if it is damaged
+        static bool loadSnapshot(const unsigned char *data, std::size_t size, CLapCounter &lapCounter,
+                                 std::uint64_t &journalRecords, std::uint64_t &journalOffset);
+
+        const static int DEFAULT_INTERVAL_MS;
+        static const char MAGIC[8];
+        static const std::uint32_t VERSION;
+        static const unsigned int HEADER_SIZE;
+
+    public slots:
+
+        void checkpoint();
+
+    private:
+        bool loadSnapshotFile(std::uint64_t &journalRecords, std::uint64_t &journalOffset);
+
+        void run();
+
+        CLapCounter &_lapCounter;
+        CTagJournal &_journal;
+        QString _snapshotPath;
+        QTimer _timer;
+        QString _errorString;
+        std::uint64_t _replayedCount;
+        std::vector<unsigned char> _state;
+        std::vector<unsigned char> _filling;
+
+        mutable std::mutex _lock;
+        std::condition_variable _wake;
+        std::vector<unsigned char> _pending;
+        bool _hasPending;
+        bool _stopRequested;
+        std::uint64_t _snapshotCount;
+        std::thread _thread;
+    };
+}
+#endif //LLRPLAPS_CCHECKPOINTER_H
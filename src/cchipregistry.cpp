@@ -0,0 +1,250 @@
+//********************************************************************
+//    created:    2026-10-18 05:20 PM
+//    file:       cchipregistry.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cchipregistry.h"
+
+#include <algorithm>
+
+namespace LLRPLaps
+{
+    const std::size_t CChipRegistry::DEFAULT_MAX_FILTERS = 2;
+
+    namespace
+    {
+        std::uint16_t commonPrefixBits(const CEpcFilter &a, const CEpcFilter &b)
+        {
+            std::uint16_t limit = std::min(a.bits, b.bits);
+            std::uint16_t bits = 0;
+
+            while (bits < limit)
+            {
+                unsigned int byte = bits / 8u;
+                unsigned char diff = a.prefix[byte] ^ b.prefix[byte];
+
+                if (0 == diff)
+                {
+                    bits = static_cast<std::uint16_t>(bits + 8u);
+                    continue;
+                }
+
+                // Count the equal bits from the top of the first differing byte
+                for (unsigned char bit = 0x80; 0 == (diff & bit); bit >>= 1)
+                {
+                    bits++;
+                }
+                return std::min(bits, limit);
+            }
+
+            return limit;
+        }
+
+        CEpcFilter truncate(const CEpcFilter &filter, std::uint16_t bits)
+        {
+            CEpcFilter truncated;
+
+            truncated.bits = bits;
+            truncated.prefix.assign(filter.prefix.begin(), filter.prefix.begin() + (bits + 7u) / 8u);
+            if (0 != bits % 8u)
+            {
+                truncated.prefix.back() &= static_cast<unsigned char>(0xFFu << (8u - bits % 8u));
+            }
+
+            return truncated;
+        }
+    }
+
+
+    bool CChipRegistry::add(const std::vector<unsigned char> &epc, std::int64_t riderId)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (epc.empty())
+        {
+            return false;
+        }
+
+        auto inserted = _epcs.insert(std::make_pair(epc, riderId));
+        if (!inserted.second)
+        {
+            if (inserted.first->second == riderId)
+            {
+                return false;
+            }
+            inserted.first->second = riderId;
+        }
+
+        _generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+
+    bool CChipRegistry::remove(const std::vector<unsigned char> &epc)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (0 == _epcs.erase(epc))
+        {
+            return false;
+        }
+
+        _generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+
+    void CChipRegistry::clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _epcs.clear();
+        _generation.fetch_add(1, std::memory_order_release);
+    }
+
+
+    bool CChipRegistry::contains(const std::vector<unsigned char> &epc) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        return _epcs.count(epc) != 0;
+    }
+
+
+    std::size_t CChipRegistry::size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        return _epcs.size();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The reader filters for the registered chips
+ **
+ ** Empty when nothing is registered, or when the best cover is
+ ** no prefix at all; the reader then reports every tag.
+ **
+ *****************************************************************************/
+
+    std::vector<CEpcFilter> CChipRegistry::getEpcFilters(std::size_t maxFilters) const
+    {
+        std::vector<std::vector<unsigned char>> epcs;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto &chip : _epcs)
+            {
+                epcs.push_back(chip.first);
+            }
+        }
+
+        return coverWithPrefixes(epcs, maxFilters);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The registered chips indexed for CReader
+ **
+ ** Rebuilt under the lock on the first call after a change, the
+ ** registry is small and changes between sessions.
+ **
+ *****************************************************************************/
+
+    std::shared_ptr<const CRosterIndex> CChipRegistry::getRoster() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::uint64_t generation = _generation.load(std::memory_order_relaxed);
+        if (!_roster || generation != _rosterGeneration)
+        {
+            _roster = std::make_shared<const CRosterIndex>(_epcs);
+            _rosterGeneration = generation;
+        }
+        return _roster;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Cover a sorted list of EPCs with at most maxFilters prefixes
+ **
+ ** Chips are bought in numbered batches, so the EPCs come in a few
+ ** runs sharing long prefixes. Starting from one exact match per
+ ** EPC, the two neighbours sharing the longest prefix are merged
+ ** until few enough are left. Merging neighbours of a sorted list
+ ** keeps it sorted, and the longest shared prefix lets the fewest
+ ** unregistered EPCs through.
+ **
+ ** Readers can only apply a handful of Select filters per query,
+ ** hence the limit.
+ **
+ *****************************************************************************/
+
+    std::vector<CEpcFilter> CChipRegistry::coverWithPrefixes(const std::vector<std::vector<unsigned char>> &epcs,
+                                                             std::size_t maxFilters)
+    {
+        std::vector<CEpcFilter> filters;
+
+        if (0 == maxFilters)
+        {
+            return filters;
+        }
+
+        for (const auto &epc : epcs)
+        {
+            CEpcFilter filter;
+            filter.prefix = epc;
+            filter.bits = static_cast<std::uint16_t>(epc.size() * 8u);
+            filters.push_back(filter);
+        }
+
+        while (filters.size() > maxFilters)
+        {
+            std::size_t best = 0;
+            std::uint16_t bestBits = 0;
+
+            for (std::size_t i = 0; i + 1 < filters.size(); i++)
+            {
+                std::uint16_t bits = commonPrefixBits(filters[i], filters[i + 1]);
+                if (0 == i || bits > bestBits)
+                {
+                    best = i;
+                    bestBits = bits;
+                }
+            }
+
+            filters[best] = truncate(filters[best], bestBits);
+            filters.erase(filters.begin() + best + 1);
+        }
+
+        for (const auto &filter : filters)
+        {
+            if (0 == filter.bits)
+            {
+                // Matches everything, no point filtering
+                filters.clear();
+                break;
+            }
+        }
+
+        return filters;
+    }
+}
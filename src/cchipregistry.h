@@ -0,0 +1,85 @@
+//********************************************************************
+//    created:    2026-10-18 05:20 PM
+//    file:       cchipregistry.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CCHIPREGISTRY_H
+#define LLRPLAPS_CCHIPREGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "crospecconfig.h"
+#include "crosterindex.h"
+
+namespace LLRPLaps
+{
+    /*
+     * The EPCs of the rider chips in use. The reader is told to
+     * only report chips matching a few EPC prefixes covering them
+     * (see getEpcFilters), which keeps spares, bikes in the infield
+     * and stray inventory off the air interface and the network.
+     *
+     * Safe to change from any thread. Every change bumps the
+     * generation, CReader reinstalls its ROSpec between inventory
+     * cycles when it sees a new one, and takes a new getRoster() to
+     * resolve reads to riders on the host.
+     */
+    class CChipRegistry
+    {
+    public:
+        CChipRegistry() : _generation(0), _rosterGeneration(0)
+        {
+        }
+
+        // Also true when only the rider of a registered chip changes
+        bool add(const std::vector<unsigned char> &epc, std::int64_t riderId = 0);
+
+        bool remove(const std::vector<unsigned char> &epc);
+
+        void clear();
+
+        bool contains(const std::vector<unsigned char> &epc) const;
+
+        std::size_t size() const;
+
+        std::uint64_t getGeneration() const { return _generation.load(std::memory_order_acquire); }
+
+        std::vector<CEpcFilter> getEpcFilters(std::size_t maxFilters = DEFAULT_MAX_FILTERS) const;
+
+        // Built once per generation, kept by the caller for as long as it likes
+        std::shared_ptr<const CRosterIndex> getRoster() const;
+
+        static std::vector<CEpcFilter> coverWithPrefixes(const std::vector<std::vector<unsigned char>> &epcs,
+                                                         std::size_t maxFilters);
+
+        // What most readers report as MaxNumSelectFiltersPerQuery
+        const static std::size_t DEFAULT_MAX_FILTERS;
+
+    private:
+        mutable std::mutex _mutex;
+        std::map<std::vector<unsigned char>, std::int64_t> _epcs;   // rider id by EPC
+        std::atomic<std::uint64_t> _generation;
+        mutable std::shared_ptr<const CRosterIndex> _roster;
+        mutable std::uint64_t _rosterGeneration;
+    };
+}
+#endif //LLRPLAPS_CCHIPREGISTRY_H
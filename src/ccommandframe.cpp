@@ -0,0 +1,504 @@
+//********************************************************************
+//    created:    2026-10-18 03:05 PM
+//    file:       ccommandframe.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "ccommandframe.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        // An ADD_ROSPEC with filters and per antenna settings stays well below this
+        const unsigned int MAX_COMMAND_SIZE = 16u * 1024u;
+
+        // The EPC starts after the CRC-16 and the PC word in the EPC bank
+        const LLRP::llrp_u2_t EPC_MEMORY_BANK = 1;
+        const LLRP::llrp_u16_t EPC_BIT_POINTER = 0x20;
+    }
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Encode an LTK message into a reusable frame
+ **
+ ** @throws     ReaderErrorDetailsException if LTK cannot encode it
+ **
+ *****************************************************************************/
+
+    CCommandFrame CCommandFrame::encode(const LLRP::CMessage *message)
+    {
+        std::vector<unsigned char> buffer(MAX_COMMAND_SIZE);
+        LLRP::CFrameEncoder encoder(buffer.data(), MAX_COMMAND_SIZE);
+
+        encoder.encodeElement(message);
+        if (LLRP::RC_OK != encoder.m_ErrorDetails.m_eResultCode)
+        {
+            throw ReaderErrorDetailsException(ReaderErrorDetailsException::CErrorDetailsToString(
+                    &encoder.m_ErrorDetails, message->m_pType->m_pName, "encode"));
+        }
+
+        return CCommandFrame(buffer.data(), encoder.getLength());
+    }
+
+
+    void CCommandFrame::setMessageId(std::uint32_t messageId)
+    {
+        _bytes[6] = static_cast<unsigned char>(messageId >> 24);
+        _bytes[7] = static_cast<unsigned char>(messageId >> 16);
+        _bytes[8] = static_cast<unsigned char>(messageId >> 8);
+        _bytes[9] = static_cast<unsigned char>(messageId);
+    }
+
+
+    std::uint32_t CCommandFrame::getMessageId() const
+    {
+        return (static_cast<std::uint32_t>(_bytes[6]) << 24) | (static_cast<std::uint32_t>(_bytes[7]) << 16) |
+               (static_cast<std::uint32_t>(_bytes[8]) << 8) | static_cast<std::uint32_t>(_bytes[9]);
+    }
+
+
+    unsigned int CCommandFrame::getMessageType() const
+    {
+        return ((_bytes[0] & 0x03u) << 8) | _bytes[1];
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Compose the C1G2InventoryCommand for one antenna
+ **
+ ** Settings left at READER_DEFAULT are not sent. With filters
+ ** there is a Gen2 Select per filter: the first one sets SL on
+ ** matching tags and clears it on the rest, the others only set it
+ ** on matching tags, so a tag is inventoried if it matches any of
+ ** them. A state aware inventory gets state aware filter actions on
+ ** SL, which is what its singulation picks tags by. Something like:
+ **
+ **     <C1G2InventoryCommand>
+ **       <TagInventoryStateAware>0</TagInventoryStateAware>
+ **       <C1G2Filter>
+ **         <T>Do_Not_Truncate</T>
+ **         <C1G2TagInventoryMask>
+ **           <MB>1</MB>
+ **           <Pointer>32</Pointer>
+ **           <TagMask Count="76">30143639f84191d1...</TagMask>
+ **         </C1G2TagInventoryMask>
+ **         <C1G2TagInventoryStateUnawareFilterAction>
+ **           <Action>Select_Unselect</Action>
+ **         </C1G2TagInventoryStateUnawareFilterAction>
+ **       </C1G2Filter>
+ **       <C1G2RFControl>
+ **         <ModeIndex>0</ModeIndex>
+ **         <Tari>0</Tari>
+ **       </C1G2RFControl>
+ **       <C1G2SingulationControl>
+ **         <Session>0</Session>
+ **         <TagPopulation>16</TagPopulation>
+ **         <TagTransitTime>120</TagTransitTime>
+ **       </C1G2SingulationControl>
+ **     </C1G2InventoryCommand>
+ **
+ *****************************************************************************/
+
+    LLRP::CC1G2InventoryCommand *CCommandFrames::makeInventoryCommand(const CAntennaConfig &antenna,
+                                                                      const std::vector<CEpcFilter> &filters)
+    {
+        bool stateAware = CAntennaConfig::TargetDefault != antenna.target;
+        auto *pInventoryCommand = new LLRP::CC1G2InventoryCommand();
+        pInventoryCommand->setTagInventoryStateAware(stateAware);
+
+        for (std::size_t i = 0; i < filters.size(); i++)
+        {
+            LLRP::llrp_u1v_t tagMask(filters[i].bits);
+            std::copy(filters[i].prefix.begin(), filters[i].prefix.end(), tagMask.m_pValue);
+
+            auto *pTagInventoryMask = new LLRP::CC1G2TagInventoryMask();
+            pTagInventoryMask->setMB(EPC_MEMORY_BANK);
+            pTagInventoryMask->setPointer(EPC_BIT_POINTER);
+            pTagInventoryMask->setTagMask(tagMask);
+
+            auto *pFilter = new LLRP::CC1G2Filter();
+            pFilter->setT(LLRP::C1G2TruncateAction_Do_Not_Truncate);
+            pFilter->setC1G2TagInventoryMask(pTagInventoryMask);
+
+            if (stateAware)
+            {
+                auto *pFilterAction = new LLRP::CC1G2TagInventoryStateAwareFilterAction();
+                pFilterAction->setTarget(LLRP::C1G2StateAwareTarget_SL);
+                pFilterAction->setAction(0 == i ? LLRP::C1G2StateAwareAction_AssertSLOrA_DeassertSLOrB
+                                                : LLRP::C1G2StateAwareAction_AssertSLOrA_Noop);
+                pFilter->setC1G2TagInventoryStateAwareFilterAction(pFilterAction);
+            }
+            else
+            {
+                auto *pFilterAction = new LLRP::CC1G2TagInventoryStateUnawareFilterAction();
+                pFilterAction->setAction(0 == i ? LLRP::C1G2StateUnawareAction_Select_Unselect
+                                                : LLRP::C1G2StateUnawareAction_Select_DoNothing);
+                pFilter->setC1G2TagInventoryStateUnawareFilterAction(pFilterAction);
+            }
+            pInventoryCommand->addC1G2Filter(pFilter);
+        }
+
+        if (CAntennaConfig::READER_DEFAULT != antenna.modeIndex)
+        {
+            auto *pRFControl = new LLRP::CC1G2RFControl();
+            pRFControl->setModeIndex(static_cast<LLRP::llrp_u16_t>(antenna.modeIndex));
+            pRFControl->setTari(antenna.tari);
+            pInventoryCommand->setC1G2RFControl(pRFControl);
+        }
+
+        /*
+         * SingulationControl has no optional fields, a session
+         * is needed to send any of it. Population and transit
+         * time fall back to 0, which means "unknown".
+         */
+
+        if (CAntennaConfig::READER_DEFAULT != antenna.session)
+        {
+            auto *pSingulationControl = new LLRP::CC1G2SingulationControl();
+            pSingulationControl->setSession(static_cast<LLRP::llrp_u2_t>(antenna.session));
+            pSingulationControl->setTagPopulation(CAntennaConfig::READER_DEFAULT == antenna.tagPopulation ?
+                                                  0 : static_cast<LLRP::llrp_u16_t>(antenna.tagPopulation));
+            pSingulationControl->setTagTransitTime(CAntennaConfig::READER_DEFAULT == antenna.tagTransitTimeMS ?
+                                                   0 : static_cast<LLRP::llrp_u32_t>(antenna.tagTransitTimeMS));
+
+            if (stateAware)
+            {
+                auto *pStateAwareAction = new LLRP::CC1G2TagInventoryStateAwareSingulationAction();
+                pStateAwareAction->setI(CAntennaConfig::TargetA == antenna.target ?
+                                        LLRP::C1G2TagInventoryStateAwareI_State_A :
+                                        LLRP::C1G2TagInventoryStateAwareI_State_B);
+                pStateAwareAction->setS(LLRP::C1G2TagInventoryStateAwareS_SL);
+                pSingulationControl->setC1G2TagInventoryStateAwareSingulationAction(pStateAwareAction);
+            }
+
+            pInventoryCommand->setC1G2SingulationControl(pSingulationControl);
+        }
+
+        return pInventoryCommand;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Compose the AntennaConfiguration that installs EPC filters
+ **
+ ** An InventoryCommand in the ROSpec replaces the one
+ ** SET_READER_CONFIG gave the antenna for as long as the ROSpec
+ ** runs, so it carries the antenna's session, target and mode
+ ** again, with the filters added. CAntennaConfig(0) is every
+ ** antenna left at its defaults.
+ **
+ *****************************************************************************/
+
+    LLRP::CAntennaConfiguration *CCommandFrames::makeFilterConfiguration(const CAntennaConfig &antenna,
+                                                                         const std::vector<CEpcFilter> &filters)
+    {
+        auto *pAntennaConfiguration = new LLRP::CAntennaConfiguration();
+        pAntennaConfiguration->setAntennaID(antenna.antennaId);
+        pAntennaConfiguration->addAirProtocolInventoryCommandSettings(makeInventoryCommand(antenna, filters));
+        return pAntennaConfiguration;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Compose the ADD_ROSPEC for a config
+ **
+ ** See CReader::addROSpec for the message this produces with the
+ ** default config. The parameters are owned by the message.
+ **
+ ** @throws     ReaderException if the config makes no sense
+ **
+ *****************************************************************************/
+
+    LLRP::CADD_ROSPEC *CCommandFrames::makeAddROSpec(const CROSpecConfig &config, const CReaderConfig &readerConfig)
+    {
+        if (0 == config.roSpecId)
+        {
+            throw ReaderException("ROSpec config: ROSpecID 0 is reserved");
+        }
+        if (0 == config.aiDurationMS)
+        {
+            throw ReaderException("ROSpec config: AISpec duration must not be 0");
+        }
+        if (config.antennaIds.empty())
+        {
+            throw ReaderException("ROSpec config: no antennas");
+        }
+        for (const auto &filter : config.epcFilters)
+        {
+            if (0 == filter.bits || filter.prefix.size() != (filter.bits + 7u) / 8u)
+            {
+                throw ReaderException("ROSpec config: bad EPC filter");
+            }
+        }
+
+        auto *pROSpecStartTrigger = new LLRP::CROSpecStartTrigger();
+        pROSpecStartTrigger->setROSpecStartTriggerType(LLRP::ROSpecStartTriggerType_Null);
+
+        auto *pROSpecStopTrigger = new LLRP::CROSpecStopTrigger();
+        pROSpecStopTrigger->setROSpecStopTriggerType(LLRP::ROSpecStopTriggerType_Null);
+        pROSpecStopTrigger->setDurationTriggerValue(0);     /* n/a */
+
+        auto *pROBoundarySpec = new LLRP::CROBoundarySpec();
+        pROBoundarySpec->setROSpecStartTrigger(pROSpecStartTrigger);
+        pROBoundarySpec->setROSpecStopTrigger(pROSpecStopTrigger);
+
+        auto *pAISpecStopTrigger = new LLRP::CAISpecStopTrigger();
+        pAISpecStopTrigger->setAISpecStopTriggerType(LLRP::AISpecStopTriggerType_Duration);
+        pAISpecStopTrigger->setDurationTrigger(config.aiDurationMS);
+
+        auto *pInventoryParameterSpec = new LLRP::CInventoryParameterSpec();
+        pInventoryParameterSpec->setInventoryParameterSpecID(config.inventoryParameterSpecId);
+        pInventoryParameterSpec->setProtocolID(LLRP::AirProtocols_EPCGlobalClass1Gen2);
+
+        /*
+         * Filters go to every antenna of the AISpec, each with the
+         * settings the reader config gives it and the reader's own
+         * where it gives none, or to all antennas (ID 0) when nothing
+         * is set up. An AISpec of all antennas can only name the ones
+         * the reader config sets up.
+         */
+
+        if (!config.epcFilters.empty() && readerConfig.antennas.empty())
+        {
+            pInventoryParameterSpec->addAntennaConfiguration(makeFilterConfiguration(CAntennaConfig(0), config.epcFilters));
+        }
+        else if (!config.epcFilters.empty() && std::vector<std::uint16_t>(1, 0) == config.antennaIds)
+        {
+            for (const auto &antenna : readerConfig.antennas)
+            {
+                pInventoryParameterSpec->addAntennaConfiguration(makeFilterConfiguration(antenna, config.epcFilters));
+            }
+        }
+        else if (!config.epcFilters.empty())
+        {
+            for (std::uint16_t antennaId : config.antennaIds)
+            {
+                CAntennaConfig antenna(antennaId);
+                for (const auto &configured : readerConfig.antennas)
+                {
+                    if (configured.antennaId == antennaId)
+                    {
+                        antenna = configured;
+                    }
+                }
+                pInventoryParameterSpec->addAntennaConfiguration(makeFilterConfiguration(antenna, config.epcFilters));
+            }
+        }
+
+        LLRP::llrp_u16v_t antennaIDs(static_cast<int>(config.antennaIds.size()));
+        for (std::size_t i = 0; i < config.antennaIds.size(); i++)
+        {
+            antennaIDs.m_pValue[i] = config.antennaIds[i];
+        }
+
+        auto *pAISpec = new LLRP::CAISpec();
+        pAISpec->setAntennaIDs(antennaIDs);
+        pAISpec->setAISpecStopTrigger(pAISpecStopTrigger);
+        pAISpec->addInventoryParameterSpec(pInventoryParameterSpec);
+
+        auto *pTagReportContentSelector = new LLRP::CTagReportContentSelector();
+        pTagReportContentSelector->setEnableROSpecID(FALSE);
+        pTagReportContentSelector->setEnableSpecIndex(FALSE);
+        pTagReportContentSelector->setEnableInventoryParameterSpecID(FALSE);
+        pTagReportContentSelector->setEnableAntennaID(config.enableAntennaId);
+        pTagReportContentSelector->setEnableChannelIndex(config.enableChannelIndex);
+        pTagReportContentSelector->setEnablePeakRSSI(config.enablePeakRSSI);
+        pTagReportContentSelector->setEnableFirstSeenTimestamp(config.enableFirstSeenTimestamp);
+        pTagReportContentSelector->setEnableLastSeenTimestamp(config.enableLastSeenTimestamp);
+        pTagReportContentSelector->setEnableTagSeenCount(config.enableTagSeenCount);
+        pTagReportContentSelector->setEnableAccessSpecID(FALSE);
+
+        auto *pROReportSpec = new LLRP::CROReportSpec();
+        pROReportSpec->setROReportTrigger(LLRP::ROReportTriggerType_Upon_N_Tags_Or_End_Of_ROSpec);
+        pROReportSpec->setN(config.reportN);
+        pROReportSpec->setTagReportContentSelector(pTagReportContentSelector);
+
+        auto *pROSpec = new LLRP::CROSpec();
+        pROSpec->setROSpecID(config.roSpecId);
+        pROSpec->setPriority(config.priority);
+        pROSpec->setCurrentState(LLRP::ROSpecState_Disabled);
+        pROSpec->setROBoundarySpec(pROBoundarySpec);
+        pROSpec->addSpecParameter(pAISpec);
+        pROSpec->setROReportSpec(pROReportSpec);
+
+        auto *command = new LLRP::CADD_ROSPEC();
+        command->setMessageID(0);
+        command->setROSpec(pROSpec);
+        return command;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Compose the SET_READER_CONFIG for a reader config
+ **
+ ** One AntennaConfiguration per configured antenna. Settings left
+ ** at READER_DEFAULT are not sent, e.g. with no transmit power
+ ** there is no RFTransmitter. The message is something like:
+ **
+ **     <SET_READER_CONFIG MessageID='n'>
+ **       <ResetToFactoryDefault>0</ResetToFactoryDefault>
+ **       <AntennaConfiguration>
+ **         <AntennaID>1</AntennaID>
+ **         <C1G2InventoryCommand>
+ **           <TagInventoryStateAware>0</TagInventoryStateAware>
+ **           <C1G2RFControl>
+ **             <ModeIndex>0</ModeIndex>
+ **             <Tari>0</Tari>
+ **           </C1G2RFControl>
+ **           <C1G2SingulationControl>
+ **             <Session>0</Session>
+ **             <TagPopulation>16</TagPopulation>
+ **             <TagTransitTime>120</TagTransitTime>
+ **           </C1G2SingulationControl>
+ **         </C1G2InventoryCommand>
+ **       </AntennaConfiguration>
+ **     </SET_READER_CONFIG>
+ **
+ ** plus a periodic KeepaliveSpec when there is a keepalive interval
+ ** and a ReaderEventNotificationSpec turning on ROSpecEvent when
+ ** notifyROSpecEvents is set.
+ **
+ ** @throws     ReaderException if the config is invalid
+ **
+ *****************************************************************************/
+
+    LLRP::CSET_READER_CONFIG *CCommandFrames::makeSetReaderConfig(const CReaderConfig &readerConfig)
+    {
+        readerConfig.validate();
+
+        std::unique_ptr<LLRP::CSET_READER_CONFIG> command(new LLRP::CSET_READER_CONFIG());
+        command->setMessageID(0);
+        command->setResetToFactoryDefault(0);
+
+        for (const auto &antenna : readerConfig.antennas)
+        {
+            auto *pAntennaConfiguration = new LLRP::CAntennaConfiguration();
+            pAntennaConfiguration->setAntennaID(antenna.antennaId);
+
+            if (CAntennaConfig::READER_DEFAULT != antenna.transmitPowerIndex)
+            {
+                auto *pRFTransmitter = new LLRP::CRFTransmitter();
+                pRFTransmitter->setHopTableID(antenna.hopTableId);
+                pRFTransmitter->setChannelIndex(antenna.channelIndex);
+                pRFTransmitter->setTransmitPower(static_cast<LLRP::llrp_u16_t>(antenna.transmitPowerIndex));
+                pAntennaConfiguration->setRFTransmitter(pRFTransmitter);
+            }
+
+            if (CAntennaConfig::READER_DEFAULT != antenna.receiverSensitivityIndex)
+            {
+                auto *pRFReceiver = new LLRP::CRFReceiver();
+                pRFReceiver->setReceiverSensitivity(static_cast<LLRP::llrp_u16_t>(antenna.receiverSensitivityIndex));
+                pAntennaConfiguration->setRFReceiver(pRFReceiver);
+            }
+
+            auto *pInventoryCommand = makeInventoryCommand(antenna, std::vector<CEpcFilter>());
+            pAntennaConfiguration->addAirProtocolInventoryCommandSettings(pInventoryCommand);
+            command->addAntennaConfiguration(pAntennaConfiguration);
+        }
+
+        if (0 != readerConfig.keepaliveIntervalMS)
+        {
+            auto *pKeepaliveSpec = new LLRP::CKeepaliveSpec();
+            pKeepaliveSpec->setKeepaliveTriggerType(LLRP::KeepaliveTriggerType_Periodic);
+            pKeepaliveSpec->setPeriodicTriggerValue(readerConfig.keepaliveIntervalMS);
+            command->setKeepaliveSpec(pKeepaliveSpec);
+        }
+
+        if (readerConfig.notifyROSpecEvents)
+        {
+            auto *pEventNotificationState = new LLRP::CEventNotificationState();
+            pEventNotificationState->setEventType(LLRP::NotificationEventType_ROSpec_Event);
+            pEventNotificationState->setNotificationState(TRUE);
+
+            auto *pReaderEventNotificationSpec = new LLRP::CReaderEventNotificationSpec();
+            pReaderEventNotificationSpec->addEventNotificationState(pEventNotificationState);
+            command->setReaderEventNotificationSpec(pReaderEventNotificationSpec);
+        }
+
+        return command.release();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Build and encode every command for a config
+ **
+ ** A ROSpec on all antennas (ID 0) is narrowed down to the
+ ** antennas the reader config sets up.
+ **
+ ** @throws     ReaderException if the config is invalid or
+ **             does not encode
+ **
+ *****************************************************************************/
+
+    CCommandFrames CCommandFrames::build(const CROSpecConfig &config, const CReaderConfig &readerConfig)
+    {
+        CCommandFrames frames;
+        frames.config = config;
+        frames.readerConfig = readerConfig;
+
+        LLRP::CSET_READER_CONFIG resetConfig;
+        resetConfig.setMessageID(0);
+        resetConfig.setResetToFactoryDefault(1);
+        frames.resetToFactoryDefaults = CCommandFrame::encode(&resetConfig);
+
+        if (!readerConfig.isFactoryDefault())
+        {
+            std::unique_ptr<LLRP::CSET_READER_CONFIG> setReaderConfig(makeSetReaderConfig(readerConfig));
+            frames.setReaderConfig = CCommandFrame::encode(setReaderConfig.get());
+        }
+
+        LLRP::CDELETE_ROSPEC deleteROSpec;
+        deleteROSpec.setMessageID(0);
+        deleteROSpec.setROSpecID(0);               /* All */
+        frames.deleteAllROSpecs = CCommandFrame::encode(&deleteROSpec);
+
+        CROSpecConfig roSpecConfig = config;
+        if (!readerConfig.antennas.empty() && std::vector<std::uint16_t>(1, 0) == roSpecConfig.antennaIds)
+        {
+            roSpecConfig.antennaIds = readerConfig.getAntennaIds();
+        }
+
+        std::unique_ptr<LLRP::CADD_ROSPEC> addROSpec(makeAddROSpec(roSpecConfig, readerConfig));
+        frames.addROSpec = CCommandFrame::encode(addROSpec.get());
+
+        LLRP::CENABLE_ROSPEC enableROSpec;
+        enableROSpec.setMessageID(0);
+        enableROSpec.setROSpecID(config.roSpecId);
+        frames.enableROSpec = CCommandFrame::encode(&enableROSpec);
+
+        LLRP::CSTART_ROSPEC startROSpec;
+        startROSpec.setMessageID(0);
+        startROSpec.setROSpecID(config.roSpecId);
+        frames.startROSpec = CCommandFrame::encode(&startROSpec);
+
+        return frames;
+    }
+}
@@ -0,0 +1,121 @@
+//********************************************************************
+//    created:    2026-10-18 03:05 PM
+//    file:       ccommandframe.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CCOMMANDFRAME_H
+#define LLRPLAPS_CCOMMANDFRAME_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <ltkcpp.h>
+#include "crospecconfig.h"
+#include "creaderconfig.h"
+
+namespace LLRPLaps
+{
+    /*
+     * An encoded LLRP command kept for reuse. Sending it again only
+     * needs a new message ID, which is patched into the header.
+     */
+    class CCommandFrame
+    {
+    public:
+        CCommandFrame() = default;
+
+        CCommandFrame(const unsigned char *bytes, std::size_t length) : _bytes(bytes, bytes + length)
+        {
+        }
+
+        template <std::size_t N>
+        explicit CCommandFrame(const std::array<unsigned char, N> &bytes) : _bytes(bytes.begin(), bytes.end())
+        {
+        }
+
+        static CCommandFrame encode(const LLRP::CMessage *message);
+
+        void setMessageId(std::uint32_t messageId);
+
+        std::uint32_t getMessageId() const;
+
+        unsigned int getMessageType() const;
+
+        const unsigned char *data() const { return _bytes.data(); }
+
+        unsigned int length() const { return static_cast<unsigned int>(_bytes.size()); }
+
+        bool empty() const { return _bytes.empty(); }
+
+        bool operator==(const CCommandFrame &other) const { return _bytes == other._bytes; }
+
+    private:
+        std::vector<unsigned char> _bytes;
+    };
+
+
+    /*
+     * Every command CReader sends to set up and run its ROSpec,
+     * encoded once. build() goes through LTK and validates the
+     * configs; fromStatic() copies the compile time frames of a
+     * CStaticROSpec and does not touch LTK at all.
+     *
+     * setReaderConfig is empty when the reader config is the
+     * factory default, the reader is then left alone.
+     */
+    class CCommandFrames
+    {
+    public:
+        static CCommandFrames build(const CROSpecConfig &config, const CReaderConfig &readerConfig = CReaderConfig());
+
+        template <class TStaticROSpec>
+        static CCommandFrames fromStatic()
+        {
+            CCommandFrames frames;
+            frames.config = TStaticROSpec::config();
+            frames.resetToFactoryDefaults = CCommandFrame(TStaticROSpec::RESET);
+            frames.deleteAllROSpecs = CCommandFrame(TStaticROSpec::DELETE_ALL);
+            frames.addROSpec = CCommandFrame(TStaticROSpec::ADD);
+            frames.enableROSpec = CCommandFrame(TStaticROSpec::ENABLE);
+            frames.startROSpec = CCommandFrame(TStaticROSpec::START);
+            return frames;
+        }
+
+        // Filters are installed per antenna of readerConfig, with that antenna's settings
+        static LLRP::CADD_ROSPEC *makeAddROSpec(const CROSpecConfig &config,
+                                                const CReaderConfig &readerConfig = CReaderConfig());
+
+        static LLRP::CSET_READER_CONFIG *makeSetReaderConfig(const CReaderConfig &readerConfig);
+
+        static LLRP::CC1G2InventoryCommand *makeInventoryCommand(const CAntennaConfig &antenna,
+                                                                 const std::vector<CEpcFilter> &filters);
+
+        static LLRP::CAntennaConfiguration *makeFilterConfiguration(const CAntennaConfig &antenna,
+                                                                    const std::vector<CEpcFilter> &filters);
+
+        CROSpecConfig config;
+        CReaderConfig readerConfig;
+        CCommandFrame resetToFactoryDefaults;
+        CCommandFrame setReaderConfig;
+        CCommandFrame deleteAllROSpecs;
+        CCommandFrame addROSpec;
+        CCommandFrame enableROSpec;
+        CCommandFrame startROSpec;
+    };
+}
+#endif //LLRPLAPS_CCOMMANDFRAME_H
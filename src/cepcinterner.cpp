@@ -0,0 +1,237 @@
+//********************************************************************
+//    created:    2026-10-19 03:20 AM
+//    file:       cepcinterner.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <cstring>
+
+#include "cepcinterner.h"
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    const std::size_t CEpcInterner::SEGMENT_SIZE = 4096;
+    const std::size_t CEpcInterner::MAX_SEGMENTS = 1024;
+    const std::size_t CEpcInterner::MAX_EPCS = SEGMENT_SIZE * MAX_SEGMENTS;
+
+    namespace
+    {
+        const std::size_t INITIAL_CAPACITY = 1024;
+
+        // FNV-1a, rider EPCs often differ in the last byte only
+        std::uint64_t hashOf(const unsigned char *epc, std::size_t length)
+        {
+            std::uint64_t hash = 14695981039346656037ULL;
+            for (std::size_t i = 0; i < length; i++)
+            {
+                hash = (hash ^ epc[i]) * 1099511628211ULL;
+            }
+            return hash;
+        }
+    }
+
+    CEpcInterner::CEpcInterner() : _segments(new std::atomic<CEntry *>[MAX_SEGMENTS]), _count(0)
+    {
+        for (std::size_t i = 0; i < MAX_SEGMENTS; i++)
+        {
+            _segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+        _table.store(newTable(INITIAL_CAPACITY, 0), std::memory_order_release);
+    }
+
+
+    CEpcInterner::~CEpcInterner()
+    {
+        for (std::size_t i = 0; i < MAX_SEGMENTS; i++)
+        {
+            delete[] _segments[i].load(std::memory_order_relaxed);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The id of epc, a new one on first sight
+ **
+ ** A miss in the table as loaded may only mean it grew or gained the
+ ** EPC meanwhile, so it is looked up again under the lock before an
+ ** id is handed out.
+ **
+ *****************************************************************************/
+
+    std::uint32_t CEpcInterner::intern(const unsigned char *epc, std::size_t length)
+    {
+        std::uint64_t hash = hashOf(epc, length);
+        std::uint32_t epcId = probe(*_table.load(std::memory_order_acquire), hash, epc, length);
+        if (CTagInfo::NO_EPC_ID != epcId)
+        {
+            return epcId;
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        CTable *table = _table.load(std::memory_order_relaxed);
+        epcId = probe(*table, hash, epc, length);
+        if (CTagInfo::NO_EPC_ID != epcId)
+        {
+            return epcId;
+        }
+
+        epcId = _count.load(std::memory_order_relaxed);
+        if (epcId >= MAX_EPCS)
+        {
+            return CTagInfo::NO_EPC_ID;
+        }
+
+        std::size_t segment = epcId / SEGMENT_SIZE;
+        if (nullptr == _segments[segment].load(std::memory_order_relaxed))
+        {
+            _segments[segment].store(new CEntry[SEGMENT_SIZE], std::memory_order_release);
+        }
+
+        static const char digits[] = "0123456789abcdef";
+        CEntry &created = _segments[segment].load(std::memory_order_relaxed)[epcId % SEGMENT_SIZE];
+        created.hash = hash;
+        created.epc.assign(epc, epc + length);
+        created.hex.reserve(2 * length);
+        for (std::size_t i = 0; i < length; i++)
+        {
+            created.hex.push_back(digits[epc[i] >> 4]);
+            created.hex.push_back(digits[epc[i] & 0x0f]);
+        }
+        created.hexDisplay = QString::fromLatin1(created.hex.c_str());
+        created.display.store(&created.hexDisplay, std::memory_order_relaxed);
+
+        /* Kept at most half full, a probe for an EPC not there ends soon */
+        if (2 * (static_cast<std::size_t>(epcId) + 1) > table->mask + 1)
+        {
+            table = newTable(2 * (table->mask + 1), epcId);
+            _table.store(table, std::memory_order_release);
+        }
+        /* Counted before it can be found, so getHex() and getDisplayName() of any id found are good */
+        _count.store(epcId + 1, std::memory_order_release);
+        place(*table, epcId, hash);
+        return epcId;
+    }
+
+
+    std::uint32_t CEpcInterner::find(const unsigned char *epc, std::size_t length) const
+    {
+        return probe(*_table.load(std::memory_order_acquire), hashOf(epc, length), epc, length);
+    }
+
+
+    std::uint32_t CEpcInterner::probe(const CTable &table, std::uint64_t hash, const unsigned char *epc,
+                                      std::size_t length) const
+    {
+        for (std::size_t i = hash & table.mask;; i = (i + 1) & table.mask)
+        {
+            std::uint32_t cell = table.cells[i].load(std::memory_order_acquire);
+            if (0 == cell)
+            {
+                return CTagInfo::NO_EPC_ID;
+            }
+
+            const CEntry *candidate = entry(cell - 1);
+            if (candidate->hash == hash && candidate->epc.size() == length &&
+                0 == std::memcmp(candidate->epc.data(), epc, length))
+            {
+                return cell - 1;
+            }
+        }
+    }
+
+
+    CEpcInterner::CTable *CEpcInterner::newTable(std::size_t capacity, std::uint32_t count)
+    {
+        std::unique_ptr<CTable> table(new CTable);
+        table->mask = capacity - 1;
+        table->cells.reset(new std::atomic<std::uint32_t>[capacity]);
+        for (std::size_t i = 0; i < capacity; i++)
+        {
+            table->cells[i].store(0, std::memory_order_relaxed);
+        }
+
+        for (std::uint32_t epcId = 0; epcId < count; epcId++)
+        {
+            place(*table, epcId, entry(epcId)->hash);
+        }
+
+        _tables.push_back(std::move(table));
+        return _tables.back().get();
+    }
+
+
+    void CEpcInterner::place(CTable &table, std::uint32_t epcId, std::uint64_t hash)
+    {
+        std::size_t i = hash & table.mask;
+        while (0 != table.cells[i].load(std::memory_order_relaxed))
+        {
+            i = (i + 1) & table.mask;
+        }
+        table.cells[i].store(epcId + 1, std::memory_order_release);
+    }
+
+
+    const CEpcInterner::CEntry *CEpcInterner::entry(std::uint32_t epcId) const
+    {
+        return _segments[epcId / SEGMENT_SIZE].load(std::memory_order_acquire) + (epcId % SEGMENT_SIZE);
+    }
+
+
+    const std::vector<unsigned char> &CEpcInterner::getEpc(std::uint32_t epcId) const
+    {
+        static const std::vector<unsigned char> none;
+        return (epcId < size()) ? entry(epcId)->epc : none;
+    }
+
+
+    const std::string &CEpcInterner::getHex(std::uint32_t epcId) const
+    {
+        static const std::string none;
+        return (epcId < size()) ? entry(epcId)->hex : none;
+    }
+
+
+    const QString &CEpcInterner::getDisplayName(std::uint32_t epcId) const
+    {
+        static const QString none;
+        return (epcId < size()) ? *entry(epcId)->display.load(std::memory_order_acquire) : none;
+    }
+
+
+    bool CEpcInterner::setDisplayName(const std::vector<unsigned char> &epc, const QString &name)
+    {
+        std::uint32_t epcId = intern(epc);
+        if (CTagInfo::NO_EPC_ID == epcId)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        CEntry *named = _segments[epcId / SEGMENT_SIZE].load(std::memory_order_relaxed) + (epcId % SEGMENT_SIZE);
+        if (name.isEmpty())
+        {
+            named->display.store(&named->hexDisplay, std::memory_order_release);
+        }
+        else if (*named->display.load(std::memory_order_relaxed) != name)
+        {
+            _names.emplace_back(new QString(name));
+            named->display.store(_names.back().get(), std::memory_order_release);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,122 @@
+//********************************************************************
+//    created:    2026-10-19 03:20 AM
+//    file:       cepcinterner.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CEPCINTERNER_H
+#define LLRPLAPS_CEPCINTERNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+namespace LLRPLaps
+{
+    /*
+     * Hands every distinct EPC a dense id, 0, 1, 2... in order of
+     * first sight, and keeps its hex and display strings so nothing
+     * downstream formats or compares EPC bytes again. The display
+     * string is the hex until a rider's name is set for the chip,
+     * see CLapDatabase::setEpcInterner().
+     *
+     * intern() of an EPC seen before is an open addressing probe that
+     * takes no lock: the table only ever gains ids and is replaced, not
+     * changed, when it grows. First sight takes the lock. Ids, the EPC
+     * bytes and the hex never change or move once handed out, so
+     * reading them takes no lock either. A new display name is a new
+     * string swapped in by pointer; the old one is kept until the
+     * interner goes, so a reference handed out stays good.
+     *
+     * Safe to use from any thread. Every reader feeding the same
+     * consumers has to share one interner for the ids to agree.
+     */
+    class CEpcInterner
+    {
+    public:
+        CEpcInterner();
+
+        ~CEpcInterner();
+
+        CEpcInterner(const CEpcInterner &) = delete;
+
+        CEpcInterner &operator=(const CEpcInterner &) = delete;
+
+        // CTagInfo::NO_EPC_ID once MAX_EPCS are taken
+        std::uint32_t intern(const unsigned char *epc, std::size_t length);
+
+        std::uint32_t intern(const std::vector<unsigned char> &epc) { return intern(epc.data(), epc.size()); }
+
+        // CTagInfo::NO_EPC_ID for an EPC never interned
+        std::uint32_t find(const unsigned char *epc, std::size_t length) const;
+
+        std::size_t size() const { return _count.load(std::memory_order_acquire); }
+
+        const std::vector<unsigned char> &getEpc(std::uint32_t epcId) const;
+
+        // Lower case, two digits a byte
+        const std::string &getHex(std::uint32_t epcId) const;
+
+        // The rider's name, or the hex as a QString made once when the EPC is interned
+        const QString &getDisplayName(std::uint32_t epcId) const;
+
+        // Interns epc if need be. An empty name goes back to the hex. false once MAX_EPCS are taken
+        bool setDisplayName(const std::vector<unsigned char> &epc, const QString &name);
+
+        const static std::size_t SEGMENT_SIZE;
+        const static std::size_t MAX_SEGMENTS;
+        const static std::size_t MAX_EPCS;
+
+    private:
+        struct CEntry
+        {
+            std::uint64_t hash;
+            std::vector<unsigned char> epc;
+            std::string hex;
+            QString hexDisplay;
+            std::atomic<const QString *> display;               // hexDisplay or one of _names
+        };
+
+        struct CTable
+        {
+            std::size_t mask;
+            std::unique_ptr<std::atomic<std::uint32_t>[]> cells;   // id + 1, 0 for an empty cell
+        };
+
+        const CEntry *entry(std::uint32_t epcId) const;
+
+        std::uint32_t probe(const CTable &table, std::uint64_t hash, const unsigned char *epc,
+                            std::size_t length) const;
+
+        CTable *newTable(std::size_t capacity, std::uint32_t count);
+
+        void place(CTable &table, std::uint32_t epcId, std::uint64_t hash);
+
+        std::atomic<CTable *> _table;
+        std::vector<std::unique_ptr<CTable>> _tables;           // current and outgrown, a reader may still be in one
+        std::unique_ptr<std::atomic<CEntry *>[]> _segments;
+        std::atomic<std::uint32_t> _count;
+        std::vector<std::unique_ptr<QString>> _names;           // every display name set, a reader may still hold one
+
+        std::mutex _lock;                                       // first sights and display names
+    };
+}
+#endif //LLRPLAPS_CEPCINTERNER_H
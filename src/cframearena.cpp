@@ -0,0 +1,105 @@
+//********************************************************************
+//    created:    2026-10-18 09:45 PM
+//    file:       cframearena.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cframearena.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace LLRPLaps
+{
+    // A burst of a few dozen reports while a command waits for its answer
+    const std::size_t CFrameArena::DEFAULT_CHUNK_SIZE = 64u * 1024u;
+
+    CFrameArena::CFrameArena(std::size_t chunkSize) : _chunkSize(chunkSize), _current(0), _used(0), _bytesInUse(0)
+    {
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Carve bytes out of the current chunk, moving on to the
+ **         next one, or a new one, when it is full
+ **
+ ** A request larger than the chunk size gets a chunk of its own.
+ ** Whatever is left at the end of a chunk that was passed over
+ ** stays unused until reset().
+ **
+ *****************************************************************************/
+
+    void *CFrameArena::allocate(std::size_t bytes, std::size_t alignment)
+    {
+        for (; _current < _chunks.size(); _current++, _used = 0)
+        {
+            Chunk &chunk = _chunks[_current];
+            auto base = reinterpret_cast<std::uintptr_t>(chunk.data.get());
+            std::size_t offset = ((base + _used + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1)) - base;
+
+            if (offset + bytes <= chunk.size)
+            {
+                _used = offset + bytes;
+                _bytesInUse += bytes;
+                return chunk.data.get() + offset;
+            }
+        }
+
+        /*
+         * new[] of unsigned char is aligned for any fundamental
+         * type, the start of a fresh chunk needs no padding.
+         */
+
+        Chunk chunk;
+        chunk.size = (bytes > _chunkSize) ? bytes : _chunkSize;
+        chunk.data.reset(new unsigned char[chunk.size]);
+        _chunks.push_back(std::move(chunk));
+
+        _current = _chunks.size() - 1;
+        _used = bytes;
+        _bytesInUse += bytes;
+        return _chunks[_current].data.get();
+    }
+
+
+    unsigned char *CFrameArena::copy(const unsigned char *data, std::size_t length)
+    {
+        auto *p = static_cast<unsigned char *>(allocate(length, 1));
+        std::memcpy(p, data, length);
+        return p;
+    }
+
+
+    void CFrameArena::reset()
+    {
+        _current = 0;
+        _used = 0;
+        _bytesInUse = 0;
+    }
+
+
+    std::size_t CFrameArena::getCapacity() const
+    {
+        std::size_t capacity = 0;
+
+        for (const auto &chunk : _chunks)
+        {
+            capacity += chunk.size;
+        }
+        return capacity;
+    }
+}
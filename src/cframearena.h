@@ -0,0 +1,72 @@
+//********************************************************************
+//    created:    2026-10-18 09:45 PM
+//    file:       cframearena.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CFRAMEARENA_H
+#define LLRPLAPS_CFRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * Bump allocator for data that lives exactly as long as a batch
+     * of frames. Nothing is freed on its own, reset() releases it all
+     * at once and keeps the chunks, so once the arena has grown to
+     * the largest burst seen it never goes to the heap again.
+     *
+     * Only for trivially destructible data, nothing is destroyed.
+     */
+    class CFrameArena
+    {
+    public:
+        explicit CFrameArena(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+        CFrameArena(const CFrameArena &) = delete;
+
+        CFrameArena &operator=(const CFrameArena &) = delete;
+
+        void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+        unsigned char *copy(const unsigned char *data, std::size_t length);
+
+        void reset();
+
+        std::size_t getBytesInUse() const { return _bytesInUse; }
+
+        std::size_t getCapacity() const;
+
+        const static std::size_t DEFAULT_CHUNK_SIZE;
+
+    private:
+        struct Chunk
+        {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        std::size_t _chunkSize;
+        std::vector<Chunk> _chunks;
+        std::size_t _current;
+        std::size_t _used;
+        std::size_t _bytesInUse;
+    };
+}
+#endif //LLRPLAPS_CFRAMEARENA_H
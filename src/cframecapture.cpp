@@ -0,0 +1,146 @@
+//********************************************************************
+//    created:    2026-10-18 11:40 AM
+//    file:       cframecapture.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cframecapture.h"
+
+namespace LLRPLaps
+{
+    const char CFrameCapture::MAGIC[8] = { 'L', 'L', 'R', 'P', 'C', 'A', 'P', '\0' };
+    const char CFrameCapture::INDEX_MAGIC[8] = { 'L', 'L', 'R', 'P', 'I', 'D', 'X', '\0' };
+    const std::uint32_t CFrameCapture::VERSION = 1;
+    const unsigned int CFrameCapture::HEADER_SIZE = 16;
+    const unsigned int CFrameCapture::RECORD_HEADER_SIZE = 16;
+    const unsigned int CFrameCapture::FOOTER_SIZE = 24;
+
+    namespace
+    {
+        // Capture writes are small and frequent, let stdio batch them
+        const std::size_t WRITE_BUFFER_SIZE = 256u * 1024u;
+
+        void putU32(unsigned char *p, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void putU64(unsigned char *p, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+    }
+
+    CFrameCapture::CFrameCapture() : _file(nullptr), _offset(0)
+    {
+    }
+
+
+    CFrameCapture::~CFrameCapture()
+    {
+        close();
+    }
+
+
+    bool CFrameCapture::open(const std::string &path)
+    {
+        close();
+
+        _file = std::fopen(path.c_str(), "wb");
+        if (nullptr == _file)
+        {
+            return false;
+        }
+        std::setvbuf(_file, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+
+        unsigned char header[HEADER_SIZE];
+        for (int i = 0; i < 8; i++)
+        {
+            header[i] = static_cast<unsigned char>(MAGIC[i]);
+        }
+        putU32(header + 8, VERSION);
+        putU32(header + 12, 0);
+
+        std::fwrite(header, 1, sizeof header, _file);
+        _offset = HEADER_SIZE;
+        _index.clear();
+        return true;
+    }
+
+
+    void CFrameCapture::write(Direction direction, std::uint64_t hostNSec, const unsigned char *frame, unsigned int length)
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        unsigned char recordHeader[RECORD_HEADER_SIZE] = { 0 };
+        putU64(recordHeader, hostNSec);
+        putU32(recordHeader + 8, length);
+        recordHeader[12] = static_cast<unsigned char>(direction);
+
+        std::fwrite(recordHeader, 1, sizeof recordHeader, _file);
+        std::fwrite(frame, 1, length, _file);
+
+        _index.push_back(_offset);
+        _offset += RECORD_HEADER_SIZE + length;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Write the index and footer and close the file
+ **
+ *****************************************************************************/
+
+    void CFrameCapture::close()
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        unsigned char value[8];
+        std::uint64_t indexOffset = _offset;
+
+        for (auto recordOffset : _index)
+        {
+            putU64(value, recordOffset);
+            std::fwrite(value, 1, sizeof value, _file);
+        }
+
+        unsigned char footer[FOOTER_SIZE];
+        putU64(footer, indexOffset);
+        putU64(footer + 8, _index.size());
+        for (int i = 0; i < 8; i++)
+        {
+            footer[16 + i] = static_cast<unsigned char>(INDEX_MAGIC[i]);
+        }
+        std::fwrite(footer, 1, sizeof footer, _file);
+
+        std::fclose(_file);
+        _file = nullptr;
+        _index.clear();
+        _offset = 0;
+    }
+}
@@ -0,0 +1,79 @@
+//********************************************************************
+//    created:    2026-10-18 11:40 AM
+//    file:       cframecapture.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CFRAMECAPTURE_H
+#define LLRPLAPS_CFRAMECAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * Writes raw LLRP frames to a capture file. All integers are
+     * little endian, frames are stored exactly as on the wire.
+     *
+     *  header   "LLRPCAP\0", u32 version, u32 reserved
+     *  record   u64 host monotonic ns, u32 frame length, u8 direction,
+     *           3 reserved bytes, frame bytes
+     *  index    u64 file offset of every record          (written by close)
+     *  footer   u64 index offset, u64 record count, "LLRPIDX\0"
+     *
+     * A capture cut short by a crash has no index or footer, the
+     * reader rebuilds the index by walking the records.
+     */
+    class CFrameCapture
+    {
+    public:
+        enum Direction
+        {
+            Inbound = 0,        // reader to host
+            Outbound = 1        // host to reader
+        };
+
+        CFrameCapture();
+
+        ~CFrameCapture();
+
+        bool open(const std::string &path);
+
+        void close();
+
+        bool isOpen() const { return nullptr != _file; }
+
+        void write(Direction direction, std::uint64_t hostNSec, const unsigned char *frame, unsigned int length);
+
+        std::uint64_t getRecordCount() const { return _index.size(); }
+
+        static const char MAGIC[8];
+        static const char INDEX_MAGIC[8];
+        static const std::uint32_t VERSION;
+        static const unsigned int HEADER_SIZE;
+        static const unsigned int RECORD_HEADER_SIZE;
+        static const unsigned int FOOTER_SIZE;
+
+    private:
+        std::FILE *_file;
+        std::uint64_t _offset;
+        std::vector<std::uint64_t> _index;
+    };
+}
+#endif //LLRPLAPS_CFRAMECAPTURE_H
@@ -0,0 +1,177 @@
+//********************************************************************
+//    created:    2026-10-18 12:05 PM
+//    file:       cframecapturereader.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cframecapturereader.h"
+#include "cframecapture.h"
+
+#include <cstring>
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::uint64_t getU64(const unsigned char *p)
+        {
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+    }
+
+    CFrameCaptureReader::CFrameCaptureReader() : _data(nullptr), _size(0), _index(nullptr), _recordCount(0)
+    {
+    }
+
+
+    CFrameCaptureReader::~CFrameCaptureReader()
+    {
+        close();
+    }
+
+
+    void CFrameCaptureReader::close()
+    {
+        if (nullptr != _data)
+        {
+            _file.unmap(const_cast<uchar *>(_data));
+        }
+        _file.close();
+        _data = nullptr;
+        _size = 0;
+        _index = nullptr;
+        _rebuiltIndex.clear();
+        _recordCount = 0;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Map a capture file and locate its index
+ **
+ ** The mapping is private so the LTK decoder, which wants a non
+ ** const buffer, can be handed record bytes directly.
+ **
+ *****************************************************************************/
+
+    bool CFrameCaptureReader::open(const QString &path)
+    {
+        close();
+
+        _file.setFileName(path);
+        if (!_file.open(QIODevice::ReadOnly))
+        {
+            _errorString = _file.errorString();
+            return false;
+        }
+
+        _size = static_cast<std::uint64_t>(_file.size());
+        if (_size < CFrameCapture::HEADER_SIZE)
+        {
+            _errorString = "Not a capture file: too short";
+            close();
+            return false;
+        }
+
+        _data = _file.map(0, _file.size(), QFileDevice::MapPrivateOption);
+        if (nullptr == _data)
+        {
+            _errorString = _file.errorString();
+            close();
+            return false;
+        }
+
+        if (0 != std::memcmp(_data, CFrameCapture::MAGIC, sizeof CFrameCapture::MAGIC) ||
+            CFrameCapture::VERSION != getU32(_data + 8))
+        {
+            _errorString = "Not a capture file: bad header";
+            close();
+            return false;
+        }
+
+        /*
+         * A cleanly closed capture ends with a footer that points at
+         * the record index. Anything else gets its index rebuilt.
+         */
+
+        if (_size >= CFrameCapture::HEADER_SIZE + CFrameCapture::FOOTER_SIZE)
+        {
+            const unsigned char *footer = _data + _size - CFrameCapture::FOOTER_SIZE;
+            std::uint64_t indexOffset = getU64(footer);
+            std::uint64_t recordCount = getU64(footer + 8);
+
+            if (0 == std::memcmp(footer + 16, CFrameCapture::INDEX_MAGIC, sizeof CFrameCapture::INDEX_MAGIC) &&
+                indexOffset + recordCount * 8u + CFrameCapture::FOOTER_SIZE == _size)
+            {
+                _index = _data + indexOffset;
+                _recordCount = static_cast<std::size_t>(recordCount);
+                return true;
+            }
+        }
+
+        return rebuildIndex();
+    }
+
+
+    bool CFrameCaptureReader::rebuildIndex()
+    {
+        std::uint64_t offset = CFrameCapture::HEADER_SIZE;
+
+        while (offset + CFrameCapture::RECORD_HEADER_SIZE <= _size)
+        {
+            std::uint32_t length = getU32(_data + offset + 8);
+            if (offset + CFrameCapture::RECORD_HEADER_SIZE + length > _size)
+            {
+                // Torn final record, the process died mid write
+                break;
+            }
+            _rebuiltIndex.push_back(offset);
+            offset += CFrameCapture::RECORD_HEADER_SIZE + length;
+        }
+
+        _recordCount = _rebuiltIndex.size();
+        return true;
+    }
+
+
+    CFrameCaptureReader::Record CFrameCaptureReader::getRecord(std::size_t i) const
+    {
+        std::uint64_t offset = (nullptr != _index) ? getU64(_index + i * 8u) : _rebuiltIndex[i];
+        const unsigned char *recordHeader = _data + offset;
+
+        Record record;
+        record.hostNSec = getU64(recordHeader);
+        record.length = getU32(recordHeader + 8);
+        record.direction = recordHeader[12];
+        record.frame = recordHeader + CFrameCapture::RECORD_HEADER_SIZE;
+        return record;
+    }
+}
@@ -0,0 +1,76 @@
+//********************************************************************
+//    created:    2026-10-18 12:05 PM
+//    file:       cframecapturereader.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CFRAMECAPTUREREADER_H
+#define LLRPLAPS_CFRAMECAPTUREREADER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+namespace LLRPLaps
+{
+    /*
+     * Read only view of a CFrameCapture file. The file is memory
+     * mapped and records point straight into the mapping, so any
+     * number of threads can decode records concurrently.
+     */
+    class CFrameCaptureReader
+    {
+    public:
+        struct Record
+        {
+            std::uint64_t hostNSec;
+            unsigned int direction;         // CFrameCapture::Direction
+            const unsigned char *frame;
+            unsigned int length;
+        };
+
+        CFrameCaptureReader();
+
+        ~CFrameCaptureReader();
+
+        bool open(const QString &path);
+
+        void close();
+
+        const QString &getErrorString() const { return _errorString; }
+
+        std::size_t getRecordCount() const { return _recordCount; }
+
+        // False if the capture was not closed cleanly and the index was rebuilt
+        bool hasIndex() const { return nullptr != _index; }
+
+        Record getRecord(std::size_t i) const;
+
+    private:
+        bool rebuildIndex();
+
+        QFile _file;
+        const unsigned char *_data;
+        std::uint64_t _size;
+        const unsigned char *_index;
+        std::vector<std::uint64_t> _rebuiltIndex;
+        std::size_t _recordCount;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CFRAMECAPTUREREADER_H
@@ -0,0 +1,289 @@
+//********************************************************************
+//    created:    2026-10-19 02:50 AM
+//    file:       clapaggregates.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include "clapaggregates.h"
+#include "clapdatabase.h"
+
+namespace LLRPLaps
+{
+    void CLapAggregates::CStats::add(const CLapInfo &lap)
+    {
+        if (0 == laps || lap.lapTimeUSec < bestLapUSec)
+        {
+            bestLapUSec = lap.lapTimeUSec;
+        }
+        if (0 == laps || lap.crossingUSec < firstCrossingUSec)
+        {
+            firstCrossingUSec = lap.crossingUSec;
+        }
+        lastCrossingUSec = std::max(lastCrossingUSec, lap.crossingUSec);
+        totalLapUSec += lap.lapTimeUSec;
+        laps++;
+    }
+
+
+    CLapAggregates::CLapAggregates(CLapDatabase &database) : _database(database), _periodVersions(), _lastLapId(0)
+    {
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Build every rollup from the database
+ **
+ ** Versions carry on from where they were so nothing cached before
+ ** the reload is mistaken for current.
+ **
+ *****************************************************************************/
+
+    bool CLapAggregates::load()
+    {
+        std::map<qint64, std::uint64_t> versions;
+        for (const auto &entry : _riders)
+        {
+            versions[entry.first] = entry.second.version;
+        }
+        _riders.clear();
+        _sessionNames.clear();
+        _unassigned.clear();
+        _lastLapId = 0;
+
+        QSqlQuery query(_database.getReader());
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT id, name FROM riders"))
+        {
+            _errorString = query.lastError().text();
+            return false;
+        }
+        while (query.next())
+        {
+            qint64 riderId = query.value(0).toLongLong();
+            CRider &entry = _riders[riderId];
+            entry.name = query.value(1).toString();
+            entry.version = versions[riderId] + 1;
+        }
+
+        for (std::uint64_t &version : _periodVersions)
+        {
+            version++;
+        }
+        return update();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Count the laps stored since last time
+ **
+ ** A range scan of the laps primary key from the last id seen, one
+ ** query however many laps landed. Laps of chips with no rider are
+ ** set aside until their chip has one.
+ **
+ *****************************************************************************/
+
+    bool CLapAggregates::update()
+    {
+        QSqlQuery query(_database.getReader());
+        query.setForwardOnly(true);
+        query.prepare("SELECT l.id, c.rider_id, l.session_id, l.lap_number, l.crossing_usec, l.lap_time_usec, l.epc "
+                      "FROM laps l LEFT JOIN chips c ON c.epc = l.epc WHERE l.id > ? ORDER BY l.id");
+        query.addBindValue(_lastLapId);
+        if (!query.exec())
+        {
+            _errorString = query.lastError().text();
+            return false;
+        }
+
+        while (query.next())
+        {
+            _lastLapId = query.value(0).toLongLong();
+            qint64 riderId = query.value(1).toLongLong();
+            if (0 == riderId)
+            {
+                _unassigned[query.value(6).toByteArray()].push_back(_lastLapId);
+                continue;
+            }
+
+            CLapInfo lap;
+            lap.lapNumber = query.value(3).toInt();
+            lap.crossingUSec = static_cast<u_int64_t>(query.value(4).toLongLong());
+            lap.lapTimeUSec = static_cast<u_int64_t>(query.value(5).toLongLong());
+            addLap(riderId, query.value(2).toLongLong(), lap);
+        }
+        return resolveUnassigned();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Count the laps set aside once their chip has a rider
+ **
+ ** Only while there are some: one look at the chips, then the laps
+ ** of the chips given a rider by their ids.
+ **
+ *****************************************************************************/
+
+    bool CLapAggregates::resolveUnassigned()
+    {
+        if (_unassigned.empty())
+        {
+            return true;
+        }
+
+        QSqlQuery chips(_database.getReader());
+        chips.setForwardOnly(true);
+        if (!chips.exec("SELECT epc, rider_id FROM chips"))
+        {
+            _errorString = chips.lastError().text();
+            return false;
+        }
+
+        std::vector<std::pair<qint64, std::vector<qint64>>> assigned;
+        while (chips.next())
+        {
+            auto chip = _unassigned.find(chips.value(0).toByteArray());
+            if (_unassigned.end() != chip)
+            {
+                assigned.emplace_back(chips.value(1).toLongLong(), std::move(chip->second));
+                _unassigned.erase(chip);
+            }
+        }
+
+        QSqlQuery query(_database.getReader());
+        query.prepare("SELECT session_id, lap_number, crossing_usec, lap_time_usec FROM laps WHERE id = ?");
+        for (const auto &chip : assigned)
+        {
+            for (qint64 lapId : chip.second)
+            {
+                query.bindValue(0, lapId);
+                if (!query.exec())
+                {
+                    _errorString = query.lastError().text();
+                    return false;
+                }
+                if (query.next())
+                {
+                    CLapInfo lap;
+                    lap.lapNumber = query.value(1).toInt();
+                    lap.crossingUSec = static_cast<u_int64_t>(query.value(2).toLongLong());
+                    lap.lapTimeUSec = static_cast<u_int64_t>(query.value(3).toLongLong());
+                    addLap(chip.first, query.value(0).toLongLong(), lap);
+                }
+            }
+        }
+        return true;
+    }
+
+
+    void CLapAggregates::addLap(qint64 riderId, qint64 sessionId, const CLapInfo &lap)
+    {
+        CRider &entry = rider(riderId);
+        entry.sessions[sessionId].add(lap);
+
+        QDate date = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(lap.crossingUSec / 1000)).date();
+        for (int period = 0; period < PeriodCount; period++)
+        {
+            entry.periods[period][periodKey(static_cast<Period>(period), date)].add(lap);
+            _periodVersions[period]++;
+        }
+        entry.version++;
+    }
+
+
+    CLapAggregates::CRider &CLapAggregates::rider(qint64 riderId)
+    {
+        CRider &entry = _riders[riderId];
+        if (entry.name.isEmpty())
+        {
+            QSqlQuery query(_database.getReader());
+            query.prepare("SELECT name FROM riders WHERE id = ?");
+            query.addBindValue(riderId);
+            if (query.exec() && query.next())
+            {
+                entry.name = query.value(0).toString();
+            }
+        }
+        return entry;
+    }
+
+
+    const CLapAggregates::CRider *CLapAggregates::getRider(qint64 riderId) const
+    {
+        auto entry = _riders.find(riderId);
+        return (_riders.end() != entry) ? &entry->second : nullptr;
+    }
+
+
+    QString CLapAggregates::getSessionName(qint64 sessionId)
+    {
+        auto name = _sessionNames.find(sessionId);
+        if (_sessionNames.end() != name)
+        {
+            return name->second;
+        }
+
+        QSqlQuery query(_database.getReader());
+        query.prepare("SELECT name FROM sessions WHERE id = ?");
+        query.addBindValue(sessionId);
+        if (query.exec() && query.next())
+        {
+            return _sessionNames[sessionId] = query.value(0).toString();
+        }
+        return QString();
+    }
+
+
+    qint64 CLapAggregates::periodKey(Period period, const QDate &date)
+    {
+        switch (period)
+        {
+            case Day:
+                return date.toJulianDay();
+
+            case Week:
+                return date.addDays(1 - date.dayOfWeek()).toJulianDay();
+
+            case Month:
+                return QDate(date.year(), date.month(), 1).toJulianDay();
+
+            case Year:
+                return QDate(date.year(), 1, 1).toJulianDay();
+
+            case All:
+            default:
+                return 0;
+        }
+    }
+
+
+    const char *CLapAggregates::periodName(Period period)
+    {
+        static const char *names[PeriodCount] = { "day", "week", "month", "year", "all" };
+        return (period >= 0 && period < PeriodCount) ? names[period] : "";
+    }
+}
@@ -0,0 +1,125 @@
+//********************************************************************
+//    created:    2026-10-19 02:50 AM
+//    file:       clapaggregates.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPAGGREGATES_H
+#define LLRPLAPS_CLAPAGGREGATES_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QDate>
+#include <QString>
+
+#include "clapinfo.h"
+
+namespace LLRPLaps
+{
+    class CLapDatabase;
+
+    /*
+     * Per rider rollups of the laps in a CLapDatabase: one per session
+     * and one per day, week, month, year and all time, so a rider's
+     * history or a leaderboard is a lookup rather than a scan of the
+     * laps. load() builds them once, update() then only reads the laps
+     * stored since, by their id, from this process's CLapDatabase or
+     * another's.
+     *
+     * Every rider and every period has a version that moves on with
+     * each lap counted into it, for the caches and ETags of whatever
+     * serves them. Days are local days, weeks start on Monday.
+     *
+     * Laps count for the rider their chip belonged to when they were
+     * read in; load() again after chips change hands. Laps of a chip
+     * with no rider yet are kept by id and count for the first rider
+     * it is given. Lives in the thread that opened the database.
+     */
+    class CLapAggregates
+    {
+    public:
+        enum Period
+        {
+            Day,
+            Week,
+            Month,
+            Year,
+            All,
+            PeriodCount
+        };
+
+        struct CStats
+        {
+            int laps = 0;
+            u_int64_t bestLapUSec = 0;
+            u_int64_t totalLapUSec = 0;
+            u_int64_t firstCrossingUSec = 0;
+            u_int64_t lastCrossingUSec = 0;
+
+            void add(const CLapInfo &lap);
+        };
+
+        struct CRider
+        {
+            QString name;
+            std::uint64_t version = 0;
+            std::map<qint64, CStats> sessions;
+            // Keyed by the Julian day the period starts on, 0 for All
+            std::map<qint64, CStats> periods[PeriodCount];
+        };
+
+        explicit CLapAggregates(CLapDatabase &database);
+
+        bool load();
+
+        // Counts the laps stored since the last load() or update()
+        bool update();
+
+        const QString &getErrorString() const { return _errorString; }
+
+        const CRider *getRider(qint64 riderId) const;
+
+        const std::map<qint64, CRider> &getRiders() const { return _riders; }
+
+        std::uint64_t getPeriodVersion(Period period) const { return _periodVersions[period]; }
+
+        QString getSessionName(qint64 sessionId);
+
+        static qint64 periodKey(Period period, const QDate &date);
+
+        static const char *periodName(Period period);
+
+    private:
+        void addLap(qint64 riderId, qint64 sessionId, const CLapInfo &lap);
+
+        // Counts the laps of chips given a rider since they were read in
+        bool resolveUnassigned();
+
+        CRider &rider(qint64 riderId);
+
+        CLapDatabase &_database;
+        std::map<qint64, CRider> _riders;
+        std::map<qint64, QString> _sessionNames;
+        std::map<QByteArray, std::vector<qint64>> _unassigned;    // lap ids by chip, of chips with no rider
+        std::uint64_t _periodVersions[PeriodCount];
+        qint64 _lastLapId;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CLAPAGGREGATES_H
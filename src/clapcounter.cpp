@@ -0,0 +1,370 @@
+//********************************************************************
+//    created:    2026-10-18 10:20 AM
+//    file:       clapcounter.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstdint>
+
+#include "clapcounter.h"
+#include "clatencyrecorder.h"
+#include "ctagjournal.h"
+
+namespace
+{
+    /* Riders are watched with a pointer to their map entry as the cookie */
+    const std::uint64_t SESSION_END_COOKIE = 0;
+
+    /* u8 EPC length, u64 last crossing, u64 last seen, u32 laps, then the EPC */
+    const std::size_t RIDER_STATE_SIZE = 21;
+
+    void putU32(unsigned char *p, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    void putU64(unsigned char *p, std::uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    std::uint32_t getU32(const unsigned char *p)
+    {
+        std::uint32_t value = 0;
+        for (int i = 3; i >= 0; i--)
+        {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+
+    std::uint64_t getU64(const unsigned char *p)
+    {
+        std::uint64_t value = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+}
+
+namespace LLRPLaps
+{
+    const u_int64_t CLapCounter::DEFAULT_MIN_LAP_USEC = 10000000ULL;
+    const u_int64_t CLapCounter::DEFAULT_OFF_TRACK_USEC = 5 * 60000000ULL;
+
+    CLapCounter::CLapCounter(u_int64_t minLapUSec, QObject *parent) : QObject(parent), _minLapUSec(minLapUSec),
+                                                                      _offTrackUSec(DEFAULT_OFF_TRACK_USEC),
+                                                                      _latencyRecorder(nullptr), _journal(nullptr),
+                                                                      _sessionEndTimer(CTimingWheel::NO_TIMER)
+    {
+    }
+
+
+    int CLapCounter::getLapCount(const std::vector<unsigned char> &epc) const
+    {
+        auto rider = _riders.find(epc);
+        return (_riders.end() == rider) ? 0 : rider->second.laps;
+    }
+
+
+    void CLapCounter::clear()
+    {
+        _timers.clear();
+        _sessionEndTimer = CTimingWheel::NO_TIMER;
+        _riders.clear();
+        _byEpcId.clear();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Write every rider in a compact little endian form
+ **
+ ** u32 rider count, then per rider u8 EPC length, u64 last crossing,
+ ** u64 last seen, u32 laps and the EPC. A few kilobytes for a full
+ ** track, quick enough to take between two tag reads.
+ **
+ *****************************************************************************/
+
+    void CLapCounter::saveState(std::vector<unsigned char> &state) const
+    {
+        state.clear();
+        state.resize(4);
+        putU32(state.data(), static_cast<std::uint32_t>(_riders.size()));
+
+        for (const auto &rider : _riders)
+        {
+            std::size_t epcLength = std::min<std::size_t>(rider.first.size(), 255);
+            std::size_t at = state.size();
+            state.resize(at + RIDER_STATE_SIZE + epcLength);
+
+            unsigned char *p = state.data() + at;
+            p[0] = static_cast<unsigned char>(epcLength);
+            putU64(p + 1, rider.second.lastCrossingUSec);
+            putU64(p + 9, rider.second.lastSeenUSec);
+            putU32(p + 17, static_cast<std::uint32_t>(rider.second.laps));
+            std::copy(rider.first.begin(), rider.first.begin() + epcLength, p + RIDER_STATE_SIZE);
+        }
+    }
+
+
+    bool CLapCounter::loadState(const unsigned char *state, std::size_t size)
+    {
+        clear();
+
+        if (size < 4)
+        {
+            return false;
+        }
+
+        std::uint32_t riders = getU32(state);
+        std::size_t at = 4;
+
+        for (std::uint32_t i = 0; i < riders; i++)
+        {
+            if (at + RIDER_STATE_SIZE > size || at + RIDER_STATE_SIZE + state[at] > size)
+            {
+                clear();
+                return false;
+            }
+
+            const unsigned char *p = state + at;
+            std::vector<unsigned char> epc(p + RIDER_STATE_SIZE, p + RIDER_STATE_SIZE + p[0]);
+
+            RiderState riderState;
+            riderState.lastCrossingUSec = getU64(p + 1);
+            riderState.lastSeenUSec = getU64(p + 9);
+            riderState.offTrackTimer = CTimingWheel::NO_TIMER;
+            riderState.laps = static_cast<int>(getU32(p + 17));
+            watchRider(*_riders.insert(std::make_pair(std::move(epc), riderState)).first);
+
+            at += RIDER_STATE_SIZE + p[0];
+        }
+        return true;
+    }
+
+
+    void CLapCounter::setSessionEndUSec(u_int64_t endUSec)
+    {
+        _timers.cancel(_sessionEndTimer);
+        _sessionEndTimer = _timers.arm(endUSec, SESSION_END_COOKIE);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The rider a read is of, by epc id when it has one
+ **
+ ** An id not indexed yet is looked up by EPC once, which finds riders
+ ** loaded from a checkpoint or first read without an id.
+ **
+ *****************************************************************************/
+
+    CLapCounter::RiderMap::value_type *CLapCounter::findRider(const CTagInfo &tagInfo)
+    {
+        std::uint32_t epcId = tagInfo.getEpcId();
+        if (CTagInfo::NO_EPC_ID != epcId)
+        {
+            if (epcId >= _byEpcId.size())
+            {
+                _byEpcId.resize(epcId + 1, nullptr);
+            }
+            if (nullptr != _byEpcId[epcId])
+            {
+                return _byEpcId[epcId];
+            }
+        }
+
+        auto rider = _riders.find(tagInfo.data);
+        if (_riders.end() == rider)
+        {
+            return nullptr;
+        }
+
+        if (CTagInfo::NO_EPC_ID != epcId)
+        {
+            _byEpcId[epcId] = &*rider;
+        }
+        return &*rider;
+    }
+
+
+    void CLapCounter::watchRider(RiderMap::value_type &rider)
+    {
+        RiderState &state = rider.second;
+
+        if ((0 == _offTrackUSec) || (CTimingWheel::NO_TIMER != state.offTrackTimer))
+        {
+            return;
+        }
+
+        auto cookie = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&rider));
+        state.offTrackTimer = _timers.arm(state.lastSeenUSec + _offTrackUSec, cookie);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Move the timers on to the time given and act on those expired
+ **
+ ** A read does not move its rider's timer, that would be a cancel and
+ ** an arm for every read of every pass. The timer goes off at the
+ ** off track time after the read that armed it and is armed again
+ ** from the last read if there has been one since, so a rider on
+ ** track costs one timer per off track time.
+ **
+ ** Signals go out once every timer has been dealt with, their slots
+ ** are free to call clear().
+ **
+ *****************************************************************************/
+
+    void CLapCounter::advanceTo(u_int64_t nowUSec)
+    {
+        if (nowUSec < _timers.getNowUSec())
+        {
+            return;
+        }
+
+        _expired.clear();
+        _timers.advance(nowUSec, _expired);
+
+        if (_expired.empty())
+        {
+            return;
+        }
+
+        std::vector<std::pair<std::vector<unsigned char>, u_int64_t>> offTrack;
+        bool sessionEnded = false;
+        u_int64_t sessionEndUSec = 0;
+
+        for (const CTimingWheel::Expired &timer : _expired)
+        {
+            if (SESSION_END_COOKIE == timer.cookie)
+            {
+                _sessionEndTimer = CTimingWheel::NO_TIMER;
+                sessionEnded = true;
+                sessionEndUSec = timer.expiryUSec;
+                continue;
+            }
+
+            auto rider = reinterpret_cast<RiderMap::value_type *>(static_cast<std::uintptr_t>(timer.cookie));
+            RiderState &state = rider->second;
+            state.offTrackTimer = CTimingWheel::NO_TIMER;
+
+            if (state.lastSeenUSec + _offTrackUSec > nowUSec)
+            {
+                watchRider(*rider);
+            }
+            else
+            {
+                offTrack.emplace_back(rider->first, state.lastSeenUSec);
+            }
+        }
+
+        for (const auto &rider : offTrack)
+        {
+            emit riderOffTrack(rider.first, rider.second);
+        }
+
+        if (sessionEnded)
+        {
+            emit this->sessionEnded(sessionEndUSec);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Account for one tag read
+ **
+ ** The first time a chip is seen only starts its first lap. Reads
+ ** closer than the minimum lap time to the last crossing belong to
+ ** the same pass of the antennas and are ignored.
+ **
+ *****************************************************************************/
+
+    void CLapCounter::onNewTag(const LLRPLaps::CTagInfo &tagInfo)
+    {
+        if (nullptr != _latencyRecorder)
+        {
+            _latencyRecorder->record(CLatencyRecorder::TagSignal, tagInfo.getHostReceivedNSec());
+        }
+
+        if (nullptr != _journal)
+        {
+            _journal->append(tagInfo);
+        }
+
+        u_int64_t seenUSec = tagInfo.getTimeStampUSec();
+        advanceTo(seenUSec);
+
+        RiderMap::value_type *rider = findRider(tagInfo);
+
+        if (nullptr == rider)
+        {
+            RiderState state;
+            state.lastCrossingUSec = seenUSec;
+            state.lastSeenUSec = seenUSec;
+            state.offTrackTimer = CTimingWheel::NO_TIMER;
+            state.laps = 0;
+            rider = &*_riders.insert(std::make_pair(tagInfo.data, state)).first;
+            if (CTagInfo::NO_EPC_ID != tagInfo.getEpcId())
+            {
+                _byEpcId[tagInfo.getEpcId()] = rider;
+            }
+            watchRider(*rider);
+            return;
+        }
+
+        RiderState &state = rider->second;
+        state.lastSeenUSec = std::max(state.lastSeenUSec, seenUSec);
+        watchRider(*rider);
+
+        if (seenUSec < state.lastCrossingUSec + _minLapUSec)
+        {
+            return;
+        }
+
+        CLapInfo lapInfo;
+        lapInfo.epc = tagInfo.data;
+        lapInfo.epcId = tagInfo.getEpcId();
+        lapInfo.lapNumber = ++state.laps;
+        lapInfo.antennaId = tagInfo.AntennaId;
+        lapInfo.crossingUSec = seenUSec;
+        lapInfo.lapTimeUSec = seenUSec - state.lastCrossingUSec;
+        lapInfo.hostReceivedNSec = tagInfo.getHostReceivedNSec();
+        state.lastCrossingUSec = seenUSec;
+
+        if (nullptr != _latencyRecorder)
+        {
+            _latencyRecorder->record(CLatencyRecorder::LapDetect, lapInfo.hostReceivedNSec);
+        }
+
+        emit newLap(lapInfo);
+    }
+}
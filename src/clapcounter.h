@@ -0,0 +1,134 @@
+//********************************************************************
+//    created:    2026-10-18 10:20 AM
+//    file:       clapcounter.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPCOUNTER_H
+#define LLRPLAPS_CLAPCOUNTER_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QObject>
+
+#include "ctaginfo.h"
+#include "clapinfo.h"
+#include "ctimingwheel.h"
+
+Q_DECLARE_METATYPE(LLRPLaps::CLapInfo);
+
+namespace LLRPLaps
+{
+    class CLatencyRecorder;
+    class CTagJournal;
+
+    /*
+     * Turns the stream of tag reads into laps. A chip is read many
+     * times while it passes the antennas; the first read after the
+     * chip has been away for at least the minimum lap time is a line
+     * crossing, and every crossing after the first completes a lap.
+     *
+     * Timers run on a CTimingWheel in the reader timebase, moved on
+     * by every tag read. A rider unseen for the off track time is
+     * reported once, and the session ends at the time given. When
+     * no tags come in, advanceTo() keeps the clock moving: the
+     * reader's UTC time live, the recorded time in replay.
+     *
+     * A read carrying an epc id is matched to its rider by that id;
+     * readers feeding one counter have to share a CEpcInterner.
+     */
+    class CLapCounter : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CLapCounter(u_int64_t minLapUSec = DEFAULT_MIN_LAP_USEC, QObject *parent = nullptr);
+
+        void setLatencyRecorder(CLatencyRecorder *recorder) { _latencyRecorder = recorder; }
+
+        // Every read is appended to the journal before it is counted
+        void setJournal(CTagJournal *journal) { _journal = journal; }
+
+        CTagJournal *getJournal() const { return _journal; }
+
+        void setMinLapUSec(u_int64_t minLapUSec) { _minLapUSec = minLapUSec; }
+
+        // 0 never reports riders off track, takes effect from each rider's next read
+        void setOffTrackUSec(u_int64_t offTrackUSec) { _offTrackUSec = offTrackUSec; }
+
+        void setSessionEndUSec(u_int64_t endUSec);
+
+        int getLapCount(const std::vector<unsigned char> &epc) const;
+
+        std::size_t getRiderCount() const { return _riders.size(); }
+
+        void clear();
+
+        // Riders and their laps, for CCheckpointer. Settings and timers are not part of it
+        void saveState(std::vector<unsigned char> &state) const;
+
+        // Replaces every rider, false and cleared if the state is cut short
+        bool loadState(const unsigned char *state, std::size_t size);
+
+        // A world class flying lap of a 250m track is a little over 12 seconds
+        const static u_int64_t DEFAULT_MIN_LAP_USEC;
+
+        // Five minutes without a read, the rider has left the track
+        const static u_int64_t DEFAULT_OFF_TRACK_USEC;
+
+    signals:
+
+        void newLap(const LLRPLaps::CLapInfo &);
+
+        void riderOffTrack(const std::vector<unsigned char> &epc, u_int64_t lastSeenUSec);
+
+        void sessionEnded(u_int64_t endUSec);
+
+    public slots:
+
+        void onNewTag(const LLRPLaps::CTagInfo &tagInfo);
+
+        void advanceTo(u_int64_t nowUSec);
+
+    private:
+        struct RiderState
+        {
+            u_int64_t lastCrossingUSec;
+            u_int64_t lastSeenUSec;
+            CTimingWheel::TimerId offTrackTimer;
+            int laps;
+        };
+
+        typedef std::map<std::vector<unsigned char>, RiderState> RiderMap;
+
+        void watchRider(RiderMap::value_type &rider);
+
+        // nullptr for a rider not seen yet
+        RiderMap::value_type *findRider(const CTagInfo &tagInfo);
+
+        RiderMap _riders;
+        std::vector<RiderMap::value_type *> _byEpcId;   // by CTagInfo::getEpcId(), nullptr until seen
+        u_int64_t _minLapUSec;
+        u_int64_t _offTrackUSec;
+        CLatencyRecorder *_latencyRecorder;
+        CTagJournal *_journal;
+        CTimingWheel _timers;
+        CTimingWheel::TimerId _sessionEndTimer;
+        std::vector<CTimingWheel::Expired> _expired;
+    };
+}
+#endif //LLRPLAPS_CLAPCOUNTER_H
@@ -0,0 +1,568 @@
+//********************************************************************
+//    created:    2026-10-19 01:40 AM
+//    file:       clapdatabase.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <chrono>
+
+#include <QByteArray>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include "clapdatabase.h"
+#include "cchipregistry.h"
+#include "cepcinterner.h"
+
+namespace LLRPLaps
+{
+    const int CLapDatabase::COMMIT_INTERVAL_MS = 100;
+    const std::size_t CLapDatabase::MAX_BATCH = 8192;
+
+    namespace
+    {
+        const char *const SCHEMA[] = {
+                "CREATE TABLE IF NOT EXISTS riders ("
+                "id INTEGER PRIMARY KEY, "
+                "name TEXT NOT NULL)",
+                "CREATE TABLE IF NOT EXISTS chips ("
+                "epc BLOB PRIMARY KEY, "
+                "rider_id INTEGER NOT NULL REFERENCES riders (id))",
+                "CREATE TABLE IF NOT EXISTS sessions ("
+                "id INTEGER PRIMARY KEY, "
+                "name TEXT NOT NULL, "
+                "start_usec INTEGER NOT NULL, "
+                "end_usec INTEGER)",
+                "CREATE TABLE IF NOT EXISTS laps ("
+                "id INTEGER PRIMARY KEY, "
+                "session_id INTEGER NOT NULL REFERENCES sessions (id), "
+                "epc BLOB NOT NULL, "
+                "lap_number INTEGER NOT NULL, "
+                "antenna_id INTEGER NOT NULL, "
+                "crossing_usec INTEGER NOT NULL, "
+                "lap_time_usec INTEGER NOT NULL)",
+                "CREATE INDEX IF NOT EXISTS chips_rider ON chips (rider_id)",
+                "CREATE INDEX IF NOT EXISTS laps_session ON laps (session_id, crossing_usec)",
+                "CREATE INDEX IF NOT EXISTS laps_crossing ON laps (crossing_usec)"
+        };
+
+        // In the order of CLapDatabase::Statement
+        const char *const STATEMENTS[] = {
+                "INSERT INTO riders (id, name) VALUES (?, ?)",
+                "INSERT OR REPLACE INTO chips (epc, rider_id) VALUES (?, ?)",
+                "DELETE FROM chips WHERE epc = ?",
+                "INSERT INTO sessions (id, name, start_usec) VALUES (?, ?, ?)",
+                "UPDATE sessions SET end_usec = ? WHERE id = ?",
+                "INSERT INTO laps (session_id, epc, lap_number, antenna_id, crossing_usec, lap_time_usec) "
+                "VALUES (?, ?, ?, ?, ?, ?)"
+        };
+
+        QByteArray toBlob(const std::vector<unsigned char> &epc)
+        {
+            return QByteArray(reinterpret_cast<const char *>(epc.data()), static_cast<int>(epc.size()));
+        }
+
+        std::vector<unsigned char> fromBlob(const QByteArray &blob)
+        {
+            return std::vector<unsigned char>(blob.constBegin(), blob.constEnd());
+        }
+
+        bool exec(QSqlDatabase &db, const QString &sql, QString &error)
+        {
+            QSqlQuery query(db);
+            if (!query.exec(sql))
+            {
+                error = query.lastError().text();
+                return false;
+            }
+            return true;
+        }
+
+        qint64 maxId(QSqlDatabase &db, const QString &table)
+        {
+            QSqlQuery query(db);
+            if (query.exec("SELECT COALESCE(MAX(id), 0) FROM " + table) && query.next())
+            {
+                return query.value(0).toLongLong();
+            }
+            return 0;
+        }
+    }
+
+    CLapDatabase::CLapDatabase(QObject *parent)
+            : QObject(parent), _nextRiderId(1), _nextSessionId(1), _sessionId(0), _epcInterner(nullptr), _queuedCount(0),
+              _writtenCount(0), _failedCount(0), _flushRequested(false), _stopRequested(false), _writerReady(false),
+              _writerFailed(false)
+    {
+        _connectionName = QString("laps-db-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    }
+
+
+    CLapDatabase::~CLapDatabase()
+    {
+        close();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start the writer on path, then open the reading connection
+ **
+ ** The writer creates the schema and switches the file to WAL, which
+ ** sticks to the file, before the reader opens it.
+ **
+ *****************************************************************************/
+
+    bool CLapDatabase::open(const QString &path)
+    {
+        close();
+
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _queuedCount = 0;
+            _writtenCount = 0;
+            _failedCount = 0;
+            _writeError.clear();
+            _flushRequested = false;
+            _stopRequested = false;
+            _writerReady = false;
+            _writerFailed = false;
+        }
+        _thread = std::thread(&CLapDatabase::run, this, path);
+
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _done.wait(lock, [this]
+            { return _writerReady || _writerFailed; });
+            if (_writerFailed)
+            {
+                _errorString = _writeError;
+                lock.unlock();
+                _thread.join();
+                return false;
+            }
+        }
+
+        QSqlDatabase reader = QSqlDatabase::addDatabase("QSQLITE", _connectionName + "-reader");
+        reader.setDatabaseName(path);
+        if (!reader.open() ||
+            !exec(reader, "PRAGMA query_only = ON", _errorString) ||
+            !exec(reader, "PRAGMA busy_timeout = 1000", _errorString))
+        {
+            if (_errorString.isEmpty())
+            {
+                _errorString = reader.lastError().text();
+            }
+            reader = QSqlDatabase();
+            close();
+            return false;
+        }
+
+        _nextRiderId = maxId(reader, "riders") + 1;
+        _nextSessionId = maxId(reader, "sessions") + 1;
+
+        /* Names for chips assigned to riders of an earlier run */
+        QSqlQuery riders(reader);
+        riders.setForwardOnly(true);
+        if (riders.exec("SELECT id, name FROM riders"))
+        {
+            std::lock_guard<std::mutex> lock(_riderNamesLock);
+            _riderNames.clear();
+            while (riders.next())
+            {
+                _riderNames[riders.value(0).toLongLong()] = riders.value(1).toString();
+            }
+        }
+
+        _errorString.clear();
+        return true;
+    }
+
+
+    void CLapDatabase::close()
+    {
+        if (_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                _stopRequested = true;
+            }
+            _wake.notify_one();
+            _thread.join();
+
+            std::lock_guard<std::mutex> lock(_lock);
+            _writerReady = false;
+        }
+
+        QString readerName = _connectionName + "-reader";
+        if (QSqlDatabase::contains(readerName))
+        {
+            QSqlDatabase::database(readerName, false).close();
+            QSqlDatabase::removeDatabase(readerName);
+        }
+    }
+
+
+    qint64 CLapDatabase::addRider(const QString &name)
+    {
+        qint64 riderId = _nextRiderId++;
+        {
+            std::lock_guard<std::mutex> lock(_riderNamesLock);
+            _riderNames[riderId] = name;
+        }
+        queue(InsertRider, { riderId, name });
+        return riderId;
+    }
+
+
+    void CLapDatabase::assignChip(const std::vector<unsigned char> &epc, qint64 riderId)
+    {
+        queue(AssignChip, { toBlob(epc), riderId });
+
+        if (nullptr != _epcInterner)
+        {
+            std::lock_guard<std::mutex> lock(_riderNamesLock);
+            auto name = _riderNames.find(riderId);
+            _epcInterner->setDisplayName(epc, (_riderNames.end() != name) ? name->second : QString());
+        }
+    }
+
+
+    void CLapDatabase::releaseChip(const std::vector<unsigned char> &epc)
+    {
+        queue(ReleaseChip, { toBlob(epc) });
+
+        if (nullptr != _epcInterner)
+        {
+            _epcInterner->setDisplayName(epc, QString());
+        }
+    }
+
+
+    qint64 CLapDatabase::startSession(const QString &name, u_int64_t startUSec)
+    {
+        qint64 sessionId = _nextSessionId++;
+        queue(InsertSession, { sessionId, name, static_cast<qlonglong>(startUSec) });
+        return sessionId;
+    }
+
+
+    void CLapDatabase::endSession(qint64 sessionId, u_int64_t endUSec)
+    {
+        queue(EndSession, { static_cast<qlonglong>(endUSec), sessionId });
+    }
+
+
+    void CLapDatabase::addLap(qint64 sessionId, const CLapInfo &lap)
+    {
+        queue(InsertLap, { sessionId, toBlob(lap.epc), lap.lapNumber, lap.antennaId,
+                           static_cast<qlonglong>(lap.crossingUSec), static_cast<qlonglong>(lap.lapTimeUSec) });
+    }
+
+
+    void CLapDatabase::onNewLap(const LLRPLaps::CLapInfo &lap)
+    {
+        qint64 sessionId = _sessionId;
+        if (0 != sessionId)
+        {
+            addLap(sessionId, lap);
+        }
+    }
+
+
+    void CLapDatabase::queue(Statement statement, QVariantList values)
+    {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            if (!_writerReady || _stopRequested)
+            {
+                return;
+            }
+            _pending.push_back(CWrite{statement, std::move(values)});
+            _queuedCount++;
+
+            /* The writer sleeps on an empty queue, and on a full one waits no longer */
+            wake = (1 == _pending.size()) || (MAX_BATCH == _pending.size());
+        }
+        if (wake)
+        {
+            _wake.notify_one();
+        }
+    }
+
+
+    void CLapDatabase::flush()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        std::uint64_t queued = _queuedCount;
+        if (_writtenCount + _failedCount >= queued)
+        {
+            return;
+        }
+
+        _flushRequested = true;
+        _wake.notify_one();
+        _done.wait(lock, [this, queued]
+        { return _writtenCount + _failedCount >= queued; });
+    }
+
+
+    std::uint64_t CLapDatabase::getWrittenCount() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _writtenCount;
+    }
+
+
+    std::uint64_t CLapDatabase::getFailedCount() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _failedCount;
+    }
+
+
+    QString CLapDatabase::getWriteError() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _writeError;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The writer thread: one connection, one transaction per batch
+ **
+ ** A batch is whatever was queued during COMMIT_INTERVAL_MS after the
+ ** first write came in. A write that fails is counted and skipped, the
+ ** rest of its batch still commits.
+ **
+ *****************************************************************************/
+
+    void CLapDatabase::run(const QString &path)
+    {
+        QString writerName = _connectionName + "-writer";
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", writerName);
+            db.setDatabaseName(path);
+
+            QString error;
+            std::vector<QSqlQuery> statements;
+            bool ready = db.open();
+            if (!ready)
+            {
+                error = db.lastError().text();
+            }
+            else
+            {
+                /* journal_mode answers with the mode it ended up in, a file system without shared memory stays put */
+                QSqlQuery walQuery(db);
+                ready = walQuery.exec("PRAGMA journal_mode = WAL") && walQuery.next() &&
+                        (0 == walQuery.value(0).toString().compare("wal", Qt::CaseInsensitive));
+                if (!ready)
+                {
+                    error = "SQLite cannot use WAL on " + path;
+                }
+            }
+
+            ready = ready &&
+                    exec(db, "PRAGMA synchronous = NORMAL", error) &&
+                    exec(db, "PRAGMA busy_timeout = 5000", error);
+            for (const char *sql : SCHEMA)
+            {
+                ready = ready && exec(db, sql, error);
+            }
+            for (int i = 0; ready && i < StatementCount; i++)
+            {
+                statements.emplace_back(db);
+                if (!statements.back().prepare(STATEMENTS[i]))
+                {
+                    error = statements.back().lastError().text();
+                    ready = false;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                _writerReady = ready;
+                _writerFailed = !ready;
+                _writeError = error;
+            }
+            _done.notify_all();
+
+            std::vector<CWrite> writing;
+            while (ready)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_lock);
+                    _wake.wait(lock, [this]
+                    { return _stopRequested || !_pending.empty(); });
+                    _wake.wait_for(lock, std::chrono::milliseconds(COMMIT_INTERVAL_MS), [this]
+                    { return _stopRequested || _flushRequested || _pending.size() >= MAX_BATCH; });
+
+                    /* What was queued before close() still goes in */
+                    if (_pending.empty())
+                    {
+                        break;
+                    }
+                    writing.swap(_pending);
+                    _flushRequested = false;
+                }
+
+                std::uint64_t failed = 0;
+                if (!db.transaction())
+                {
+                    error = db.lastError().text();
+                    failed = writing.size();
+                }
+                else
+                {
+                    for (const CWrite &write : writing)
+                    {
+                        QSqlQuery &query = statements[write.statement];
+                        for (int i = 0; i < write.values.size(); i++)
+                        {
+                            query.bindValue(i, write.values[i]);
+                        }
+                        if (!query.exec())
+                        {
+                            error = query.lastError().text();
+                            failed++;
+                        }
+                    }
+
+                    if (!db.commit())
+                    {
+                        error = db.lastError().text();
+                        db.rollback();
+                        failed = writing.size();
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(_lock);
+                    _writtenCount += writing.size() - failed;
+                    _failedCount += failed;
+                    if (0 != failed)
+                    {
+                        _writeError = error;
+                    }
+                }
+                _done.notify_all();
+                if (failed < writing.size())
+                {
+                    emit committed();
+                }
+                writing.clear();
+            }
+
+            statements.clear();
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(writerName);
+    }
+
+
+    QSqlDatabase CLapDatabase::getReader() const
+    {
+        return QSqlDatabase::database(_connectionName + "-reader", false);
+    }
+
+
+    bool CLapDatabase::getLaps(qint64 sessionId, std::vector<CLapInfo> &laps) const
+    {
+        laps.clear();
+
+        QSqlQuery query(getReader());
+        query.setForwardOnly(true);
+        query.prepare("SELECT epc, lap_number, antenna_id, crossing_usec, lap_time_usec FROM laps "
+                      "WHERE session_id = ? ORDER BY crossing_usec, id");
+        query.addBindValue(sessionId);
+        if (!query.exec())
+        {
+            return false;
+        }
+
+        while (query.next())
+        {
+            CLapInfo lap;
+            lap.epc = fromBlob(query.value(0).toByteArray());
+            lap.lapNumber = query.value(1).toInt();
+            lap.antennaId = query.value(2).toInt();
+            lap.crossingUSec = static_cast<u_int64_t>(query.value(3).toLongLong());
+            lap.lapTimeUSec = static_cast<u_int64_t>(query.value(4).toLongLong());
+            laps.push_back(lap);
+        }
+        return true;
+    }
+
+
+    qint64 CLapDatabase::findRider(const std::vector<unsigned char> &epc) const
+    {
+        QSqlQuery query(getReader());
+        query.prepare("SELECT rider_id FROM chips WHERE epc = ?");
+        query.addBindValue(toBlob(epc));
+        if (query.exec() && query.next())
+        {
+            return query.value(0).toLongLong();
+        }
+        return 0;
+    }
+
+
+    bool CLapDatabase::loadChips(CChipRegistry &registry) const
+    {
+        QSqlQuery query(getReader());
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT epc, rider_id FROM chips"))
+        {
+            return false;
+        }
+
+        while (query.next())
+        {
+            registry.add(fromBlob(query.value(0).toByteArray()), query.value(1).toLongLong());
+        }
+        return true;
+    }
+
+
+    bool CLapDatabase::setEpcInterner(CEpcInterner *interner)
+    {
+        _epcInterner = interner;
+        if (nullptr == interner)
+        {
+            return true;
+        }
+
+        /* Chips queued for assignment must be in the file for the query to see them */
+        flush();
+
+        QSqlQuery query(getReader());
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT c.epc, r.name FROM chips c JOIN riders r ON r.id = c.rider_id"))
+        {
+            return false;
+        }
+
+        while (query.next())
+        {
+            interner->setDisplayName(fromBlob(query.value(0).toByteArray()), query.value(1).toString());
+        }
+        return true;
+    }
+}
@@ -0,0 +1,183 @@
+//********************************************************************
+//    created:    2026-10-19 01:40 AM
+//    file:       clapdatabase.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPDATABASE_H
+#define LLRPLAPS_CLAPDATABASE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariantList>
+
+#include "clapinfo.h"
+
+namespace LLRPLaps
+{
+    class CChipRegistry;
+    class CEpcInterner;
+
+    /*
+     * Riders, their chips, sessions and laps in a SQLite database in
+     * WAL mode.
+     *
+     * Writes are queued and return at once. A writer thread with its
+     * own connection commits the queue every COMMIT_INTERVAL_MS, or
+     * sooner once MAX_BATCH writes are waiting, in one transaction
+     * through prepared statements kept for the life of the database.
+     * With synchronous=NORMAL a commit does not wait for the disk, a
+     * power cut can lose the last commits but never corrupts the
+     * file. Rider and session ids are handed out on the queueing side
+     * so a caller can use them straight away.
+     *
+     * Reads go through a second connection belonging to the thread
+     * that called open(). Under WAL a reader sees the last commit and
+     * neither side waits for the other; flush() first to read back
+     * what was just queued. committed() says when there is more to
+     * read; it comes from the writer thread, connect to it queued.
+     */
+    class CLapDatabase : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CLapDatabase(QObject *parent = nullptr);
+
+        ~CLapDatabase() override;
+
+        // Creates the file and the schema if need be
+        bool open(const QString &path);
+
+        void close();
+
+        bool isOpen() const { return _thread.joinable(); }
+
+        const QString &getErrorString() const { return _errorString; }
+
+        qint64 addRider(const QString &name);
+
+        // A chip belongs to one rider at a time, assigning it again moves it
+        void assignChip(const std::vector<unsigned char> &epc, qint64 riderId);
+
+        void releaseChip(const std::vector<unsigned char> &epc);
+
+        qint64 startSession(const QString &name, u_int64_t startUSec);
+
+        void endSession(qint64 sessionId, u_int64_t endUSec);
+
+        // Where onNewLap() puts laps, 0 drops them
+        void setSession(qint64 sessionId) { _sessionId = sessionId; }
+
+        void addLap(qint64 sessionId, const CLapInfo &lap);
+
+        // Blocks until everything queued so far is committed or has failed
+        void flush();
+
+        std::uint64_t getWrittenCount() const;
+
+        std::uint64_t getFailedCount() const;
+
+        // Why the last failed write failed
+        QString getWriteError() const;
+
+        // For reporting queries, only from the thread that called open()
+        QSqlDatabase getReader() const;
+
+        bool getLaps(qint64 sessionId, std::vector<CLapInfo> &laps) const;
+
+        // 0 for a chip no rider has
+        qint64 findRider(const std::vector<unsigned char> &epc) const;
+
+        // Every assigned chip and its rider, to filter on at the reader and resolve reads by
+        bool loadChips(CChipRegistry &registry) const;
+
+        /*
+         * Chips assigned from now on show their rider's name as the
+         * interner's display name, released ones the hex again. The
+         * chips assigned already are named straight away, so call it
+         * from the thread that called open().
+         */
+        bool setEpcInterner(CEpcInterner *interner);
+
+        const static int COMMIT_INTERVAL_MS;
+        const static std::size_t MAX_BATCH;
+
+    signals:
+
+        // A batch of writes went in, some of them maybe laps
+        void committed();
+
+    public slots:
+
+        void onNewLap(const LLRPLaps::CLapInfo &lap);
+
+    private:
+        enum Statement
+        {
+            InsertRider,
+            AssignChip,
+            ReleaseChip,
+            InsertSession,
+            EndSession,
+            InsertLap,
+            StatementCount
+        };
+
+        struct CWrite
+        {
+            Statement statement;
+            QVariantList values;
+        };
+
+        void queue(Statement statement, QVariantList values);
+
+        void run(const QString &path);
+
+        QString _connectionName;
+        QString _errorString;
+        std::atomic<qint64> _nextRiderId;
+        std::atomic<qint64> _nextSessionId;
+        std::atomic<qint64> _sessionId;
+        CEpcInterner *_epcInterner;
+
+        mutable std::mutex _riderNamesLock;
+        std::map<qint64, QString> _riderNames;
+
+        mutable std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        std::vector<CWrite> _pending;
+        std::uint64_t _queuedCount;
+        std::uint64_t _writtenCount;
+        std::uint64_t _failedCount;
+        QString _writeError;
+        bool _flushRequested;
+        bool _stopRequested;
+        bool _writerReady;
+        bool _writerFailed;
+        std::thread _thread;
+    };
+}
+#endif //LLRPLAPS_CLAPDATABASE_H
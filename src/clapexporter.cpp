@@ -0,0 +1,384 @@
+//********************************************************************
+//    created:    2026-10-19 02:15 AM
+//    file:       clapexporter.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include "clapexporter.h"
+
+namespace LLRPLaps
+{
+    const int CLapExporter::ROW_GROUP_ROWS = 65536;
+    const char CLapExporter::MAGIC[8] = { 'L', 'A', 'P', 'S', 'C', 'O', 'L', '\0' };
+    const std::uint32_t CLapExporter::VERSION = 1;
+
+    namespace
+    {
+        enum Column
+        {
+            SessionId,
+            Session,
+            RiderId,
+            Rider,
+            Epc,
+            LapNumber,
+            AntennaId,
+            CrossingUSec,
+            LapTimeUSec,
+            ColumnCount
+        };
+
+        struct CColumnInfo
+        {
+            const char *name;
+            CLapExporter::ColumnType type;
+        };
+
+        // In the order of Column and of the SELECT
+        const CColumnInfo COLUMNS[] = {
+                { "session_id",    CLapExporter::Int64 },
+                { "session",       CLapExporter::Utf8 },
+                { "rider_id",      CLapExporter::Int64 },
+                { "rider",         CLapExporter::Utf8 },
+                { "epc",           CLapExporter::Binary },
+                { "lap_number",    CLapExporter::Int32 },
+                { "antenna_id",    CLapExporter::Int32 },
+                { "crossing_usec", CLapExporter::Int64 },
+                { "lap_time_usec", CLapExporter::Int64 }
+        };
+
+        const int CSV_CHUNK_BYTES = 256 * 1024;
+
+        void putU32(std::vector<unsigned char> &out, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+            }
+        }
+
+        void putU64(std::vector<unsigned char> &out, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+            }
+        }
+
+        void pad(std::vector<unsigned char> &out)
+        {
+            out.resize((out.size() + 7) & ~static_cast<std::size_t>(7), 0);
+        }
+
+        bool write(QSaveFile &file, const std::vector<unsigned char> &bytes)
+        {
+            return static_cast<qint64>(bytes.size()) ==
+                   file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<qint64>(bytes.size()));
+        }
+
+        void appendCsvField(QByteArray &line, const QByteArray &field)
+        {
+            if (field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r'))
+            {
+                QByteArray quoted = field;
+                quoted.replace('"', "\"\"");
+                line.append('"').append(quoted).append('"');
+            }
+            else
+            {
+                line.append(field);
+            }
+        }
+
+        /*
+         * One row group of the columnar format being filled, every
+         * buffer kept between groups so a long export allocates once.
+         */
+        class CRowGroup
+        {
+        public:
+            CRowGroup() : _rows(0), _values(ColumnCount), _offsets(ColumnCount)
+            {
+                for (auto &offsets : _offsets)
+                {
+                    offsets.push_back(0);
+                }
+            }
+
+            int getRows() const { return _rows; }
+
+            void addInt(int column, std::int64_t value)
+            {
+                std::vector<unsigned char> &values = _values[column];
+                int width = (CLapExporter::Int32 == COLUMNS[column].type) ? 4 : 8;
+                for (int i = 0; i < width; i++)
+                {
+                    values.push_back(static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> (8 * i)));
+                }
+            }
+
+            void addBytes(int column, const QByteArray &value)
+            {
+                std::vector<unsigned char> &values = _values[column];
+                values.insert(values.end(), value.constBegin(), value.constEnd());
+                _offsets[column].push_back(static_cast<std::uint32_t>(values.size()));
+            }
+
+            void endRow() { _rows++; }
+
+            // Appends the group to out and starts the next one
+            void take(std::vector<unsigned char> &out)
+            {
+                putU32(out, static_cast<std::uint32_t>(_rows));
+                putU32(out, 0);
+
+                for (int column = 0; column < ColumnCount; column++)
+                {
+                    CLapExporter::ColumnType type = COLUMNS[column].type;
+                    if (CLapExporter::Utf8 == type || CLapExporter::Binary == type)
+                    {
+                        std::vector<std::uint32_t> &offsets = _offsets[column];
+                        putU64(out, offsets.size() * 4);
+                        for (std::uint32_t offset : offsets)
+                        {
+                            putU32(out, offset);
+                        }
+                        pad(out);
+                        offsets.assign(1, 0);
+                    }
+
+                    std::vector<unsigned char> &values = _values[column];
+                    putU64(out, values.size());
+                    out.insert(out.end(), values.begin(), values.end());
+                    pad(out);
+                    values.clear();
+                }
+                _rows = 0;
+            }
+
+        private:
+            int _rows;
+            std::vector<std::vector<unsigned char>> _values;
+            std::vector<std::vector<std::uint32_t>> _offsets;
+        };
+    }
+
+    CLapExporter::CLapExporter()
+            : _fromUSec(0), _toUSec(static_cast<u_int64_t>(std::numeric_limits<qint64>::max())), _sessionId(0),
+              _cancelled(false), _exportedCount(0)
+    {
+    }
+
+
+    void CLapExporter::setTimeRange(u_int64_t fromUSec, u_int64_t toUSec)
+    {
+        /* SQLite integers are signed, the far future is as far as they go */
+        _fromUSec = std::min<u_int64_t>(fromUSec, std::numeric_limits<qint64>::max());
+        _toUSec = std::min<u_int64_t>(toUSec, std::numeric_limits<qint64>::max());
+    }
+
+
+    CLapExporter::Format CLapExporter::formatForPath(const QString &path)
+    {
+        return path.endsWith(".lapcol", Qt::CaseInsensitive) ? Columnar : Csv;
+    }
+
+
+    bool CLapExporter::exportLaps(const QString &databasePath, const QString &outputPath, Format format)
+    {
+        _cancelled = false;
+        _exportedCount = 0;
+        _errorString.clear();
+
+        QString connectionName = QString("laps-export-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+        bool exported = false;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            db.setDatabaseName(databasePath);
+            db.setConnectOptions("QSQLITE_OPEN_READONLY");
+            if (!db.open())
+            {
+                _errorString = db.lastError().text();
+            }
+            else
+            {
+                exported = exportFrom(db, outputPath, format);
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        return exported;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Query the range and write it out
+ **
+ ** The query is forward only, SQLite hands over one row per step from
+ ** the (session_id, crossing_usec) or crossing_usec index, so nothing
+ ** but the current CSV chunk or row group is held. Cancelling or any
+ ** error discards the output.
+ **
+ *****************************************************************************/
+
+    bool CLapExporter::exportFrom(QSqlDatabase &db, const QString &outputPath, Format format)
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (!query.prepare(QString(
+                "SELECT l.session_id, s.name, COALESCE(c.rider_id, 0), COALESCE(r.name, ''), l.epc, "
+                "l.lap_number, l.antenna_id, l.crossing_usec, l.lap_time_usec "
+                "FROM laps l JOIN sessions s ON s.id = l.session_id "
+                "LEFT JOIN chips c ON c.epc = l.epc LEFT JOIN riders r ON r.id = c.rider_id "
+                "WHERE l.crossing_usec >= ? AND l.crossing_usec < ? %1"
+                "ORDER BY l.crossing_usec, l.id").arg((0 != _sessionId) ? "AND l.session_id = ? " : "")))
+        {
+            _errorString = query.lastError().text();
+            return false;
+        }
+
+        query.addBindValue(static_cast<qlonglong>(_fromUSec));
+        query.addBindValue(static_cast<qlonglong>(_toUSec));
+        if (0 != _sessionId)
+        {
+            query.addBindValue(_sessionId);
+        }
+        if (!query.exec())
+        {
+            _errorString = query.lastError().text();
+            return false;
+        }
+
+        QSaveFile file(outputPath);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            _errorString = file.errorString();
+            return false;
+        }
+
+        bool written = (Csv == format) ? writeCsv(query, file) : writeColumnar(query, file);
+        if (_cancelled)
+        {
+            _errorString = "Export cancelled";
+            return false;
+        }
+        if (query.lastError().isValid())
+        {
+            _errorString = query.lastError().text();
+            return false;
+        }
+        if (!written || !file.commit())
+        {
+            _errorString = file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+
+    bool CLapExporter::writeCsv(QSqlQuery &query, QSaveFile &file)
+    {
+        bool written = true;
+        QByteArray chunk("session_id,session,rider_id,rider,epc,lap_number,antenna_id,"
+                         "crossing_utc,crossing_usec,lap_time_sec\r\n");
+
+        while (written && !_cancelled && query.next())
+        {
+            qint64 crossingUSec = query.value(CrossingUSec).toLongLong();
+            chunk.append(QByteArray::number(query.value(SessionId).toLongLong())).append(',');
+            appendCsvField(chunk, query.value(Session).toString().toUtf8());
+            chunk.append(',').append(QByteArray::number(query.value(RiderId).toLongLong())).append(',');
+            appendCsvField(chunk, query.value(Rider).toString().toUtf8());
+            chunk.append(',').append(query.value(Epc).toByteArray().toHex()).append(',');
+            chunk.append(QByteArray::number(query.value(LapNumber).toInt())).append(',');
+            chunk.append(QByteArray::number(query.value(AntennaId).toInt())).append(',');
+            chunk.append(QDateTime::fromMSecsSinceEpoch(crossingUSec / 1000, Qt::UTC)
+                                 .toString(Qt::ISODateWithMs).toLatin1()).append(',');
+            chunk.append(QByteArray::number(crossingUSec)).append(',');
+            chunk.append(QByteArray::number(query.value(LapTimeUSec).toLongLong() / 1000000.0, 'f', 3));
+            chunk.append("\r\n");
+            _exportedCount++;
+
+            if (chunk.size() >= CSV_CHUNK_BYTES)
+            {
+                written = (chunk.size() == file.write(chunk));
+                chunk.clear();
+            }
+        }
+        return written && (chunk.size() == file.write(chunk));
+    }
+
+
+    bool CLapExporter::writeColumnar(QSqlQuery &query, QSaveFile &file)
+    {
+        std::vector<unsigned char> out;
+        out.insert(out.end(), MAGIC, MAGIC + sizeof MAGIC);
+        putU32(out, VERSION);
+        putU32(out, ColumnCount);
+        for (const CColumnInfo &column : COLUMNS)
+        {
+            std::size_t length = std::strlen(column.name);
+            out.push_back(static_cast<unsigned char>(column.type));
+            out.push_back(static_cast<unsigned char>(length));
+            out.insert(out.end(), column.name, column.name + length);
+        }
+        pad(out);
+
+        bool written = true;
+        CRowGroup group;
+        while (written && !_cancelled && query.next())
+        {
+            group.addInt(SessionId, query.value(SessionId).toLongLong());
+            group.addBytes(Session, query.value(Session).toString().toUtf8());
+            group.addInt(RiderId, query.value(RiderId).toLongLong());
+            group.addBytes(Rider, query.value(Rider).toString().toUtf8());
+            group.addBytes(Epc, query.value(Epc).toByteArray());
+            group.addInt(LapNumber, query.value(LapNumber).toInt());
+            group.addInt(AntennaId, query.value(AntennaId).toInt());
+            group.addInt(CrossingUSec, query.value(CrossingUSec).toLongLong());
+            group.addInt(LapTimeUSec, query.value(LapTimeUSec).toLongLong());
+            group.endRow();
+            _exportedCount++;
+
+            if (ROW_GROUP_ROWS == group.getRows())
+            {
+                group.take(out);
+                written = write(file, out);
+                out.clear();
+            }
+        }
+
+        /* The last rows, then the empty group that ends the file */
+        if (0 != group.getRows())
+        {
+            group.take(out);
+        }
+        group.take(out);
+        return written && write(file, out);
+    }
+}
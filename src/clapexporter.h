@@ -0,0 +1,114 @@
+//********************************************************************
+//    created:    2026-10-19 02:15 AM
+//    file:       clapexporter.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPEXPORTER_H
+#define LLRPLAPS_CLAPEXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <QSqlDatabase>
+#include <QString>
+
+class QSaveFile;
+class QSqlQuery;
+
+namespace LLRPLaps
+{
+    /*
+     * Streams the laps of a CLapDatabase to a file, in crossing order,
+     * one row at a time from a read only connection of its own. Memory
+     * use does not grow with the range, and under WAL the live writer
+     * is never held up. Safe to run on any thread; the output only
+     * appears, atomically, once it is complete.
+     *
+     * Csv has a header row and one lap per row, times in UTC.
+     *
+     * Columnar keeps each column in one contiguous little endian
+     * buffer per row group, laid out like an Arrow record batch so
+     * numpy.frombuffer or pyarrow can take the buffers as they are:
+     *
+     *   header     "LAPSCOL\0", u32 version, u32 column count, then per
+     *              column u8 type, u8 name length, name; padded to 8
+     *   row group  u32 rows, u32 zero, then per buffer u64 length and
+     *              the bytes padded to 8. Int32 and Int64 columns have
+     *              one buffer, Utf8 and Binary ones u32 offsets
+     *              (rows + 1) then the values, as Arrow does
+     *   end        a row group of 0 rows
+     *
+     * A lap whose chip has no rider has rider_id 0 and no rider name.
+     */
+    class CLapExporter
+    {
+    public:
+        enum Format
+        {
+            Csv,
+            Columnar
+        };
+
+        enum ColumnType
+        {
+            Int32 = 1,
+            Int64 = 2,
+            Utf8 = 3,
+            Binary = 4
+        };
+
+        CLapExporter();
+
+        // Crossings from fromUSec up to but not including toUSec, default everything
+        void setTimeRange(u_int64_t fromUSec, u_int64_t toUSec);
+
+        // 0 for every session
+        void setSession(qint64 sessionId) { _sessionId = sessionId; }
+
+        bool exportLaps(const QString &databasePath, const QString &outputPath, Format format);
+
+        // From any thread, exportLaps() then fails and leaves no file
+        void cancel() { _cancelled = true; }
+
+        // Rows written so far, for progress from any thread
+        std::uint64_t getExportedCount() const { return _exportedCount; }
+
+        const QString &getErrorString() const { return _errorString; }
+
+        // Columnar for .lapcol, Csv otherwise
+        static Format formatForPath(const QString &path);
+
+        const static int ROW_GROUP_ROWS;
+        static const char MAGIC[8];
+        static const std::uint32_t VERSION;
+
+    private:
+        bool exportFrom(QSqlDatabase &db, const QString &outputPath, Format format);
+
+        bool writeCsv(QSqlQuery &query, QSaveFile &file);
+
+        bool writeColumnar(QSqlQuery &query, QSaveFile &file);
+
+        u_int64_t _fromUSec;
+        u_int64_t _toUSec;
+        qint64 _sessionId;
+        std::atomic<bool> _cancelled;
+        std::atomic<std::uint64_t> _exportedCount;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CLAPEXPORTER_H
@@ -0,0 +1,54 @@
+//********************************************************************
+//    created:    2026-10-18 10:20 AM
+//    file:       clapinfo.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPINFO_H
+#define LLRPLAPS_CLAPINFO_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    /*
+     * One completed lap of one chip, as produced by CLapCounter.
+     * Times are in the reader's timebase (UTC microseconds) except
+     * hostReceivedNSec which is carried over from the CTagInfo.
+     */
+    class CLapInfo
+    {
+    public:
+        CLapInfo() : epcId(CTagInfo::NO_EPC_ID), lapNumber(0), antennaId(0), crossingUSec(0), lapTimeUSec(0),
+                     hostReceivedNSec(0)
+        {
+        }
+
+        double getLapTimeSec() const { return static_cast<double>(lapTimeUSec / 1000000.0); }
+
+        std::vector<unsigned char> epc;
+        std::uint32_t epcId;        // as the CTagInfo had it
+        int lapNumber;
+        int antennaId;
+        u_int64_t crossingUSec;
+        u_int64_t lapTimeUSec;
+        u_int64_t hostReceivedNSec;
+    };
+}
+#endif //LLRPLAPS_CLAPINFO_H
@@ -0,0 +1,420 @@
+//********************************************************************
+//    created:    2026-10-18 11:40 PM
+//    file:       clappipeline.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <limits>
+
+#include <QMetaObject>
+
+#include "clappipeline.h"
+
+namespace
+{
+    const std::uint64_t NO_SEQ = std::numeric_limits<std::uint64_t>::max();
+}
+
+namespace LLRPLaps
+{
+    const std::size_t CLapPipeline::MAX_QUEUED_READS = 65536;
+
+    CLapPipeline::CShard::CShard(CLapPipeline &pipeline, u_int64_t minLapUSec) : _pipeline(pipeline),
+                                                                                 _lapCounter(minLapUSec),
+                                                                                 _batchSeq(NO_SEQ),
+                                                                                 _busySeq(NO_SEQ),
+                                                                                 _blocked(0),
+                                                                                 _busy(false),
+                                                                                 _tickPending(false),
+                                                                                 _stopRequested(false)
+    {
+        QObject::connect(&_lapCounter, &CLapCounter::newLap, [this](const CLapInfo &lapInfo)
+        {
+            CSequencedLap lap;
+            lap.seq = _batchSeq;
+            lap.lapInfo = lapInfo;
+            _batchLaps.push_back(std::move(lap));
+        });
+        QObject::connect(&_lapCounter, &CLapCounter::riderOffTrack,
+                         [this](const std::vector<unsigned char> &epc, u_int64_t lastSeenUSec)
+        {
+            _batchOffTrack.emplace_back(epc, lastSeenUSec);
+        });
+
+        _thread = std::thread(&CShard::run, this);
+    }
+
+
+    CLapPipeline::CShard::~CShard()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stopRequested = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+    }
+
+
+    void CLapPipeline::CShard::push(std::uint64_t seq, const CTagInfo &tagInfo)
+    {
+        bool wasEmpty;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            if (_queue.size() >= MAX_QUEUED_READS)
+            {
+                _blocked++;
+                _notFull.wait(lock, [this]
+                { return _queue.size() < MAX_QUEUED_READS; });
+            }
+
+            wasEmpty = _queue.empty();
+            _queue.push_back(CSequencedTag{seq, tagInfo});
+        }
+
+        if (wasEmpty)
+        {
+            _wake.notify_one();
+        }
+    }
+
+
+    std::uint64_t CLapPipeline::CShard::takeLaps(std::vector<CSequencedLap> &laps, std::vector<COffTrack> &offTrack)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        std::move(_laps.begin(), _laps.end(), std::back_inserter(laps));
+        _laps.clear();
+        std::move(_offTrack.begin(), _offTrack.end(), std::back_inserter(offTrack));
+        _offTrack.clear();
+
+        if (NO_SEQ != _busySeq)
+        {
+            return _busySeq;
+        }
+        return _queue.empty() ? NO_SEQ : _queue.front().seq;
+    }
+
+
+    void CLapPipeline::CShard::waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _idle.wait(lock, [this]
+        { return _queue.empty() && !_busy && !_tickPending; });
+    }
+
+
+    void CLapPipeline::CShard::tick()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _tickPending = true;
+        }
+        _wake.notify_one();
+    }
+
+
+    void CLapPipeline::CShard::clear()
+    {
+        /* The worker only touches the counter between taking a batch and handing its laps back */
+        std::lock_guard<std::mutex> lock(_lock);
+        _lapCounter.clear();
+    }
+
+
+    void CLapPipeline::CShard::setLatencyRecorder(CLatencyRecorder *recorder)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _lapCounter.setLatencyRecorder(recorder);
+    }
+
+
+    void CLapPipeline::CShard::setOffTrackUSec(u_int64_t offTrackUSec)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _lapCounter.setOffTrackUSec(offTrackUSec);
+    }
+
+
+    std::uint64_t CLapPipeline::CShard::getBlockedCount() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _blocked;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Worker thread of a shard
+ **
+ ** Takes whatever has queued up as one batch, so the lock is taken
+ ** twice per batch and not per read. The busier the shard, the
+ ** bigger the batches.
+ **
+ ** The counter is then moved on to the pipeline's clock as it was
+ ** when the batch was taken. The clock is read under the lock, so
+ ** every read of this shard that came in before the reads the clock
+ ** has seen is in the batch, and a rider is not timed off track
+ ** with a read of theirs still queued.
+ **
+ *****************************************************************************/
+
+    void CLapPipeline::CShard::run()
+    {
+        std::vector<CSequencedTag> batch;
+
+        for (;;)
+        {
+            u_int64_t nowUSec;
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _wake.wait(lock, [this]
+                { return _stopRequested || !_queue.empty() || _tickPending; });
+
+                if (_stopRequested)
+                {
+                    return;
+                }
+
+                nowUSec = _pipeline._clockUSec.load(std::memory_order_acquire);
+                batch.swap(_queue);
+                _busySeq = batch.empty() ? NO_SEQ : batch.front().seq;
+                _busy = true;
+                _tickPending = false;
+            }
+            _notFull.notify_one();
+
+            for (const CSequencedTag &tag : batch)
+            {
+                _batchSeq = tag.seq;
+                _lapCounter.onNewTag(tag.tagInfo);
+            }
+            batch.clear();
+            _lapCounter.advanceTo(nowUSec);
+
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                std::move(_batchLaps.begin(), _batchLaps.end(), std::back_inserter(_laps));
+                std::move(_batchOffTrack.begin(), _batchOffTrack.end(), std::back_inserter(_offTrack));
+                _busySeq = NO_SEQ;
+                _busy = false;
+
+                if (_queue.empty() && !_tickPending)
+                {
+                    _idle.notify_all();
+                }
+            }
+            _batchLaps.clear();
+            _batchOffTrack.clear();
+
+            _pipeline.requestMerge();
+        }
+    }
+
+
+    CLapPipeline::CLapPipeline(unsigned int shardCount, u_int64_t minLapUSec, QObject *parent) : QObject(parent),
+                                                                                                 _reorderWindowUSec(0),
+                                                                                                 _nextSeq(0),
+                                                                                                 _latestReadUSec(0),
+                                                                                                 _clockUSec(0),
+                                                                                                 _mergePending(false)
+    {
+        if (0 == shardCount)
+        {
+            shardCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (unsigned int i = 0; i < shardCount; i++)
+        {
+            _shards.emplace_back(new CShard(*this, minLapUSec));
+        }
+    }
+
+
+    CLapPipeline::~CLapPipeline()
+    {
+        /* Stop the workers while they can still post merges to a live object */
+        _shards.clear();
+    }
+
+
+    void CLapPipeline::setLatencyRecorder(CLatencyRecorder *recorder)
+    {
+        for (auto &shard : _shards)
+        {
+            shard->setLatencyRecorder(recorder);
+        }
+    }
+
+
+    void CLapPipeline::setOffTrackUSec(u_int64_t offTrackUSec)
+    {
+        for (auto &shard : _shards)
+        {
+            shard->setOffTrackUSec(offTrackUSec);
+        }
+    }
+
+
+    std::uint64_t CLapPipeline::getBlockedCount() const
+    {
+        std::uint64_t blocked = 0;
+        for (auto &shard : _shards)
+        {
+            blocked += shard->getBlockedCount();
+        }
+        return blocked;
+    }
+
+
+    unsigned int CLapPipeline::shardOf(const std::vector<unsigned char> &epc) const
+    {
+        /* FNV-1a, rider EPCs often differ in the last byte only */
+        std::uint32_t hash = 2166136261u;
+        for (unsigned char byte : epc)
+        {
+            hash = (hash ^ byte) * 16777619u;
+        }
+        return hash % static_cast<std::uint32_t>(_shards.size());
+    }
+
+
+    void CLapPipeline::onNewTag(const LLRPLaps::CTagInfo &tagInfo)
+    {
+        _latestReadUSec = std::max(_latestReadUSec, tagInfo.getTimeStampUSec());
+        _clockUSec.store(_latestReadUSec, std::memory_order_release);
+        _shards[shardOf(tagInfo.data)]->push(_nextSeq++, tagInfo);
+    }
+
+
+    void CLapPipeline::advanceTo(u_int64_t nowUSec)
+    {
+        /* Held laps are released against it too, as they would be by a read at that time */
+        _latestReadUSec = std::max(_latestReadUSec, nowUSec);
+        _clockUSec.store(_latestReadUSec, std::memory_order_release);
+        for (auto &shard : _shards)
+        {
+            shard->tick();
+        }
+    }
+
+
+    void CLapPipeline::requestMerge()
+    {
+        /* One merge queued at a time, it picks up every shard's laps */
+        if (!_mergePending.exchange(true, std::memory_order_acq_rel))
+        {
+            QMetaObject::invokeMethod(this, "merge", Qt::QueuedConnection);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Gather the laps the shards have handed back
+ **
+ ** Returns the number of the oldest read still in a shard, or the
+ ** next read number if none is. Every lap from a read before that
+ ** is in _held, no later read can come up with a lap that goes
+ ** before it.
+ **
+ *****************************************************************************/
+
+    std::uint64_t CLapPipeline::collectLaps()
+    {
+        std::uint64_t oldestSeq = _nextSeq;
+        for (auto &shard : _shards)
+        {
+            oldestSeq = std::min(oldestSeq, shard->takeLaps(_held, _offTrack));
+        }
+
+        auto final = std::partition(_held.begin(), _held.end(), [oldestSeq](const CSequencedLap &lap)
+        { return lap.seq >= oldestSeq; });
+
+        for (auto lap = final; lap != _held.end(); ++lap)
+        {
+            _ready.push(std::move(*lap));
+        }
+        _held.erase(final, _held.end());
+
+        return oldestSeq;
+    }
+
+
+    void CLapPipeline::release(bool all)
+    {
+        while (!_ready.empty())
+        {
+            const CSequencedLap &next = _ready.top();
+            if (!all && (next.lapInfo.crossingUSec + _reorderWindowUSec > _latestReadUSec))
+            {
+                break;
+            }
+
+            CLapInfo lapInfo = next.lapInfo;
+            _ready.pop();
+            emit newLap(lapInfo);
+        }
+    }
+
+
+    void CLapPipeline::reportOffTrack()
+    {
+        /* A slot connected to riderOffTrack may flush() */
+        std::vector<COffTrack> offTrack;
+        offTrack.swap(_offTrack);
+        for (const COffTrack &rider : offTrack)
+        {
+            emit riderOffTrack(rider.first, rider.second);
+        }
+    }
+
+
+    void CLapPipeline::merge()
+    {
+        _mergePending.store(false, std::memory_order_release);
+        collectLaps();
+        release(false);
+        reportOffTrack();
+    }
+
+
+    void CLapPipeline::flush()
+    {
+        for (auto &shard : _shards)
+        {
+            shard->waitIdle();
+        }
+
+        collectLaps();
+        release(true);
+        reportOffTrack();
+    }
+
+
+    void CLapPipeline::clear()
+    {
+        flush();
+
+        for (auto &shard : _shards)
+        {
+            shard->clear();
+        }
+        _latestReadUSec = 0;
+        _clockUSec.store(0, std::memory_order_release);
+    }
+}
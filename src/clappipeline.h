@@ -0,0 +1,213 @@
+//********************************************************************
+//    created:    2026-10-18 11:40 PM
+//    file:       clappipeline.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLAPPIPELINE_H
+#define LLRPLAPS_CLAPPIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <QObject>
+
+#include "ctaginfo.h"
+#include "clapinfo.h"
+#include "clapcounter.h"
+
+namespace LLRPLaps
+{
+    class CLatencyRecorder;
+
+    /*
+     * Lap counting spread over worker threads.
+     *
+     * Tag reads are partitioned by a hash of the EPC, so every read
+     * of a rider goes to the same shard, in the order it came in.
+     * Each shard is a thread with a CLapCounter of its own and
+     * nothing shared, the counters need no locks.
+     *
+     * Laps come back through a merge on the pipeline's thread. Every
+     * read is numbered as it comes in; a lap is released once every
+     * read numbered before it has been through its shard, then
+     * handed out in crossing time order. With the reorder window at
+     * 0 that is the order one CLapCounter would give. A window holds
+     * laps back that long in the reader timebase, for readers whose
+     * reports arrive out of step.
+     *
+     * A shard holds at most MAX_QUEUED_READS, past that onNewTag()
+     * waits for it, backing up whatever feeds the pipeline.
+     *
+     * Each shard's counter times its own riders off track. After
+     * every batch its wheel is moved on to the newest read the
+     * pipeline has taken in, not only its own; advanceTo() moves
+     * every shard on when no tags come in. Per rider stats are not
+     * sharded, they are kept downstream of the merged laps.
+     *
+     * onNewTag() and the rest are called on the pipeline's thread,
+     * readers in other threads connect to it queued. newLap and
+     * riderOffTrack are emitted on the pipeline's thread too.
+     */
+    class CLapPipeline : public QObject
+    {
+    Q_OBJECT
+    public:
+        // 0 shards is one per core
+        explicit CLapPipeline(unsigned int shardCount = 0, u_int64_t minLapUSec = CLapCounter::DEFAULT_MIN_LAP_USEC,
+                              QObject *parent = nullptr);
+
+        ~CLapPipeline() override;
+
+        // Call before the first tag
+        void setLatencyRecorder(CLatencyRecorder *recorder);
+
+        // Call before the first tag, 0 never reports riders off track
+        void setOffTrackUSec(u_int64_t offTrackUSec);
+
+        void setReorderWindowUSec(u_int64_t windowUSec) { _reorderWindowUSec = windowUSec; }
+
+        unsigned int getShardCount() const { return static_cast<unsigned int>(_shards.size()); }
+
+        unsigned int shardOf(const std::vector<unsigned char> &epc) const;
+
+        // Times onNewTag() waited for a full shard
+        std::uint64_t getBlockedCount() const;
+
+        // Blocks until every read so far is through its shard, then hands out every lap held back
+        void flush();
+
+        // Flushes, then forgets every rider
+        void clear();
+
+        const static std::size_t MAX_QUEUED_READS;
+
+    signals:
+
+        void newLap(const LLRPLaps::CLapInfo &);
+
+        void riderOffTrack(const std::vector<unsigned char> &epc, u_int64_t lastSeenUSec);
+
+    public slots:
+
+        void onNewTag(const LLRPLaps::CTagInfo &tagInfo);
+
+        void advanceTo(u_int64_t nowUSec);
+
+    private slots:
+
+        void merge();
+
+    private:
+        struct CSequencedTag
+        {
+            std::uint64_t seq;
+            CTagInfo tagInfo;
+        };
+
+        struct CSequencedLap
+        {
+            std::uint64_t seq;
+            CLapInfo lapInfo;
+        };
+
+        typedef std::pair<std::vector<unsigned char>, u_int64_t> COffTrack;
+
+        struct CLaterCrossing
+        {
+            bool operator()(const CSequencedLap &a, const CSequencedLap &b) const
+            {
+                return (a.lapInfo.crossingUSec != b.lapInfo.crossingUSec)
+                       ? (a.lapInfo.crossingUSec > b.lapInfo.crossingUSec) : (a.seq > b.seq);
+            }
+        };
+
+        class CShard
+        {
+        public:
+            CShard(CLapPipeline &pipeline, u_int64_t minLapUSec);
+
+            ~CShard();
+
+            void push(std::uint64_t seq, const CTagInfo &tagInfo);
+
+            // The number of the oldest read not yet through, UINT64_MAX for none
+            std::uint64_t takeLaps(std::vector<CSequencedLap> &laps, std::vector<COffTrack> &offTrack);
+
+            // Wakes the worker to move its counter on to the pipeline's clock
+            void tick();
+
+            void waitIdle();
+
+            // Only while idle, after waitIdle()
+            void clear();
+
+            void setLatencyRecorder(CLatencyRecorder *recorder);
+
+            void setOffTrackUSec(u_int64_t offTrackUSec);
+
+            std::uint64_t getBlockedCount() const;
+
+        private:
+            void run();
+
+            CLapPipeline &_pipeline;
+            CLapCounter _lapCounter;
+            mutable std::mutex _lock;
+            std::condition_variable _wake;
+            std::condition_variable _idle;
+            std::condition_variable _notFull;
+            std::vector<CSequencedTag> _queue;
+            std::vector<CSequencedLap> _laps;
+            std::vector<CSequencedLap> _batchLaps;
+            std::vector<COffTrack> _offTrack;
+            std::vector<COffTrack> _batchOffTrack;
+            std::uint64_t _batchSeq;        // read the lap counter is on, worker thread only
+            std::uint64_t _busySeq;         // first read of the batch being worked on
+            std::uint64_t _blocked;
+            bool _busy;                     // the worker has the counter, for a batch or a tick
+            bool _tickPending;
+            bool _stopRequested;
+            std::thread _thread;
+        };
+
+        void requestMerge();
+
+        std::uint64_t collectLaps();
+
+        void release(bool all);
+
+        void reportOffTrack();
+
+        std::vector<std::unique_ptr<CShard>> _shards;
+        u_int64_t _reorderWindowUSec;
+        std::uint64_t _nextSeq;
+        std::vector<CSequencedLap> _held;
+        std::priority_queue<CSequencedLap, std::vector<CSequencedLap>, CLaterCrossing> _ready;
+        u_int64_t _latestReadUSec;
+        std::atomic<u_int64_t> _clockUSec;      // what the workers move their counters on to
+        std::vector<COffTrack> _offTrack;
+        std::atomic<bool> _mergePending;
+    };
+}
+#endif //LLRPLAPS_CLAPPIPELINE_H
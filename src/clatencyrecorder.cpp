@@ -0,0 +1,150 @@
+//********************************************************************
+//    created:    2026-10-18 10:05 AM
+//    file:       clatencyrecorder.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "clatencyrecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+namespace LLRPLaps
+{
+    CLatencyRecorder::CLatencyRecorder(std::size_t expectedSamples)
+    {
+        for (auto &samples : _samplesNSec)
+        {
+            samples.reserve(expectedSamples);
+        }
+    }
+
+
+    std::uint64_t CLatencyRecorder::nowNSec()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+
+    const char *CLatencyRecorder::stageName(Stage stage)
+    {
+        switch (stage)
+        {
+            case Decode:
+                return "decode";
+            case TagSignal:
+                return "tag signal";
+            case LapDetect:
+                return "lap detect";
+            case Publish:
+                return "publish";
+            default:
+                return "?unknown-stage?";
+        }
+    }
+
+
+    void CLatencyRecorder::record(Stage stage, std::uint64_t frameReceivedNSec)
+    {
+        std::uint64_t now = nowNSec();
+        std::uint64_t elapsed = (now > frameReceivedNSec) ? now - frameReceivedNSec : 0;
+
+        /*
+         * Samples are kept as 32 bit nanoseconds, anything past
+         * ~4.2 seconds is clamped. That is a stall, not a latency.
+         */
+
+        if (elapsed > std::numeric_limits<std::uint32_t>::max())
+        {
+            elapsed = std::numeric_limits<std::uint32_t>::max();
+        }
+
+        std::lock_guard<std::mutex> guard(_lock);
+        _samplesNSec[stage].push_back(static_cast<std::uint32_t>(elapsed));
+    }
+
+
+    void CLatencyRecorder::clear()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        for (auto &samples : _samplesNSec)
+        {
+            samples.clear();
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Nearest rank percentiles of one stage
+ **
+ ** Works on a copy so recording can continue while a report is
+ ** being produced.
+ **
+ *****************************************************************************/
+
+    CLatencyRecorder::Percentiles CLatencyRecorder::percentiles(Stage stage) const
+    {
+        std::vector<std::uint32_t> samples;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            samples = _samplesNSec[stage];
+        }
+
+        Percentiles result = { samples.size(), 0.0, 0.0, 0.0, 0.0 };
+        if (samples.empty())
+        {
+            return result;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        auto rank = [&samples](double p) -> double
+        {
+            auto index = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+            return samples[index] / 1000.0;
+        };
+
+        result.p50USec = rank(0.50);
+        result.p99USec = rank(0.99);
+        result.p999USec = rank(0.999);
+        result.maxUSec = samples.back() / 1000.0;
+        return result;
+    }
+
+
+    std::string CLatencyRecorder::report() const
+    {
+        std::string text;
+        char line[160];
+
+        std::snprintf(line, sizeof line, "%-12s %10s %12s %12s %12s %12s\n",
+                      "stage", "samples", "p50 us", "p99 us", "p99.9 us", "max us");
+        text.append(line);
+
+        for (int stage = 0; stage < StageCount; stage++)
+        {
+            Percentiles p = percentiles(static_cast<Stage>(stage));
+            std::snprintf(line, sizeof line, "%-12s %10zu %12.1f %12.1f %12.1f %12.1f\n",
+                          stageName(static_cast<Stage>(stage)), p.count, p.p50USec, p.p99USec, p.p999USec, p.maxUSec);
+            text.append(line);
+        }
+        return text;
+    }
+}
@@ -0,0 +1,79 @@
+//********************************************************************
+//    created:    2026-10-18 10:05 AM
+//    file:       clatencyrecorder.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLATENCYRECORDER_H
+#define LLRPLAPS_CLATENCYRECORDER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * Collects per stage latencies of the tag pipeline. Every sample
+     * is the time from the host reading the LLRP frame off the socket
+     * to the moment a stage is done with a tag from that frame, so
+     * each stage includes the stages before it.
+     *
+     * Stages are recorded from whatever thread runs them. A component
+     * with no recorder attached pays for a null pointer check only.
+     */
+    class CLatencyRecorder
+    {
+    public:
+        enum Stage
+        {
+            Decode = 0,         // frame decoded into LTK objects
+            TagSignal,          // CTagInfo delivered to a newTag consumer
+            LapDetect,          // lap counter decided the read completes a lap
+            Publish,            // lap result handed to its consumer
+            StageCount
+        };
+
+        struct Percentiles
+        {
+            std::size_t count;
+            double p50USec;
+            double p99USec;
+            double p999USec;
+            double maxUSec;
+        };
+
+        explicit CLatencyRecorder(std::size_t expectedSamples = 1u << 16);
+
+        static std::uint64_t nowNSec();
+
+        static const char *stageName(Stage stage);
+
+        void record(Stage stage, std::uint64_t frameReceivedNSec);
+
+        void clear();
+
+        Percentiles percentiles(Stage stage) const;
+
+        std::string report() const;
+
+    private:
+        mutable std::mutex _lock;
+        std::vector<std::uint32_t> _samplesNSec[StageCount];
+    };
+}
+#endif //LLRPLAPS_CLATENCYRECORDER_H
@@ -0,0 +1,1020 @@
+//********************************************************************
+//    created:    2026-10-18 12:30 PM
+//    file:       cllrpconnection.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "cllrpconnection.h"
+#include "cframecapture.h"
+#include "clatencyrecorder.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define LAPS_POLL WSAPoll
+#define LAPS_CLOSESOCKET closesocket
+#define LAPS_SEND_FLAGS 0
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define LAPS_POLL poll
+#define LAPS_CLOSESOCKET ::close
+/* A reset link must fail the send, not raise SIGPIPE; macOS has SO_NOSIGPIPE instead */
+#ifdef MSG_NOSIGNAL
+#define LAPS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define LAPS_SEND_FLAGS 0
+#endif
+#endif
+
+namespace LLRPLaps
+{
+    const unsigned short CLLRPConnection::LLRP_PORT = 5084;
+    const unsigned int CLLRPConnection::LLRP_HEADER_SIZE = 10;
+    const unsigned int CLLRPConnection::KEEPALIVE_TYPE = 62;
+    const unsigned int CLLRPConnection::KEEPALIVE_ACK_TYPE = 72;
+
+    // Anything bigger is a framing error, not a report
+    const std::size_t CLLRPConnection::MAX_FRAME_SIZE = 16u * 1024u * 1024u;
+    const std::size_t CLLRPConnection::MIN_RECV_BUFFER_SIZE = 4u * 1024u;
+    const std::size_t CLLRPConnection::RECV_FRAMES_PER_READ = 4;
+    const std::uint64_t CLLRPConnection::RECV_RESIZE_WINDOW = 1024;
+
+    namespace
+    {
+        const std::intptr_t INVALID_SOCKET_FD = -1;
+
+        std::uint32_t readU32(const unsigned char *p)
+        {
+            return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) | static_cast<std::uint32_t>(p[3]);
+        }
+
+        void writeU32(unsigned char *p, std::uint32_t value)
+        {
+            p[0] = static_cast<unsigned char>(value >> 24);
+            p[1] = static_cast<unsigned char>(value >> 16);
+            p[2] = static_cast<unsigned char>(value >> 8);
+            p[3] = static_cast<unsigned char>(value);
+        }
+
+        // Whole ms from now until deadline, rounded up so waiting that long gets past it
+        int msUntil(std::uint64_t deadlineNSec, std::uint64_t nowNSec)
+        {
+            return (nowNSec >= deadlineNSec) ? 0 : static_cast<int>((deadlineNSec - nowNSec + 999999u) / 1000000u);
+        }
+
+        bool setBlocking(std::intptr_t fd, bool blocking)
+        {
+#ifdef _WIN32
+            u_long nonBlocking = blocking ? 0 : 1;
+            return 0 == ioctlsocket(static_cast<SOCKET>(fd), FIONBIO, &nonBlocking);
+#else
+            int flags = fcntl(static_cast<int>(fd), F_GETFL, 0);
+            if (flags < 0)
+            {
+                return false;
+            }
+            flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+            return 0 == fcntl(static_cast<int>(fd), F_SETFL, flags);
+#endif
+        }
+
+        bool connectInProgress()
+        {
+#ifdef _WIN32
+            return WSAEWOULDBLOCK == WSAGetLastError();
+#else
+            return EINPROGRESS == errno;
+#endif
+        }
+
+        bool wouldBlock()
+        {
+#ifdef _WIN32
+            return WSAEWOULDBLOCK == WSAGetLastError();
+#else
+            return EAGAIN == errno || EWOULDBLOCK == errno;
+#endif
+        }
+
+#ifdef _WIN32
+        struct CWinsockInit
+        {
+            CWinsockInit()
+            {
+                WSADATA wsaData;
+                WSAStartup(MAKEWORD(2, 2), &wsaData);
+            }
+        };
+#endif
+    }
+
+    CLLRPConnection::CLLRPConnection(const LLRP::CTypeRegistry *typeRegistry, unsigned int maxSendFrameSize)
+            : _typeRegistry(typeRegistry), _socket(INVALID_SOCKET_FD), _connecting(false), _nonBlocking(false), _recvBuffer(MIN_RECV_BUFFER_SIZE), _recvStart(0), _recvEnd(0),
+              _recvConsume(0), _lastRecvNSec(0), _largestRecentFrame(0), _framesSinceResize(0), _sendBuffer(maxSendFrameSize), _pendingSendStart(0), _queueHead(0), _frameReceivedNSec(0), _linkTimeoutNSec(0),
+              _lastFrameNSec(0), _keepaliveCount(0), _linkDead(false)
+    {
+        std::memset(&_frame, 0, sizeof _frame);
+        setError(_recvError, LLRP::RC_OK, nullptr);
+        setError(_sendError, LLRP::RC_OK, nullptr);
+        setError(_transactError, LLRP::RC_OK, nullptr);
+    }
+
+
+    CLLRPConnection::~CLLRPConnection()
+    {
+        closeConnectionToReader();
+    }
+
+
+    void CLLRPConnection::setError(LLRP::CErrorDetails &errorDetails, LLRP::EResultCode resultCode, const char *whatStr)
+    {
+        errorDetails.m_eResultCode = resultCode;
+        errorDetails.m_pWhatStr = whatStr;
+        errorDetails.m_pRefType = nullptr;
+        errorDetails.m_pRefField = nullptr;
+        errorDetails.m_OtherDetail = 0;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Look up "host" or "host:port", the port defaults to 5084
+ **
+ ** @return     true            addresses must be freed with freeaddrinfo
+ **             false           Failed, see getConnectError()
+ **
+ *****************************************************************************/
+
+    bool CLLRPConnection::resolve(const char *readerHostName, ::addrinfo **addresses)
+    {
+#ifdef _WIN32
+        static CWinsockInit winsockInit;
+#endif
+
+        if (INVALID_SOCKET_FD != _socket)
+        {
+            _connectError = "already connected";
+            return false;
+        }
+
+        std::string host(readerHostName);
+        std::string port = std::to_string(LLRP_PORT);
+        std::size_t colon = host.rfind(':');
+
+        // Only a single colon is a port, IPv6 literals have several
+        if (std::string::npos != colon && colon == host.find(':'))
+        {
+            port = host.substr(colon + 1);
+            host.resize(colon);
+        }
+
+        struct addrinfo hints;
+        std::memset(&hints, 0, sizeof hints);
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        if (0 != getaddrinfo(host.c_str(), port.c_str(), &hints, addresses))
+        {
+            _connectError = "host lookup failed";
+            return false;
+        }
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Resolve the reader and open the TCP connection
+ **
+ ** @return     ==0             Connected
+ **             !=0             Failed, see getConnectError()
+ **
+ *****************************************************************************/
+
+    int CLLRPConnection::openConnectionToReader(const char *readerHostName)
+    {
+        struct addrinfo *addresses = nullptr;
+
+        if (!resolve(readerHostName, &addresses))
+        {
+            return -1;
+        }
+
+        _connectError = "connect failed";
+        for (struct addrinfo *address = addresses; nullptr != address; address = address->ai_next)
+        {
+            auto fd = static_cast<std::intptr_t>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+            if (fd < 0)
+            {
+                continue;
+            }
+            if (0 == connect(static_cast<int>(fd), address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)))
+            {
+                _socket = fd;
+                break;
+            }
+            LAPS_CLOSESOCKET(static_cast<int>(fd));
+        }
+        freeaddrinfo(addresses);
+
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            return -1;
+        }
+        if (_nonBlocking && !setBlocking(_socket, false))
+        {
+            closeConnectionToReader();
+            return -1;
+        }
+
+        connected();
+        return 0;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start opening the TCP connection without waiting for it
+ **
+ ** The host lookup still blocks, readers are normally given by
+ ** address. Only the first address is tried. Once the socket is
+ ** writable finishConnect() says how it went.
+ **
+ ** @return     ==0             Connecting, or already connected
+ **             !=0             Failed, see getConnectError()
+ **
+ *****************************************************************************/
+
+    int CLLRPConnection::startConnectionToReader(const char *readerHostName)
+    {
+        struct addrinfo *addresses = nullptr;
+
+        if (!resolve(readerHostName, &addresses))
+        {
+            return -1;
+        }
+
+        _connectError = "connect failed";
+        auto fd = static_cast<std::intptr_t>(socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol));
+        if (fd < 0)
+        {
+            freeaddrinfo(addresses);
+            return -1;
+        }
+
+        if (!setBlocking(fd, false))
+        {
+            LAPS_CLOSESOCKET(static_cast<int>(fd));
+            freeaddrinfo(addresses);
+            return -1;
+        }
+
+        int rc = connect(static_cast<int>(fd), addresses->ai_addr, static_cast<socklen_t>(addresses->ai_addrlen));
+        freeaddrinfo(addresses);
+
+        if (0 != rc && !connectInProgress())
+        {
+            LAPS_CLOSESOCKET(static_cast<int>(fd));
+            return -1;
+        }
+
+        _socket = fd;
+        _connecting = true;
+        return 0;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Check on a connect started by startConnectionToReader()
+ **
+ ** The socket goes back to blocking once connected, unless
+ ** setNonBlocking() asked for it to stay non-blocking. The receive
+ ** calls poll before they read either way.
+ **
+ ** @param[in]  nMaxMS          0 => check and return immediately
+ **                             >0 => ms to wait for the connect
+ **
+ ** @return     1               Connected
+ **             0               Still connecting, wait for writable
+ **             -1              Failed and closed, see getConnectError()
+ **
+ *****************************************************************************/
+
+    int CLLRPConnection::finishConnect(int nMaxMS)
+    {
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            return -1;
+        }
+        if (!_connecting)
+        {
+            return 1;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = static_cast<decltype(pfd.fd)>(_socket);
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+
+        int rc = LAPS_POLL(&pfd, 1, (nMaxMS > 0) ? nMaxMS : 0);
+        if (0 == rc || (rc < 0 && EINTR == errno))
+        {
+            return 0;
+        }
+
+        int error = 0;
+        socklen_t length = sizeof error;
+        if (rc < 0 || 0 != getsockopt(static_cast<int>(_socket), SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length) ||
+            0 != error || !setBlocking(_socket, !_nonBlocking))
+        {
+            _connectError = "connect failed";
+            closeConnectionToReader();
+            return -1;
+        }
+
+        connected();
+        return 1;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Fresh connection state once the socket is connected
+ **
+ ** Nagle is turned off, LLRP commands are small and every one
+ ** of them waits for an answer. Where sends cannot be flagged
+ ** MSG_NOSIGNAL the socket is told not to raise SIGPIPE.
+ **
+ *****************************************************************************/
+
+    void CLLRPConnection::connected()
+    {
+        int noDelay = 1;
+        setsockopt(static_cast<int>(_socket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof noDelay);
+#ifdef SO_NOSIGPIPE
+        int noSigPipe = 1;
+        setsockopt(static_cast<int>(_socket), SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof noSigPipe);
+#endif
+
+        _connecting = false;
+        _recvStart = _recvEnd = _recvConsume = 0;
+        releaseQueuedFrames();
+        _connectError.clear();
+        _lastFrameNSec = CLatencyRecorder::nowNSec();
+        _linkDead = false;
+    }
+
+
+    int CLLRPConnection::closeConnectionToReader()
+    {
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            return -1;
+        }
+        LAPS_CLOSESOCKET(static_cast<int>(_socket));
+        _socket = INVALID_SOCKET_FD;
+        _connecting = false;
+        _pendingSend.clear();
+        _pendingSendStart = 0;
+        _queuedFrames.clear();
+        _queueHead = 0;
+        _frameArena.reset();
+        return 0;
+    }
+
+
+    void CLLRPConnection::setNonBlocking(bool nonBlocking)
+    {
+        _nonBlocking = nonBlocking;
+        if (INVALID_SOCKET_FD != _socket && !_connecting)
+        {
+            setBlocking(_socket, !nonBlocking);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send one encoded frame, capturing it if enabled
+ **
+ ** On a non-blocking connection whatever the socket does not take
+ ** now is kept for flushSend(), and a frame behind kept bytes is
+ ** queued after them whole. RC_OK then means sent or queued.
+ **
+ *****************************************************************************/
+
+    LLRP::EResultCode CLLRPConnection::sendFrame(const unsigned char *frame, unsigned int length)
+    {
+        setError(_sendError, LLRP::RC_OK, nullptr);
+
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            setError(_sendError, LLRP::RC_MiscError, "not connected");
+            return LLRP::RC_MiscError;
+        }
+
+        if (_capture)
+        {
+            _capture->write(CFrameCapture::Outbound, CLatencyRecorder::nowNSec(), frame, length);
+        }
+
+        if (hasPendingSend())
+        {
+            _pendingSend.insert(_pendingSend.end(), frame, frame + length);
+            return flushSend();
+        }
+
+        std::size_t sent = 0;
+        if (!sendSome(frame, length, sent))
+        {
+            setError(_sendError, LLRP::RC_SendIOError, "send IO error");
+            return LLRP::RC_SendIOError;
+        }
+        if (sent < length)
+        {
+            _pendingSend.assign(frame + sent, frame + length);
+            _pendingSendStart = 0;
+        }
+        return LLRP::RC_OK;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send the bytes a non-blocking sendFrame() had to keep
+ **
+ ** Takes what the socket takes without waiting, the caller polls
+ ** for writable while hasPendingSend().
+ **
+ *****************************************************************************/
+
+    LLRP::EResultCode CLLRPConnection::flushSend()
+    {
+        setError(_sendError, LLRP::RC_OK, nullptr);
+
+        if (!hasPendingSend())
+        {
+            return LLRP::RC_OK;
+        }
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            setError(_sendError, LLRP::RC_MiscError, "not connected");
+            return LLRP::RC_MiscError;
+        }
+
+        if (!sendSome(_pendingSend.data(), _pendingSend.size(), _pendingSendStart))
+        {
+            setError(_sendError, LLRP::RC_SendIOError, "send IO error");
+            return LLRP::RC_SendIOError;
+        }
+        if (!hasPendingSend())
+        {
+            _pendingSend.clear();
+            _pendingSendStart = 0;
+        }
+        return LLRP::RC_OK;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send from data + sent on until all is sent or, when
+ **         non-blocking, until the socket takes no more
+ **
+ ** @return     false           The send failed
+ **
+ *****************************************************************************/
+
+    bool CLLRPConnection::sendSome(const unsigned char *data, std::size_t length, std::size_t &sent)
+    {
+        while (sent < length)
+        {
+            auto n = send(static_cast<int>(_socket), reinterpret_cast<const char *>(data + sent), static_cast<int>(length - sent),
+                          LAPS_SEND_FLAGS);
+            if (n < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            if (n < 0 && _nonBlocking && wouldBlock())
+            {
+                return true;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+
+    LLRP::EResultCode CLLRPConnection::sendMessage(LLRP::CMessage *message)
+    {
+        LLRP::CFrameEncoder encoder(_sendBuffer.data(), static_cast<unsigned int>(_sendBuffer.size()));
+
+        encoder.encodeElement(message);
+        if (LLRP::RC_OK != encoder.m_ErrorDetails.m_eResultCode)
+        {
+            _sendError = encoder.m_ErrorDetails;
+            return _sendError.m_eResultCode;
+        }
+
+        return sendFrame(_sendBuffer.data(), encoder.getLength());
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Watch for a dead link
+ **
+ ** The reader sends a KEEPALIVE every keepaliveIntervalMS once its
+ ** KeepaliveSpec asks for it (see CReaderConfig). Any frame proves
+ ** the link alive, not just keepalives. The clock starts now.
+ **
+ *****************************************************************************/
+
+    void CLLRPConnection::setLinkTimeout(std::uint32_t keepaliveIntervalMS, unsigned int missedKeepalives)
+    {
+        _linkTimeoutNSec = static_cast<std::uint64_t>(keepaliveIntervalMS) * missedKeepalives * 1000000u;
+        _lastFrameNSec = CLatencyRecorder::nowNSec();
+    }
+
+
+    void CLLRPConnection::ackKeepalive(std::uint32_t messageId)
+    {
+        unsigned char ack[LLRP_HEADER_SIZE];
+
+        ack[0] = static_cast<unsigned char>((1u << 2) | (KEEPALIVE_ACK_TYPE >> 8));     /* version 1 */
+        ack[1] = static_cast<unsigned char>(KEEPALIVE_ACK_TYPE);
+        writeU32(ack + 2, LLRP_HEADER_SIZE);
+        writeU32(ack + 6, messageId);
+
+        /* A failed send shows up as a dead link soon enough */
+        sendFrame(ack, LLRP_HEADER_SIZE);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Wait until the socket has data
+ **
+ ** @param[in]  nMaxMS          -1 => block indefinitely
+ **                              0 => poll, return immediately
+ **                             >0 => ms to wait
+ **
+ ** @return     true            Readable (or closed, recv will tell)
+ **             false           Timed out or failed, _recvError set
+ **
+ *****************************************************************************/
+
+    bool CLLRPConnection::waitReadable(int nMaxMS)
+    {
+        struct pollfd pfd;
+        pfd.fd = static_cast<decltype(pfd.fd)>(_socket);
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        for (;;)
+        {
+            int rc = LAPS_POLL(&pfd, 1, nMaxMS);
+            if (rc > 0)
+            {
+                return true;
+            }
+            if (0 == rc)
+            {
+                setError(_recvError, LLRP::RC_RecvTimeout, "timeout");
+                return false;
+            }
+            if (EINTR != errno)
+            {
+                setError(_recvError, LLRP::RC_RecvIOError, "poll IO error");
+                return false;
+            }
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Try to cut the next complete frame out of the buffer
+ **
+ ** @return     true            _frame describes a complete frame
+ **             false           Need more bytes, or a framing error
+ **                             was set in _recvError
+ **
+ *****************************************************************************/
+
+    bool CLLRPConnection::extractFrame()
+    {
+        std::size_t available = _recvEnd - _recvStart;
+        if (available < LLRP_HEADER_SIZE)
+        {
+            return false;
+        }
+
+        const unsigned char *header = _recvBuffer.data() + _recvStart;
+        std::uint32_t length = readU32(header + 2);
+
+        if (length < LLRP_HEADER_SIZE)
+        {
+            setError(_recvError, LLRP::RC_RecvFramingError, "frame length smaller than header");
+            return false;
+        }
+        if (length > MAX_FRAME_SIZE)
+        {
+            setError(_recvError, LLRP::RC_RecvBufferOverflow, "frame larger than MAX_FRAME_SIZE");
+            return false;
+        }
+        if (available < length)
+        {
+            return false;
+        }
+
+        _frame.data = header;
+        _frame.length = length;
+        _frame.messageType = ((header[0] & 0x03u) << 8) | header[1];
+        _frame.messageId = readU32(header + 6);
+        _frame.hostReceivedNSec = _lastRecvNSec;
+        _recvConsume = length;
+
+        if (length > _largestRecentFrame)
+        {
+            _largestRecentFrame = length;
+        }
+        _framesSinceResize++;
+
+        if (_capture)
+        {
+            _capture->write(CFrameCapture::Inbound, _frame.hostReceivedNSec, _frame.data, _frame.length);
+        }
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive buffer size for frames of a given size
+ **
+ ** Room for RECV_FRAMES_PER_READ of them, so a burst of reports
+ ** waiting in the socket comes in with one recv.
+ **
+ *****************************************************************************/
+
+    std::size_t CLLRPConnection::recvBufferSizeFor(std::size_t frameLength)
+    {
+        std::size_t size = MIN_RECV_BUFFER_SIZE;
+
+        while (size < frameLength * RECV_FRAMES_PER_READ)
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Give back a buffer grown for frames that stopped coming
+ **
+ ** Every RECV_RESIZE_WINDOW frames, with the buffer empty, the
+ ** buffer drops to what the largest frame of the window needs if
+ ** that is less than a quarter of it. Growing is done on the spot
+ ** by readFrame(), when a frame does not fit.
+ **
+ *****************************************************************************/
+
+    void CLLRPConnection::shrinkRecvBuffer()
+    {
+        if (_framesSinceResize < RECV_RESIZE_WINDOW)
+        {
+            return;
+        }
+
+        std::size_t size = recvBufferSizeFor(_largestRecentFrame);
+        if (size < _recvBuffer.size() / 4)
+        {
+            std::vector<unsigned char>(size).swap(_recvBuffer);
+        }
+        _framesSinceResize = 0;
+        _largestRecentFrame = 0;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive the next raw frame, queued ones first
+ **
+ ** @return     !=NULL          Frame, valid until the next receive
+ **             ==NULL          Error or timeout, see getRecvError()
+ **
+ *****************************************************************************/
+
+    const CLLRPFrame *CLLRPConnection::recvFrame(int nMaxMS)
+    {
+        releaseQueuedFrames();
+
+        if (_queueHead < _queuedFrames.size())
+        {
+            setError(_recvError, LLRP::RC_OK, nullptr);
+            const CLLRPFrame *frame = &_queuedFrames[_queueHead++];
+            _frameReceivedNSec = frame->hostReceivedNSec;
+            return frame;
+        }
+        return readFrame(nMaxMS);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Drop the queued frames once they have all been handed out
+ **
+ ** The last one handed out is only valid until the next receive,
+ ** which is what calls this.
+ **
+ *****************************************************************************/
+
+    void CLLRPConnection::releaseQueuedFrames()
+    {
+        if (_queueHead == _queuedFrames.size() && 0 != _queueHead)
+        {
+            _queuedFrames.clear();
+            _queueHead = 0;
+            _frameArena.reset();
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive the next raw frame from the socket
+ **
+ ** Every recv takes as much as the buffer has room for, so frames
+ ** already waiting in the socket come in with one syscall and are
+ ** then handed out from the buffer.
+ **
+ *****************************************************************************/
+
+    const CLLRPFrame *CLLRPConnection::readFrame(int nMaxMS)
+    {
+        setError(_recvError, LLRP::RC_OK, nullptr);
+
+        _recvStart += _recvConsume;
+        _recvConsume = 0;
+        if (_recvStart == _recvEnd)
+        {
+            _recvStart = _recvEnd = 0;
+            shrinkRecvBuffer();
+        }
+
+        if (INVALID_SOCKET_FD == _socket)
+        {
+            setError(_recvError, LLRP::RC_RecvIOError, "not connected");
+            return nullptr;
+        }
+        if (_linkDead)
+        {
+            setError(_recvError, LLRP::RC_RecvTimeout, "link dead, keepalives missed");
+            return nullptr;
+        }
+
+        std::uint64_t deadlineNSec = CLatencyRecorder::nowNSec() + static_cast<std::uint64_t>(nMaxMS > 0 ? nMaxMS : 0) * 1000000u;
+
+        for (;;)
+        {
+            if (extractFrame())
+            {
+                _lastFrameNSec = _frame.hostReceivedNSec;
+                if (KEEPALIVE_TYPE == _frame.messageType)
+                {
+                    _keepaliveCount++;
+                    ackKeepalive(_frame.messageId);
+                    _recvStart += _recvConsume;
+                    _recvConsume = 0;
+                    continue;
+                }
+                _frameReceivedNSec = _frame.hostReceivedNSec;
+                return &_frame;
+            }
+            if (LLRP::RC_OK != _recvError.m_eResultCode)
+            {
+                return nullptr;
+            }
+
+            /*
+             * Partial frame that will not fit behind the frames
+             * already handed out: move it to the front, and grow
+             * the buffer if it is too big even then.
+             */
+
+            std::size_t needed = (_recvEnd - _recvStart >= LLRP_HEADER_SIZE)
+                                 ? readU32(_recvBuffer.data() + _recvStart + 2) : LLRP_HEADER_SIZE;
+            if (_recvStart + needed > _recvBuffer.size())
+            {
+                std::memmove(_recvBuffer.data(), _recvBuffer.data() + _recvStart, _recvEnd - _recvStart);
+                _recvEnd -= _recvStart;
+                _recvStart = 0;
+
+                if (needed > _recvBuffer.size())
+                {
+                    _recvBuffer.resize(recvBufferSizeFor(needed));
+                    _framesSinceResize = 0;
+                    _largestRecentFrame = 0;
+                }
+            }
+
+            /*
+             * Never wait past the link deadline, the caller's
+             * timeout may be seconds.
+             */
+
+            std::uint64_t now = CLatencyRecorder::nowNSec();
+            int waitMS = (nMaxMS > 0) ? msUntil(deadlineNSec, now) : nMaxMS;
+            if (0 != _linkTimeoutNSec)
+            {
+                int linkWaitMS = msUntil(_lastFrameNSec + _linkTimeoutNSec, now);
+                if (waitMS < 0 || linkWaitMS < waitMS)
+                {
+                    waitMS = linkWaitMS;
+                }
+            }
+            if (!waitReadable(waitMS))
+            {
+                if (LLRP::RC_RecvTimeout == _recvError.m_eResultCode && 0 != _linkTimeoutNSec &&
+                    CLatencyRecorder::nowNSec() >= _lastFrameNSec + _linkTimeoutNSec)
+                {
+                    _linkDead = true;
+                    setError(_recvError, LLRP::RC_RecvTimeout, "link dead, keepalives missed");
+                }
+                return nullptr;
+            }
+
+            auto n = recv(static_cast<int>(_socket), reinterpret_cast<char *>(_recvBuffer.data() + _recvEnd),
+                          static_cast<int>(_recvBuffer.size() - _recvEnd), 0);
+            if (0 == n)
+            {
+                setError(_recvError, LLRP::RC_RecvEOF, "connection closed by reader");
+                return nullptr;
+            }
+            if (n < 0)
+            {
+                // Non-blocking, the poll said readable but there was nothing after all
+                if (EINTR == errno || (_nonBlocking && wouldBlock()))
+                {
+                    continue;
+                }
+                setError(_recvError, LLRP::RC_RecvIOError, "recv IO error");
+                return nullptr;
+            }
+
+            _lastRecvNSec = CLatencyRecorder::nowNSec();
+            _recvEnd += static_cast<std::size_t>(n);
+        }
+    }
+
+
+    LLRP::CMessage *CLLRPConnection::decodeFrame(const CLLRPFrame *frame)
+    {
+        LLRP::CFrameDecoder decoder(_typeRegistry, const_cast<unsigned char *>(frame->data), frame->length);
+        LLRP::CMessage *message = decoder.decodeMessage();
+
+        if (nullptr == message)
+        {
+            _recvError = decoder.m_ErrorDetails;
+        }
+        return message;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive the next message, queued ones first
+ **
+ ** The message returned resides in allocated memory. It is the
+ ** caller's obligation to free it.
+ **
+ ** @return     !=NULL          Pointer to a message
+ **             ==NULL          Error or timeout, see getRecvError()
+ **
+ *****************************************************************************/
+
+    LLRP::CMessage *CLLRPConnection::recvMessage(int nMaxMS)
+    {
+        const CLLRPFrame *frame = recvFrame(nMaxMS);
+        if (nullptr == frame)
+        {
+            return nullptr;
+        }
+        return decodeFrame(frame);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive the response to a request
+ **
+ ** A response matches on message type and ID. An ERROR_MESSAGE
+ ** with the ID counts as the response too. Everything else is
+ ** copied to the frame arena, undecoded, for the receive calls,
+ ** so a report that comes in now still takes the fast path.
+ **
+ *****************************************************************************/
+
+    LLRP::CMessage *CLLRPConnection::recvResponse(int nMaxMS, const LLRP::CTypeDescriptor *responseType, LLRP::llrp_u32_t responseMessageId)
+    {
+        std::uint64_t deadlineNSec = CLatencyRecorder::nowNSec() + static_cast<std::uint64_t>(nMaxMS > 0 ? nMaxMS : 0) * 1000000u;
+
+        releaseQueuedFrames();
+
+        for (;;)
+        {
+            int waitMS = (nMaxMS > 0) ? msUntil(deadlineNSec, CLatencyRecorder::nowNSec()) : nMaxMS;
+
+            const CLLRPFrame *frame = readFrame(waitMS);
+            if (nullptr == frame)
+            {
+                return nullptr;
+            }
+
+            if (responseMessageId == frame->messageId &&
+                (responseType->m_TypeNum == frame->messageType ||
+                 LLRP::CERROR_MESSAGE::s_typeDescriptor.m_TypeNum == frame->messageType))
+            {
+                return decodeFrame(frame);
+            }
+
+            CLLRPFrame queued = *frame;
+            queued.data = _frameArena.copy(frame->data, frame->length);
+            _queuedFrames.push_back(queued);
+        }
+    }
+
+
+    LLRP::CMessage *CLLRPConnection::transact(LLRP::CMessage *sendMessage, int nMaxMS)
+    {
+        setError(_transactError, LLRP::RC_OK, nullptr);
+
+        const LLRP::CTypeDescriptor *responseType = sendMessage->m_pType->m_pResponseType;
+        if (nullptr == responseType)
+        {
+            setError(_transactError, LLRP::RC_MissingResponseType, "message has no response type");
+            return nullptr;
+        }
+
+        if (LLRP::RC_OK != this->sendMessage(sendMessage))
+        {
+            _transactError = _sendError;
+            return nullptr;
+        }
+
+        LLRP::CMessage *response = recvResponse(nMaxMS, responseType, sendMessage->getMessageID());
+        if (nullptr == response)
+        {
+            _transactError = _recvError;
+        }
+        return response;
+    }
+}
@@ -0,0 +1,216 @@
+//********************************************************************
+//    created:    2026-10-18 12:30 PM
+//    file:       cllrpconnection.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CLLRPCONNECTION_H
+#define LLRPLAPS_CLLRPCONNECTION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ltkcpp.h>
+
+#include "cframearena.h"
+
+struct addrinfo;
+
+namespace LLRPLaps
+{
+    class CFrameCapture;
+
+    /*
+     * One complete LLRP frame sitting in the connection's receive
+     * buffer. The pointer is valid until the next receive call.
+     */
+    struct CLLRPFrame
+    {
+        const unsigned char *data;
+        unsigned int length;
+        unsigned int messageType;
+        std::uint32_t messageId;
+        std::uint64_t hostReceivedNSec;     // CLatencyRecorder::nowNSec of the recv that completed it
+    };
+
+
+    /*
+     * TCP connection to an LLRP reader.
+     *
+     * A drop in for LLRP::CConnection with the same calls and the
+     * same NULL-plus-error-details conventions, but the socket and
+     * the frame buffer are ours. That gives access to the raw
+     * frames (recvFrame/sendFrame), a host timestamp taken at the
+     * socket read and optional capture of all traffic.
+     *
+     * Frames that arrive while transact() waits for its response
+     * are copied into a frame arena, still undecoded, and handed
+     * out first by the receive calls, in order. Once they are all
+     * handed out the arena is reset in one go.
+     *
+     * The receive buffer has no fixed size. It grows on the spot for
+     * a frame that does not fit, up to MAX_FRAME_SIZE, and shrinks
+     * back once frames have been small for a while. Either way it
+     * keeps room for a few frames so a burst comes in with one recv.
+     *
+     * KEEPALIVEs are acknowledged and swallowed by the receive
+     * calls. With a link timeout set, a receive that sees nothing
+     * at all from the reader for that long fails and the link is
+     * dead until reconnected, however long the caller meant to wait.
+     *
+     * A non-blocking connection never waits in a send: what the
+     * socket does not take is kept, in order, until flushSend()
+     * gets it out, for a caller that polls the socket itself.
+     */
+    class CLLRPConnection
+    {
+    public:
+        // Only outbound frames are limited in size, the receive buffer sizes itself
+        CLLRPConnection(const LLRP::CTypeRegistry *typeRegistry, unsigned int maxSendFrameSize);
+
+        ~CLLRPConnection();
+
+        // "host" or "host:port", the port defaults to 5084. Returns 0 on success
+        int openConnectionToReader(const char *readerHostName);
+
+        // Non-blocking open for an event loop: start it, wait for the socket to be writable, finish it
+        int startConnectionToReader(const char *readerHostName);
+
+        // 1 connected, 0 still in progress after nMaxMS, -1 failed, see getConnectError()
+        int finishConnect(int nMaxMS = 0);
+
+        int closeConnectionToReader();
+
+        // Keep the socket non-blocking once connected, sends that do not fit wait for flushSend()
+        void setNonBlocking(bool nonBlocking);
+
+        // Send what the socket did not take before, as much as it takes now
+        LLRP::EResultCode flushSend();
+
+        bool hasPendingSend() const { return _pendingSendStart < _pendingSend.size(); }
+
+        // For polling alongside other sockets, -1 when not connected
+        std::intptr_t getSocket() const { return _socket; }
+
+        const char *getConnectError() const { return _connectError.c_str(); }
+
+        LLRP::CMessage *transact(LLRP::CMessage *sendMessage, int nMaxMS);
+
+        const LLRP::CErrorDetails *getTransactError() const { return &_transactError; }
+
+        LLRP::EResultCode sendMessage(LLRP::CMessage *message);
+
+        LLRP::EResultCode sendFrame(const unsigned char *frame, unsigned int length);
+
+        const LLRP::CErrorDetails *getSendError() const { return &_sendError; }
+
+        LLRP::CMessage *recvMessage(int nMaxMS);
+
+        LLRP::CMessage *recvResponse(int nMaxMS, const LLRP::CTypeDescriptor *responseType, LLRP::llrp_u32_t responseMessageId);
+
+        const CLLRPFrame *recvFrame(int nMaxMS);
+
+        LLRP::CMessage *decodeFrame(const CLLRPFrame *frame);
+
+        const LLRP::CErrorDetails *getRecvError() const { return &_recvError; }
+
+        // Host receive time of the frame behind the last recvFrame/recvMessage
+        std::uint64_t getFrameReceivedNSec() const { return _frameReceivedNSec; }
+
+        void setCapture(std::shared_ptr<CFrameCapture> capture) { _capture = capture; }
+
+        // Dead after missedKeepalives keepalive periods of silence, 0 turns it off
+        void setLinkTimeout(std::uint32_t keepaliveIntervalMS, unsigned int missedKeepalives);
+
+        bool isLinkDead() const { return _linkDead; }
+
+        std::uint64_t getKeepaliveCount() const { return _keepaliveCount; }
+
+        std::size_t getRecvBufferSize() const { return _recvBuffer.size(); }
+
+        // When the link is declared dead if nothing arrives, 0 without a link timeout
+        std::uint64_t getLinkDeadlineNSec() const { return (0 == _linkTimeoutNSec) ? 0 : _lastFrameNSec + _linkTimeoutNSec; }
+
+        const static unsigned short LLRP_PORT;
+        const static unsigned int LLRP_HEADER_SIZE;
+        const static unsigned int KEEPALIVE_TYPE;
+        const static unsigned int KEEPALIVE_ACK_TYPE;
+        const static std::size_t MAX_FRAME_SIZE;
+        const static std::size_t MIN_RECV_BUFFER_SIZE;
+        const static std::size_t RECV_FRAMES_PER_READ;
+        const static std::uint64_t RECV_RESIZE_WINDOW;
+
+    private:
+        bool resolve(const char *readerHostName, ::addrinfo **addresses);
+
+        void connected();
+
+        const CLLRPFrame *readFrame(int nMaxMS);
+
+        void releaseQueuedFrames();
+
+        static std::size_t recvBufferSizeFor(std::size_t frameLength);
+
+        void shrinkRecvBuffer();
+
+        bool extractFrame();
+
+        bool waitReadable(int nMaxMS);
+
+        bool sendSome(const unsigned char *data, std::size_t length, std::size_t &sent);
+
+        void ackKeepalive(std::uint32_t messageId);
+
+        static void setError(LLRP::CErrorDetails &errorDetails, LLRP::EResultCode resultCode, const char *whatStr);
+
+        const LLRP::CTypeRegistry *_typeRegistry;
+        std::intptr_t _socket;
+        std::string _connectError;
+        bool _connecting;
+        bool _nonBlocking;
+
+        std::vector<unsigned char> _recvBuffer;
+        std::size_t _recvStart;
+        std::size_t _recvEnd;
+        std::size_t _recvConsume;
+        std::uint64_t _lastRecvNSec;
+        std::size_t _largestRecentFrame;
+        std::uint64_t _framesSinceResize;
+        CLLRPFrame _frame;
+
+        std::vector<unsigned char> _sendBuffer;
+        std::vector<unsigned char> _pendingSend;
+        std::size_t _pendingSendStart;
+        std::vector<CLLRPFrame> _queuedFrames;
+        std::size_t _queueHead;
+        CFrameArena _frameArena;
+        std::uint64_t _frameReceivedNSec;
+
+        std::uint64_t _linkTimeoutNSec;
+        std::uint64_t _lastFrameNSec;
+        std::uint64_t _keepaliveCount;
+        bool _linkDead;
+
+        LLRP::CErrorDetails _recvError;
+        LLRP::CErrorDetails _sendError;
+        LLRP::CErrorDetails _transactError;
+
+        std::shared_ptr<CFrameCapture> _capture;
+    };
+}
+#endif //LLRPLAPS_CLLRPCONNECTION_H
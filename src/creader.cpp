@@ -9,6 +9,10 @@
 #include "exceptions.h"
 #include "creader.h"
 #include "ctaginfo.h"
+#include "clatencyrecorder.h"
+#include "cepcinterner.h"
+#include "cllrpconnection.h"
+#include "cframecapture.h"
 
 
 namespace LLRPLaps
@@ -17,11 +21,34 @@ namespace LLRPLaps
     const int CReader::TIMEOUT_7SEC = 7000;
     const int CReader::TIMEOUT_5SEC = 5000;
 
-    CReader::CReader(QString readerHostName): _readerHostname (readerHostName), _connectionToReader(nullptr), _typeRegistry(nullptr)
+    // Longest a reconnect holds up ProcessRecentChipsSeen() waiting for the TCP connect
+    const int CReader::RECONNECT_POLL_MS = 100;
+
+    CReader::CReader(QString readerHostName): CReaderProtocol(readerHostName), _typeRegistry(nullptr),
+                                              _reconnectPending(false), _reinstallPending(false),
+                                              _connecting(false), _connectDeadlineNSec(0)
     {
     }
 
+
     void CReader::Connect()
+    {
+        createConnection();
+
+        /*
+         * Open the connection to the reader
+         */
+
+        if (_connectionToReader->openConnectionToReader(_readerHostname.toLatin1().data()))
+        {
+            throw LLRPLaps::ReaderException(QString().sprintf("ERROR: connect: %s", _connectionToReader->getConnectError()).toStdString());
+        }
+
+        setUpReader();
+    }
+
+
+    void CReader::createConnection()
     {
         /*
          * Allocate the type registry. This is needed
@@ -35,43 +62,182 @@ namespace LLRPLaps
         }
 
         /*
-         * Construct a connection (LLRP::CConnection).
-         * Using a 32kb max frame size for send/recv.
+         * Construct a connection (CLLRPConnection).
+         * Commands are limited to 32kb, the receive buffer
+         * grows and shrinks with the reports.
          * The connection object is ready for business
          * but not actually connected to the reader yet.
          */
 
-        _connectionToReader = std::make_shared<LLRP::CConnection>(new LLRP::CConnection(_typeRegistry, 32u * 1024u));
+        _connectionToReader.reset(new CLLRPConnection(_typeRegistry, 32u * 1024u));
         if (!_connectionToReader.get())
         {
-            throw LLRPLaps::ReaderException("ERROR: new CConnection failed");
+            throw LLRPLaps::ReaderException("ERROR: new CLLRPConnection failed");
         }
+        _connectionToReader->setCapture(_capture);
+    }
+
 
+    void CReader::setUpReader()
+    {
         /*
-         * Open the connection to the reader
+         * Commence the sequence and check for errors as we go.
+         * See comments for each routine for details.
+         * Each routine prints messages. Any failure here is
+         * fatal and thrown.
          */
 
-        if (_connectionToReader->openConnectionToReader(_readerHostname.toLatin1().data()))
+        checkConnectionStatus();
+        scrubConfiguration().raiseOnError();
+        setReaderConfiguration().raiseOnError();
+        updateEpcFilters();
+        addROSpec().raiseOnError();
+        enableROSpec().raiseOnError();
+        _reconfigurePending = false;
+    }
+
+
+    CResult<void> CReader::ProcessRecentChipsSeen()
+    {
+        if (_reconnectPending)
         {
-            throw LLRPLaps::ReaderException(QString().sprintf("ERROR: connect: %s", _connectionToReader->getConnectError()).toStdString());
+            CResult<void> reconnected = reconnect();
+            if (!reconnected)
+            {
+                return reconnected;
+            }
         }
 
+        CResult<void> result = inventoryCycle();
+
         /*
-         * Commence the sequence and check for errors as we go.
-         * See comments for each routine for details.
-         * Each routine prints messages.
+         * Missed keepalives: raise the alarm and get the reader
+         * back straight away. Anything else, a quiet track timing
+         * out included, goes back to the caller.
          */
 
-        checkConnectionStatus();
-        scrubConfiguration();
-        addROSpec();
-        enableROSpec();
+        if (!result && _connectionToReader && _connectionToReader->isLinkDead())
+        {
+            emit linkDown(QString::fromStdString(result.error().message));
+            return reconnect();
+        }
+        return result;
     }
 
-    void CReader::ProcessRecentChipsSeen()
+
+    CResult<void> CReader::inventoryCycle()
     {
-        startROSpec();
-        awaitReports();
+        CResult<void> result;
+
+        bool roSpecChanged = updateEpcFilters();
+        roSpecChanged = updateReportBatching() || roSpecChanged;
+
+        if (roSpecChanged || _reinstallPending)
+        {
+            /*
+             * The ROSpec is idle between cycles, swap it for one
+             * with the new filters or report settings. Until that
+             * worked every cycle tries again.
+             */
+
+            _reinstallPending = true;
+            if (!(result = deleteAllROSpecs()) || !(result = addROSpec()) || !(result = enableROSpec()))
+            {
+                return result;
+            }
+            _reinstallPending = false;
+        }
+
+        result = startROSpec();
+        if (!result)
+        {
+            return result;
+        }
+        return awaitReports();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Drop the connection and set the reader up from scratch
+ **
+ ** The TCP connect does not block: each call waits at most
+ ** RECONNECT_POLL_MS for it and returns a timeout while it is under
+ ** way, so a pulled cable does not hold up the caller's thread for
+ ** the kernel's connect timeout. An attempt still pending after
+ ** TIMEOUT_10SEC is dropped and the next call starts another one.
+ ** Once connected the reader is set up as by Connect().
+ **
+ ** If the reader is not back yet the error goes to the caller and
+ ** the next ProcessRecentChipsSeen() carries on.
+ **
+ *****************************************************************************/
+
+    CResult<void> CReader::reconnect()
+    {
+        _reconnectPending = true;
+
+        if (!_connecting)
+        {
+            try
+            {
+                if (_connectionToReader)
+                {
+                    _connectionToReader->closeConnectionToReader();
+                }
+                else
+                {
+                    createConnection();
+                }
+            }
+            catch (const LLRPLaps::ReaderException &e)
+            {
+                return CReaderError(ReaderErrorCode::Connection, e.what());
+            }
+
+            if (0 != _connectionToReader->startConnectionToReader(_readerHostname.toLatin1().data()))
+            {
+                return CReaderError(ReaderErrorCode::Connection,
+                                    std::string("ERROR: connect: ") + _connectionToReader->getConnectError());
+            }
+            _connecting = true;
+            _connectDeadlineNSec = CLatencyRecorder::nowNSec() + static_cast<std::uint64_t>(TIMEOUT_10SEC) * 1000000u;
+        }
+
+        int connected = _connectionToReader->finishConnect(RECONNECT_POLL_MS);
+        if (0 == connected)
+        {
+            if (CLatencyRecorder::nowNSec() < _connectDeadlineNSec)
+            {
+                return CReaderError(ReaderErrorCode::Timeout, "ERROR: connect: still connecting");
+            }
+            _connectionToReader->closeConnectionToReader();
+            _connecting = false;
+            return CReaderError(ReaderErrorCode::Connection, "ERROR: connect: timed out");
+        }
+
+        _connecting = false;
+        if (connected < 0)
+        {
+            return CReaderError(ReaderErrorCode::Connection,
+                                std::string("ERROR: connect: ") + _connectionToReader->getConnectError());
+        }
+
+        try
+        {
+            setUpReader();
+        }
+        catch (const LLRPLaps::ReaderException &e)
+        {
+            _connectionToReader->closeConnectionToReader();
+            return CReaderError(ReaderErrorCode::Connection, e.what());
+        }
+
+        _reconnectPending = false;
+        _reinstallPending = false;
+        emit linkRestored();
+        return CResult<void>();
     }
 
 
@@ -80,8 +246,12 @@ namespace LLRPLaps
         // Don't blow exceptions in the destructor
         try
         {
-            scrubConfiguration();
-            _connectionToReader->closeConnectionToReader();
+            if (_connectionToReader)
+            {
+                // Best effort, the reader is let go whatever it answers
+                static_cast<void>(scrubConfiguration());
+                _connectionToReader->closeConnectionToReader();
+            }
         }
         catch (const std::exception& e)
         {
@@ -128,17 +298,17 @@ namespace LLRPLaps
          * Expect the notification within 10 seconds.
          * It is suppose to be the very first message sent.
          */
-        std::shared_ptr<LLRP::CMessage> message = recvMessage(TIMEOUT_10SEC);
+        CResult<std::shared_ptr<LLRP::CMessage>> received = recvMessage(TIMEOUT_10SEC);
 
         /*
-         * recvMessage() returns NULL if something went wrong.
+         * No notification at all means no usable connection.
          */
 
-        if (nullptr == message.get())
+        if (!received)
         {
-            /* recvMessage already tattled */
-            throw LLRPLaps::ReaderConnectionException("recvMessage failed: No connection");
+            throw LLRPLaps::ReaderConnectionException("recvMessage failed: No connection, " + received.error().message);
         }
+        std::shared_ptr<LLRP::CMessage> message = received.value();
 
         /*
          * Check to make sure the message is of the right type.
@@ -199,10 +369,14 @@ namespace LLRPLaps
  **
  *****************************************************************************/
 
-    void CReader::scrubConfiguration()
+    CResult<void> CReader::scrubConfiguration()
     {
-        resetConfigurationToFactoryDefaults();
-        deleteAllROSpecs();
+        CResult<void> result = resetConfigurationToFactoryDefaults();
+        if (!result)
+        {
+            return result;
+        }
+        return deleteAllROSpecs();
     }
 
 
@@ -217,37 +391,81 @@ namespace LLRPLaps
  **
  ** The message is:
  **
- **     <SET_READER_CONFIG MessageID='101'>
+ **     <SET_READER_CONFIG MessageID='n'>
  **       <ResetToFactoryDefault>1</ResetToFactoryDefault>
  **     </SET_READER_CONFIG>
  **
  *****************************************************************************/
 
-    void CReader::resetConfigurationToFactoryDefaults()
+    CResult<void> CReader::resetConfigurationToFactoryDefaults()
     {
         /*
-         * Compose the command message
+         * Send the pre-encoded message, expect the response of certain type
+         */
+
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.resetToFactoryDefaults,
+                                                                       &LLRP::CSET_READER_CONFIG_RESPONSE::s_typeDescriptor);
+
+        /*
+         * transactFrame() says what went wrong, pass it on.
+         */
+
+        if (!response)
+        {
+            return response.error();
+        }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
+
+        /*
+         * Cast to a SET_READER_CONFIG_RESPONSE message.
+         */
+
+        auto *configResponse = dynamic_cast<LLRP::CSET_READER_CONFIG_RESPONSE *>(responseMessage.get());
+
+        /*
+         * Check the LLRPStatus parameter.
          */
 
-        std::shared_ptr<LLRP::CSET_READER_CONFIG> readerConfig (new LLRP::CSET_READER_CONFIG());
-        readerConfig->setMessageID(101);
-        readerConfig->setResetToFactoryDefault(1);
+        return checkLLRPStatus(configResponse->getLLRPStatus(), "resetConfigurationToFactoryDefaults");
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send the antenna configuration with SET_READER_CONFIG
+ **
+ ** Nothing is sent for the default reader config, the reader
+ ** then stays at its factory defaults.
+ **
+ ** See CCommandFrames::makeSetReaderConfig for the message.
+ **
+ *****************************************************************************/
+
+    CResult<void> CReader::setReaderConfiguration()
+    {
+        if (_commands.setReaderConfig.empty())
+        {
+            return CResult<void>();
+        }
 
         /*
-         * Send the message, expect the response of certain type
+         * The link timeout starts with the reader sending keepalives,
+         * set it only once the reader took the config.
          */
 
-        std::shared_ptr<LLRP::CMessage> responseMessage = transact(readerConfig);
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.setReaderConfig,
+                                                                       &LLRP::CSET_READER_CONFIG_RESPONSE::s_typeDescriptor);
 
         /*
-         * transact() returns NULL if something went wrong.
+         * transactFrame() says what went wrong, pass it on.
          */
 
-        if (nullptr == responseMessage.get())
+        if (!response)
         {
-            /* transact already tattled */
-            throw LLRPLaps::ReaderException("transact command failed");
+            return response.error();
         }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
 
         /*
          * Cast to a SET_READER_CONFIG_RESPONSE message.
@@ -256,10 +474,17 @@ namespace LLRPLaps
         auto *configResponse = dynamic_cast<LLRP::CSET_READER_CONFIG_RESPONSE *>(responseMessage.get());
 
         /*
-         * Check the LLRPStatus parameter.
+         * Check the LLRPStatus parameter. A reader that rejects an
+         * index answers with a field error naming it.
          */
 
-        checkLLRPStatus(configResponse->getLLRPStatus(), "resetConfigurationToFactoryDefaults");
+        CResult<void> status = checkLLRPStatus(configResponse->getLLRPStatus(), "setReaderConfiguration");
+        if (status)
+        {
+            _connectionToReader->setLinkTimeout(_commands.readerConfig.keepaliveIntervalMS,
+                                                _commands.readerConfig.missedKeepalives);
+        }
+        return status;
     }
 
 
@@ -273,7 +498,7 @@ namespace LLRPLaps
  **
  ** The message is
  **
- **     <DELETE_ROSPEC MessageID='102'>
+ **     <DELETE_ROSPEC MessageID='n'>
  **       <ROSpecID>0</ROSpecID>
  **     </DELETE_ROSPEC>
  **
@@ -282,31 +507,24 @@ namespace LLRPLaps
  **
  *****************************************************************************/
 
-    void CReader::deleteAllROSpecs()
+    CResult<void> CReader::deleteAllROSpecs()
     {
         /*
-         * Compose the command message
+         * Send the pre-encoded message, expect the response of certain type
          */
 
-        std::shared_ptr<LLRP::CDELETE_ROSPEC> cdeleteRospec (new LLRP::CDELETE_ROSPEC());
-        cdeleteRospec->setMessageID(102);
-        cdeleteRospec->setROSpecID(0);               /* All */
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.deleteAllROSpecs,
+                                                                       &LLRP::CDELETE_ROSPEC_RESPONSE::s_typeDescriptor);
 
         /*
-         * Send the message, expect the response of certain type
+         * transactFrame() says what went wrong, pass it on.
          */
 
-        std::shared_ptr<LLRP::CMessage> responseMessage = transact(cdeleteRospec);
-
-       /*
-         * transact() returns NULL if something went wrong.
-         */
-
-        if (nullptr == responseMessage)
+        if (!response)
         {
-            /* transact already tattled */
-            throw LLRPLaps::ReaderException("transact could not create DELETE_ROSPEC command");
+            return response.error();
         }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
 
         /*
          * Cast to a DELETE_ROSPEC_RESPONSE message.
@@ -318,7 +536,7 @@ namespace LLRPLaps
          * Check the LLRPStatus parameter.
          */
 
-        checkLLRPStatus(cdeleteRospecResponse->getLLRPStatus(), "deleteAllROSpecs");
+        return checkLLRPStatus(cdeleteRospecResponse->getLLRPStatus(), "deleteAllROSpecs");
     }
 
 
@@ -342,9 +560,13 @@ namespace LLRPLaps
  ** Experience suggests that typical ROSpecs are about
  ** double this in size.
  **
+ ** The message is encoded once per ROSpec config (at compile
+ ** time for CDefaultROSpec) and only the MessageID changes
+ ** between sends.
+ **
  ** The message is
  **
- **     <ADD_ROSPEC MessageID='201'>
+ **     <ADD_ROSPEC MessageID='n'>
  **       <ROSpec>
  **         <ROSpecID>123</ROSpecID>
  **         <Priority>0</Priority>
@@ -362,7 +584,7 @@ namespace LLRPLaps
  **           <AntennaIDs>0</AntennaIDs>
  **           <AISpecStopTrigger>
  **             <AISpecStopTriggerType>Duration</AISpecStopTriggerType>
- **             <DurationTrigger>5000</DurationTrigger>
+ **             <DurationTrigger>500</DurationTrigger>
  **           </AISpecStopTrigger>
  **           <InventoryParameterSpec>
  **             <InventoryParameterSpecID>1234</InventoryParameterSpecID>
@@ -392,97 +614,26 @@ namespace LLRPLaps
  **
  *****************************************************************************/
 
-    void CReader::addROSpec(void)
+    CResult<void> CReader::addROSpec(void)
     {
-        QString s;
-
-        LLRP::CROSpecStartTrigger *pROSpecStartTrigger = new LLRP::CROSpecStartTrigger();
-        pROSpecStartTrigger->setROSpecStartTriggerType(
-                LLRP::ROSpecStartTriggerType_Null);
-
-        LLRP::CROSpecStopTrigger *pROSpecStopTrigger = new LLRP::CROSpecStopTrigger();
-        pROSpecStopTrigger->setROSpecStopTriggerType(LLRP::ROSpecStopTriggerType_Null);
-        pROSpecStopTrigger->setDurationTriggerValue(0);     /* n/a */
-
-        LLRP::CROBoundarySpec *pROBoundarySpec = new LLRP::CROBoundarySpec();
-        pROBoundarySpec->setROSpecStartTrigger(pROSpecStartTrigger);
-        pROBoundarySpec->setROSpecStopTrigger(pROSpecStopTrigger);
-
-        LLRP::CAISpecStopTrigger *pAISpecStopTrigger = new LLRP::CAISpecStopTrigger();
-        pAISpecStopTrigger->setAISpecStopTriggerType(
-                LLRP::AISpecStopTriggerType_Duration);
-        pAISpecStopTrigger->setDurationTrigger(500);
-
-        LLRP::CInventoryParameterSpec *pInventoryParameterSpec =
-                new LLRP::CInventoryParameterSpec();
-        pInventoryParameterSpec->setInventoryParameterSpecID(1234);
-        pInventoryParameterSpec->setProtocolID(LLRP::AirProtocols_EPCGlobalClass1Gen2);
-
-        // FIXME: Cannot assume all antennas
-        LLRP::llrp_u16v_t antennaIDs = LLRP::llrp_u16v_t(1);
-        antennaIDs.m_pValue[0] = 0;         /* All */
-
-        LLRP::CAISpec *pAISpec = new LLRP::CAISpec();
-        pAISpec->setAntennaIDs(antennaIDs);
-        pAISpec->setAISpecStopTrigger(pAISpecStopTrigger);
-        pAISpec->addInventoryParameterSpec(pInventoryParameterSpec);
-
-        LLRP::CTagReportContentSelector *pTagReportContentSelector =
-                new LLRP::CTagReportContentSelector();
-        pTagReportContentSelector->setEnableROSpecID(FALSE);
-        pTagReportContentSelector->setEnableSpecIndex(FALSE);
-        pTagReportContentSelector->setEnableInventoryParameterSpecID(FALSE);
-        pTagReportContentSelector->setEnableAntennaID(TRUE);
-        pTagReportContentSelector->setEnableChannelIndex(FALSE);
-        pTagReportContentSelector->setEnablePeakRSSI(FALSE);
-        pTagReportContentSelector->setEnableFirstSeenTimestamp(TRUE);
-        pTagReportContentSelector->setEnableLastSeenTimestamp(FALSE);
-        pTagReportContentSelector->setEnableTagSeenCount(FALSE);
-        pTagReportContentSelector->setEnableAccessSpecID(FALSE);
-
-        LLRP::CROReportSpec *pROReportSpec = new LLRP::CROReportSpec();
-        pROReportSpec->setROReportTrigger(
-                LLRP::ROReportTriggerType_Upon_N_Tags_Or_End_Of_ROSpec);
-        pROReportSpec->setN(0);         /* Unlimited */
-        pROReportSpec->setTagReportContentSelector(pTagReportContentSelector);
-
-        LLRP::CROSpec *pROSpec = new LLRP::CROSpec();
-        pROSpec->setROSpecID(123);
-        pROSpec->setPriority(0);
-        pROSpec->setCurrentState(LLRP::ROSpecState_Disabled);
-        pROSpec->setROBoundarySpec(pROBoundarySpec);
-        pROSpec->addSpecParameter(pAISpec);
-        pROSpec->setROReportSpec(pROReportSpec);
-
-        ;
-
-        /*
-         * Compose the command message.
-         * N.B.: After the message is composed, all the parameters
-         *       constructed, immediately above, are considered "owned"
-         *       by the command message. When it is destructed so
-         *       too will the parameters be.
-         */
-
-        std::shared_ptr<LLRP::CADD_ROSPEC> command (new LLRP::CADD_ROSPEC());
-        command->setMessageID(201);
-        command->setROSpec(pROSpec);
-
         /*
-         * Send the message, expect the response of certain type
+         * The ADD_ROSPEC was composed and encoded once, from the
+         * ROSpec config, when the command frames were built. See
+         * CCommandFrames::makeAddROSpec and CStaticROSpec.
          */
 
-        std::shared_ptr<LLRP::CMessage> responseMessage = transact(command);
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.addROSpec,
+                                                                       &LLRP::CADD_ROSPEC_RESPONSE::s_typeDescriptor);
 
         /*
-         * transact() returns NULL if something went wrong.
+         * transactFrame() says what went wrong, pass it on.
          */
 
-        if (nullptr == responseMessage.get())
+        if (!response)
         {
-            /* transact already tattled */
-            throw LLRPLaps::ReaderException("transact failed on addROSpec");
+            return response.error();
         }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
 
         /*
          * Cast to a ADD_ROSPEC_RESPONSE message.
@@ -494,7 +645,7 @@ namespace LLRPLaps
          * Check the LLRPStatus parameter.
          */
 
-        checkLLRPStatus(pROSpecResponseMessage->getLLRPStatus(), "addROSpec");
+        return checkLLRPStatus(pROSpecResponseMessage->getLLRPStatus(), "addROSpec");
     }
 
 
@@ -506,7 +657,7 @@ namespace LLRPLaps
  ** Enable the ROSpec that was added above.
  **
  ** The message we send is:
- **     <ENABLE_ROSPEC MessageID='202'>
+ **     <ENABLE_ROSPEC MessageID='n'>
  **       <ROSpecID>123</ROSpecID>
  **     </ENABLE_ROSPEC>
  **
@@ -514,31 +665,24 @@ namespace LLRPLaps
  **
  *****************************************************************************/
 
-    void CReader::enableROSpec()
+    CResult<void> CReader::enableROSpec()
     {
         /*
-         * Compose the command message
+         * Send the pre-encoded message, expect the response of certain type
          */
 
-        std::shared_ptr<LLRP::CENABLE_ROSPEC> command (new LLRP::CENABLE_ROSPEC());
-        command->setMessageID(202);
-        command->setROSpecID(123);
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.enableROSpec,
+                                                                       &LLRP::CENABLE_ROSPEC_RESPONSE::s_typeDescriptor);
 
         /*
-         * Send the message, expect the response of certain type
+         * transactFrame() says what went wrong, pass it on.
          */
 
-        std::shared_ptr<LLRP::CMessage> responseMessage = transact(command);
-
-        /*
-         * transact() returns NULL if something went wrong.
-         */
-
-        if (nullptr == responseMessage.get())
+        if (!response)
         {
-            /* transact already tattled */
-            throw LLRPLaps::ReaderException("Response to ENABLE_ROSPEC command failed");
+            return response.error();
         }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
 
         /*
          * Cast to a ENABLE_ROSPEC_RESPONSE message.
@@ -550,7 +694,7 @@ namespace LLRPLaps
          * Check the LLRPStatus parameter.
          */
 
-        checkLLRPStatus(rospecResponse->getLLRPStatus(), "enableROSpec");
+        return checkLLRPStatus(rospecResponse->getLLRPStatus(), "enableROSpec");
     }
 
 
@@ -562,7 +706,7 @@ namespace LLRPLaps
  ** Start the ROSpec that was added above.
  **
  ** The message we send is:
- **     <START_ROSPEC MessageID='203'>
+ **     <START_ROSPEC MessageID='n'>
  **       <ROSpecID>123</ROSpecID>
  **     </START_ROSPEC>
  **
@@ -571,43 +715,36 @@ namespace LLRPLaps
  **
  *****************************************************************************/
 
-    void CReader::startROSpec(void)
+    CResult<void> CReader::startROSpec(void)
     {
         /*
-         * Compose the command message
+         * Send the pre-encoded message, expect the response of certain type
          */
 
-        std::shared_ptr<LLRP::CSTART_ROSPEC> cstartRospecCommand (new LLRP::CSTART_ROSPEC());
-        cstartRospecCommand->setMessageID(202);
-        cstartRospecCommand->setROSpecID(123);
+        CResult<std::shared_ptr<LLRP::CMessage>> response = transactFrame(_commands.startROSpec,
+                                                                       &LLRP::CSTART_ROSPEC_RESPONSE::s_typeDescriptor);
 
         /*
-         * Send the message, expect the response of certain type
+         * transactFrame() says what went wrong, pass it on.
          */
 
-        std::shared_ptr<LLRP::CMessage> responseMessage = transact(cstartRospecCommand);
-
-       /*
-         * transact() returns NULL if something went wrong.
-         */
-
-        if (nullptr == responseMessage.get())
+        if (!response)
         {
-            /* transact already tattled */
-            throw LLRPLaps::ReaderException("Response to START_ROSPEC command invalid");
+            return response.error();
         }
+        std::shared_ptr<LLRP::CMessage> responseMessage = response.value();
 
         /*
          * Cast to a START_ROSPEC_RESPONSE message.
          */
 
-        auto *response = dynamic_cast<LLRP::CSTART_ROSPEC_RESPONSE *>(responseMessage.get());
+        auto *startResponse = dynamic_cast<LLRP::CSTART_ROSPEC_RESPONSE *>(responseMessage.get());
 
         /*
          * Check the LLRPStatus parameter.
          */
 
-        checkLLRPStatus(response->getLLRPStatus(), "startROSpec");
+        return checkLLRPStatus(startResponse->getLLRPStatus(), "startROSpec");
     }
 
 /**
@@ -618,17 +755,26 @@ namespace LLRPLaps
  ** Receive messages until an RO_ACCESS_REPORT is received.
  ** Time limit is 7 seconds. We expect a report within 5 seconds.
  **
- ** This shows how to determine the type of a received message.
+ ** See CReaderProtocol::handleFrame for what is made of them.
  **
- ** @return     ==0             Everything OK
- **             !=0             Something went wrong
+ ** @return     ok              The ROSpec's reports are in
+ **             error           Timeout or what else went wrong
  **
  *****************************************************************************/
 
-    void CReader::awaitReports()
+    CResult<void> CReader::awaitReports()
     {
         bool done(false);
 
+        /*
+         * With ROSpec events on, a ROSpec may send several reports
+         * and is only over when the reader says so. Otherwise the
+         * one report at the end of the ROSpec is the end.
+         */
+
+        const bool untilROSpecEnd = _commands.readerConfig.notifyROSpecEvents;
+        _roSpecEnded = false;
+
         /*
          * Keep receiving messages until done or until
          * something bad happens.
@@ -636,346 +782,28 @@ namespace LLRPLaps
 
         while (!done)
         {
-            const LLRP::CTypeDescriptor *pType;
-
             /*
              * Wait up to 7 seconds for a message. The report
              * should occur within 5 seconds.
+             *
+             * Frames queued while a transact() waited come first.
              */
 
-            auto recvMessage = recvMessage(TIMEOUT_7SEC);
-            if (nullptr == recvMessage.get())
+            CResult<const CLLRPFrame *> received = recvFrame(TIMEOUT_7SEC);
+            if (!received)
             {
-                /*
-                 * Did not receive a message within a reasonable
-                 * amount of time. recvMessage() already tattled
-                 */
-                throw LLRPLaps::ReaderTimeoutException("timeout waiting for recvMessage awating reports");
+                return received.error();
             }
 
-            /*
-             * What happens depends on what kind of message
-             * received. Use the type label (m_pType) to
-             * discriminate message types.
-             */
-
-            pType = recvMessage->m_pType;
-
-            /*
-             * Is it a tag report? If so, process.
-             */
-
-            if (&LLRP::CRO_ACCESS_REPORT::s_typeDescriptor == pType)
-            {
-                processTagList(dynamic_cast<LLRP::CRO_ACCESS_REPORT *>(recvMessage));
-                done = true;
-            }
-
-                /*
-                 * Is it a reader event? This example only recognizes
-                 * AntennaEvents.
-                 */
-
-            else if (&LLRP::CREADER_EVENT_NOTIFICATION::s_typeDescriptor == pType)
-            {
-                auto *creaderEventNotification = (LLRP::CREADER_EVENT_NOTIFICATION *) recvMessage;
-                auto *readerEventNotificationData = creaderEventNotification->getReaderEventNotificationData();
-                if (nullptr != readerEventNotificationData)
-                {
-                    handleReaderEventNotification(readerEventNotificationData);
-                }
-                else
-                {
-                    /*
-                     * This should never happen. Using continue
-                     * to keep indent depth down.
-                     */
-
-                    // LOG(QString().sprintf("WARNING: READER_EVENT_NOTIFICATION without data"));
-                }
-            }
-
-                /*
-                 * Hmmm. Something unexpected. Just tattle and keep going.
-                 */
-
-            else
+            bool reported = false;
+            CResult<void> handled = handleFrame(received.value(), reported);
+            if (!handled)
             {
-                // LOG(QString().sprintf("WARNING: Ignored unexpected message during monitor: %s", pType->m_pName));
+                return handled;
             }
-
-        }
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Helper routine to
- **
- ** The report is printed in list order, which is arbitrary.
- **
- ** TODO: It would be cool to sort the list by EPC and antenna,
- **       then print it.
- **
- ** @return     void
- **
- *****************************************************************************/
-
-    void CReader::processTagList(std::shared_ptr<LLRP::CRO_ACCESS_REPORT> RO_ACCESS_REPORT)
-    {
-        for (std::list<LLRP::CTagReportData*>::iterator i = RO_ACCESS_REPORT->beginTagReportData(); RO_ACCESS_REPORT->endTagReportData() != i; ++i)
-        {
-            processTagInfo(*i);
-        }
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Helper routine to print one tag report entry on one line
- **
- ** @return     void
- **
- *****************************************************************************/
-
-    void CReader::processTagInfo(LLRP::CTagReportData *tagReportData)
-    {
-        const LLRP::CTypeDescriptor *cTypeDescriptor;
-        auto *pEPCParameter = tagReportData->getEPCParameter();
-        LLRPLaps::CTagInfo tagInfo;
-
-        /*
-         * Process the EPC. It could be a 96-bit EPC_96 parameter
-         * or an variable length EPCData parameter.
-         */
-
-        if (nullptr != pEPCParameter)
-        {
-            LLRP::llrp_u96_t my_u96;
-            LLRP::llrp_u1v_t my_u1v;
-            LLRP::llrp_u8_t *value = NULL;
-            int n;
-
-            cTypeDescriptor = pEPCParameter->m_pType;
-            if (&LLRP::CEPC_96::s_typeDescriptor == cTypeDescriptor)
-            {
-                auto *pEPC_96 = dynamic_cast<LLRP::CEPC_96 *>(pEPCParameter);
-                my_u96 = pEPC_96->getEPC();
-                value = my_u96.m_aValue;
-                n = 12u;
-            }
-            else if (&LLRP::CEPCData::s_typeDescriptor == cTypeDescriptor)
-            {
-                auto *pEPCData = dynamic_cast<LLRP::CEPCData *>(pEPCParameter);
-                my_u1v = pEPCData->getEPC();
-                value = my_u1v.m_pValue;
-                n = (my_u1v.m_nBit + 7u) / 8u;
-            }
-
-            if (value)
-            {
-                tagInfo.setTimeStampUSec(tagReportData->getFirstSeenTimestampUTC()->getMicroseconds());
-                tagInfo.AntennaId = tagReportData->getAntennaID()->getAntennaID();
-                tagInfo.data.reserve(n);
-                for (int i = 0; i < n; i++)
-                {
-                    tagInfo.data.push_back(value[i]);
-                }
-                emit newTag(tagInfo);
-            }
-            else
-            {
-                // LOG(QString("Unknown-epc-data-type in tag"));
-            }
-        }
-        else
-        {
-            // LOGQString("Missing-epc-data in tag"));
-        }
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Handle a ReaderEventNotification
- **
- ** Handle the payload of a READER_EVENT_NOTIFICATION message.
- ** This routine simply dispatches to handlers of specific
- ** event types.
- **
- ** @return     void
- **
- *****************************************************************************/
-
-    void CReader::handleReaderEventNotification(LLRP::CReaderEventNotificationData *cReaderEventNotificationData)
-    {
-        auto reported = false;
-
-        auto *pAntennaEvent = cReaderEventNotificationData->getAntennaEvent();
-        if (NULL != pAntennaEvent)
-        {
-            handleAntennaEvent(pAntennaEvent);
-            reported = true;
-        }
-
-        auto *pReaderExceptionEvent = cReaderEventNotificationData->getReaderExceptionEvent();
-        if (NULL != pReaderExceptionEvent)
-        {
-            handleReaderExceptionEvent(pReaderExceptionEvent);
-            reported = true;
-        }
-
-        /*
-         * Similarly handle other events here:
-         *      HoppingEvent
-         *      GPIEvent
-         *      ROSpecEvent
-         *      ReportBufferLevelWarningEvent
-         *      ReportBufferOverflowErrorEvent
-         *      RFSurveyEvent
-         *      AISpecEvent
-         *      ConnectionAttemptEvent
-         *      ConnectionCloseEvent
-         *      Custom
-         */
-
-        if (0 == reported)
-        {
-            // LOG("NOTICE: Unexpected (unhandled) ReaderEvent"));
-        }
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Handle an AntennaEvent
- **
- ** An antenna was disconnected or (re)connected. Tattle.
- **
- ** @return     void
- **
- *****************************************************************************/
-
-    void CReader::handleAntennaEvent(LLRP::CAntennaEvent *pAntennaEvent)
-    {
-        LLRP::EAntennaEventType eEventType;
-        LLRP::llrp_u16_t AntennaID;
-        std::string stateStr;
-        QString s;
-
-        eEventType = pAntennaEvent->getEventType();
-        AntennaID = pAntennaEvent->getAntennaID();
-
-        switch (eEventType)
-        {
-            case LLRP::AntennaEventType_Antenna_Disconnected:
-                stateStr = "disconnected";
-                break;
-
-            case LLRP::AntennaEventType_Antenna_Connected:
-                stateStr = "connected";
-                break;
-
-            default:
-                stateStr = "?unknown-event?";
-                break;
-        }
-
-        // LOG(s.sprintf("NOTICE: Antenna %d is %s", AntennaID,ß stateStr.c_str()));
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Handle a ReaderExceptionEvent
- **
- ** Something has gone wrong. There are lots of details but
- ** all this does is print the message, if one.
- **
- ** @return     void
- **
- *****************************************************************************/
-
-    void CReader::handleReaderExceptionEvent(LLRP::CReaderExceptionEvent *pReaderExceptionEvent)
-    {
-        LLRP::llrp_utf8v_t Message;
-        QString s;
-
-        Message = pReaderExceptionEvent->getMessage();
-
-        if (0 < Message.m_nValue && NULL != Message.m_pValue)
-        {
-            // LOG(s.sprintf("NOTICE: ReaderException '%.*s'", Message.m_nValue, Message.m_pValue));
-        }
-        else
-        {
-            // LOG(emit newLogMessage(s.sprintf("NOTICE: ReaderException but no message"));
-        }
-    }
-
-
-/**
- *****************************************************************************
- **
- ** @brief  Helper routine to check an LLRPStatus parameter
- **         and tattle on errors
- **
- ** Helper routine to interpret the LLRPStatus subparameter
- ** that is in all responses. It tattles on an error, if one,
- ** and tries to safely provide details.
- **
- ** This simplifies the code, above, for common check/tattle
- ** sequences.
- **
- ** @return     ==0             Everything OK
- **             !=0             Something went wrong, already tattled
- **
- *****************************************************************************/
-
-    void CReader::checkLLRPStatus(LLRP::CLLRPStatus* llrpStatus, const std::string whatStr)
-    {
-        /*
-         * The LLRPStatus parameter is mandatory in all responses.
-         * If it is missing there should have been a decode error.
-         * This just makes sure (remember, this program is a
-         * diagnostic and suppose to catch LTKC mistakes).
-         */
-
-        if (nullptr == llrpStatus)
-        {
-            // LOG(s.sprintf("ERROR: %s missing LLRP status", pWhatStr));
-            throw LLRPLaps::ReaderException(QString().sprintf("ERROR: %s missing LLRP status", whatStr).toStdString());
-        }
-
-        /*
-         * Make sure the status is M_Success.
-         * If it isn't, print the error string if one.
-         * This does not try to pretty-print the status
-         * code. To get that, run this program with -vv
-         * and examine the XML output.
-         */
-
-        if (LLRP::StatusCode_M_Success != llrpStatus->getStatusCode())
-        {
-            LLRP::llrp_utf8v_t ErrorDesc;
-
-            ErrorDesc = llrpStatus->getErrorDescription();
-            QString errorStr;
-            if (0 == ErrorDesc.m_nValue)
-            {
-                errorStr.sprintf("ERROR: %s failed, no error description given", whatStr));
-            }
-            else
-            {
-                errorStr.sprintf("ERROR: %s failed, %.*s", whatStr, ErrorDesc.m_nValue, ErrorDesc.m_pValue));
-            }
-            throw LLRPLaps::ReaderException(errorStr.toStdString());
+            done = untilROSpecEnd ? _roSpecEnded : reported;
         }
+        return CResult<void>();
     }
 
 
@@ -1016,11 +844,11 @@ namespace LLRPLaps
 
         /*
          * Send the message, expect the response of certain type.
-         * If LLRP::CConnection::transact() returns NULL then there was
+         * If CLLRPConnection::transact() returns NULL then there was
          * an error. In that case we try to print the error details.
          */
 
-        message = _connectionToReader->transact(sendMsg.get(), TIMEOUT_5SEC);
+        message.reset(_connectionToReader->transact(sendMsg.get(), TIMEOUT_5SEC));
 
         if (nullptr == message)
         {
@@ -1068,6 +896,34 @@ namespace LLRPLaps
     }
 
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Wrapper routine to do an LLRP transaction with a
+ **         pre-encoded command
+ **
+ ** Like transact() but nothing is composed or encoded, see
+ ** CReaderProtocol::sendCommand. The response is not turned into
+ ** XML, nothing would print it.
+ **
+ ** @return     ok              Pointer to the response message
+ **             error           Send, receive or ERROR_MESSAGE details
+ **
+ *****************************************************************************/
+
+    CResult<std::shared_ptr<LLRP::CMessage>> CReader::transactFrame(CCommandFrame &command,
+                                                                     const LLRP::CTypeDescriptor *responseType)
+    {
+        CResult<LLRP::llrp_u32_t> sent = sendCommand(command, responseType);
+        if (!sent)
+        {
+            return sent.error();
+        }
+
+        return checkResponse(_connectionToReader->recvResponse(TIMEOUT_5SEC, responseType, sent.value()), responseType);
+    }
+
+
 /**
  *****************************************************************************
  **
@@ -1087,34 +943,36 @@ namespace LLRPLaps
  **                                   no matter what
  **                             >0 => ms to await complete frame
  **
- ** @return     !=NULL          Pointer to a message
- ** @throws     ReaderException on error
- **
+ ** @return     ok              Pointer to a message
+ **             error           Timeout or what else went wrong
  **
  *****************************************************************************/
 
-    std::shared_ptr<LLRP::CMessage> CReader::recvMessage(int nMaxMS)
+    CResult<std::shared_ptr<LLRP::CMessage>> CReader::recvMessage(int nMaxMS)
     {
         std::shared_ptr<LLRP::CMessage> message;
-        QString s;
 
         /*
          * Receive the message subject to a time limit
          */
 
-        message = _connectionToReader->recvMessage(nMaxMS);
+        message.reset(_connectionToReader->recvMessage(nMaxMS));
 
         /*
-         * If LLRP::CConnection::recvMessage() returns NULL then there was
-         * an error. In that case we try to print the error details.
+         * The connection stamps each frame when the recv that
+         * completed it returned, before it is decoded.
+         */
+
+        _frameReceivedNSec = _connectionToReader->getFrameReceivedNSec();
+
+        /*
+         * If CLLRPConnection::recvMessage() returns NULL then there was
+         * an error, a timeout being the usual one.
          */
 
         if (NULL == message.get())
         {
-            const LLRP::CErrorDetails *pError = _connectionToReader->getRecvError();
-
-            throw LLRPLaps::ReaderException(s.sprintf("ERROR: recvMessage failed, %s", pError->m_pWhatStr ? pError->m_pWhatStr
-                                                                                             : "no reason given").toStdString());
+            return recvError("recvMessage");
         }
 
         // FIXME: REquired when logging is implemented:    printXMLMessage(message);
@@ -1123,6 +981,33 @@ namespace LLRPLaps
     }
 
 
+/**
+ *****************************************************************************
+ **
+ ** @brief  Wrapper routine to receive a raw frame
+ **
+ ** Like recvMessage() but leaves decoding to the caller.
+ ** The frame is valid until the next receive.
+ **
+ ** @return     ok              Pointer to the frame
+ **             error           Timeout or what else went wrong
+ **
+ *****************************************************************************/
+
+    CResult<const CLLRPFrame *> CReader::recvFrame(int nMaxMS)
+    {
+        const CLLRPFrame *frame = _connectionToReader->recvFrame(nMaxMS);
+
+        if (nullptr == frame)
+        {
+            return recvError("recvFrame");
+        }
+
+        _frameReceivedNSec = frame->hostReceivedNSec;
+        return frame;
+    }
+
+
 /**
  *****************************************************************************
  **
@@ -1150,7 +1035,7 @@ namespace LLRPLaps
         // FIXME: Enable for logging: printXMLMessage(sendMsg);
 
         /*
-         * If LLRP::CConnection::sendMessage() returns other than RC_OK
+         * If CLLRPConnection::sendMessage() returns other than RC_OK
          * then there was an error. In that case we try to print
          * the error details.
          */
@@ -23,82 +23,85 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <QObject>
 #include <QString>
 
 #include "ltkcpp.h"
-#include "ctaginfo.h"
-
-class LLRPLaps::CTagInfo;
-
-Q_DECLARE_METATYPE(LLRPLaps::CTagInfo);
+#include "creaderprotocol.h"
+#include "cresult.h"
 
 namespace LLRPLaps
 {
+    class CLLRPConnection;
+    struct CLLRPFrame;
 
-    class CReader : public QObject
+    class CReader : public CReaderProtocol
     {
     Q_OBJECT
+        friend class CTagPathBenchmark;
+
     public:
         explicit CReader(QString readerHostName);
 
         ~CReader() override;
 
-        void ProcessRecentChipsSeen();
+        CResult<void> ProcessRecentChipsSeen();
 
         void Connect();
 
-    signals:
-
-        void newTag(const LLRPLaps::CTagInfo &);
-
     private:
-        std::shared_ptr<LLRP::CConnection> _connectionToReader;
         LLRP::CTypeRegistry* _typeRegistry;
-        QString _readerHostname;
+        bool _reconnectPending;
+        bool _reinstallPending;
+        bool _connecting;                               // reconnect() waiting for the TCP connect
+        std::uint64_t _connectDeadlineNSec;
 
-        void checkConnectionStatus();
+        void createConnection();
 
-        std::shared_ptr<LLRP::CMessage> recvMessage(int nMaxMS);
+        void setUpReader();
 
-        void printXMLMessage(std::shared_ptr<LLRP::CMessage> message);
+        CResult<void> reconnect();
 
-        void scrubConfiguration();
+        CResult<void> inventoryCycle();
 
-        void resetConfigurationToFactoryDefaults();
+        void checkConnectionStatus();
 
-        void deleteAllROSpecs();
+        CResult<std::shared_ptr<LLRP::CMessage>> recvMessage(int nMaxMS);
 
-        void addROSpec();
+        CResult<const CLLRPFrame *> recvFrame(int nMaxMS);
 
-        void enableROSpec();
+        void printXMLMessage(std::shared_ptr<LLRP::CMessage> message);
 
-        void startROSpec();
+        CResult<void> scrubConfiguration();
 
-        void handleReaderEventNotification(LLRP::CReaderEventNotificationData *cReaderEventNotificationData);
+        CResult<void> resetConfigurationToFactoryDefaults();
 
-        void handleAntennaEvent(LLRP::CAntennaEvent *antennaEvent);
+        CResult<void> setReaderConfiguration();
 
-        void handleReaderExceptionEvent(LLRP::CReaderExceptionEvent *readerExceptionEvent);
+        CResult<void> deleteAllROSpecs();
 
-        void checkLLRPStatus(LLRP::CLLRPStatus* llrpStatus, const std::string whatStr);
+        CResult<void> addROSpec();
 
-        std::shared_ptr<LLRP::CMessage> transact(std::shared_ptr<LLRP::CMessage> sendMsg);
+        CResult<void> enableROSpec();
 
-        void sendMessage(std::shared_ptr<LLRP::CMessage> sendMsg);
+        CResult<void> startROSpec();
 
-        void awaitReports();
+        std::shared_ptr<LLRP::CMessage> transact(std::shared_ptr<LLRP::CMessage> sendMsg);
+
+        CResult<std::shared_ptr<LLRP::CMessage>> transactFrame(CCommandFrame &command, const LLRP::CTypeDescriptor *responseType);
 
-        void processTagList(std::shared_ptr<LLRP::CRO_ACCESS_REPORT> RO_ACCESS_REPORT);
+        void sendMessage(std::shared_ptr<LLRP::CMessage> sendMsg);
 
-        void processTagInfo(LLRP::CTagReportData *tagReportData);
+        CResult<void> awaitReports();
 
         std::string CErrorDetailsToString(const LLRP::CErrorDetails *errorDetails);
 
         const static int TIMEOUT_10SEC;
         const static int TIMEOUT_7SEC;
         const static int TIMEOUT_5SEC;
+        const static int RECONNECT_POLL_MS;
     };
 
 }
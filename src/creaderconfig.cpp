@@ -0,0 +1,169 @@
+//********************************************************************
+//    created:    2026-10-18 04:10 PM
+//    file:       creaderconfig.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "creaderconfig.h"
+#include "exceptions.h"
+
+#include <set>
+#include <string>
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        // A bunch of riders crossing the line together
+        const int FAST_TAG_POPULATION = 16;
+
+        // ~2m of antenna field at 60km/h
+        const int FAST_TAG_TRANSIT_MS = 120;
+    }
+
+    CReaderConfig CReaderConfig::factoryDefaults()
+    {
+        return CReaderConfig();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Settings for tags that are only in the field briefly
+ **
+ ** A rider passes an antenna in a fraction of a second, so the
+ ** aim is as many reads of each chip as possible in that window:
+ **
+ **     - Session 0: the inventoried flag only lasts while the
+ **       tag is powered, so a tag is never kept quiet past the
+ **       pass it was read in.
+ **     - Inventory is not state aware, the reader keeps querying
+ **       every tag instead of singulating each one once.
+ **     - Mode 0, which readers list as their highest throughput
+ **       mode, with the reader picking the tari.
+ **     - A small tag population so the first Q is small and
+ **       rounds are short.
+ **     - Fast keepalives, a line that stops timing is noticed
+ **       within a second.
+ **
+ ** The transmit power index is reader specific, give the highest
+ ** index from the reader capabilities for the most range.
+ **
+ *****************************************************************************/
+
+    CReaderConfig CReaderConfig::fastMovingTags(const std::vector<std::uint16_t> &antennaIds, int transmitPowerIndex)
+    {
+        CReaderConfig config;
+
+        for (auto antennaId : antennaIds)
+        {
+            CAntennaConfig antenna(antennaId);
+            antenna.transmitPowerIndex = transmitPowerIndex;
+            antenna.modeIndex = 0;
+            antenna.session = 0;
+            antenna.target = CAntennaConfig::TargetDefault;
+            antenna.tagPopulation = FAST_TAG_POPULATION;
+            antenna.tagTransitTimeMS = FAST_TAG_TRANSIT_MS;
+            config.antennas.push_back(antenna);
+        }
+
+        config.keepaliveIntervalMS = FAST_KEEPALIVE_INTERVAL_MS;
+
+        return config;
+    }
+
+
+    std::vector<std::uint16_t> CReaderConfig::getAntennaIds() const
+    {
+        std::vector<std::uint16_t> antennaIds;
+
+        for (const auto &antenna : antennas)
+        {
+            antennaIds.push_back(antenna.antennaId);
+        }
+
+        return antennaIds;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Check what can be checked without the reader
+ **
+ ** Indexes are only range checked by the reader, which answers
+ ** SET_READER_CONFIG with an error status.
+ **
+ ** @throws     ReaderException on the first problem found
+ **
+ *****************************************************************************/
+
+    void CReaderConfig::validate() const
+    {
+        std::set<std::uint16_t> seen;
+
+        if (0 != keepaliveIntervalMS && 0 == missedKeepalives)
+        {
+            throw ReaderException("reader config: keepalives need at least one miss to declare a link dead");
+        }
+
+        for (const auto &antenna : antennas)
+        {
+            std::string which = "reader config: antenna " + std::to_string(antenna.antennaId);
+
+            if (0 == antenna.antennaId)
+            {
+                throw ReaderException("reader config: antenna ID 0 is all antennas, configure them one by one");
+            }
+            if (!seen.insert(antenna.antennaId).second)
+            {
+                throw ReaderException(which + " is configured twice");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.transmitPowerIndex &&
+                (antenna.transmitPowerIndex < 1 || antenna.transmitPowerIndex > 0xFFFF))
+            {
+                throw ReaderException(which + " has an invalid transmit power index");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.receiverSensitivityIndex &&
+                (antenna.receiverSensitivityIndex < 1 || antenna.receiverSensitivityIndex > 0xFFFF))
+            {
+                throw ReaderException(which + " has an invalid receiver sensitivity index");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.modeIndex &&
+                (antenna.modeIndex < 0 || antenna.modeIndex > 0xFFFF))
+            {
+                throw ReaderException(which + " has an invalid mode index");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.session && (antenna.session < 0 || antenna.session > 3))
+            {
+                throw ReaderException(which + " has an invalid session, must be 0 to 3");
+            }
+            if (CAntennaConfig::TargetDefault != antenna.target && CAntennaConfig::READER_DEFAULT == antenna.session)
+            {
+                throw ReaderException(which + " sets a target without a session");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.tagPopulation &&
+                (antenna.tagPopulation < 0 || antenna.tagPopulation > 0xFFFF))
+            {
+                throw ReaderException(which + " has an invalid tag population");
+            }
+            if (CAntennaConfig::READER_DEFAULT != antenna.tagTransitTimeMS && antenna.tagTransitTimeMS < 0)
+            {
+                throw ReaderException(which + " has an invalid tag transit time");
+            }
+        }
+    }
+}
@@ -0,0 +1,142 @@
+//********************************************************************
+//    created:    2026-10-18 04:10 PM
+//    file:       creaderconfig.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREADERCONFIG_H
+#define LLRPLAPS_CREADERCONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * RF and Gen2 settings for one antenna, sent as an
+     * AntennaConfiguration in SET_READER_CONFIG.
+     *
+     * Power, sensitivity and mode are indexes into the tables the
+     * reader reports in GET_READER_CAPABILITIES, so they only mean
+     * something for a given reader model. READER_DEFAULT leaves a
+     * setting where the factory reset put it.
+     */
+    class CAntennaConfig
+    {
+    public:
+        static const int READER_DEFAULT = -1;
+
+        enum Target
+        {
+            TargetDefault,      // let the reader pick, inventory is not state aware
+            TargetA,
+            TargetB
+        };
+
+        explicit CAntennaConfig(std::uint16_t antennaId = 1) : antennaId(antennaId), transmitPowerIndex(READER_DEFAULT),
+                                                               hopTableId(1), channelIndex(0),
+                                                               receiverSensitivityIndex(READER_DEFAULT),
+                                                               modeIndex(READER_DEFAULT), tari(0),
+                                                               session(READER_DEFAULT), target(TargetDefault),
+                                                               tagPopulation(READER_DEFAULT),
+                                                               tagTransitTimeMS(READER_DEFAULT)
+        {
+        }
+
+        bool operator==(const CAntennaConfig &other) const
+        {
+            return antennaId == other.antennaId && transmitPowerIndex == other.transmitPowerIndex &&
+                   hopTableId == other.hopTableId && channelIndex == other.channelIndex &&
+                   receiverSensitivityIndex == other.receiverSensitivityIndex && modeIndex == other.modeIndex &&
+                   tari == other.tari && session == other.session && target == other.target &&
+                   tagPopulation == other.tagPopulation && tagTransitTimeMS == other.tagTransitTimeMS;
+        }
+
+        bool operator!=(const CAntennaConfig &other) const { return !(*this == other); }
+
+        std::uint16_t antennaId;
+
+        // RFTransmitter, only sent when the power is set
+        int transmitPowerIndex;
+        std::uint16_t hopTableId;
+        std::uint16_t channelIndex;
+
+        // RFReceiver
+        int receiverSensitivityIndex;
+
+        // C1G2RFControl, tari 0 lets the reader pick within the mode
+        int modeIndex;
+        std::uint16_t tari;
+
+        // C1G2SingulationControl
+        int session;                // 0..3
+        Target target;
+        int tagPopulation;
+        int tagTransitTimeMS;
+    };
+
+
+    /*
+     * The reader configuration CReader sends after resetting the
+     * reader to factory defaults. The default config sends nothing
+     * and the ROSpec uses all antennas, which is how CReader has
+     * always behaved.
+     *
+     * notifyROSpecEvents has the reader tell when the ROSpec ends,
+     * which CReader needs when a ROSpec sends more than one report.
+     *
+     * With a keepalive interval the reader sends a KEEPALIVE that
+     * often and CReader declares the link dead after missedKeepalives
+     * of them fail to show up.
+     */
+    class CReaderConfig
+    {
+    public:
+        CReaderConfig() : notifyROSpecEvents(false), keepaliveIntervalMS(0), missedKeepalives(DEFAULT_MISSED_KEEPALIVES)
+        {
+        }
+
+        static CReaderConfig factoryDefaults();
+
+        static CReaderConfig fastMovingTags(const std::vector<std::uint16_t> &antennaIds,
+                                            int transmitPowerIndex = CAntennaConfig::READER_DEFAULT);
+
+        std::vector<std::uint16_t> getAntennaIds() const;
+
+        void validate() const;
+
+        bool isFactoryDefault() const { return antennas.empty() && !notifyROSpecEvents && 0 == keepaliveIntervalMS; }
+
+        bool operator==(const CReaderConfig &other) const
+        {
+            return antennas == other.antennas && notifyROSpecEvents == other.notifyROSpecEvents &&
+                   keepaliveIntervalMS == other.keepaliveIntervalMS && missedKeepalives == other.missedKeepalives;
+        }
+
+        bool operator!=(const CReaderConfig &other) const { return !(*this == other); }
+
+        std::vector<CAntennaConfig> antennas;
+        bool notifyROSpecEvents;
+        std::uint32_t keepaliveIntervalMS;      // 0 is no keepalives
+        unsigned int missedKeepalives;
+
+        const static unsigned int DEFAULT_MISSED_KEEPALIVES = 3;
+
+        // Three missed make a dead link known in under a second
+        const static std::uint32_t FAST_KEEPALIVE_INTERVAL_MS = 250;
+    };
+}
+#endif //LLRPLAPS_CREADERCONFIG_H
@@ -0,0 +1,886 @@
+//********************************************************************
+//    created:    2026-10-19 06:10 AM
+//    file:       creaderprotocol.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <QList>
+
+#include <ltkcpp_platform.h>
+#include <ltkcpp.h>
+#include "exceptions.h"
+#include "creaderprotocol.h"
+#include "ctaginfo.h"
+#include "clatencyrecorder.h"
+#include "cepcinterner.h"
+#include "cllrpconnection.h"
+#include "cframecapture.h"
+#include "cstaticrospec.h"
+#include "cchipregistry.h"
+#include "creportbatchcontroller.h"
+
+
+namespace LLRPLaps
+{
+    const std::size_t CReaderProtocol::INITIAL_TAG_RECORDS = 512;
+    const std::uint64_t CReaderProtocol::NO_GENERATION = ~0ull;
+
+    CReaderProtocol::CReaderProtocol(QString readerHostName)
+            : _readerHostname(readerHostName), _latencyRecorder(nullptr), _epcInterner(nullptr), _frameReceivedNSec(0),
+              _tagRecords(INITIAL_TAG_RECORDS), _commands(CCommandFrames::fromStatic<CDefaultROSpec>()), _nextMessageId(1),
+              _chipRegistry(nullptr), _maxEpcFilters(CChipRegistry::DEFAULT_MAX_FILTERS),
+              _registryGeneration(NO_GENERATION), _rosterGeneration(NO_GENERATION), _rejectUnregistered(false),
+              _batchController(nullptr), _configuredReportN(_commands.config.reportN),
+              _configuredAIDurationMS(_commands.config.aiDurationMS),
+              _configuredNotifyROSpecEvents(_commands.readerConfig.notifyROSpecEvents), _roSpecEnded(false),
+              _reconfigurePending(false)
+    {
+        // The compile time frames must be exactly what LTK makes of the same config
+        Q_ASSERT(CCommandFrames::build(CDefaultROSpec::config()).addROSpec == _commands.addROSpec);
+    }
+
+
+    CReaderProtocol::~CReaderProtocol()
+    {
+    }
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Change the ROSpec
+ **
+ ** CReader uses it from the next Connect() on, CReaderSession
+ ** reconfigures the reader at the end of the current inventory
+ ** cycle. The commands are built and encoded here, once, so a bad
+ ** config is reported now rather than on connect.
+ **
+ ** @throws     ReaderException if the config is invalid
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::setROSpecConfig(const CROSpecConfig &config)
+    {
+        buildCommands(config, _commands.readerConfig);
+        _configuredReportN = config.reportN;
+        _configuredAIDurationMS = config.aiDurationMS;
+
+        // The registry filters go on top of the new config
+        _registryGeneration = NO_GENERATION;
+        _reconfigurePending = true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Only have the reader report the chips in a registry
+ **
+ ** The ROSpec gets up to maxFilters EPC prefix filters covering
+ ** the registered chips. When the registry changes, the ROSpec is
+ ** reinstalled before the next inventory cycle. NULL reports all
+ ** tags again. The registry must outlive the reader.
+ **
+ ** Tags are emitted with the rider id the registry has for their
+ ** chip. A prefix also lets through unregistered chips of the same
+ ** batch; with rejectUnregistered those are dropped on the host,
+ ** unless nothing is registered at all.
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::setChipRegistry(const CChipRegistry *registry, std::size_t maxFilters, bool rejectUnregistered)
+    {
+        _chipRegistry = registry;
+        _maxEpcFilters = maxFilters;
+        _registryGeneration = NO_GENERATION;
+        _roster.reset();
+        _rosterGeneration = NO_GENERATION;
+        _rejectUnregistered = rejectUnregistered;
+    }
+
+
+    const CRosterIndex *CReaderProtocol::currentRoster()
+    {
+        if (nullptr == _chipRegistry)
+        {
+            return nullptr;
+        }
+
+        std::uint64_t generation = _chipRegistry->getGeneration();
+        if (generation != _rosterGeneration)
+        {
+            _roster = _chipRegistry->getRoster();
+            _rosterGeneration = generation;
+        }
+        return _roster.get();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Bring the ROSpec EPC filters in line with the registry
+ **
+ ** @return     true if the ROSpec changed and needs reinstalling
+ **
+ *****************************************************************************/
+
+    bool CReaderProtocol::updateEpcFilters()
+    {
+        std::vector<CEpcFilter> filters;
+
+        if (_chipRegistry)
+        {
+            std::uint64_t generation = _chipRegistry->getGeneration();
+            if (generation == _registryGeneration)
+            {
+                return false;
+            }
+            _registryGeneration = generation;
+            filters = _chipRegistry->getEpcFilters(_maxEpcFilters);
+        }
+
+        if (filters == _commands.config.epcFilters)
+        {
+            return false;
+        }
+
+        CROSpecConfig config = _commands.config;
+        config.epcFilters = filters;
+        buildCommands(config, _commands.readerConfig);
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Change the antenna and Gen2 settings
+ **
+ ** Taken on as setROSpecConfig() is.
+ ** See CReaderConfig::fastMovingTags for the race profile. A ROSpec
+ ** on all antennas is narrowed to the configured ones.
+ **
+ ** @throws     ReaderException if the config is invalid
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::setReaderConfig(const CReaderConfig &readerConfig)
+    {
+        CReaderConfig config = readerConfig;
+        config.notifyROSpecEvents = config.notifyROSpecEvents || nullptr != _batchController;
+        buildCommands(_commands.config, config);
+        _configuredNotifyROSpecEvents = readerConfig.notifyROSpecEvents;
+        _reconfigurePending = true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Let a controller pick the report N and AISpec duration
+ **
+ ** A ROSpec with N > 0 sends several reports, so the reader is also
+ ** asked for ROSpec events to tell when the ROSpec is done. Takes
+ ** effect as setROSpecConfig() does; NULL goes back to the
+ ** configured ROSpec. The controller must outlive the reader.
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::setReportBatchController(CReportBatchController *controller)
+    {
+        CROSpecConfig config = _commands.config;
+        CReaderConfig readerConfig = _commands.readerConfig;
+
+        _batchController = controller;
+        if (nullptr != _batchController)
+        {
+            config.reportN = _batchController->getSettings().reportN;
+            config.aiDurationMS = _batchController->getSettings().aiDurationMS;
+            readerConfig.notifyROSpecEvents = true;
+        }
+        else
+        {
+            config.reportN = _configuredReportN;
+            config.aiDurationMS = _configuredAIDurationMS;
+            readerConfig.notifyROSpecEvents = _configuredNotifyROSpecEvents;
+        }
+
+        buildCommands(config, readerConfig);
+        _reconfigurePending = true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Apply the batch controller's latest settings
+ **
+ ** @return     true if the ROSpec changed and needs reinstalling
+ **
+ *****************************************************************************/
+
+    bool CReaderProtocol::updateReportBatching()
+    {
+        CReportBatchController::Settings settings;
+
+        if (nullptr == _batchController || !_batchController->retune(CLatencyRecorder::nowNSec(), settings))
+        {
+            return false;
+        }
+
+        CROSpecConfig config = _commands.config;
+        config.reportN = settings.reportN;
+        config.aiDurationMS = settings.aiDurationMS;
+        buildCommands(config, _commands.readerConfig);
+        return true;
+    }
+
+
+    void CReaderProtocol::buildCommands(const CROSpecConfig &config, const CReaderConfig &readerConfig)
+    {
+        if (config == CDefaultROSpec::config() && readerConfig.isFactoryDefault())
+        {
+            _commands = CCommandFrames::fromStatic<CDefaultROSpec>();
+        }
+        else
+        {
+            _commands = CCommandFrames::build(config, readerConfig);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Record all LLRP traffic with this reader to a capture file
+ **
+ ** Takes effect immediately if connected, otherwise on Connect().
+ ** An empty path stops capturing. See CFrameCapture for the format
+ ** and laps_capdecode for reading it back.
+ **
+ ** @throws     ReaderException if the file cannot be created
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::setCaptureFile(const QString &path)
+    {
+        std::shared_ptr<CFrameCapture> capture;
+
+        if (!path.isEmpty())
+        {
+            capture = std::make_shared<CFrameCapture>();
+            if (!capture->open(path.toStdString()))
+            {
+                throw LLRPLaps::ReaderException(QString("ERROR: cannot create capture file %1").arg(path).toStdString());
+            }
+        }
+
+        _capture = capture;
+        if (_connectionToReader)
+        {
+            _connectionToReader->setCapture(_capture);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send a pre-encoded command with the next MessageID
+ **
+ ** Nothing is composed or encoded, the frame only gets the ID
+ ** patched in. On a non-blocking connection the tail of the frame
+ ** may still be waiting in the send buffer, see
+ ** CLLRPConnection::flushSend.
+ **
+ ** @return     ok              The MessageID the response will carry
+ **             error           Send details
+ **
+ *****************************************************************************/
+
+    CResult<LLRP::llrp_u32_t> CReaderProtocol::sendCommand(CCommandFrame &command, const LLRP::CTypeDescriptor *responseType)
+    {
+        LLRP::llrp_u32_t messageId = _nextMessageId++;
+
+        command.setMessageId(messageId);
+
+        if (LLRP::RC_OK != _connectionToReader->sendFrame(command.data(), command.length()))
+        {
+            return CReaderError(ReaderErrorCode::Connection,
+                                LLRPLaps::ReaderErrorDetailsException::CErrorDetailsToString(
+                                        _connectionToReader->getSendError(), responseType->m_pName, "send"));
+        }
+        return messageId;
+    }
+
+
+    // The response matches on type and ID, an ERROR_MESSAGE with the ID is the response too
+    bool CReaderProtocol::isResponse(const CLLRPFrame *frame, LLRP::llrp_u32_t messageId, const LLRP::CTypeDescriptor *responseType)
+    {
+        return messageId == frame->messageId && (responseType->m_TypeNum == frame->messageType ||
+                                                 LLRP::CERROR_MESSAGE::s_typeDescriptor.m_TypeNum == frame->messageType);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Take ownership of a decoded response and check it is one
+ **
+ ** If it is an ERROR_MESSAGE (response from reader when it can't
+ ** understand the request), the command failed.
+ **
+ ** @param[in]  response        Decoded response, NULL if receiving
+ **                             or decoding it failed
+ **
+ ** @return     ok              The response
+ **             error           Receive, decode or ERROR_MESSAGE details
+ **
+ *****************************************************************************/
+
+    CResult<std::shared_ptr<LLRP::CMessage>> CReaderProtocol::checkResponse(LLRP::CMessage *response,
+                                                                            const LLRP::CTypeDescriptor *responseType)
+    {
+        std::shared_ptr<LLRP::CMessage> message(response);
+
+        if (nullptr == message)
+        {
+            return recvError(responseType->m_pName);
+        }
+
+        if (&LLRP::CERROR_MESSAGE::s_typeDescriptor == message->m_pType)
+        {
+            return CReaderError(ReaderErrorCode::Reader,
+                                std::string("ERROR: Received ERROR_MESSAGE instead of ") + responseType->m_pName);
+        }
+        return message;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Helper routine to check an LLRPStatus parameter
+ **         and tattle on errors
+ **
+ ** Helper routine to interpret the LLRPStatus subparameter
+ ** that is in all responses. It tattles on an error, if one,
+ ** and tries to safely provide details.
+ **
+ ** This simplifies the code, above, for common check/tattle
+ ** sequences.
+ **
+ ** @return     ok              Everything OK
+ **             error           Something went wrong, with the details
+ **
+ *****************************************************************************/
+
+    CResult<void> CReaderProtocol::checkLLRPStatus(LLRP::CLLRPStatus* llrpStatus, const std::string whatStr)
+    {
+        /*
+         * The LLRPStatus parameter is mandatory in all responses.
+         * If it is missing there should have been a decode error.
+         * This just makes sure (remember, this program is a
+         * diagnostic and suppose to catch LTKC mistakes).
+         */
+
+        if (nullptr == llrpStatus)
+        {
+            // LOG(s.sprintf("ERROR: %s missing LLRP status", pWhatStr));
+            return CReaderError(ReaderErrorCode::Reader,
+                                QString().sprintf("ERROR: %s missing LLRP status", whatStr.c_str()).toStdString());
+        }
+
+        /*
+         * Make sure the status is M_Success.
+         * If it isn't, print the error string if one.
+         * This does not try to pretty-print the status
+         * code. To get that, run this program with -vv
+         * and examine the XML output.
+         */
+
+        if (LLRP::StatusCode_M_Success != llrpStatus->getStatusCode())
+        {
+            LLRP::llrp_utf8v_t ErrorDesc;
+
+            ErrorDesc = llrpStatus->getErrorDescription();
+            QString errorStr;
+            if (0 == ErrorDesc.m_nValue)
+            {
+                errorStr.sprintf("ERROR: %s failed, no error description given", whatStr.c_str());
+            }
+            else
+            {
+                errorStr.sprintf("ERROR: %s failed, %.*s", whatStr.c_str(), ErrorDesc.m_nValue, ErrorDesc.m_pValue);
+            }
+            return CReaderError(ReaderErrorCode::Reader, errorStr.toStdString());
+        }
+
+        return CResult<void>();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Turn the connection's receive error into a CReaderError
+ **
+ ** Timeouts are their own category so the caller can tell a quiet
+ ** reader from a broken one. A dead link is a connection error
+ ** whatever the socket said.
+ **
+ *****************************************************************************/
+
+    CReaderError CReaderProtocol::recvError(const CLLRPConnection &connection, const char *function)
+    {
+        const LLRP::CErrorDetails *pError = connection.getRecvError();
+        std::string what = std::string("ERROR: ") + function + " failed, " +
+                           (pError->m_pWhatStr ? pError->m_pWhatStr : "no reason given");
+
+        if (connection.isLinkDead())
+        {
+            return CReaderError(ReaderErrorCode::Connection, what);
+        }
+
+        switch (pError->m_eResultCode)
+        {
+            case LLRP::RC_RecvTimeout:
+                return CReaderError(ReaderErrorCode::Timeout, what);
+            case LLRP::RC_RecvEOF:
+            case LLRP::RC_RecvIOError:
+                return CReaderError(ReaderErrorCode::Connection, what);
+            default:
+                return CReaderError(ReaderErrorCode::ErrorDetails, what);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Decode a raw frame with LTK
+ **
+ ** @return     ok              Pointer to a message
+ **             error           What the decoder did not like
+ **
+ *****************************************************************************/
+
+    CResult<std::shared_ptr<LLRP::CMessage>> CReaderProtocol::decodeFrame(const CLLRPFrame *frame)
+    {
+        std::shared_ptr<LLRP::CMessage> message(_connectionToReader->decodeFrame(frame));
+
+        if (nullptr == message.get())
+        {
+            return recvError("decodeFrame");
+        }
+        return message;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Deal with a report or event that is not a response
+ **
+ ** RO_ACCESS_REPORT frames go through the fast path decoder and
+ ** only fall back to LTK if it gives up. Reader events end the
+ ** ROSpec or are passed on, anything else is ignored.
+ **
+ ** @param[out] reported        true if it was an RO_ACCESS_REPORT
+ **
+ ** @return     ok              Handled or ignored
+ **             error           LTK could not decode it
+ **
+ *****************************************************************************/
+
+    CResult<void> CReaderProtocol::handleFrame(const CLLRPFrame *frame, bool &reported)
+    {
+        reported = false;
+
+        if (CROAccessReportDecoder::RO_ACCESS_REPORT_TYPE == frame->messageType && processReportFrame(frame))
+        {
+            reported = true;
+            return CResult<void>();
+        }
+
+        CResult<std::shared_ptr<LLRP::CMessage>> decoded = decodeFrame(frame);
+        if (!decoded)
+        {
+            return decoded.error();
+        }
+        std::shared_ptr<LLRP::CMessage> message = decoded.value();
+
+        if (&LLRP::CRO_ACCESS_REPORT::s_typeDescriptor == message->m_pType)
+        {
+            if (nullptr != _latencyRecorder)
+            {
+                _latencyRecorder->record(CLatencyRecorder::Decode, _frameReceivedNSec);
+            }
+            processTagList(std::dynamic_pointer_cast<LLRP::CRO_ACCESS_REPORT>(message));
+            reported = true;
+        }
+        else if (&LLRP::CREADER_EVENT_NOTIFICATION::s_typeDescriptor == message->m_pType)
+        {
+            auto *readerEventNotificationData =
+                    dynamic_cast<LLRP::CREADER_EVENT_NOTIFICATION *>(message.get())->getReaderEventNotificationData();
+            if (nullptr != readerEventNotificationData)
+            {
+                handleReaderEventNotification(readerEventNotificationData);
+            }
+        }
+        else
+        {
+            // LOG(QString().sprintf("WARNING: Ignored unexpected message during monitor: %s", message->m_pType->m_pName));
+        }
+        return CResult<void>();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Helper routine to
+ **
+ ** The report is printed in list order, which is arbitrary.
+ **
+ ** TODO: It would be cool to sort the list by EPC and antenna,
+ **       then print it.
+ **
+ ** @return     void
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::processTagList(std::shared_ptr<LLRP::CRO_ACCESS_REPORT> RO_ACCESS_REPORT)
+    {
+        for (std::list<LLRP::CTagReportData*>::iterator i = RO_ACCESS_REPORT->beginTagReportData(); RO_ACCESS_REPORT->endTagReportData() != i; ++i)
+        {
+            processTagInfo(*i);
+        }
+
+        if (nullptr != _batchController)
+        {
+            _batchController->onReport(RO_ACCESS_REPORT->countTagReportData(), _frameReceivedNSec,
+                                       CLatencyRecorder::nowNSec());
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Helper routine to print one tag report entry on one line
+ **
+ ** @return     void
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::processTagInfo(LLRP::CTagReportData *tagReportData)
+    {
+        const LLRP::CTypeDescriptor *cTypeDescriptor;
+        auto *pEPCParameter = tagReportData->getEPCParameter();
+        LLRPLaps::CTagInfo tagInfo;
+
+        /*
+         * Process the EPC. It could be a 96-bit EPC_96 parameter
+         * or an variable length EPCData parameter.
+         */
+
+        if (nullptr != pEPCParameter)
+        {
+            LLRP::llrp_u96_t my_u96;
+            LLRP::llrp_u1v_t my_u1v;
+            LLRP::llrp_u8_t *value = NULL;
+            int n;
+
+            cTypeDescriptor = pEPCParameter->m_pType;
+            if (&LLRP::CEPC_96::s_typeDescriptor == cTypeDescriptor)
+            {
+                auto *pEPC_96 = dynamic_cast<LLRP::CEPC_96 *>(pEPCParameter);
+                my_u96 = pEPC_96->getEPC();
+                value = my_u96.m_aValue;
+                n = 12u;
+            }
+            else if (&LLRP::CEPCData::s_typeDescriptor == cTypeDescriptor)
+            {
+                auto *pEPCData = dynamic_cast<LLRP::CEPCData *>(pEPCParameter);
+                my_u1v = pEPCData->getEPC();
+                value = my_u1v.m_pValue;
+                n = (my_u1v.m_nBit + 7u) / 8u;
+            }
+
+            if (value)
+            {
+                tagInfo.setTimeStampUSec(tagReportData->getFirstSeenTimestampUTC()->getMicroseconds());
+                tagInfo.setHostReceivedNSec(_frameReceivedNSec);
+                tagInfo.AntennaId = tagReportData->getAntennaID()->getAntennaID();
+                if (nullptr != tagReportData->getPeakRSSI())
+                {
+                    tagInfo.setPeakRSSI(tagReportData->getPeakRSSI()->getPeakRSSI());
+                }
+                tagInfo.data.reserve(n);
+                for (int i = 0; i < n; i++)
+                {
+                    tagInfo.data.push_back(value[i]);
+                }
+                const CRosterIndex *roster = currentRoster();
+                if (nullptr != roster)
+                {
+                    tagInfo.setRiderId(roster->find(tagInfo.data.data(), tagInfo.data.size()));
+                    if (_rejectUnregistered && !roster->empty() && CRosterIndex::NOT_REGISTERED == tagInfo.getRiderId())
+                    {
+                        return;
+                    }
+                }
+                if (nullptr != _epcInterner)
+                {
+                    tagInfo.setEpcId(_epcInterner->intern(tagInfo.data));
+                }
+                emit newTag(tagInfo);
+            }
+            else
+            {
+                // LOG(QString("Unknown-epc-data-type in tag"));
+            }
+        }
+        else
+        {
+            // LOGQString("Missing-epc-data in tag"));
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Fast path for an RO_ACCESS_REPORT frame
+ **
+ ** Decodes the frame in place into _tagRecords, growing it once if
+ ** the report is larger than any seen so far, and emits the tags.
+ **
+ ** @return     true            Report processed
+ **             false           The fast decoder gave up, use LTK
+ **
+ *****************************************************************************/
+
+    bool CReaderProtocol::processReportFrame(const CLLRPFrame *frame)
+    {
+        auto result = _reportDecoder.decode(frame->data, frame->length, _tagRecords.data(), _tagRecords.size());
+
+        if (CROAccessReportDecoder::TooManyTags == result)
+        {
+            _tagRecords.resize(_reportDecoder.getTagCount());
+            result = _reportDecoder.decode(frame->data, frame->length, _tagRecords.data(), _tagRecords.size());
+        }
+
+        if (CROAccessReportDecoder::Ok != result)
+        {
+            // LOG("NOTICE: RO_ACCESS_REPORT fast path failed, using LTK");
+            return false;
+        }
+
+        if (nullptr != _latencyRecorder)
+        {
+            _latencyRecorder->record(CLatencyRecorder::Decode, _frameReceivedNSec);
+        }
+
+        processTagRecords(_tagRecords.data(), _reportDecoder.getTagCount());
+
+        if (nullptr != _batchController)
+        {
+            _batchController->onReport(_reportDecoder.getTagCount(), _frameReceivedNSec, CLatencyRecorder::nowNSec());
+        }
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Emit a CTagInfo for every decoded tag record
+ **
+ ** Same result as processTagInfo for the LTK path.
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::processTagRecords(const CTagRecord *records, std::size_t count)
+    {
+        /* The whole report resolved to riders in one pass before any is emitted */
+        const CRosterIndex *roster = currentRoster();
+        bool reject = nullptr != roster && _rejectUnregistered && !roster->empty();
+        if (nullptr != roster)
+        {
+            if (_riderIds.size() < count)
+            {
+                _riderIds.resize(count);
+            }
+            roster->resolve(records, count, _riderIds.data());
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (reject && CRosterIndex::NOT_REGISTERED == _riderIds[i])
+            {
+                continue;
+            }
+
+            const CTagRecord &record = records[i];
+            LLRPLaps::CTagInfo tagInfo;
+
+            tagInfo.setTimeStampUSec(record.firstSeenUSec);
+            tagInfo.setHostReceivedNSec(_frameReceivedNSec);
+            tagInfo.AntennaId = record.antennaId;
+            tagInfo.setPeakRSSI(record.peakRSSI);
+            tagInfo.data.assign(record.epc, record.epc + record.getEpcBytes());
+            if (nullptr != roster)
+            {
+                tagInfo.setRiderId(_riderIds[i]);
+            }
+            if (nullptr != _epcInterner)
+            {
+                tagInfo.setEpcId(_epcInterner->intern(record.epc, record.getEpcBytes()));
+            }
+            emit newTag(tagInfo);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Handle a ReaderEventNotification
+ **
+ ** Handle the payload of a READER_EVENT_NOTIFICATION message.
+ ** This routine simply dispatches to handlers of specific
+ ** event types.
+ **
+ ** @return     void
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::handleReaderEventNotification(LLRP::CReaderEventNotificationData *cReaderEventNotificationData)
+    {
+        auto reported = false;
+
+        auto *pAntennaEvent = cReaderEventNotificationData->getAntennaEvent();
+        if (NULL != pAntennaEvent)
+        {
+            handleAntennaEvent(pAntennaEvent);
+            reported = true;
+        }
+
+        auto *pReaderExceptionEvent = cReaderEventNotificationData->getReaderExceptionEvent();
+        if (NULL != pReaderExceptionEvent)
+        {
+            handleReaderExceptionEvent(pReaderExceptionEvent);
+            reported = true;
+        }
+
+        auto *pROSpecEvent = cReaderEventNotificationData->getROSpecEvent();
+        if (NULL != pROSpecEvent)
+        {
+            if (LLRP::ROSpecEventType_End_Of_ROSpec == pROSpecEvent->getEventType() &&
+                _commands.config.roSpecId == pROSpecEvent->getROSpecID())
+            {
+                _roSpecEnded = true;
+            }
+            reported = true;
+        }
+
+        /*
+         * Similarly handle other events here:
+         *      HoppingEvent
+         *      GPIEvent
+         *      ReportBufferLevelWarningEvent
+         *      ReportBufferOverflowErrorEvent
+         *      RFSurveyEvent
+         *      AISpecEvent
+         *      ConnectionAttemptEvent
+         *      ConnectionCloseEvent
+         *      Custom
+         */
+
+        if (0 == reported)
+        {
+            // LOG("NOTICE: Unexpected (unhandled) ReaderEvent"));
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Handle an AntennaEvent
+ **
+ ** An antenna was disconnected or (re)connected. Passed on for
+ ** CAntennaAnalytics and the operator.
+ **
+ ** @return     void
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::handleAntennaEvent(LLRP::CAntennaEvent *pAntennaEvent)
+    {
+        LLRP::EAntennaEventType eEventType;
+        LLRP::llrp_u16_t AntennaID;
+
+        eEventType = pAntennaEvent->getEventType();
+        AntennaID = pAntennaEvent->getAntennaID();
+
+        switch (eEventType)
+        {
+            case LLRP::AntennaEventType_Antenna_Disconnected:
+                emit antennaChanged(AntennaID, false);
+                break;
+
+            case LLRP::AntennaEventType_Antenna_Connected:
+                emit antennaChanged(AntennaID, true);
+                break;
+
+            default:
+                // LOG("NOTICE: Antenna %d unknown event", AntennaID);
+                break;
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Handle a ReaderExceptionEvent
+ **
+ ** Something has gone wrong. There are lots of details but
+ ** all this does is print the message, if one.
+ **
+ ** @return     void
+ **
+ *****************************************************************************/
+
+    void CReaderProtocol::handleReaderExceptionEvent(LLRP::CReaderExceptionEvent *pReaderExceptionEvent)
+    {
+        LLRP::llrp_utf8v_t Message;
+        QString s;
+
+        Message = pReaderExceptionEvent->getMessage();
+
+        if (0 < Message.m_nValue && NULL != Message.m_pValue)
+        {
+            // LOG(s.sprintf("NOTICE: ReaderException '%.*s'", Message.m_nValue, Message.m_pValue));
+        }
+        else
+        {
+            // LOG(emit newLogMessage(s.sprintf("NOTICE: ReaderException but no message"));
+        }
+    }
+}
@@ -0,0 +1,185 @@
+//********************************************************************
+//    created:    2026-10-19 06:10 AM
+//    file:       creaderprotocol.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#ifndef LLRPLAPS_CREADERPROTOCOL_H
+#define LLRPLAPS_CREADERPROTOCOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+#include "ltkcpp.h"
+#include "ctaginfo.h"
+#include "croaccessreportdecoder.h"
+#include "ccommandframe.h"
+#include "crospecconfig.h"
+#include "creaderconfig.h"
+#include "cresult.h"
+#include "crosterindex.h"
+
+Q_DECLARE_METATYPE(LLRPLaps::CTagInfo);
+
+namespace LLRPLaps
+{
+    class CLatencyRecorder;
+    class CEpcInterner;
+    class CLLRPConnection;
+    class CFrameCapture;
+    class CChipRegistry;
+    class CReportBatchController;
+    struct CLLRPFrame;
+
+    /*
+     * What CReader and CReaderSession say to a reader and make of
+     * its answers, whichever way they wait for them.
+     *
+     * Holds the commands with the registry filters and the batch
+     * controller's settings folded in, sends them, checks the
+     * responses and turns reports into CTagInfo, with rider ids,
+     * epc ids and RSSI. Reports and events are handled by
+     * handleFrame() for both, the fast decoder first and LTK when it
+     * gives up.
+     *
+     * Receiving is left to the subclass: CReader blocks on the
+     * connection, CReaderSession suspends on its executor.
+     */
+    class CReaderProtocol : public QObject
+    {
+    Q_OBJECT
+
+    public:
+        explicit CReaderProtocol(QString readerHostName);
+
+        ~CReaderProtocol() override;
+
+        const QString &getHostName() const { return _readerHostname; }
+
+        void setLatencyRecorder(CLatencyRecorder *recorder) { _latencyRecorder = recorder; }
+
+        // Tags are emitted with their epc id from interner
+        void setEpcInterner(CEpcInterner *interner) { _epcInterner = interner; }
+
+        void setCaptureFile(const QString &path);
+
+        void setROSpecConfig(const CROSpecConfig &config);
+
+        const CROSpecConfig &getROSpecConfig() const { return _commands.config; }
+
+        void setReaderConfig(const CReaderConfig &readerConfig);
+
+        const CReaderConfig &getReaderConfig() const { return _commands.readerConfig; }
+
+        void setChipRegistry(const CChipRegistry *registry, std::size_t maxFilters, bool rejectUnregistered = false);
+
+        void setReportBatchController(CReportBatchController *controller);
+
+        static CResult<void> checkLLRPStatus(LLRP::CLLRPStatus* llrpStatus, const std::string whatStr);
+
+        static CReaderError recvError(const CLLRPConnection &connection, const char *function);
+
+    signals:
+
+        void newTag(const LLRPLaps::CTagInfo &);
+
+        // Operator alarm: the reader stopped sending keepalives, a reconnect is under way
+        void linkDown(const QString &reason);
+
+        void linkRestored();
+
+        // From the reader's AntennaEvent
+        void antennaChanged(int antennaId, bool connected);
+
+    protected:
+        std::shared_ptr<CLLRPConnection> _connectionToReader;
+        std::shared_ptr<CFrameCapture> _capture;
+        QString _readerHostname;
+        CLatencyRecorder *_latencyRecorder;
+        CEpcInterner *_epcInterner;
+        std::uint64_t _frameReceivedNSec;
+        CROAccessReportDecoder _reportDecoder;
+        std::vector<CTagRecord> _tagRecords;
+        CCommandFrames _commands;
+        LLRP::llrp_u32_t _nextMessageId;
+        const CChipRegistry *_chipRegistry;
+        std::size_t _maxEpcFilters;
+        std::uint64_t _registryGeneration;
+        std::shared_ptr<const CRosterIndex> _roster;
+        std::uint64_t _rosterGeneration;
+        std::vector<std::int64_t> _riderIds;            // per record of the report being emitted
+        bool _rejectUnregistered;
+        CReportBatchController *_batchController;
+        std::uint16_t _configuredReportN;               // as set, the batch controller's stand in while there is one
+        std::uint32_t _configuredAIDurationMS;
+        bool _configuredNotifyROSpecEvents;
+        bool _roSpecEnded;
+        bool _reconfigurePending;                       // a setter changed the commands since the last full configure
+
+        void buildCommands(const CROSpecConfig &config, const CReaderConfig &readerConfig);
+
+        bool updateEpcFilters();
+
+        const CRosterIndex *currentRoster();
+
+        bool updateReportBatching();
+
+        CResult<LLRP::llrp_u32_t> sendCommand(CCommandFrame &command, const LLRP::CTypeDescriptor *responseType);
+
+        static bool isResponse(const CLLRPFrame *frame, LLRP::llrp_u32_t messageId, const LLRP::CTypeDescriptor *responseType);
+
+        CResult<std::shared_ptr<LLRP::CMessage>> checkResponse(LLRP::CMessage *response, const LLRP::CTypeDescriptor *responseType);
+
+        // The LLRPStatus of a TResponse from checkResponse()
+        template <class TResponse>
+        static CResult<void> checkStatus(const CResult<std::shared_ptr<LLRP::CMessage>> &response, const char *whatStr)
+        {
+            if (!response)
+            {
+                return response.error();
+            }
+            return checkLLRPStatus(dynamic_cast<TResponse *>(response.value().get())->getLLRPStatus(), whatStr);
+        }
+
+        CReaderError recvError(const char *function) const { return recvError(*_connectionToReader, function); }
+
+        CResult<std::shared_ptr<LLRP::CMessage>> decodeFrame(const CLLRPFrame *frame);
+
+        CResult<void> handleFrame(const CLLRPFrame *frame, bool &reported);
+
+        void processTagList(std::shared_ptr<LLRP::CRO_ACCESS_REPORT> RO_ACCESS_REPORT);
+
+        void processTagInfo(LLRP::CTagReportData *tagReportData);
+
+        bool processReportFrame(const CLLRPFrame *frame);
+
+        void processTagRecords(const CTagRecord *records, std::size_t count);
+
+        void handleReaderEventNotification(LLRP::CReaderEventNotificationData *cReaderEventNotificationData);
+
+        void handleAntennaEvent(LLRP::CAntennaEvent *antennaEvent);
+
+        void handleReaderExceptionEvent(LLRP::CReaderExceptionEvent *readerExceptionEvent);
+
+        const static std::size_t INITIAL_TAG_RECORDS;
+        const static std::uint64_t NO_GENERATION;
+    };
+}
+#endif //LLRPLAPS_CREADERPROTOCOL_H
@@ -0,0 +1,480 @@
+//********************************************************************
+//    created:    2026-10-18 09:00 PM
+//    file:       creadersession.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "creadersession.h"
+#include "clatencyrecorder.h"
+#include "cllrpconnection.h"
+#include "exceptions.h"
+
+namespace LLRPLaps
+{
+    const unsigned int CReaderSession::RECONNECT_DELAY_MS = 2000;
+
+    namespace
+    {
+        const std::uint64_t NSEC_PER_MS = 1000000u;
+
+        // Same limits as CReader
+        const std::uint64_t CONNECT_TIMEOUT_MS = 10000;
+        const std::uint64_t RESPONSE_TIMEOUT_MS = 5000;
+        const std::uint64_t REPORT_TIMEOUT_MS = 7000;
+
+        std::uint64_t deadlineAfterMS(std::uint64_t ms)
+        {
+            return CLatencyRecorder::nowNSec() + ms * NSEC_PER_MS;
+        }
+    }
+
+    CReaderSession::CReaderSession(CSessionExecutor &executor, QString readerHostName)
+            : CReaderProtocol(readerHostName), _executor(executor), _state(Stopped), _linkDownReported(false),
+              _stopRequested(false)
+    {
+        _connectionToReader.reset(new CLLRPConnection(LLRP::getTheTypeRegistry(), 32u * 1024u));
+        _connectionToReader->setNonBlocking(true);
+    }
+
+
+    CReaderSession::~CReaderSession()
+    {
+        _connectionToReader->closeConnectionToReader();
+    }
+
+
+    void CReaderSession::setState(State state)
+    {
+        if (state != _state)
+        {
+            _state = state;
+            emit stateChanged(state);
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The session: connect, configure, run, and start over
+ **         on any error until stopped
+ **
+ *****************************************************************************/
+
+    CTask<void> CReaderSession::run()
+    {
+        _stopRequested = false;
+
+        while (!_stopRequested)
+        {
+            CResult<void> result = co_await connect();
+            if (result)
+            {
+                setState(Configuring);
+                result = co_await configure();
+            }
+            if (result)
+            {
+                if (_linkDownReported)
+                {
+                    _linkDownReported = false;
+                    emit linkRestored();
+                }
+                result = co_await inventory();
+            }
+            if (_stopRequested)
+            {
+                break;
+            }
+
+            /*
+             * Tell the operator once per outage, not once per
+             * failed attempt to get the reader back.
+             */
+
+            _connectionToReader->closeConnectionToReader();
+            if (!_linkDownReported)
+            {
+                _linkDownReported = true;
+                emit linkDown(QString::fromStdString(result.error().message));
+            }
+            setState(Reconnecting);
+            co_await _executor.sleepMS(RECONNECT_DELAY_MS);
+        }
+
+        _connectionToReader->closeConnectionToReader();
+        setState(Stopped);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Open the connection and check the reader accepted it
+ **
+ ** See CReader::checkConnectionStatus for the notification the
+ ** reader sends first thing.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<void>> CReaderSession::connect()
+    {
+        setState(Connecting);
+
+        std::uint64_t deadlineNSec = deadlineAfterMS(CONNECT_TIMEOUT_MS);
+
+        if (0 != _connectionToReader->startConnectionToReader(_readerHostname.toLatin1().data()))
+        {
+            co_return CReaderError(ReaderErrorCode::Connection,
+                                   std::string("ERROR: connect: ") + _connectionToReader->getConnectError());
+        }
+
+        for (;;)
+        {
+            int connected = _connectionToReader->finishConnect();
+            if (connected > 0)
+            {
+                break;
+            }
+            if (connected < 0)
+            {
+                co_return CReaderError(ReaderErrorCode::Connection,
+                                       std::string("ERROR: connect: ") + _connectionToReader->getConnectError());
+            }
+            if (!co_await _executor.writable(_connectionToReader->getSocket(), deadlineNSec))
+            {
+                co_return CReaderError(ReaderErrorCode::Connection, "ERROR: connect: timed out");
+            }
+        }
+
+        setState(AwaitingConnectionEvent);
+
+        CResult<const CLLRPFrame *> received = co_await recvFrame(deadlineNSec);
+        if (!received)
+        {
+            co_return CReaderError(ReaderErrorCode::Connection,
+                                   "recvMessage failed: No connection, " + received.error().message);
+        }
+
+        CResult<std::shared_ptr<LLRP::CMessage>> decoded = decodeFrame(received.value());
+        if (!decoded)
+        {
+            co_return decoded.error();
+        }
+
+        auto *notification = dynamic_cast<LLRP::CREADER_EVENT_NOTIFICATION *>(decoded.value().get());
+        LLRP::CReaderEventNotificationData *data = (nullptr != notification) ? notification->getReaderEventNotificationData()
+                                                                             : nullptr;
+        LLRP::CConnectionAttemptEvent *attempt = (nullptr != data) ? data->getConnectionAttemptEvent() : nullptr;
+
+        if (nullptr == attempt)
+        {
+            co_return CReaderError(ReaderErrorCode::Connection, "recvMessage failed: Wrong message type");
+        }
+        if (LLRP::ConnectionAttemptStatusType_Success != attempt->getStatus())
+        {
+            co_return CReaderError(ReaderErrorCode::Connection, "recvMessage failed: invalid connection");
+        }
+        co_return CResult<void>();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Put the reader in a known state and install the ROSpec
+ **
+ ** Same steps as CReader::Connect(), with the registry filters as
+ ** they are now. Any pending config change is taken on here.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<void>> CReaderSession::configure()
+    {
+        CResult<void> result;
+
+        _reconfigurePending = false;
+        updateEpcFilters();
+
+        if (!(result = co_await command<LLRP::CSET_READER_CONFIG_RESPONSE>(_commands.resetToFactoryDefaults,
+                                                                           "resetConfigurationToFactoryDefaults")))
+        {
+            co_return result;
+        }
+
+        if (!_commands.setReaderConfig.empty())
+        {
+            if (!(result = co_await command<LLRP::CSET_READER_CONFIG_RESPONSE>(_commands.setReaderConfig,
+                                                                               "setReaderConfiguration")))
+            {
+                co_return result;
+            }
+            _connectionToReader->setLinkTimeout(_commands.readerConfig.keepaliveIntervalMS,
+                                                _commands.readerConfig.missedKeepalives);
+        }
+
+        co_return co_await installROSpec();
+    }
+
+
+    CTask<CResult<void>> CReaderSession::installROSpec()
+    {
+        CResult<void> result;
+
+        if (!(result = co_await command<LLRP::CDELETE_ROSPEC_RESPONSE>(_commands.deleteAllROSpecs, "deleteAllROSpecs")) ||
+            !(result = co_await command<LLRP::CADD_ROSPEC_RESPONSE>(_commands.addROSpec, "addROSpec")))
+        {
+            co_return result;
+        }
+        co_return co_await command<LLRP::CENABLE_ROSPEC_RESPONSE>(_commands.enableROSpec, "enableROSpec");
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Inventory cycles until stopped or something breaks
+ **
+ ** A config change goes through Reconfiguring. New registry
+ ** filters or batch settings only need the ROSpec swapped, as
+ ** CReader::inventoryCycle does.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<void>> CReaderSession::inventory()
+    {
+        setState(Running);
+
+        while (!_stopRequested)
+        {
+            bool roSpecChanged = updateEpcFilters();
+            roSpecChanged = updateReportBatching() || roSpecChanged;
+
+            if (_reconfigurePending || roSpecChanged)
+            {
+                setState(Reconfiguring);
+                CResult<void> reconfigured = _reconfigurePending ? co_await configure() : co_await installROSpec();
+                if (!reconfigured)
+                {
+                    co_return reconfigured;
+                }
+                setState(Running);
+            }
+
+            CResult<void> result = co_await command<LLRP::CSTART_ROSPEC_RESPONSE>(_commands.startROSpec, "startROSpec");
+            if (result)
+            {
+                result = co_await awaitReports();
+            }
+
+            // A quiet track, not a broken reader
+            if (!result && !(ReaderErrorCode::Timeout == result.code() && !_connectionToReader->isLinkDead()))
+            {
+                co_return result;
+            }
+        }
+        co_return CResult<void>();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive until the ROSpec's reports are in
+ **
+ ** See CReader::awaitReports.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<void>> CReaderSession::awaitReports()
+    {
+        const bool untilROSpecEnd = _commands.readerConfig.notifyROSpecEvents;
+        bool done = false;
+
+        _roSpecEnded = false;
+
+        while (!done)
+        {
+            CResult<const CLLRPFrame *> received = co_await recvFrame(deadlineAfterMS(REPORT_TIMEOUT_MS));
+            if (!received)
+            {
+                co_return received.error();
+            }
+
+            bool reported = false;
+            CResult<void> handled = handleFrame(received.value(), reported);
+            if (!handled)
+            {
+                co_return handled;
+            }
+            done = untilROSpecEnd ? _roSpecEnded : reported;
+        }
+        co_return CResult<void>();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Transact a pre-encoded command and check the LLRPStatus
+ **         of its TResponse
+ **
+ *****************************************************************************/
+
+    template <class TResponse>
+    CTask<CResult<void>> CReaderSession::command(CCommandFrame &frame, const char *whatStr)
+    {
+        CResult<std::shared_ptr<LLRP::CMessage>> response = co_await transact(frame, &TResponse::s_typeDescriptor);
+
+        co_return checkStatus<TResponse>(response, whatStr);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send a pre-encoded command and wait for its response
+ **
+ ** Reports and events that come in first are handled on the spot
+ ** rather than queued, there is nobody else to read them.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<std::shared_ptr<LLRP::CMessage>>> CReaderSession::transact(CCommandFrame &command,
+                                                                            const LLRP::CTypeDescriptor *responseType)
+    {
+        std::uint64_t deadlineNSec = deadlineAfterMS(RESPONSE_TIMEOUT_MS);
+
+        CResult<LLRP::llrp_u32_t> sent = sendCommand(command, responseType);
+        if (!sent)
+        {
+            co_return sent.error();
+        }
+
+        CResult<void> flushed = co_await flushSend(deadlineNSec);
+        if (!flushed)
+        {
+            co_return flushed.error();
+        }
+
+        for (;;)
+        {
+            CResult<const CLLRPFrame *> received = co_await recvFrame(deadlineNSec);
+            if (!received)
+            {
+                co_return received.error();
+            }
+
+            const CLLRPFrame *frame = received.value();
+            if (isResponse(frame, sent.value(), responseType))
+            {
+                co_return checkResponse(_connectionToReader->decodeFrame(frame), responseType);
+            }
+
+            bool reported = false;
+            CResult<void> handled = handleFrame(frame, reported);
+            if (!handled)
+            {
+                co_return handled.error();
+            }
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Get a command the socket did not take at once out,
+ **         suspending while the socket is full
+ **
+ ** A reader that does not take a command within the response
+ ** timeout is as good as gone, that is a connection error.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<void>> CReaderSession::flushSend(std::uint64_t deadlineNSec)
+    {
+        for (;;)
+        {
+            if (LLRP::RC_OK != _connectionToReader->flushSend())
+            {
+                co_return sendError("flushSend");
+            }
+            if (!_connectionToReader->hasPendingSend())
+            {
+                co_return CResult<void>();
+            }
+            if (!co_await _executor.writable(_connectionToReader->getSocket(), deadlineNSec))
+            {
+                co_return CReaderError(ReaderErrorCode::Connection, "ERROR: flushSend failed, timeout");
+            }
+        }
+    }
+
+
+    CReaderError CReaderSession::sendError(const char *function) const
+    {
+        return CReaderError(ReaderErrorCode::Connection,
+                            LLRPLaps::ReaderErrorDetailsException::CErrorDetailsToString(
+                                    _connectionToReader->getSendError(), function, "send"));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Receive the next frame, suspending while there is none
+ **
+ ** The wait ends at the deadline or at the link deadline, whichever
+ ** comes first, so a dead link is noticed even during a long wait.
+ ** Keepalive acks the socket did not take go out on every pass.
+ **
+ *****************************************************************************/
+
+    CTask<CResult<const CLLRPFrame *>> CReaderSession::recvFrame(std::uint64_t deadlineNSec)
+    {
+        for (;;)
+        {
+            if (LLRP::RC_OK != _connectionToReader->flushSend())
+            {
+                co_return sendError("flushSend");
+            }
+
+            const CLLRPFrame *frame = _connectionToReader->recvFrame(0);
+            if (nullptr != frame)
+            {
+                _frameReceivedNSec = frame->hostReceivedNSec;
+                co_return frame;
+            }
+            if (LLRP::RC_RecvTimeout != _connectionToReader->getRecvError()->m_eResultCode || _connectionToReader->isLinkDead())
+            {
+                co_return recvError("recvFrame");
+            }
+
+            std::uint64_t wakeNSec = deadlineNSec;
+            std::uint64_t linkDeadlineNSec = _connectionToReader->getLinkDeadlineNSec();
+            if (0 != linkDeadlineNSec && linkDeadlineNSec < wakeNSec)
+            {
+                wakeNSec = linkDeadlineNSec;
+            }
+
+            if (!co_await _executor.readable(_connectionToReader->getSocket(), wakeNSec) &&
+                CLatencyRecorder::nowNSec() >= deadlineNSec)
+            {
+                co_return CReaderError(ReaderErrorCode::Timeout, "ERROR: recvFrame failed, timeout");
+            }
+        }
+    }
+}
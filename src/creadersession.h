@@ -0,0 +1,134 @@
+//********************************************************************
+//    created:    2026-10-18 09:00 PM
+//    file:       creadersession.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREADERSESSION_H
+#define LLRPLAPS_CREADERSESSION_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+#include "ltkcpp.h"
+#include "ccommandframe.h"
+#include "creaderprotocol.h"
+#include "cresult.h"
+#include "csessionexecutor.h"
+#include "ctask.h"
+
+namespace LLRPLaps
+{
+    struct CLLRPFrame;
+
+    /*
+     * One reader driven as a coroutine on a CSessionExecutor.
+     *
+     * The same conversation as CReader, but every send, receive and
+     * transaction suspends the session instead of blocking a thread,
+     * so one executor thread keeps a dozen readers going. The socket
+     * stays non-blocking, a command the socket cannot take at once
+     * waits for writable. The commands, filters, batching and report
+     * handling are CReader's, see CReaderProtocol. Where CReader
+     * leaves reconnecting to whoever calls it, here it is part of
+     * the session:
+     *
+     *     Connecting -> AwaitingConnectionEvent -> Configuring -> Running
+     *          ^                                       ^            |
+     *          |                                       +- Reconfiguring
+     *          +------------- Reconnecting <------ any error ------+
+     *
+     * Timeouts waiting for a report while Running are a quiet track
+     * and the next inventory cycle starts. Config changes, registry
+     * filters and batch settings are taken on between cycles.
+     * Everything else, a dead link included, closes the connection
+     * and starts over after RECONNECT_DELAY_MS.
+     *
+     * The session must outlive the task run() returns. Everything,
+     * the setters included, is called on the executor thread.
+     * Signals are emitted there too, connect to them queued.
+     */
+    class CReaderSession : public CReaderProtocol
+    {
+    Q_OBJECT
+
+    public:
+        enum State
+        {
+            Connecting,
+            AwaitingConnectionEvent,
+            Configuring,
+            Running,
+            Reconfiguring,
+            Reconnecting,
+            Stopped
+        };
+        Q_ENUM(State)
+
+        CReaderSession(CSessionExecutor &executor, QString readerHostName);
+
+        ~CReaderSession() override;
+
+        // Hand to CSessionExecutor::spawn(), finishes after stop()
+        CTask<void> run();
+
+        // Stops after the inventory cycle or wait under way
+        void stop() { _stopRequested = true; }
+
+        State getState() const { return _state; }
+
+        const static unsigned int RECONNECT_DELAY_MS;
+
+    signals:
+
+        void stateChanged(LLRPLaps::CReaderSession::State state);
+
+    private:
+        void setState(State state);
+
+        CTask<CResult<void>> connect();
+
+        CTask<CResult<void>> configure();
+
+        CTask<CResult<void>> installROSpec();
+
+        CTask<CResult<void>> inventory();
+
+        CTask<CResult<void>> awaitReports();
+
+        template <class TResponse>
+        CTask<CResult<void>> command(CCommandFrame &frame, const char *whatStr);
+
+        CTask<CResult<std::shared_ptr<LLRP::CMessage>>> transact(CCommandFrame &command,
+                                                                  const LLRP::CTypeDescriptor *responseType);
+
+        CTask<CResult<void>> flushSend(std::uint64_t deadlineNSec);
+
+        CTask<CResult<const CLLRPFrame *>> recvFrame(std::uint64_t deadlineNSec);
+
+        CReaderError sendError(const char *function) const;
+
+        CSessionExecutor &_executor;
+        State _state;
+        bool _linkDownReported;
+        bool _stopRequested;
+    };
+}
+#endif //LLRPLAPS_CREADERSESSION_H
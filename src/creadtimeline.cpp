@@ -0,0 +1,327 @@
+//********************************************************************
+//    created:    2026-10-19 04:10 AM
+//    file:       creadtimeline.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "creadtimeline.h"
+
+namespace LLRPLaps
+{
+    const char CReadTimeline::MAGIC[8] = { 'L', 'A', 'P', 'S', 'T', 'M', 'L', '\0' };
+    const std::uint32_t CReadTimeline::VERSION = 2;
+    const unsigned int CReadTimeline::HEADER_SIZE = 16;
+    const unsigned int CReadTimeline::BLOCK_SIZE = 4096;
+    const unsigned int CReadTimeline::BLOCK_HEADER_SIZE = 32;
+    const unsigned int CReadTimeline::ANTENNA_BITS = 3;
+    const std::size_t CReadTimeline::MAX_OPEN_BLOCKS = 1024;
+
+    namespace
+    {
+        const std::size_t MAX_EPC_BYTES = 255;
+
+        // A 64 bit varint, a 16 bit antenna varint and the RSSI
+        const std::size_t MAX_READ_BYTES = 10 + 3 + 1;
+
+        void putU16(unsigned char *p, std::uint16_t value)
+        {
+            p[0] = static_cast<unsigned char>(value);
+            p[1] = static_cast<unsigned char>(value >> 8);
+        }
+
+        void putU32(unsigned char *p, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void putU64(unsigned char *p, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        std::uint16_t getU16(const unsigned char *p)
+        {
+            return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::size_t putVarint(unsigned char *p, std::uint64_t value)
+        {
+            std::size_t n = 0;
+            while (value >= 0x80)
+            {
+                p[n++] = static_cast<unsigned char>(value | 0x80);
+                value >>= 7;
+            }
+            p[n++] = static_cast<unsigned char>(value);
+            return n;
+        }
+
+        // Reads from several readers can come a little out of order
+        std::size_t encodeRead(unsigned char *p, const CTagInfo &tagInfo, u_int64_t previousUSec,
+                               unsigned int antennaBits)
+        {
+            std::int64_t delta = static_cast<std::int64_t>(tagInfo.getTimeStampUSec() - previousUSec);
+            std::uint64_t zigzag = (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+            unsigned int maxCode = (1u << antennaBits) - 1u;
+            unsigned int code = (tagInfo.AntennaId >= 1 && static_cast<unsigned int>(tagInfo.AntennaId) <= maxCode)
+                                ? static_cast<unsigned int>(tagInfo.AntennaId) : 0u;
+
+            std::size_t n = putVarint(p, (zigzag << antennaBits) | code);
+            if (0 == code)
+            {
+                n += putVarint(p + n, static_cast<std::uint16_t>(tagInfo.AntennaId));
+            }
+            p[n++] = static_cast<unsigned char>(tagInfo.getPeakRSSI());
+            return n;
+        }
+    }
+
+    CReadTimeline::CReadTimeline(QObject *parent) : QObject(parent), _file(nullptr), _readCount(0), _blockCount(0)
+    {
+    }
+
+
+    CReadTimeline::~CReadTimeline()
+    {
+        close();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start a timeline, or carry on with one
+ **
+ ** A block torn by a crash is cut off before appending. A file that
+ ** is not a timeline is left alone.
+ **
+ *****************************************************************************/
+
+    bool CReadTimeline::open(const std::string &path)
+    {
+        close();
+
+        std::error_code error;
+        std::uint64_t size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+        if (error)
+        {
+            return false;
+        }
+
+        if (0 != size)
+        {
+            unsigned char header[HEADER_SIZE] = {};
+            std::FILE *existing = std::fopen(path.c_str(), "rb");
+            if (nullptr == existing)
+            {
+                return false;
+            }
+            std::size_t got = std::fread(header, 1, sizeof header, existing);
+            if (sizeof header != got || 0 != std::memcmp(header, MAGIC, sizeof MAGIC) ||
+                VERSION != getU32(header + 8) || BLOCK_SIZE != getU32(header + 12))
+            {
+                std::fclose(existing);
+                return false;
+            }
+
+            /* Walk the block headers up to the first that runs past the end */
+            std::uint64_t end = HEADER_SIZE;
+            unsigned char blockHeader[BLOCK_HEADER_SIZE];
+            _blockCount = 0;
+            while (end + BLOCK_HEADER_SIZE <= size && 0 == std::fseek(existing, static_cast<long>(end), SEEK_SET) &&
+                   sizeof blockHeader == std::fread(blockHeader, 1, sizeof blockHeader, existing))
+            {
+                std::size_t length = getBlockLength(blockHeader);
+                if (length > BLOCK_SIZE || end + length > size)
+                {
+                    break;
+                }
+                end += length;
+                _blockCount++;
+            }
+            std::fclose(existing);
+
+            std::filesystem::resize_file(path, end, error);
+            if (error)
+            {
+                return false;
+            }
+
+            _file = std::fopen(path.c_str(), "ab");
+            if (nullptr == _file)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            _file = std::fopen(path.c_str(), "wb");
+            if (nullptr == _file)
+            {
+                return false;
+            }
+
+            unsigned char header[HEADER_SIZE];
+            std::copy(MAGIC, MAGIC + sizeof MAGIC, header);
+            putU32(header + 8, VERSION);
+            putU32(header + 12, BLOCK_SIZE);
+            std::fwrite(header, 1, sizeof header, _file);
+            _blockCount = 0;
+        }
+
+        _readCount = 0;
+        return true;
+    }
+
+
+    void CReadTimeline::close()
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        flush();
+        std::fclose(_file);
+        _file = nullptr;
+    }
+
+
+    void CReadTimeline::append(const CTagInfo &tagInfo)
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        auto entry = _open.find(tagInfo.data);
+        if (_open.end() == entry)
+        {
+            if (_open.size() >= MAX_OPEN_BLOCKS)
+            {
+                evictOldest();
+            }
+            entry = _open.emplace(tagInfo.data, COpenBlock()).first;
+            startBlock(entry->second, tagInfo.data, tagInfo.getTimeStampUSec());
+        }
+
+        COpenBlock &block = entry->second;
+        unsigned char encoded[MAX_READ_BYTES];
+        std::size_t length = encodeRead(encoded, tagInfo, block.previousUSec, ANTENNA_BITS);
+        if (block.used + length > BLOCK_SIZE)
+        {
+            writeBlock(block);
+            startBlock(block, tagInfo.data, tagInfo.getTimeStampUSec());
+            length = encodeRead(encoded, tagInfo, block.previousUSec, ANTENNA_BITS);
+        }
+
+        std::memcpy(block.data.data() + block.used, encoded, length);
+        block.used += length;
+        block.reads++;
+        block.minUSec = std::min(block.minUSec, tagInfo.getTimeStampUSec());
+        block.maxUSec = std::max(block.maxUSec, tagInfo.getTimeStampUSec());
+        block.previousUSec = tagInfo.getTimeStampUSec();
+        block.lastAppend = ++_readCount;
+    }
+
+
+    void CReadTimeline::flush()
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        for (auto &entry : _open)
+        {
+            writeBlock(entry.second);
+        }
+        _open.clear();
+        std::fflush(_file);
+    }
+
+
+    std::size_t CReadTimeline::getBlockLength(const unsigned char *blockHeader)
+    {
+        return BLOCK_HEADER_SIZE + blockHeader[30] + getU16(blockHeader + 28);
+    }
+
+
+    void CReadTimeline::startBlock(COpenBlock &block, const std::vector<unsigned char> &epc, u_int64_t timeStampUSec)
+    {
+        block.epcLength = std::min(epc.size(), MAX_EPC_BYTES);
+        block.data.assign(BLOCK_SIZE, 0);
+        std::copy(epc.begin(), epc.begin() + block.epcLength, block.data.begin() + BLOCK_HEADER_SIZE);
+        block.used = BLOCK_HEADER_SIZE + block.epcLength;
+        block.reads = 0;
+        block.baseUSec = timeStampUSec;
+        block.minUSec = timeStampUSec;
+        block.maxUSec = timeStampUSec;
+        block.previousUSec = timeStampUSec;
+    }
+
+
+    void CReadTimeline::writeBlock(COpenBlock &block)
+    {
+        if (0 == block.reads)
+        {
+            return;
+        }
+
+        unsigned char *header = block.data.data();
+        putU64(header, block.baseUSec);
+        putU64(header + 8, block.minUSec);
+        putU64(header + 16, block.maxUSec);
+        putU32(header + 24, block.reads);
+        putU16(header + 28, static_cast<std::uint16_t>(block.used - BLOCK_HEADER_SIZE - block.epcLength));
+        header[30] = static_cast<unsigned char>(block.epcLength);
+        header[31] = 0;
+
+        std::fwrite(header, 1, block.used, _file);
+        _blockCount++;
+        block.reads = 0;
+    }
+
+
+    void CReadTimeline::evictOldest()
+    {
+        auto oldest = std::min_element(_open.begin(), _open.end(), [](const auto &a, const auto &b)
+        { return a.second.lastAppend < b.second.lastAppend; });
+
+        writeBlock(oldest->second);
+        _open.erase(oldest);
+    }
+}
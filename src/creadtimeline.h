@@ -0,0 +1,131 @@
+//********************************************************************
+//    created:    2026-10-19 04:10 AM
+//    file:       creadtimeline.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREADTIMELINE_H
+#define LLRPLAPS_CREADTIMELINE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QObject>
+
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    /*
+     * Every raw read of every chip, for pass estimation and analysis
+     * after the race, at a few bytes a read. All integers are little
+     * endian.
+     *
+     *  header   "LAPSTML\0", u32 version, u32 largest block size
+     *  block    up to BLOCK_SIZE bytes of one chip's reads:
+     *           u64 base us, u64 min us, u64 max us, u32 read count,
+     *           u16 payload bytes, u8 EPC length, u8 reserved, EPC
+     *           bytes, payload
+     *  read     varint (zigzag(us - previous us) << 3 | antenna code),
+     *           varint antenna if the code is 0, s8 peak RSSI
+     *
+     * The first read of a block is relative to the base, which is its
+     * own time. Antennas 1 to 7 fit in the code. The min and max of a
+     * block header are what CReadTimelineReader indexes by, so a time
+     * range decodes only the blocks overlapping it.
+     *
+     * Blocks are filled up to a fixed BLOCK_SIZE but stored at their
+     * used length, header plus EPC plus payload, the next following
+     * straight on; an index entry is found by walking the headers
+     * once. A full block is within a read of BLOCK_SIZE, one written
+     * by flush() or an eviction can be a few dozen bytes. Version 1
+     * zero filled every block to BLOCK_SIZE, which made each flush
+     * cost 4 KiB a chip; CReadTimelineReader still reads it, open()
+     * does not append to it.
+     *
+     * Each chip has a block open in memory, written out when full or
+     * on flush(). A crash loses the open blocks; the tag journal has
+     * those reads.
+     */
+    class CReadTimeline : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CReadTimeline(QObject *parent = nullptr);
+
+        ~CReadTimeline() override;
+
+        // Appends to an existing timeline, cut back to its last whole block
+        bool open(const std::string &path);
+
+        void close();
+
+        bool isOpen() const { return nullptr != _file; }
+
+        void append(const CTagInfo &tagInfo);
+
+        // Writes every open block out, partly filled ones too
+        void flush();
+
+        std::uint64_t getReadCount() const { return _readCount; }
+
+        std::uint64_t getBlockCount() const { return _blockCount; }
+
+        // Header, EPC and payload of the block whose BLOCK_HEADER_SIZE header is at blockHeader
+        static std::size_t getBlockLength(const unsigned char *blockHeader);
+
+        static const char MAGIC[8];
+        static const std::uint32_t VERSION;
+        static const unsigned int HEADER_SIZE;
+        static const unsigned int BLOCK_SIZE;
+        static const unsigned int BLOCK_HEADER_SIZE;
+        static const unsigned int ANTENNA_BITS;
+        static const std::size_t MAX_OPEN_BLOCKS;
+
+    public slots:
+
+        void onNewTag(const LLRPLaps::CTagInfo &tagInfo) { append(tagInfo); }
+
+    private:
+        struct COpenBlock
+        {
+            std::vector<unsigned char> data;    // BLOCK_SIZE, the header filled in and used bytes written
+            std::size_t used;
+            std::size_t epcLength;
+            std::uint32_t reads;
+            u_int64_t baseUSec;
+            u_int64_t minUSec;
+            u_int64_t maxUSec;
+            u_int64_t previousUSec;
+            std::uint64_t lastAppend;           // _readCount then, the oldest goes first past MAX_OPEN_BLOCKS
+        };
+
+        void startBlock(COpenBlock &block, const std::vector<unsigned char> &epc, u_int64_t timeStampUSec);
+
+        void writeBlock(COpenBlock &block);
+
+        void evictOldest();
+
+        std::FILE *_file;
+        std::map<std::vector<unsigned char>, COpenBlock> _open;
+        std::uint64_t _readCount;
+        std::uint64_t _blockCount;
+    };
+}
+#endif //LLRPLAPS_CREADTIMELINE_H
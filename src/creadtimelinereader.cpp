@@ -0,0 +1,299 @@
+//********************************************************************
+//    created:    2026-10-19 04:10 AM
+//    file:       creadtimelinereader.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "creadtimelinereader.h"
+#include "creadtimeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        // Every block zero filled to BLOCK_SIZE
+        const std::uint32_t VERSION_PADDED = 1;
+
+        std::uint16_t getU16(const unsigned char *p)
+        {
+            return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::uint64_t getU64(const unsigned char *p)
+        {
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        bool getVarint(const unsigned char *&p, const unsigned char *end, std::uint64_t &value)
+        {
+            value = 0;
+            for (unsigned int shift = 0; p < end && shift < 64; shift += 7)
+            {
+                unsigned char byte = *p++;
+                value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if (0 == (byte & 0x80))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    CReadTimelineReader::CReadTimelineReader() : _data(nullptr), _size(0), _blockCount(0)
+    {
+    }
+
+
+    CReadTimelineReader::~CReadTimelineReader()
+    {
+        close();
+    }
+
+
+    void CReadTimelineReader::close()
+    {
+        if (nullptr != _data)
+        {
+            _file.unmap(const_cast<uchar *>(_data));
+        }
+        _file.close();
+        _data = nullptr;
+        _size = 0;
+        _blockCount = 0;
+        _index.clear();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Map a timeline and index its blocks
+ **
+ ** A block cut short by a crash of the writer is left out. Version 1
+ ** files, every block padded to BLOCK_SIZE, are read as well.
+ **
+ *****************************************************************************/
+
+    bool CReadTimelineReader::open(const QString &path)
+    {
+        close();
+
+        _file.setFileName(path);
+        if (!_file.open(QIODevice::ReadOnly))
+        {
+            _errorString = _file.errorString();
+            return false;
+        }
+
+        _size = static_cast<std::uint64_t>(_file.size());
+        if (_size < CReadTimeline::HEADER_SIZE)
+        {
+            _errorString = "Not a read timeline: too short";
+            close();
+            return false;
+        }
+
+        _data = _file.map(0, _file.size());
+        if (nullptr == _data)
+        {
+            _errorString = _file.errorString();
+            close();
+            return false;
+        }
+
+        if (0 != std::memcmp(_data, CReadTimeline::MAGIC, sizeof CReadTimeline::MAGIC) ||
+            (CReadTimeline::VERSION != getU32(_data + 8) && VERSION_PADDED != getU32(_data + 8)) ||
+            CReadTimeline::BLOCK_SIZE != getU32(_data + 12))
+        {
+            _errorString = "Not a read timeline: bad header";
+            close();
+            return false;
+        }
+
+        bool padded = (VERSION_PADDED == getU32(_data + 8));
+        std::uint64_t offset = CReadTimeline::HEADER_SIZE;
+        while (offset + CReadTimeline::BLOCK_HEADER_SIZE <= _size)
+        {
+            const unsigned char *block = _data + offset;
+            std::size_t length = padded ? CReadTimeline::BLOCK_SIZE : CReadTimeline::getBlockLength(block);
+            if (length > CReadTimeline::BLOCK_SIZE || offset + length > _size)
+            {
+                break;
+            }
+            std::vector<unsigned char> epc(block + CReadTimeline::BLOCK_HEADER_SIZE,
+                                           block + CReadTimeline::BLOCK_HEADER_SIZE + block[30]);
+            _index[epc].push_back({ getU64(block + 8), getU64(block + 16), offset, getU32(block + 24) });
+            offset += length;
+            _blockCount++;
+        }
+
+        for (auto &blocks : _index)
+        {
+            std::stable_sort(blocks.second.begin(), blocks.second.end(), [](const CBlockIndex &a, const CBlockIndex &b)
+            { return a.minUSec < b.minUSec; });
+        }
+        return true;
+    }
+
+
+    std::vector<std::vector<unsigned char>> CReadTimelineReader::getEpcs() const
+    {
+        std::vector<std::vector<unsigned char>> epcs;
+        for (const auto &blocks : _index)
+        {
+            epcs.push_back(blocks.first);
+        }
+        return epcs;
+    }
+
+
+    std::uint64_t CReadTimelineReader::getReadCount(const std::vector<unsigned char> &epc) const
+    {
+        auto blocks = _index.find(epc);
+        std::uint64_t reads = 0;
+        if (_index.end() != blocks)
+        {
+            for (const CBlockIndex &block : blocks->second)
+            {
+                reads += block.reads;
+            }
+        }
+        return reads;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  The reads of one chip in a time range
+ **
+ ** Blocks are in order of their first read, so the walk stops at the
+ ** first starting at or after toUSec. Only blocks reaching into the
+ ** range are decoded.
+ **
+ *****************************************************************************/
+
+    bool CReadTimelineReader::read(const std::vector<unsigned char> &epc, u_int64_t fromUSec, u_int64_t toUSec,
+                                   std::vector<CTimelineRead> &reads)
+    {
+        reads.clear();
+
+        auto blocks = _index.find(epc);
+        if (_index.end() == blocks)
+        {
+            return true;
+        }
+
+        for (const CBlockIndex &block : blocks->second)
+        {
+            if (block.minUSec >= toUSec)
+            {
+                break;
+            }
+            if (block.maxUSec < fromUSec)
+            {
+                continue;
+            }
+
+            _decoded.clear();
+            if (!decodeBlock(_data + block.offset, _decoded))
+            {
+                _errorString = QString("Corrupt block at offset %1").arg(block.offset);
+                return false;
+            }
+            for (const CTimelineRead &decoded : _decoded)
+            {
+                if (decoded.timeStampUSec >= fromUSec && decoded.timeStampUSec < toUSec)
+                {
+                    reads.push_back(decoded);
+                }
+            }
+        }
+
+        /* Overlapping blocks of reads that came out of order */
+        if (!std::is_sorted(reads.begin(), reads.end(), [](const CTimelineRead &a, const CTimelineRead &b)
+        { return a.timeStampUSec < b.timeStampUSec; }))
+        {
+            std::stable_sort(reads.begin(), reads.end(), [](const CTimelineRead &a, const CTimelineRead &b)
+            { return a.timeStampUSec < b.timeStampUSec; });
+        }
+        return true;
+    }
+
+
+    bool CReadTimelineReader::decodeBlock(const unsigned char *block, std::vector<CTimelineRead> &reads)
+    {
+        std::uint32_t count = getU32(block + 24);
+        const unsigned char *p = block + CReadTimeline::BLOCK_HEADER_SIZE + block[30];
+        const unsigned char *end = p + getU16(block + 28);
+        if (end > block + CReadTimeline::BLOCK_SIZE)
+        {
+            return false;
+        }
+
+        unsigned int antennaMask = (1u << CReadTimeline::ANTENNA_BITS) - 1u;
+        u_int64_t timeStampUSec = getU64(block);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            std::uint64_t value;
+            if (!getVarint(p, end, value))
+            {
+                return false;
+            }
+
+            CTimelineRead read;
+            std::uint64_t zigzag = value >> CReadTimeline::ANTENNA_BITS;
+            timeStampUSec += static_cast<u_int64_t>(static_cast<std::int64_t>(zigzag >> 1) ^
+                                                    -static_cast<std::int64_t>(zigzag & 1));
+            read.timeStampUSec = timeStampUSec;
+            read.antennaId = static_cast<int>(value & antennaMask);
+            if (0 == read.antennaId)
+            {
+                std::uint64_t antennaId;
+                if (!getVarint(p, end, antennaId))
+                {
+                    return false;
+                }
+                read.antennaId = static_cast<int>(antennaId);
+            }
+            if (p >= end)
+            {
+                return false;
+            }
+            read.peakRSSI = static_cast<std::int8_t>(*p++);
+            reads.push_back(read);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,92 @@
+//********************************************************************
+//    created:    2026-10-19 04:10 AM
+//    file:       creadtimelinereader.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREADTIMELINEREADER_H
+#define LLRPLAPS_CREADTIMELINEREADER_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+namespace LLRPLaps
+{
+    // One read of a chip as a CReadTimeline keeps it
+    struct CTimelineRead
+    {
+        u_int64_t timeStampUSec;
+        int antennaId;
+        std::int8_t peakRSSI;
+    };
+
+
+    /*
+     * Memory mapped view of a CReadTimeline file. Opening reads only
+     * the block headers, into a per chip index of block time ranges;
+     * a query decodes just the blocks overlapping it.
+     */
+    class CReadTimelineReader
+    {
+    public:
+        CReadTimelineReader();
+
+        ~CReadTimelineReader();
+
+        bool open(const QString &path);
+
+        void close();
+
+        const QString &getErrorString() const { return _errorString; }
+
+        std::vector<std::vector<unsigned char>> getEpcs() const;
+
+        std::uint64_t getReadCount(const std::vector<unsigned char> &epc) const;
+
+        std::uint64_t getBlockCount() const { return _blockCount; }
+
+        std::uint64_t getSize() const { return _size; }
+
+        // The reads of epc from fromUSec up to, not including, toUSec in time order. false on a corrupt block
+        bool read(const std::vector<unsigned char> &epc, u_int64_t fromUSec, u_int64_t toUSec,
+                  std::vector<CTimelineRead> &reads);
+
+        // Appends every read of the block at block, false if it does not decode
+        static bool decodeBlock(const unsigned char *block, std::vector<CTimelineRead> &reads);
+
+    private:
+        struct CBlockIndex
+        {
+            u_int64_t minUSec;
+            u_int64_t maxUSec;
+            std::uint64_t offset;
+            std::uint32_t reads;
+        };
+
+        QFile _file;
+        const unsigned char *_data;
+        std::uint64_t _size;
+        std::uint64_t _blockCount;
+        std::map<std::vector<unsigned char>, std::vector<CBlockIndex>> _index;  // by min time
+        std::vector<CTimelineRead> _decoded;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CREADTIMELINEREADER_H
@@ -0,0 +1,577 @@
+//********************************************************************
+//    created:    2026-10-19 01:10 AM
+//    file:       creplication.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "creplication.h"
+#include "ccheckpointer.h"
+#include "clapcounter.h"
+#include "ctaginfo.h"
+#include "ctagjournal.h"
+#include "ctagjournalreader.h"
+
+namespace LLRPLaps
+{
+    const quint16 CReplicationPrimary::DEFAULT_PORT = 5085;
+    const int CReplicationPrimary::POLL_MS = 20;
+    const int CReplicationPrimary::HEARTBEAT_MS = 250;
+    const qint64 CReplicationPrimary::MAX_BATCH_BYTES = 1024 * 1024;
+    const qint64 CReplicationPrimary::MAX_BUFFERED_BYTES = 8 * 1024 * 1024;
+
+    const int CReplicationStandby::FAILOVER_TIMEOUT_MS = 1000;
+    const int CReplicationStandby::RECONNECT_DELAY_MS = 500;
+
+    namespace
+    {
+        enum MessageType
+        {
+            Snapshot = 1,
+            Journal = 2,
+            Checkpoint = 3,
+            Heartbeat = 4
+        };
+
+        const std::size_t MESSAGE_HEADER_SIZE = 8;
+
+        /* Where CCheckpointer keeps the journal offset in a snapshot */
+        const std::size_t SNAPSHOT_OFFSET_AT = 24;
+
+        void putU32(unsigned char *p, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void putU64(unsigned char *p, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::uint64_t getU64(const unsigned char *p)
+        {
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        const unsigned char *bytes(const QByteArray &array)
+        {
+            return reinterpret_cast<const unsigned char *>(array.constData());
+        }
+    }
+
+    CReplicationPrimary::CReplicationPrimary(const QString &journalPath, const QString &snapshotPath, QObject *parent)
+            : QObject(parent), _journalPath(journalPath), _snapshotPath(snapshotPath), _server(this),
+              _pollTimer(this), _snapshotOffset(0), _snapshotGeneration(0), _snapshotModifiedMSecs(0), _journalSize(0),
+              _bytesSent(0)
+    {
+        connect(&_server, &QTcpServer::newConnection, this, &CReplicationPrimary::onNewConnection);
+        connect(&_pollTimer, &QTimer::timeout, this, &CReplicationPrimary::onPoll);
+    }
+
+
+    CReplicationPrimary::~CReplicationPrimary()
+    {
+        for (CStandby &standby : _standbys)
+        {
+            standby.socket->abort();
+        }
+    }
+
+
+    bool CReplicationPrimary::listen(quint16 port, const QHostAddress &address)
+    {
+        if (!_server.listen(address, port))
+        {
+            _errorString = _server.errorString();
+            return false;
+        }
+
+        _sinceHeartbeat.start();
+        _pollTimer.start(POLL_MS);
+        return true;
+    }
+
+
+    void CReplicationPrimary::onNewConnection()
+    {
+        while (QTcpSocket *socket = _server.nextPendingConnection())
+        {
+            socket->setParent(this);
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            connect(socket, &QTcpSocket::disconnected, this, &CReplicationPrimary::onDisconnected);
+
+            loadSnapshot();
+            _standbys.push_back(CStandby{socket, 0, 0});
+            sendSnapshot(_standbys.back(), Snapshot);
+        }
+    }
+
+
+    void CReplicationPrimary::onDisconnected()
+    {
+        auto socket = qobject_cast<QTcpSocket *>(sender());
+        _standbys.erase(std::remove_if(_standbys.begin(), _standbys.end(), [socket](const CStandby &standby)
+        { return standby.socket == socket; }), _standbys.end());
+        socket->deleteLater();
+    }
+
+
+    void CReplicationPrimary::loadSnapshot(bool reload)
+    {
+        if (reload)
+        {
+            _snapshot.clear();
+            _snapshotOffset = 0;
+            _snapshotModifiedMSecs = 0;
+        }
+
+        QFileInfo info(_snapshotPath);
+        if (!info.exists() || info.lastModified().toMSecsSinceEpoch() == _snapshotModifiedMSecs)
+        {
+            return;
+        }
+
+        /* CCheckpointer replaces the file in one rename, what is read is one whole snapshot */
+        QFile file(_snapshotPath);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            return;
+        }
+
+        QByteArray snapshot = file.readAll();
+        if (static_cast<std::size_t>(snapshot.size()) < CCheckpointer::HEADER_SIZE)
+        {
+            return;
+        }
+
+        _snapshot = snapshot;
+        _snapshotOffset = getU64(bytes(_snapshot) + SNAPSHOT_OFFSET_AT);
+        _snapshotModifiedMSecs = info.lastModified().toMSecsSinceEpoch();
+        _snapshotGeneration++;
+    }
+
+
+    void CReplicationPrimary::sendSnapshot(CStandby &standby, quint32 type)
+    {
+        standby.snapshotGeneration = _snapshotGeneration;
+
+        if (Checkpoint == type)
+        {
+            send(standby, Checkpoint, _snapshot);
+            return;
+        }
+
+        /* With no snapshot of this journal the standby gets the journal from its very start, header and all */
+        std::uint64_t journalSize = static_cast<std::uint64_t>(QFileInfo(_journalPath).size());
+        if (_snapshot.isEmpty() || _snapshotOffset > journalSize)
+        {
+            send(standby, Snapshot, QByteArray());
+            standby.sentOffset = 0;
+        }
+        else
+        {
+            send(standby, Snapshot, _snapshot);
+            standby.sentOffset = _snapshotOffset;
+        }
+    }
+
+
+    void CReplicationPrimary::send(CStandby &standby, quint32 type, const QByteArray &payload)
+    {
+        unsigned char header[MESSAGE_HEADER_SIZE];
+        putU32(header, type);
+        putU32(header + 4, static_cast<std::uint32_t>(payload.size()));
+
+        standby.socket->write(reinterpret_cast<const char *>(header), sizeof header);
+        standby.socket->write(payload);
+        _bytesSent += sizeof header + payload.size();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Send each standby what the journal has gained since
+ **
+ ** A standby whose socket has more than MAX_BUFFERED_BYTES waiting
+ ** is skipped, it catches up from where it was once the socket
+ ** drains. A journal shorter than the last poll found has been cut
+ ** back or started over: the snapshot is read again, the one cached
+ ** may point into the journal that was, and every standby starts
+ ** over from it.
+ **
+ *****************************************************************************/
+
+    void CReplicationPrimary::onPoll()
+    {
+        std::uint64_t journalSize = static_cast<std::uint64_t>(QFileInfo(_journalPath).size());
+        bool restarted = journalSize < _journalSize;
+        _journalSize = journalSize;
+
+        if (_standbys.empty())
+        {
+            return;
+        }
+
+        loadSnapshot(restarted);
+
+        if (restarted || !_journal.isOpen())
+        {
+            _journal.close();
+            _journal.setFileName(_journalPath);
+            _journal.open(QIODevice::ReadOnly);
+        }
+
+        bool heartbeat = _sinceHeartbeat.elapsed() >= HEARTBEAT_MS;
+        if (heartbeat)
+        {
+            _sinceHeartbeat.restart();
+        }
+
+        for (CStandby &standby : _standbys)
+        {
+            if (restarted || journalSize < standby.sentOffset)
+            {
+                sendSnapshot(standby, Snapshot);
+                continue;
+            }
+
+            while (_journal.isOpen() && standby.sentOffset < journalSize &&
+                   standby.socket->bytesToWrite() < MAX_BUFFERED_BYTES)
+            {
+                qint64 length = std::min<qint64>(MAX_BATCH_BYTES, journalSize - standby.sentOffset);
+                QByteArray payload(8, '\0');
+                putU64(reinterpret_cast<unsigned char *>(payload.data()), standby.sentOffset);
+
+                _journal.seek(static_cast<qint64>(standby.sentOffset));
+                QByteArray data = _journal.read(length);
+                if (data.isEmpty())
+                {
+                    break;
+                }
+                payload.append(data);
+
+                send(standby, Journal, payload);
+                standby.sentOffset += static_cast<std::uint64_t>(data.size());
+            }
+
+            /* A newer snapshot only once the standby has the journal it points into */
+            if (standby.snapshotGeneration != _snapshotGeneration && standby.sentOffset >= _snapshotOffset)
+            {
+                sendSnapshot(standby, Checkpoint);
+            }
+
+            if (heartbeat)
+            {
+                QByteArray payload(8, '\0');
+                putU64(reinterpret_cast<unsigned char *>(payload.data()), journalSize);
+                send(standby, Heartbeat, payload);
+            }
+        }
+    }
+
+
+    CReplicationStandby::CReplicationStandby(CLapCounter &lapCounter, const QString &journalPath,
+                                             const QString &snapshotPath, QObject *parent)
+            : QObject(parent), _lapCounter(lapCounter), _journalPath(journalPath), _snapshotPath(snapshotPath),
+              _port(0), _socket(this), _watchdog(this), _mirrorOffset(0), _appliedOffset(0), _records(0),
+              _appliedCount(0), _synced(false), _lost(false), _tookOver(false)
+    {
+        connect(&_socket, &QTcpSocket::readyRead, this, &CReplicationStandby::onReadyRead);
+        connect(&_socket, &QTcpSocket::disconnected, this, &CReplicationStandby::onDisconnected);
+        connect(&_socket, static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error),
+                this, &CReplicationStandby::onDisconnected);
+        connect(&_watchdog, &QTimer::timeout, this, &CReplicationStandby::onWatchdog);
+    }
+
+
+    CReplicationStandby::~CReplicationStandby()
+    {
+        _socket.abort();
+    }
+
+
+    void CReplicationStandby::connectToPrimary(const QString &host, quint16 port)
+    {
+        _host = host;
+        _port = port;
+        _lastHeard.start();
+        _watchdog.start(FAILOVER_TIMEOUT_MS / 4);
+        reconnect();
+    }
+
+
+    void CReplicationStandby::reconnect()
+    {
+        if (_tookOver || QAbstractSocket::UnconnectedState != _socket.state())
+        {
+            return;
+        }
+
+        _received.clear();
+        _socket.connectToHost(_host, _port);
+    }
+
+
+    void CReplicationStandby::onDisconnected()
+    {
+        if (_tookOver)
+        {
+            return;
+        }
+
+        _socket.abort();
+        QTimer::singleShot(RECONNECT_DELAY_MS, this, &CReplicationStandby::reconnect);
+    }
+
+
+    void CReplicationStandby::onWatchdog()
+    {
+        /* A standby that never had the primary's state has nothing to take over with */
+        if (_synced && !_lost && _lastHeard.elapsed() > FAILOVER_TIMEOUT_MS)
+        {
+            _lost = true;
+            emit primaryLost();
+        }
+    }
+
+
+    void CReplicationStandby::onReadyRead()
+    {
+        _received.append(_socket.readAll());
+        _lastHeard.restart();
+        _lost = false;
+
+        std::size_t consumed = 0;
+        std::size_t available = static_cast<std::size_t>(_received.size());
+        const unsigned char *data = bytes(_received);
+
+        while (available - consumed >= MESSAGE_HEADER_SIZE)
+        {
+            quint32 type = getU32(data + consumed);
+            std::size_t length = getU32(data + consumed + 4);
+            if (available - consumed < MESSAGE_HEADER_SIZE + length)
+            {
+                break;
+            }
+
+            if (!handleMessage(type, data + consumed + MESSAGE_HEADER_SIZE, length))
+            {
+                /* Out of step with the primary, a new connection starts with a snapshot */
+                _socket.abort();
+                _received.clear();
+                QTimer::singleShot(RECONNECT_DELAY_MS, this, &CReplicationStandby::reconnect);
+                return;
+            }
+            consumed += MESSAGE_HEADER_SIZE + length;
+        }
+
+        _received.remove(0, static_cast<int>(consumed));
+        _mirror.flush();
+    }
+
+
+    bool CReplicationStandby::handleMessage(quint32 type, const unsigned char *payload, std::size_t size)
+    {
+        switch (type)
+        {
+            case Snapshot:
+                return resync(payload, size);
+
+            case Journal:
+                return (size >= 8) && applyJournal(getU64(payload), payload + 8, size - 8);
+
+            case Checkpoint:
+                /* Kept only once the mirrored journal reaches it, a restart could not replay it otherwise */
+                if (_synced && size >= CCheckpointer::HEADER_SIZE && getU64(payload + SNAPSHOT_OFFSET_AT) <= _mirrorOffset)
+                {
+                    _mirror.flush();
+                    saveSnapshot(payload, size);
+                }
+                return true;
+
+            case Heartbeat:
+            default:
+                return true;
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start over from a snapshot of the primary
+ **
+ ** The mirrored journal is cut back to where the snapshot was taken.
+ ** The bytes before that are not sent, the file is left sparse up to
+ ** there with a journal header in front so CCheckpointer::restore()
+ ** takes it.
+ **
+ *****************************************************************************/
+
+    bool CReplicationStandby::resync(const unsigned char *snapshot, std::size_t size)
+    {
+        std::uint64_t journalRecords = 0;
+        std::uint64_t journalOffset = 0;
+
+        /* Until the snapshot and the mirror are both in place neither is the primary's */
+        _synced = false;
+        if (0 == size)
+        {
+            /* Nothing of the primary's journal came before, a snapshot left from an earlier one must not be restored */
+            _lapCounter.clear();
+            QFile::remove(_snapshotPath);
+        }
+        else if (!CCheckpointer::loadSnapshot(snapshot, size, _lapCounter, journalRecords, journalOffset))
+        {
+            _errorString = "Damaged snapshot from the primary";
+            return false;
+        }
+
+        _mirror.close();
+        _mirror.setFileName(_journalPath);
+        if (!_mirror.open(QIODevice::ReadWrite) || !_mirror.resize(0) ||
+            !_mirror.resize(static_cast<qint64>(journalOffset)))
+        {
+            _errorString = "Journal mirror cannot be written: " + _mirror.errorString();
+            return false;
+        }
+
+        if (0 != journalOffset)
+        {
+            std::vector<unsigned char> header(CTagJournal::HEADER_SIZE, 0);
+            std::copy(CTagJournal::MAGIC, CTagJournal::MAGIC + sizeof CTagJournal::MAGIC, header.begin());
+            putU32(header.data() + 8, CTagJournal::VERSION);
+            _mirror.seek(0);
+            _mirror.write(reinterpret_cast<const char *>(header.data()), static_cast<qint64>(header.size()));
+            saveSnapshot(snapshot, size);
+        }
+
+        _mirrorOffset = journalOffset;
+        _appliedOffset = std::max<std::uint64_t>(journalOffset, CTagJournal::HEADER_SIZE);
+        _records = journalRecords;
+        _tail.clear();
+        _synced = true;
+        emit synced();
+        return true;
+    }
+
+
+    bool CReplicationStandby::applyJournal(std::uint64_t offset, const unsigned char *data, std::size_t size)
+    {
+        if (!_synced || offset != _mirrorOffset)
+        {
+            _errorString = "Journal out of step with the primary";
+            return false;
+        }
+
+        _mirror.seek(static_cast<qint64>(offset));
+        if (static_cast<qint64>(size) != _mirror.write(reinterpret_cast<const char *>(data), static_cast<qint64>(size)))
+        {
+            _errorString = "Journal mirror cannot be written: " + _mirror.errorString();
+            return false;
+        }
+        _mirrorOffset += size;
+        _tail.insert(_tail.end(), data, data + size);
+
+        /* _tail holds the mirrored bytes from tailStart on, the journal header included at first */
+        std::uint64_t tailStart = _mirrorOffset - _tail.size();
+        std::uint64_t at = std::max(_appliedOffset, tailStart) - tailStart;
+        if (at > _tail.size())
+        {
+            return true;
+        }
+
+        CTagInfo tagInfo;
+        while (CTagJournalReader::parseRecord(_tail.data(), _tail.size(), at, tagInfo))
+        {
+            _lapCounter.onNewTag(tagInfo);
+            _records++;
+            _appliedCount++;
+        }
+
+        _appliedOffset = tailStart + at;
+        _tail.erase(_tail.begin(), _tail.begin() + static_cast<std::ptrdiff_t>(at));
+        return true;
+    }
+
+
+    void CReplicationStandby::saveSnapshot(const unsigned char *snapshot, std::size_t size)
+    {
+        QSaveFile file(_snapshotPath);
+        if (file.open(QIODevice::WriteOnly))
+        {
+            file.write(reinterpret_cast<const char *>(snapshot), static_cast<qint64>(size));
+            file.commit();
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Become the primary
+ **
+ ** The journal carries on from the last record applied, a record the
+ ** primary only sent part of is cut off. From here on the counter
+ ** journals its own reads, the application starts a CCheckpointer
+ ** and connects to the readers.
+ **
+ *****************************************************************************/
+
+    bool CReplicationStandby::takeOver(CTagJournal &journal)
+    {
+        _tookOver = true;
+        _watchdog.stop();
+        _socket.abort();
+        _mirror.close();
+
+        bool opened = _synced ? journal.open(_journalPath.toStdString(), _records, _appliedOffset)
+                              : journal.open(_journalPath.toStdString());
+        if (!opened)
+        {
+            _errorString = "Journal cannot be written: " + _journalPath;
+            return false;
+        }
+
+        _lapCounter.setJournal(&journal);
+        return true;
+    }
+}
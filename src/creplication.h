@@ -0,0 +1,201 @@
+//********************************************************************
+//    created:    2026-10-19 01:10 AM
+//    file:       creplication.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREPLICATION_H
+#define LLRPLAPS_CREPLICATION_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace LLRPLaps
+{
+    class CLapCounter;
+    class CTagJournal;
+
+    /*
+     * Ships a CTagJournal and the CCheckpointer snapshots of it to
+     * standby instances. Every message is u32 type, u32 length and
+     * the payload, little endian:
+     *
+     *   Snapshot    start over from this snapshot, empty for none
+     *   Journal     u64 journal offset, journal bytes from there
+     *   Checkpoint  a newer snapshot, to keep on disk
+     *   Heartbeat   u64 journal size
+     *
+     * The primary tails the files the timing path writes anyway, on
+     * its own event loop, so replication costs the timing path
+     * nothing. A standby is as far behind as the journal flush
+     * interval plus the poll interval.
+     */
+    class CReplicationPrimary : public QObject
+    {
+    Q_OBJECT
+    public:
+        CReplicationPrimary(const QString &journalPath, const QString &snapshotPath, QObject *parent = nullptr);
+
+        ~CReplicationPrimary() override;
+
+        bool listen(quint16 port, const QHostAddress &address = QHostAddress::Any);
+
+        const QString &getErrorString() const { return _errorString; }
+
+        // The port listened on, what listen() picked for port 0
+        quint16 getPort() const { return _server.serverPort(); }
+
+        int getStandbyCount() const { return static_cast<int>(_standbys.size()); }
+
+        quint64 getBytesSent() const { return _bytesSent; }
+
+        const static quint16 DEFAULT_PORT;
+        const static int POLL_MS;
+        const static int HEARTBEAT_MS;
+        const static qint64 MAX_BATCH_BYTES;
+        const static qint64 MAX_BUFFERED_BYTES;
+
+    private slots:
+
+        void onNewConnection();
+
+        void onDisconnected();
+
+        void onPoll();
+
+    private:
+        struct CStandby
+        {
+            QTcpSocket *socket;
+            std::uint64_t sentOffset;
+            std::uint64_t snapshotGeneration;
+        };
+
+        // reload drops the cached snapshot, taken for a journal since cut back or started over
+        void loadSnapshot(bool reload = false);
+
+        void sendSnapshot(CStandby &standby, quint32 type);
+
+        void send(CStandby &standby, quint32 type, const QByteArray &payload);
+
+        QString _journalPath;
+        QString _snapshotPath;
+        QTcpServer _server;
+        QTimer _pollTimer;
+        QElapsedTimer _sinceHeartbeat;
+        QFile _journal;
+        std::vector<CStandby> _standbys;
+        QByteArray _snapshot;
+        std::uint64_t _snapshotOffset;
+        std::uint64_t _snapshotGeneration;
+        qint64 _snapshotModifiedMSecs;
+        std::uint64_t _journalSize;                 // as of the last poll
+        quint64 _bytesSent;
+        QString _errorString;
+    };
+
+
+    /*
+     * Keeps a CLapCounter in step with a primary: loads its snapshot,
+     * applies every journal record as it comes in and mirrors both
+     * files on disk. Once synced, primaryLost() fires when the primary
+     * has been silent for FAILOVER_TIMEOUT_MS; takeOver() then carries
+     * on the mirrored journal and the application connects to the
+     * readers. A reconnect keeps what was applied, the new connection's
+     * snapshot replaces it.
+     *
+     * The counter has no journal attached until takeOver().
+     */
+    class CReplicationStandby : public QObject
+    {
+    Q_OBJECT
+    public:
+        CReplicationStandby(CLapCounter &lapCounter, const QString &journalPath, const QString &snapshotPath,
+                            QObject *parent = nullptr);
+
+        ~CReplicationStandby() override;
+
+        void connectToPrimary(const QString &host, quint16 port);
+
+        // Stop following the primary and journal into the mirrored journal from here on
+        bool takeOver(CTagJournal &journal);
+
+        bool isSynced() const { return _synced; }
+
+        std::uint64_t getAppliedCount() const { return _appliedCount; }
+
+        const QString &getErrorString() const { return _errorString; }
+
+        const static int FAILOVER_TIMEOUT_MS;
+        const static int RECONNECT_DELAY_MS;
+
+    signals:
+
+        void synced();
+
+        void primaryLost();
+
+    private slots:
+
+        void onReadyRead();
+
+        void onDisconnected();
+
+        void onWatchdog();
+
+        void reconnect();
+
+    private:
+        bool handleMessage(quint32 type, const unsigned char *payload, std::size_t size);
+
+        bool resync(const unsigned char *snapshot, std::size_t size);
+
+        bool applyJournal(std::uint64_t offset, const unsigned char *data, std::size_t size);
+
+        void saveSnapshot(const unsigned char *snapshot, std::size_t size);
+
+        CLapCounter &_lapCounter;
+        QString _journalPath;
+        QString _snapshotPath;
+        QString _host;
+        quint16 _port;
+        QTcpSocket _socket;
+        QTimer _watchdog;
+        QElapsedTimer _lastHeard;
+        QFile _mirror;
+        QByteArray _received;
+        std::vector<unsigned char> _tail;           // mirrored bytes not yet applied, a record cut in two
+        std::uint64_t _mirrorOffset;
+        std::uint64_t _appliedOffset;
+        std::uint64_t _records;
+        std::uint64_t _appliedCount;
+        bool _synced;
+        bool _lost;
+        bool _tookOver;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CREPLICATION_H
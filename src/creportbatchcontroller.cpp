@@ -0,0 +1,169 @@
+//********************************************************************
+//    created:    2026-10-18 06:30 PM
+//    file:       creportbatchcontroller.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "creportbatchcontroller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace LLRPLaps
+{
+    const std::uint32_t CReportBatchController::DEFAULT_TARGET_LATENCY_MS = 50;
+    const std::uint32_t CReportBatchController::DEFAULT_MAX_LATENCY_MS = 400;
+    const std::uint16_t CReportBatchController::MAX_REPORT_N = 1000;
+    const std::uint32_t CReportBatchController::QUIET_DURATION_MS = 1000;
+    const std::uint32_t CReportBatchController::MIN_DURATION_MS = 200;
+    const std::uint64_t CReportBatchController::RETUNE_INTERVAL_NSEC = 2000000000ull;
+
+    namespace
+    {
+        // Share of the time spent processing reports that calls for bigger or smaller batches
+        const double LOAD_HIGH = 0.5;
+        const double LOAD_LOW = 0.1;
+
+        // Weight of the latest window in the averages
+        const double SMOOTHING = 0.5;
+
+        // Smaller N changes are not worth a ROSpec reinstall
+        const double N_HYSTERESIS = 0.25;
+
+        // A batch that does not fill is sent at the end of the AISpec
+        const std::uint32_t DURATION_PER_INTERVAL = 4;
+    }
+
+    CReportBatchController::CReportBatchController(std::uint32_t targetLatencyMS, std::uint32_t maxLatencyMS)
+            : _targetLatencyMS(std::max<std::uint32_t>(targetLatencyMS, 1)),
+              _maxLatencyMS(std::max(maxLatencyMS, _targetLatencyMS)), _intervalMS(_targetLatencyMS),
+              _lastRetuneNSec(0), _tagsSinceRetune(0), _busyNSecSinceRetune(0), _tagRateHz(0.0), _consumerLoad(0.0)
+    {
+        _settings.reportN = 1;
+        _settings.aiDurationMS = QUIET_DURATION_MS;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Account for one processed report
+ **
+ ** receivedNSec is when the frame came off the socket and
+ ** processedNSec when every tag in it was handed on, both from
+ ** CLatencyRecorder::nowNSec().
+ **
+ *****************************************************************************/
+
+    void CReportBatchController::onReport(std::size_t tagCount, std::uint64_t receivedNSec, std::uint64_t processedNSec)
+    {
+        _tagsSinceRetune += tagCount;
+        if (processedNSec > receivedNSec)
+        {
+            _busyNSecSinceRetune += processedNSec - receivedNSec;
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Fold in the reports since the last call and decide
+ **         whether the ROSpec should change
+ **
+ ** Call between inventory cycles. Does nothing until
+ ** RETUNE_INTERVAL_NSEC has passed since the last call that did.
+ **
+ ** @return     true if settings was updated and the ROSpec needs
+ **             rebuilding
+ **
+ *****************************************************************************/
+
+    bool CReportBatchController::retune(std::uint64_t nowNSec, Settings &settings)
+    {
+        if (0 == _lastRetuneNSec)
+        {
+            _lastRetuneNSec = nowNSec;
+            return false;
+        }
+        if (nowNSec - _lastRetuneNSec < RETUNE_INTERVAL_NSEC)
+        {
+            return false;
+        }
+
+        double elapsedSec = (nowNSec - _lastRetuneNSec) / 1e9;
+        _tagRateHz += SMOOTHING * (_tagsSinceRetune / elapsedSec - _tagRateHz);
+        _consumerLoad += SMOOTHING * (_busyNSecSinceRetune / 1e9 / elapsedSec - _consumerLoad);
+        _tagsSinceRetune = 0;
+        _busyNSecSinceRetune = 0;
+        _lastRetuneNSec = nowNSec;
+
+        /*
+         * A busy consumer gets fewer, bigger reports. Back off
+         * towards the target latency once it has caught up.
+         */
+
+        if (_consumerLoad > LOAD_HIGH)
+        {
+            _intervalMS = std::min(_intervalMS * 2, _maxLatencyMS);
+        }
+        else if (_consumerLoad < LOAD_LOW)
+        {
+            _intervalMS = std::max(_intervalMS / 2, _targetLatencyMS);
+        }
+
+        Settings desired = desiredSettings();
+        bool nChanged = (1 == desired.reportN) != (1 == _settings.reportN) ||
+                        std::abs(static_cast<double>(desired.reportN) - _settings.reportN) >
+                        N_HYSTERESIS * _settings.reportN;
+
+        if (!nChanged && desired.aiDurationMS == _settings.aiDurationMS)
+        {
+            return false;
+        }
+
+        _settings = desired;
+        settings = desired;
+        return true;
+    }
+
+
+    CReportBatchController::Settings CReportBatchController::desiredSettings() const
+    {
+        Settings settings;
+        double n = std::round(_tagRateHz * _intervalMS / 1000.0);
+
+        settings.reportN = static_cast<std::uint16_t>(std::min<double>(std::max(n, 1.0), MAX_REPORT_N));
+
+        /*
+         * Reporting every tag, the AISpec can be long and save the
+         * START_ROSPEC round trips. Batching, the leftover tags at the
+         * end of a burst wait for the end of the AISpec, so keep it
+         * within a few report intervals.
+         */
+
+        if (1 == settings.reportN)
+        {
+            settings.aiDurationMS = QUIET_DURATION_MS;
+        }
+        else
+        {
+            settings.aiDurationMS = std::min(std::max(_intervalMS * DURATION_PER_INTERVAL, MIN_DURATION_MS),
+                                             QUIET_DURATION_MS);
+        }
+
+        return settings;
+    }
+}
@@ -0,0 +1,92 @@
+//********************************************************************
+//    created:    2026-10-18 06:30 PM
+//    file:       creportbatchcontroller.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CREPORTBATCHCONTROLLER_H
+#define LLRPLAPS_CREPORTBATCHCONTROLLER_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace LLRPLaps
+{
+    /*
+     * Picks the ROReportSpec N and the AISpec duration from what the
+     * reports look like. A report is sent every N tags, so N is the
+     * tag rate times the report interval we can live with: 1 when
+     * the track is quiet, so a lone rider is reported at once, and
+     * larger during a bunch crossing so the per report cost stays
+     * bounded. When the consumer is busy for a large share of the
+     * time the interval is stretched, up to the maximum latency.
+     *
+     * Driven from the thread that processes the reports; not thread
+     * safe. Changes are rate limited since each one costs a ROSpec
+     * reinstall.
+     */
+    class CReportBatchController
+    {
+    public:
+        struct Settings
+        {
+            std::uint16_t reportN;
+            std::uint32_t aiDurationMS;
+
+            bool operator==(const Settings &other) const
+            {
+                return reportN == other.reportN && aiDurationMS == other.aiDurationMS;
+            }
+
+            bool operator!=(const Settings &other) const { return !(*this == other); }
+        };
+
+        explicit CReportBatchController(std::uint32_t targetLatencyMS = DEFAULT_TARGET_LATENCY_MS,
+                                        std::uint32_t maxLatencyMS = DEFAULT_MAX_LATENCY_MS);
+
+        void onReport(std::size_t tagCount, std::uint64_t receivedNSec, std::uint64_t processedNSec);
+
+        bool retune(std::uint64_t nowNSec, Settings &settings);
+
+        const Settings &getSettings() const { return _settings; }
+
+        double getTagRateHz() const { return _tagRateHz; }
+
+        double getConsumerLoad() const { return _consumerLoad; }
+
+        const static std::uint32_t DEFAULT_TARGET_LATENCY_MS;
+        const static std::uint32_t DEFAULT_MAX_LATENCY_MS;
+        const static std::uint16_t MAX_REPORT_N;
+        const static std::uint32_t QUIET_DURATION_MS;
+        const static std::uint32_t MIN_DURATION_MS;
+        const static std::uint64_t RETUNE_INTERVAL_NSEC;
+
+    private:
+        Settings desiredSettings() const;
+
+        std::uint32_t _targetLatencyMS;
+        std::uint32_t _maxLatencyMS;
+        std::uint32_t _intervalMS;
+        Settings _settings;
+
+        std::uint64_t _lastRetuneNSec;
+        std::uint64_t _tagsSinceRetune;
+        std::uint64_t _busyNSecSinceRetune;
+        double _tagRateHz;
+        double _consumerLoad;
+    };
+}
+#endif //LLRPLAPS_CREPORTBATCHCONTROLLER_H
@@ -0,0 +1,106 @@
+//********************************************************************
+//    created:    2026-10-18 08:10 PM
+//    file:       cresult.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CRESULT_H
+#define LLRPLAPS_CRESULT_H
+
+#include <utility>
+#include <variant>
+
+#include "exceptions.h"
+
+namespace LLRPLaps
+{
+    /*
+     * A value or the CReaderError saying why there is none, in the
+     * spirit of std::expected. Returned where a failure such as a
+     * receive timeout is an everyday event; raiseOnError() turns it
+     * back into an exception where a failure is fatal, e.g. while
+     * setting up the reader. Dropping one unchecked is a bug, hence
+     * [[nodiscard]].
+     */
+    template <class T>
+    class [[nodiscard]] CResult
+    {
+    public:
+        CResult(T value) : _result(std::in_place_index<0>, std::move(value))
+        {
+        }
+
+        CResult(CReaderError error) : _result(std::in_place_index<1>, std::move(error))
+        {
+        }
+
+        bool ok() const { return 0 == _result.index(); }
+
+        explicit operator bool() const { return ok(); }
+
+        T &value() { return std::get<0>(_result); }
+
+        const T &value() const { return std::get<0>(_result); }
+
+        const CReaderError &error() const { return std::get<1>(_result); }
+
+        ReaderErrorCode code() const { return ok() ? ReaderErrorCode::None : error().code; }
+
+        T &raiseOnError()
+        {
+            if (!ok())
+            {
+                error().raise();
+            }
+            return value();
+        }
+
+    private:
+        std::variant<T, CReaderError> _result;
+    };
+
+
+    template <>
+    class [[nodiscard]] CResult<void>
+    {
+    public:
+        CResult() = default;
+
+        CResult(CReaderError error) : _error(std::move(error))
+        {
+        }
+
+        bool ok() const { return ReaderErrorCode::None == _error.code; }
+
+        explicit operator bool() const { return ok(); }
+
+        const CReaderError &error() const { return _error; }
+
+        ReaderErrorCode code() const { return _error.code; }
+
+        void raiseOnError() const
+        {
+            if (!ok())
+            {
+                _error.raise();
+            }
+        }
+
+    private:
+        CReaderError _error;
+    };
+}
+#endif //LLRPLAPS_CRESULT_H
@@ -0,0 +1,462 @@
+//********************************************************************
+//    created:    2026-10-19 02:50 AM
+//    file:       criderapi.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTcpSocket>
+
+#include "criderapi.h"
+#include "cantennaanalytics.h"
+
+namespace LLRPLaps
+{
+    const quint16 CRiderApi::DEFAULT_PORT = 8085;
+    const int CRiderApi::LEADERBOARD_SIZE = 50;
+    const int CRiderApi::MAX_REQUEST_BYTES = 8192;
+    const int CRiderApi::UPDATE_INTERVAL_MS = 250;
+
+    namespace
+    {
+        // A year of days in /riders/{id}/bests
+        const int DAYS_LISTED = 366;
+
+        double toSec(u_int64_t usec)
+        {
+            return static_cast<double>(usec) / 1000000.0;
+        }
+
+        QString toTime(u_int64_t usec)
+        {
+            return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(usec / 1000), Qt::UTC).toString(Qt::ISODateWithMs);
+        }
+
+        QJsonObject toJson(const CLapAggregates::CStats &stats)
+        {
+            QJsonObject json;
+            json["laps"] = stats.laps;
+            json["bestLapSec"] = toSec(stats.bestLapUSec);
+            json["averageLapSec"] = toSec(stats.totalLapUSec / static_cast<u_int64_t>(std::max(1, stats.laps)));
+            return json;
+        }
+
+        const char *statusText(int status)
+        {
+            switch (status)
+            {
+                case 200:
+                    return "OK";
+                case 304:
+                    return "Not Modified";
+                case 400:
+                    return "Bad Request";
+                case 404:
+                    return "Not Found";
+                case 405:
+                    return "Method Not Allowed";
+                case 431:
+                    return "Request Header Fields Too Large";
+                default:
+                    return "Error";
+            }
+        }
+    }
+
+    CRiderApi::CRiderApi(CLapAggregates &aggregates, QObject *parent)
+            : QObject(parent), _aggregates(aggregates), _analytics(nullptr), _server(this), _requestCount(0), _notModifiedCount(0)
+    {
+        /* ETags of an earlier run must not match what this one renders */
+        _instance = QByteArray::number(QDateTime::currentMSecsSinceEpoch(), 36);
+        connect(&_server, &QTcpServer::newConnection, this, &CRiderApi::onNewConnection);
+    }
+
+
+    CRiderApi::~CRiderApi()
+    {
+        for (auto &entry : _received)
+        {
+            entry.first->abort();
+        }
+    }
+
+
+    bool CRiderApi::listen(quint16 port, const QHostAddress &address)
+    {
+        if (!_server.listen(address, port))
+        {
+            _errorString = _server.errorString();
+            return false;
+        }
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Take in what the database stored since last time
+ **
+ ** Versions move on only for what the new laps touch, so the bodies
+ ** and ETags of everything else stay valid.
+ **
+ *****************************************************************************/
+
+    void CRiderApi::onCommitted()
+    {
+        _aggregates.update();
+    }
+
+
+    void CRiderApi::onNewConnection()
+    {
+        while (QTcpSocket *socket = _server.nextPendingConnection())
+        {
+            socket->setParent(this);
+            _received[socket];
+            connect(socket, &QTcpSocket::readyRead, this, &CRiderApi::onReadyRead);
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]()
+            {
+                _received.erase(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+
+    void CRiderApi::onReadyRead()
+    {
+        auto socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &received = _received[socket];
+        received.append(socket->readAll());
+
+        /* Requests are GETs, a request is its head and may be pipelined */
+        for (;;)
+        {
+            int end = received.indexOf("\r\n\r\n");
+            if (end < 0)
+            {
+                if (received.size() > MAX_REQUEST_BYTES)
+                {
+                    received.clear();
+                    respond(socket, 431, QByteArray(), QByteArray(), false);
+                }
+                return;
+            }
+
+            QByteArray request = received.left(end);
+            received.remove(0, end + 4);
+            if (!handleRequest(socket, request))
+            {
+                /* Closing may already have dropped received */
+                return;
+            }
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Answer one request from the cache
+ **
+ ** The ETag comes from version numbers alone. A matching
+ ** If-None-Match costs no rendering, a body is only rendered when
+ ** the one kept is of an older version.
+ **
+ *****************************************************************************/
+
+    bool CRiderApi::handleRequest(QTcpSocket *socket, const QByteArray &request)
+    {
+        _requestCount++;
+
+        QList<QByteArray> lines = request.split('\n');
+        QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (3 != requestLine.size())
+        {
+            respond(socket, 400, QByteArray(), QByteArray(), false);
+            return false;
+        }
+
+        QByteArray ifNoneMatch;
+        QByteArray connection;
+        for (int i = 1; i < lines.size(); i++)
+        {
+            int colon = lines[i].indexOf(':');
+            QByteArray name = lines[i].left(colon).trimmed().toLower();
+            if ("if-none-match" == name)
+            {
+                ifNoneMatch = lines[i].mid(colon + 1).trimmed();
+            }
+            else if ("connection" == name)
+            {
+                connection = lines[i].mid(colon + 1).trimmed().toLower();
+            }
+        }
+        bool keepAlive = ("HTTP/1.1" == requestLine[2]) ? ("close" != connection) : ("keep-alive" == connection);
+
+        /* A body is not read, left there it would be taken for the next request */
+        if ("GET" != requestLine[0])
+        {
+            respond(socket, 405, QByteArray(), QByteArray(), false);
+            return false;
+        }
+
+        QString path = QString::fromUtf8(requestLine[1]).section('?', 0, 0);
+        qint64 riderId = 0;
+        CLapAggregates::Period period = CLapAggregates::All;
+        QByteArray etag = etagOf(path, riderId, period);
+        if (etag.isEmpty())
+        {
+            respond(socket, 404, QByteArray(), "{\"error\":\"not found\"}", keepAlive);
+            return keepAlive;
+        }
+
+        if (ifNoneMatch.contains(etag) || "*" == ifNoneMatch)
+        {
+            _notModifiedCount++;
+            respond(socket, 304, etag, QByteArray(), keepAlive);
+            return keepAlive;
+        }
+
+        /* Keyed by what the body is of, /riders/007/bests is /riders/7/bests */
+        bool sessions = path.endsWith("/sessions");
+        bool bests = path.endsWith("/bests");
+        bool antennas = path.endsWith("/antennas");
+        QString key = sessions ? QString("/riders/%1/sessions").arg(riderId)
+                               : bests ? QString("/riders/%1/bests").arg(riderId)
+                                       : antennas ? QString("/antennas")
+                                                  : QString("/leaderboards/") + CLapAggregates::periodName(period);
+
+        CCached &cached = _cache[key];
+        if (cached.etag != etag)
+        {
+            cached.body = sessions ? renderSessions(riderId) : bests ? renderBests(riderId)
+                                                                     : antennas ? renderAntennas()
+                                                                                : renderLeaderboard(period);
+            cached.etag = etag;
+        }
+
+        respond(socket, 200, etag, cached.body, keepAlive);
+        return keepAlive;
+    }
+
+
+    QByteArray CRiderApi::etagOf(const QString &path, qint64 &riderId, CLapAggregates::Period &period) const
+    {
+        QStringList parts = path.split('/', QString::SkipEmptyParts);
+        qint64 today = QDate::currentDate().toJulianDay();
+
+        if (3 == parts.size() && "riders" == parts[0] && ("sessions" == parts[2] || "bests" == parts[2]))
+        {
+            bool valid = false;
+            riderId = parts[1].toLongLong(&valid);
+            const CLapAggregates::CRider *rider = valid ? _aggregates.getRider(riderId) : nullptr;
+            if (nullptr == rider)
+            {
+                return QByteArray();
+            }
+
+            /* What is best this week changes on Monday whether or not there are laps */
+            QByteArray etag = "\"" + _instance + "-r" + QByteArray::number(riderId) + "-" +
+                              QByteArray::number(static_cast<qulonglong>(rider->version));
+            return etag + (("bests" == parts[2]) ? "-" + QByteArray::number(today) + "\"" : QByteArray("\""));
+        }
+
+        if (1 == parts.size() && "antennas" == parts[0] && nullptr != _analytics)
+        {
+            /* New numbers with every bucket the analytics closes */
+            return "\"" + _instance + "-a" + QByteArray::number(static_cast<qulonglong>(_analytics->getVersion())) + "\"";
+        }
+
+        if (2 == parts.size() && "leaderboards" == parts[0])
+        {
+            for (int p = 0; p < CLapAggregates::PeriodCount; p++)
+            {
+                period = static_cast<CLapAggregates::Period>(p);
+                if (parts[1] == CLapAggregates::periodName(period))
+                {
+                    return "\"" + _instance + "-l" + QByteArray::number(p) + "-" +
+                           QByteArray::number(static_cast<qulonglong>(_aggregates.getPeriodVersion(period))) + "-" +
+                           QByteArray::number(today) + "\"";
+                }
+            }
+        }
+        return QByteArray();
+    }
+
+
+    QByteArray CRiderApi::renderSessions(qint64 riderId)
+    {
+        const CLapAggregates::CRider *rider = _aggregates.getRider(riderId);
+
+        QJsonArray sessions;
+        for (auto entry = rider->sessions.rbegin(); entry != rider->sessions.rend(); ++entry)
+        {
+            QJsonObject session = toJson(entry->second);
+            session["id"] = entry->first;
+            session["name"] = _aggregates.getSessionName(entry->first);
+            session["firstCrossing"] = toTime(entry->second.firstCrossingUSec);
+            session["lastCrossing"] = toTime(entry->second.lastCrossingUSec);
+            sessions.append(session);
+        }
+
+        QJsonObject json;
+        json["rider"] = riderId;
+        json["name"] = rider->name;
+        json["sessions"] = sessions;
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+
+
+    QByteArray CRiderApi::renderBests(qint64 riderId)
+    {
+        const CLapAggregates::CRider *rider = _aggregates.getRider(riderId);
+        QDate today = QDate::currentDate();
+
+        QJsonObject bests;
+        for (int p = 0; p < CLapAggregates::PeriodCount; p++)
+        {
+            auto period = static_cast<CLapAggregates::Period>(p);
+            auto stats = rider->periods[p].find(CLapAggregates::periodKey(period, today));
+            bests[CLapAggregates::periodName(period)] =
+                    (rider->periods[p].end() != stats) ? QJsonValue(toJson(stats->second)) : QJsonValue();
+        }
+
+        QJsonArray days;
+        const auto &byDay = rider->periods[CLapAggregates::Day];
+        for (auto day = byDay.rbegin(); day != byDay.rend() && days.size() < DAYS_LISTED; ++day)
+        {
+            QJsonObject json = toJson(day->second);
+            json["date"] = QDate::fromJulianDay(day->first).toString(Qt::ISODate);
+            days.append(json);
+        }
+
+        QJsonObject json;
+        json["rider"] = riderId;
+        json["name"] = rider->name;
+        json["bests"] = bests;
+        json["days"] = days;
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+
+
+    QByteArray CRiderApi::renderLeaderboard(CLapAggregates::Period period)
+    {
+        qint64 key = CLapAggregates::periodKey(period, QDate::currentDate());
+
+        std::vector<std::tuple<u_int64_t, qint64, const CLapAggregates::CRider *, int>> best;
+        for (const auto &entry : _aggregates.getRiders())
+        {
+            auto stats = entry.second.periods[period].find(key);
+            if (entry.second.periods[period].end() != stats)
+            {
+                best.emplace_back(stats->second.bestLapUSec, entry.first, &entry.second, stats->second.laps);
+            }
+        }
+
+        std::size_t size = std::min(best.size(), static_cast<std::size_t>(LEADERBOARD_SIZE));
+        std::partial_sort(best.begin(), best.begin() + static_cast<std::ptrdiff_t>(size), best.end(),
+                          [](const decltype(best)::value_type &a, const decltype(best)::value_type &b)
+                          { return std::get<0>(a) < std::get<0>(b); });
+
+        QJsonArray riders;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            QJsonObject rider;
+            rider["rank"] = static_cast<int>(i + 1);
+            rider["rider"] = std::get<1>(best[i]);
+            rider["name"] = std::get<2>(best[i])->name;
+            rider["bestLapSec"] = toSec(std::get<0>(best[i]));
+            rider["laps"] = std::get<3>(best[i]);
+            riders.append(rider);
+        }
+
+        QJsonObject json;
+        json["period"] = CLapAggregates::periodName(period);
+        json["from"] = (CLapAggregates::All == period) ? QJsonValue()
+                                                       : QJsonValue(QDate::fromJulianDay(key).toString(Qt::ISODate));
+        json["riders"] = riders;
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+
+
+    QByteArray CRiderApi::renderAntennas()
+    {
+        QJsonArray antennas;
+        for (const CAntennaAnalytics::CAntennaStats &stats : _analytics->getStats())
+        {
+            QJsonObject antenna;
+            antenna["reader"] = stats.reader;
+            antenna["antenna"] = stats.antennaId;
+            antenna["connected"] = stats.connected;
+            antenna["readsPerSec"] = stats.readsPerSec;
+            antenna["passes"] = static_cast<qint64>(stats.passes);
+            antenna["meanReadsPerPass"] = stats.meanReadsPerPass;
+            antenna["readsPerPassP50"] = stats.readsPerPassP50;
+            antenna["readsPerPassP90"] = stats.readsPerPassP90;
+            antenna["rssiP10"] = stats.rssiP10;
+            antenna["rssiP50"] = stats.rssiP50;
+            antenna["rssiP90"] = stats.rssiP90;
+            antenna["baselineReadsPerPass"] = stats.baselineReadsPerPass;
+            antenna["peerReadsPerPass"] = stats.peerReadsPerPass;
+            antenna["degraded"] = stats.degraded;
+            antenna["reason"] = stats.degraded ? QJsonValue(stats.reason) : QJsonValue();
+            antennas.append(antenna);
+        }
+
+        QJsonObject json;
+        json["windowSec"] = static_cast<double>(CAntennaAnalytics::WINDOW_BUCKETS * CAntennaAnalytics::BUCKET_USEC) / 1e6;
+        json["antennas"] = antennas;
+        return QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+
+
+    void CRiderApi::respond(QTcpSocket *socket, int status, const QByteArray &etag, const QByteArray &body,
+                            bool keepAlive)
+    {
+        QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n";
+        if (!etag.isEmpty())
+        {
+            response += "ETag: " + etag + "\r\n";
+        }
+        if (304 != status)
+        {
+            response += "Content-Type: application/json; charset=utf-8\r\n";
+            response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+        }
+        response += "Cache-Control: no-cache\r\n";
+        response += "Access-Control-Allow-Origin: *\r\n";
+        response += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        if (304 != status)
+        {
+            response += body;
+        }
+
+        socket->write(response);
+        if (!keepAlive)
+        {
+            socket->disconnectFromHost();
+        }
+    }
+}
@@ -0,0 +1,130 @@
+//********************************************************************
+//    created:    2026-10-19 02:50 AM
+//    file:       criderapi.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CRIDERAPI_H
+#define LLRPLAPS_CRIDERAPI_H
+
+#include <cstdint>
+#include <map>
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+#include "clapaggregates.h"
+
+class QTcpSocket;
+
+namespace LLRPLaps
+{
+    class CAntennaAnalytics;
+
+    /*
+     * Read only JSON over HTTP/1.1 of what CLapAggregates holds:
+     *
+     *   GET /riders/{id}/sessions      every session ridden, newest first
+     *   GET /riders/{id}/bests         best laps this day, week, month,
+     *                                  year and ever, and per day
+     *   GET /leaderboards/{period}     best lap per rider, period being
+     *                                  day, week, month, year or all
+     *   GET /antennas                  read rates, reads per pass, RSSI
+     *                                  and health of every antenna, when
+     *                                  there is a CAntennaAnalytics
+     *
+     * A body is rendered once per version of what it is built from and
+     * kept, with an ETag naming that version. A client polling with
+     * If-None-Match gets 304 and no body until a lap changes it.
+     * Connections are kept alive. New laps are taken in by onCommitted(),
+     * off the request path: connect CLapDatabase::committed() to it, or
+     * call it every UPDATE_INTERVAL_MS for a database another process
+     * writes.
+     *
+     * Lives in the thread of the CLapAggregates.
+     */
+    class CRiderApi : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CRiderApi(CLapAggregates &aggregates, QObject *parent = nullptr);
+
+        ~CRiderApi() override;
+
+        bool listen(quint16 port = DEFAULT_PORT, const QHostAddress &address = QHostAddress::Any);
+
+        const QString &getErrorString() const { return _errorString; }
+
+        // Must outlive the API, NULL for no /antennas
+        void setAntennaAnalytics(const CAntennaAnalytics *analytics) { _analytics = analytics; }
+
+        std::uint64_t getRequestCount() const { return _requestCount; }
+
+        std::uint64_t getNotModifiedCount() const { return _notModifiedCount; }
+
+        const static quint16 DEFAULT_PORT;
+        const static int LEADERBOARD_SIZE;
+        const static int MAX_REQUEST_BYTES;
+        const static int UPDATE_INTERVAL_MS;
+
+    public slots:
+
+        void onCommitted();
+
+    private slots:
+
+        void onNewConnection();
+
+        void onReadyRead();
+
+    private:
+        struct CCached
+        {
+            QByteArray etag;
+            QByteArray body;
+        };
+
+        // false once the connection is to be closed
+        bool handleRequest(QTcpSocket *socket, const QByteArray &request);
+
+        // The ETag path would have now, empty for no such resource
+        QByteArray etagOf(const QString &path, qint64 &riderId, CLapAggregates::Period &period) const;
+
+        QByteArray renderSessions(qint64 riderId);
+
+        QByteArray renderBests(qint64 riderId);
+
+        QByteArray renderLeaderboard(CLapAggregates::Period period);
+
+        QByteArray renderAntennas();
+
+        void respond(QTcpSocket *socket, int status, const QByteArray &etag, const QByteArray &body, bool keepAlive);
+
+        CLapAggregates &_aggregates;
+        const CAntennaAnalytics *_analytics;
+        QTcpServer _server;
+        QByteArray _instance;
+        std::map<QString, CCached> _cache;
+        std::map<QTcpSocket *, QByteArray> _received;
+        std::uint64_t _requestCount;
+        std::uint64_t _notModifiedCount;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CRIDERAPI_H
@@ -0,0 +1,264 @@
+//********************************************************************
+//    created:    2026-10-18 02:00 PM
+//    file:       croaccessreportdecoder.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "croaccessreportdecoder.h"
+
+namespace LLRPLaps
+{
+    const unsigned int CROAccessReportDecoder::RO_ACCESS_REPORT_TYPE = 61;
+
+    namespace
+    {
+        const unsigned int HEADER_SIZE = 10;
+        const unsigned int TLV_HEADER_SIZE = 4;
+
+        // TLV parameter types
+        const unsigned int TAG_REPORT_DATA = 240;
+        const unsigned int EPC_DATA = 241;
+
+        // TV parameter types
+        const unsigned int TV_ANTENNA_ID = 1;
+        const unsigned int TV_FIRST_SEEN_UTC = 2;
+        const unsigned int TV_FIRST_SEEN_UPTIME = 3;
+        const unsigned int TV_LAST_SEEN_UTC = 4;
+        const unsigned int TV_LAST_SEEN_UPTIME = 5;
+        const unsigned int TV_PEAK_RSSI = 6;
+        const unsigned int TV_CHANNEL_INDEX = 7;
+        const unsigned int TV_TAG_SEEN_COUNT = 8;
+        const unsigned int TV_ROSPEC_ID = 9;
+        const unsigned int TV_EPC_96 = 13;
+
+        /*
+         * Value sizes of the TV parameters in LLRP 1.0.1 and 1.1,
+         * indexed by type. Zero means not a known TV type.
+         */
+        const unsigned char TV_VALUE_SIZE[128] =
+        {
+            0,  2,  8,  8,  8,  8,  1,  2,  2,  4,  2,  2,  2, 12,  2,  2,     //  0 - 15
+            4,  2,  4,  2,  2                                                  // 16 - 20
+        };
+
+        inline std::uint16_t readU16(const unsigned char *p)
+        {
+            return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+        }
+
+        inline std::uint32_t readU32(const unsigned char *p)
+        {
+            return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) | static_cast<std::uint32_t>(p[3]);
+        }
+
+        inline std::uint64_t readU64(const unsigned char *p)
+        {
+            return (static_cast<std::uint64_t>(readU32(p)) << 32) | readU32(p + 4);
+        }
+    }
+
+    CROAccessReportDecoder::CROAccessReportDecoder() : _tagCount(0)
+    {
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Decode the TagReportData parameters of a report
+ **
+ ** Top level parameters other than TagReportData (RFSurveyReportData,
+ ** Custom) are skipped. Records beyond the capacity are counted but
+ ** not decoded so the caller can size up and call again.
+ **
+ *****************************************************************************/
+
+    CROAccessReportDecoder::Result CROAccessReportDecoder::decode(const unsigned char *frame, unsigned int length,
+                                                                  CTagRecord *records, std::size_t capacity)
+    {
+        _tagCount = 0;
+
+        if (length < HEADER_SIZE)
+        {
+            return Malformed;
+        }
+
+        unsigned int messageType = ((frame[0] & 0x03u) << 8) | frame[1];
+        if (RO_ACCESS_REPORT_TYPE != messageType)
+        {
+            return NotAReport;
+        }
+        if (readU32(frame + 2) != length)
+        {
+            return Malformed;
+        }
+
+        const unsigned char *p = frame + HEADER_SIZE;
+        const unsigned char *end = frame + length;
+
+        while (p < end)
+        {
+            if (p[0] & 0x80u)
+            {
+                // No TV parameters at the top level of a report
+                return Malformed;
+            }
+            if (end - p < static_cast<std::ptrdiff_t>(TLV_HEADER_SIZE))
+            {
+                return Malformed;
+            }
+
+            unsigned int type = ((p[0] & 0x03u) << 8) | p[1];
+            unsigned int paramLength = readU16(p + 2);
+            if (paramLength < TLV_HEADER_SIZE || paramLength > static_cast<unsigned int>(end - p))
+            {
+                return Malformed;
+            }
+
+            if (TAG_REPORT_DATA == type)
+            {
+                if (_tagCount < capacity)
+                {
+                    if (!decodeTagReportData(p + TLV_HEADER_SIZE, p + paramLength, records[_tagCount]))
+                    {
+                        return Malformed;
+                    }
+                }
+                _tagCount++;
+            }
+            p += paramLength;
+        }
+
+        return (_tagCount > capacity) ? TooManyTags : Ok;
+    }
+
+
+    bool CROAccessReportDecoder::decodeTagReportData(const unsigned char *p, const unsigned char *end, CTagRecord &record)
+    {
+        record.epc = nullptr;
+        record.epcBits = 0;
+        record.antennaId = 0;
+        record.channelIndex = 0;
+        record.tagSeenCount = 0;
+        record.peakRSSI = 0;
+        record.roSpecId = 0;
+        record.fields = 0;
+        record.firstSeenUSec = 0;
+        record.lastSeenUSec = 0;
+
+        while (p < end)
+        {
+            if (p[0] & 0x80u)
+            {
+                unsigned int type = p[0] & 0x7fu;
+                unsigned int size = TV_VALUE_SIZE[type];
+                if (0 == size || size + 1u > static_cast<unsigned int>(end - p))
+                {
+                    return false;
+                }
+
+                const unsigned char *value = p + 1;
+                switch (type)
+                {
+                    case TV_EPC_96:
+                        record.epc = value;
+                        record.epcBits = 96;
+                        break;
+                    case TV_ANTENNA_ID:
+                        record.antennaId = readU16(value);
+                        record.fields |= CTagRecord::HasAntennaId;
+                        break;
+                    case TV_PEAK_RSSI:
+                        record.peakRSSI = static_cast<std::int8_t>(value[0]);
+                        record.fields |= CTagRecord::HasPeakRSSI;
+                        break;
+                    case TV_CHANNEL_INDEX:
+                        record.channelIndex = readU16(value);
+                        record.fields |= CTagRecord::HasChannelIndex;
+                        break;
+                    case TV_FIRST_SEEN_UTC:
+                        record.firstSeenUSec = readU64(value);
+                        record.fields |= CTagRecord::HasFirstSeenUTC;
+                        break;
+                    case TV_FIRST_SEEN_UPTIME:
+                        if (!(record.fields & CTagRecord::HasFirstSeenUTC))
+                        {
+                            record.firstSeenUSec = readU64(value);
+                        }
+                        record.fields |= CTagRecord::HasFirstSeenUptime;
+                        break;
+                    case TV_LAST_SEEN_UTC:
+                        record.lastSeenUSec = readU64(value);
+                        record.fields |= CTagRecord::HasLastSeenUTC;
+                        break;
+                    case TV_LAST_SEEN_UPTIME:
+                        if (!(record.fields & CTagRecord::HasLastSeenUTC))
+                        {
+                            record.lastSeenUSec = readU64(value);
+                        }
+                        record.fields |= CTagRecord::HasLastSeenUptime;
+                        break;
+                    case TV_TAG_SEEN_COUNT:
+                        record.tagSeenCount = readU16(value);
+                        record.fields |= CTagRecord::HasTagSeenCount;
+                        break;
+                    case TV_ROSPEC_ID:
+                        record.roSpecId = readU32(value);
+                        record.fields |= CTagRecord::HasROSpecId;
+                        break;
+                    default:
+                        // SpecIndex, CRC, PC, AccessSpecID, ... not needed
+                        break;
+                }
+                p += 1u + size;
+                continue;
+            }
+
+            if (end - p < static_cast<std::ptrdiff_t>(TLV_HEADER_SIZE))
+            {
+                return false;
+            }
+
+            unsigned int type = ((p[0] & 0x03u) << 8) | p[1];
+            unsigned int paramLength = readU16(p + 2);
+            if (paramLength < TLV_HEADER_SIZE || paramLength > static_cast<unsigned int>(end - p))
+            {
+                return false;
+            }
+
+            if (EPC_DATA == type)
+            {
+                if (paramLength < TLV_HEADER_SIZE + 2u)
+                {
+                    return false;
+                }
+                std::uint16_t bits = readU16(p + TLV_HEADER_SIZE);
+                if ((bits + 7u) / 8u > paramLength - TLV_HEADER_SIZE - 2u)
+                {
+                    return false;
+                }
+                record.epc = p + TLV_HEADER_SIZE + 2u;
+                record.epcBits = bits;
+            }
+
+            // Anything else (OpSpecResults, Custom, ...) is skipped
+            p += paramLength;
+        }
+
+        // The EPC is mandatory in a TagReportData
+        return nullptr != record.epc;
+    }
+}
@@ -0,0 +1,98 @@
+//********************************************************************
+//    created:    2026-10-18 02:00 PM
+//    file:       croaccessreportdecoder.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CROACCESSREPORTDECODER_H
+#define LLRPLAPS_CROACCESSREPORTDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace LLRPLaps
+{
+    /*
+     * One TagReportData of an RO_ACCESS_REPORT. The EPC points into
+     * the frame the record was decoded from and is only valid as
+     * long as that frame is.
+     */
+    struct CTagRecord
+    {
+        enum Fields
+        {
+            HasAntennaId            = 1u << 0,
+            HasPeakRSSI             = 1u << 1,
+            HasChannelIndex         = 1u << 2,
+            HasFirstSeenUTC         = 1u << 3,
+            HasFirstSeenUptime      = 1u << 4,
+            HasLastSeenUTC          = 1u << 5,
+            HasLastSeenUptime       = 1u << 6,
+            HasTagSeenCount         = 1u << 7,
+            HasROSpecId             = 1u << 8
+        };
+
+        const unsigned char *epc;
+        std::uint16_t epcBits;
+        std::uint16_t antennaId;
+        std::uint16_t channelIndex;
+        std::uint16_t tagSeenCount;
+        std::int8_t peakRSSI;
+        std::uint32_t roSpecId;
+        std::uint32_t fields;
+        std::uint64_t firstSeenUSec;        // UTC, or uptime if only HasFirstSeenUptime
+        std::uint64_t lastSeenUSec;
+
+        unsigned int getEpcBytes() const { return (epcBits + 7u) / 8u; }
+    };
+
+
+    /*
+     * Decodes RO_ACCESS_REPORT frames straight from the receive
+     * buffer into a caller supplied array of CTagRecord, without
+     * building LTK objects or allocating.
+     *
+     * Only the parts of a report a timing system needs are understood.
+     * Anything the decoder cannot skip safely (an unknown TV parameter,
+     * a length that does not add up) makes it give up and the caller
+     * falls back to the LTK decoder for that frame.
+     */
+    class CROAccessReportDecoder
+    {
+    public:
+        enum Result
+        {
+            Ok,
+            NotAReport,         // some other message type
+            Malformed,          // lengths inconsistent, or something we cannot skip
+            TooManyTags         // records too small, getTagCount() tells how many are needed
+        };
+
+        CROAccessReportDecoder();
+
+        Result decode(const unsigned char *frame, unsigned int length, CTagRecord *records, std::size_t capacity);
+
+        std::size_t getTagCount() const { return _tagCount; }
+
+        const static unsigned int RO_ACCESS_REPORT_TYPE;
+
+    private:
+        bool decodeTagReportData(const unsigned char *p, const unsigned char *end, CTagRecord &record);
+
+        std::size_t _tagCount;
+    };
+}
+#endif //LLRPLAPS_CROACCESSREPORTDECODER_H
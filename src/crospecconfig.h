@@ -0,0 +1,89 @@
+//********************************************************************
+//    created:    2026-10-18 02:45 PM
+//    file:       crospecconfig.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CROSPECCONFIG_H
+#define LLRPLAPS_CROSPECCONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * Only tags whose EPC starts with the first bits of prefix are
+     * reported. Bits past the length are zero.
+     */
+    struct CEpcFilter
+    {
+        std::vector<unsigned char> prefix;
+        std::uint16_t bits;
+
+        bool operator==(const CEpcFilter &other) const { return bits == other.bits && prefix == other.prefix; }
+    };
+
+
+    /*
+     * What CReader puts in its ROSpec. The defaults are the ROSpec
+     * addROSpec has always sent: started by START_ROSPEC, one 500ms
+     * AISpec on all antennas, a single report at the end carrying
+     * the antenna and first seen time of every tag.
+     *
+     * With EPC filters only tags matching one of them are reported,
+     * see CChipRegistry.
+     */
+    class CROSpecConfig
+    {
+    public:
+        CROSpecConfig() : roSpecId(123), priority(0), aiDurationMS(500), antennaIds(1, 0), inventoryParameterSpecId(1234),
+                          reportN(0), enableAntennaId(true), enableChannelIndex(false), enablePeakRSSI(false),
+                          enableFirstSeenTimestamp(true), enableLastSeenTimestamp(false), enableTagSeenCount(false)
+        {
+        }
+
+        bool operator==(const CROSpecConfig &other) const
+        {
+            return roSpecId == other.roSpecId && priority == other.priority && aiDurationMS == other.aiDurationMS &&
+                   antennaIds == other.antennaIds && inventoryParameterSpecId == other.inventoryParameterSpecId &&
+                   reportN == other.reportN && enableAntennaId == other.enableAntennaId &&
+                   enableChannelIndex == other.enableChannelIndex && enablePeakRSSI == other.enablePeakRSSI &&
+                   enableFirstSeenTimestamp == other.enableFirstSeenTimestamp &&
+                   enableLastSeenTimestamp == other.enableLastSeenTimestamp && enableTagSeenCount == other.enableTagSeenCount &&
+                   epcFilters == other.epcFilters;
+        }
+
+        bool operator!=(const CROSpecConfig &other) const { return !(*this == other); }
+
+        std::uint32_t roSpecId;
+        std::uint8_t priority;
+        std::uint32_t aiDurationMS;
+        std::vector<std::uint16_t> antennaIds;      // {0} is all antennas
+        std::uint16_t inventoryParameterSpecId;
+        std::uint16_t reportN;                      // 0 is one report at the end of the ROSpec
+
+        bool enableAntennaId;
+        bool enableChannelIndex;
+        bool enablePeakRSSI;
+        bool enableFirstSeenTimestamp;
+        bool enableLastSeenTimestamp;
+        bool enableTagSeenCount;
+
+        std::vector<CEpcFilter> epcFilters;     // none reports every tag
+    };
+}
+#endif //LLRPLAPS_CROSPECCONFIG_H
@@ -0,0 +1,285 @@
+//********************************************************************
+//    created:    2026-10-19 03:45 AM
+//    file:       crosterindex.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <cstring>
+
+#include "crosterindex.h"
+#include "croaccessreportdecoder.h"
+
+namespace LLRPLaps
+{
+    const std::int64_t CRosterIndex::NOT_REGISTERED = -1;
+    const std::size_t CRosterIndex::BITS_PER_CHIP = 16;
+
+    namespace
+    {
+        const unsigned int EPC96_BYTES = 12;
+        const unsigned int BLOCK_WORDS = 8;
+        const unsigned int BUCKET_SLOTS = 8;
+        const std::size_t RESOLVE_RUN = 32;
+
+        // One odd constant per word of a block, as in the Parquet split block filter
+        const std::uint32_t SALTS[BLOCK_WORDS] = { 0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                                   0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u };
+
+        void splitEpc96(const unsigned char *epc, std::uint64_t &high, std::uint32_t &low)
+        {
+            std::memcpy(&high, epc, sizeof(high));
+            std::memcpy(&low, epc + sizeof(high), sizeof(low));
+        }
+
+        // Chips of a batch differ in the last few bits only, the finaliser spreads them over every bit
+        std::uint64_t hashOf(std::uint64_t high, std::uint32_t low)
+        {
+            std::uint64_t hash = high ^ (static_cast<std::uint64_t>(low) * 0x9e3779b97f4a7c15ULL);
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        std::uint64_t powerOfTwoAtLeast(std::uint64_t n)
+        {
+            std::uint64_t power = 1;
+            while (power < n)
+            {
+                power <<= 1;
+            }
+            return power;
+        }
+
+        void prefetch(const void *p)
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(p);
+#else
+            (void) p;
+#endif
+        }
+    }
+
+    struct alignas(32) CRosterIndex::CBlock
+    {
+        std::uint32_t words[BLOCK_WORDS];
+    };
+
+    struct alignas(64) CRosterIndex::CBucket
+    {
+        std::uint64_t high[BUCKET_SLOTS];
+        std::uint32_t low[BUCKET_SLOTS];
+        std::uint32_t count;
+        std::uint32_t overflow;     // a key of this bucket went on to the next
+    };
+
+
+    CRosterIndex::CRosterIndex() : _blocks(1), _buckets(1), _riderIds(BUCKET_SLOTS), _blockMask(0), _bucketMask(0),
+                                   _size(0)
+    {
+        std::memset(_blocks.data(), 0, sizeof(CBlock));
+        std::memset(_buckets.data(), 0, sizeof(CBucket));
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Index every chip of the registry
+ **
+ ** The filter gets BITS_PER_CHIP bits a chip, under one in a hundred
+ ** unregistered chips get past it. The buckets are kept at most half
+ ** full so nearly every probe ends in the first one.
+ **
+ *****************************************************************************/
+
+    CRosterIndex::CRosterIndex(const std::map<std::vector<unsigned char>, std::int64_t> &chips) : _size(chips.size())
+    {
+        std::size_t epc96Count = 0;
+        for (const auto &chip : chips)
+        {
+            epc96Count += (EPC96_BYTES == chip.first.size());
+        }
+
+        _blocks.resize(powerOfTwoAtLeast((epc96Count * BITS_PER_CHIP + 255) / 256));
+        _buckets.resize(powerOfTwoAtLeast((2 * epc96Count + BUCKET_SLOTS - 1) / BUCKET_SLOTS));
+        _riderIds.assign(_buckets.size() * BUCKET_SLOTS, NOT_REGISTERED);
+        _blockMask = _blocks.size() - 1;
+        _bucketMask = _buckets.size() - 1;
+        std::memset(_blocks.data(), 0, _blocks.size() * sizeof(CBlock));
+        std::memset(_buckets.data(), 0, _buckets.size() * sizeof(CBucket));
+
+        for (const auto &chip : chips)
+        {
+            if (EPC96_BYTES != chip.first.size())
+            {
+                _others.insert(chip);
+                continue;
+            }
+
+            std::uint64_t high;
+            std::uint32_t low;
+            splitEpc96(chip.first.data(), high, low);
+            std::uint64_t hash = hashOf(high, low);
+
+            CBlock &block = _blocks[(hash >> 32) & _blockMask];
+            for (unsigned int i = 0; i < BLOCK_WORDS; i++)
+            {
+                block.words[i] |= 1u << ((static_cast<std::uint32_t>(hash) * SALTS[i]) >> 27);
+            }
+
+            std::uint64_t at = (hash >> 20) & _bucketMask;
+            while (BUCKET_SLOTS == _buckets[at].count)
+            {
+                _buckets[at].overflow = 1;
+                at = (at + 1) & _bucketMask;
+            }
+
+            CBucket &bucket = _buckets[at];
+            bucket.high[bucket.count] = high;
+            bucket.low[bucket.count] = low;
+            _riderIds[at * BUCKET_SLOTS + bucket.count] = chip.second;
+            bucket.count++;
+        }
+    }
+
+
+    CRosterIndex::~CRosterIndex()
+    {
+    }
+
+
+    std::int64_t CRosterIndex::find(const unsigned char *epc, std::size_t length) const
+    {
+        if (EPC96_BYTES != length)
+        {
+            auto chip = _others.find(std::vector<unsigned char>(epc, epc + length));
+            return (_others.end() != chip) ? chip->second : NOT_REGISTERED;
+        }
+
+        std::uint64_t high;
+        std::uint32_t low;
+        splitEpc96(epc, high, low);
+        std::uint64_t hash = hashOf(high, low);
+        return mayContain(hash) ? probe(hash, high, low) : NOT_REGISTERED;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Resolve the reads of a report to riders
+ **
+ ** In runs of RESOLVE_RUN reads: hash and filter them all, starting a
+ ** prefetch of the bucket of each that passes, then probe those. By
+ ** the time the first probe runs its bucket is on its way in.
+ **
+ *****************************************************************************/
+
+    std::size_t CRosterIndex::resolve(const CTagRecord *records, std::size_t count, std::int64_t *riderIds) const
+    {
+        std::uint64_t hashes[RESOLVE_RUN];
+        std::uint64_t highs[RESOLVE_RUN];
+        std::uint32_t lows[RESOLVE_RUN];
+        std::size_t candidates[RESOLVE_RUN];
+        std::size_t registered = 0;
+
+        for (std::size_t start = 0; start < count; start += RESOLVE_RUN)
+        {
+            std::size_t end = std::min(count, start + RESOLVE_RUN);
+            std::size_t candidateCount = 0;
+
+            for (std::size_t i = start; i < end; i++)
+            {
+                riderIds[i] = NOT_REGISTERED;
+                if (EPC96_BYTES != records[i].getEpcBytes())
+                {
+                    riderIds[i] = find(records[i].epc, records[i].getEpcBytes());
+                    registered += (NOT_REGISTERED != riderIds[i]);
+                    continue;
+                }
+
+                std::size_t k = i - start;
+                splitEpc96(records[i].epc, highs[k], lows[k]);
+                hashes[k] = hashOf(highs[k], lows[k]);
+                if (mayContain(hashes[k]))
+                {
+                    prefetch(&_buckets[(hashes[k] >> 20) & _bucketMask]);
+                    candidates[candidateCount++] = i;
+                }
+            }
+
+            for (std::size_t c = 0; c < candidateCount; c++)
+            {
+                std::size_t i = candidates[c];
+                std::size_t k = i - start;
+                riderIds[i] = probe(hashes[k], highs[k], lows[k]);
+                registered += (NOT_REGISTERED != riderIds[i]);
+            }
+        }
+        return registered;
+    }
+
+
+    bool CRosterIndex::mayContain(std::uint64_t hash) const
+    {
+        const CBlock &block = _blocks[(hash >> 32) & _blockMask];
+        std::uint32_t key = static_cast<std::uint32_t>(hash);
+        std::uint32_t missing = 0;
+
+        /* No early out, the eight words are tested side by side */
+        for (unsigned int i = 0; i < BLOCK_WORDS; i++)
+        {
+            missing |= ~block.words[i] & (1u << ((key * SALTS[i]) >> 27));
+        }
+        return 0 == missing;
+    }
+
+
+    std::int64_t CRosterIndex::probe(std::uint64_t hash, std::uint64_t high, std::uint32_t low) const
+    {
+        for (std::uint64_t at = (hash >> 20) & _bucketMask;; at = (at + 1) & _bucketMask)
+        {
+            const CBucket &bucket = _buckets[at];
+            unsigned int matches = 0;
+
+            /* Every slot compared, unused ones masked off after */
+            for (unsigned int i = 0; i < BUCKET_SLOTS; i++)
+            {
+                matches |= static_cast<unsigned int>((bucket.high[i] == high) & (bucket.low[i] == low)) << i;
+            }
+            matches &= (1u << bucket.count) - 1u;
+
+            if (0 != matches)
+            {
+                unsigned int slot = 0;
+                while (0 == (matches & (1u << slot)))
+                {
+                    slot++;
+                }
+                return _riderIds[at * BUCKET_SLOTS + slot];
+            }
+
+            if (0 == bucket.overflow)
+            {
+                return NOT_REGISTERED;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+//********************************************************************
+//    created:    2026-10-19 03:45 AM
+//    file:       crosterindex.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CROSTERINDEX_H
+#define LLRPLAPS_CROSTERINDEX_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace LLRPLaps
+{
+    struct CTagRecord;
+
+    /*
+     * A snapshot of the chip registry built for resolving the reads of
+     * a whole report at once, see CChipRegistry::getRoster().
+     *
+     * 96-bit EPCs are hashed once. A split block Bloom filter, eight
+     * 32-bit words a block and one bit set in each, turns away chips
+     * not registered after touching a single cache line. The rest are
+     * compared against a bucket of eight keys held as arrays, all
+     * eight at once with no branch per key. resolve() hashes and
+     * filters a run of reads first, prefetching the buckets of those
+     * that pass, then probes them, so the cache misses overlap.
+     *
+     * EPCs of other lengths are rare and go to a map.
+     *
+     * Immutable once built, safe to share between threads.
+     */
+    class CRosterIndex
+    {
+    public:
+        CRosterIndex();
+
+        explicit CRosterIndex(const std::map<std::vector<unsigned char>, std::int64_t> &chips);
+
+        ~CRosterIndex();
+
+        // The rider id the chip was registered with, NOT_REGISTERED if it was not
+        std::int64_t find(const unsigned char *epc, std::size_t length) const;
+
+        // riderIds[i] for records[i], NOT_REGISTERED if its chip is not. Returns the registered count
+        std::size_t resolve(const CTagRecord *records, std::size_t count, std::int64_t *riderIds) const;
+
+        std::size_t size() const { return _size; }
+
+        bool empty() const { return 0 == _size; }
+
+        // What find() and resolve() give for a chip not registered, one without a rider gives 0
+        const static std::int64_t NOT_REGISTERED;
+
+        const static std::size_t BITS_PER_CHIP;
+
+    private:
+        struct CBlock;
+        struct CBucket;
+
+        bool mayContain(std::uint64_t hash) const;
+
+        std::int64_t probe(std::uint64_t hash, std::uint64_t high, std::uint32_t low) const;
+
+        std::vector<CBlock> _blocks;
+        std::vector<CBucket> _buckets;
+        std::vector<std::int64_t> _riderIds;       // per bucket slot
+        std::uint64_t _blockMask;
+        std::uint64_t _bucketMask;
+        std::map<std::vector<unsigned char>, std::int64_t> _others;
+        std::size_t _size;
+    };
+}
+#endif //LLRPLAPS_CROSTERINDEX_H
@@ -0,0 +1,208 @@
+//********************************************************************
+//    created:    2026-10-18 09:00 PM
+//    file:       csessionexecutor.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "csessionexecutor.h"
+#include "clatencyrecorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#define LAPS_POLL WSAPoll
+#else
+#include <poll.h>
+#define LAPS_POLL poll
+#endif
+
+namespace LLRPLaps
+{
+    // Longest a poll sleeps, so stop() from another thread is seen promptly
+    const int CSessionExecutor::MAX_POLL_MS = 100;
+
+    namespace
+    {
+        const std::intptr_t NO_SOCKET = -1;
+    }
+
+    CSessionExecutor::CSessionExecutor() : _stopped(false)
+    {
+    }
+
+
+    void CSessionExecutor::CWait::await_suspend(std::coroutine_handle<> handle)
+    {
+        _handle = handle;
+        _executor._waits.push_back(this);
+    }
+
+
+    CSessionExecutor::CWait CSessionExecutor::readable(std::intptr_t socket, std::uint64_t deadlineNSec)
+    {
+        return CWait(*this, socket, POLLIN, deadlineNSec);
+    }
+
+
+    CSessionExecutor::CWait CSessionExecutor::writable(std::intptr_t socket, std::uint64_t deadlineNSec)
+    {
+        return CWait(*this, socket, POLLOUT, deadlineNSec);
+    }
+
+
+    CSessionExecutor::CWait CSessionExecutor::sleepUntil(std::uint64_t deadlineNSec)
+    {
+        return CWait(*this, NO_SOCKET, 0, deadlineNSec);
+    }
+
+
+    CSessionExecutor::CWait CSessionExecutor::sleepMS(unsigned int ms)
+    {
+        return sleepUntil(CLatencyRecorder::nowNSec() + static_cast<std::uint64_t>(ms) * 1000000u);
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start a top level task, it runs up to its first wait now
+ **
+ *****************************************************************************/
+
+    void CSessionExecutor::spawn(CTask<void> task)
+    {
+        task.start();
+        _tasks.push_back(std::move(task));
+        reapTasks();
+    }
+
+
+    void CSessionExecutor::run()
+    {
+        while (!isStopped() && runOnce(MAX_POLL_MS))
+        {
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  One poll over everything waited on, then resume whatever
+ **         became ready or ran out of time
+ **
+ ** @return     false once there are no tasks left
+ **
+ ** @throws     whatever escaped a finished top level task
+ **
+ *****************************************************************************/
+
+    bool CSessionExecutor::runOnce(int maxWaitMS)
+    {
+        if (_tasks.empty())
+        {
+            return false;
+        }
+
+        std::uint64_t now = CLatencyRecorder::nowNSec();
+        int timeoutMS = (maxWaitMS < 0 || maxWaitMS > MAX_POLL_MS) ? MAX_POLL_MS : maxWaitMS;
+        std::vector<struct pollfd> pfds;
+        std::vector<CWait *> polled;
+
+        for (CWait *wait : _waits)
+        {
+            if (0 != wait->_deadlineNSec)
+            {
+                int untilMS = (now >= wait->_deadlineNSec) ? 0
+                                                           : static_cast<int>((wait->_deadlineNSec - now + 999999u) / 1000000u);
+                timeoutMS = std::min(timeoutMS, untilMS);
+            }
+            if (NO_SOCKET != wait->_socket)
+            {
+                struct pollfd pfd;
+                pfd.fd = static_cast<decltype(pfd.fd)>(wait->_socket);
+                pfd.events = wait->_events;
+                pfd.revents = 0;
+                pfds.push_back(pfd);
+                polled.push_back(wait);
+            }
+        }
+
+        if (pfds.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMS));
+        }
+        else if (LAPS_POLL(pfds.data(), static_cast<unsigned int>(pfds.size()), timeoutMS) < 0 && EINTR != errno)
+        {
+            // Every socket waited on reads as ready, the receive tells each session what is wrong
+            for (auto &pfd : pfds)
+            {
+                pfd.revents = POLLERR;
+            }
+        }
+
+        for (std::size_t i = 0; i < polled.size(); i++)
+        {
+            polled[i]->_ready = 0 != pfds[i].revents;
+        }
+
+        /*
+         * Take the finished waits off the list before resuming any,
+         * a resumed coroutine usually waits again straight away.
+         */
+
+        now = CLatencyRecorder::nowNSec();
+        std::vector<std::coroutine_handle<>> resume;
+        auto keep = std::remove_if(_waits.begin(), _waits.end(), [&](CWait *wait) {
+            if (wait->_ready || (0 != wait->_deadlineNSec && now >= wait->_deadlineNSec))
+            {
+                resume.push_back(wait->_handle);
+                return true;
+            }
+            return false;
+        });
+        _waits.erase(keep, _waits.end());
+
+        for (auto handle : resume)
+        {
+            handle.resume();
+        }
+
+        reapTasks();
+        return !_tasks.empty();
+    }
+
+
+    void CSessionExecutor::reapTasks()
+    {
+        for (auto i = _tasks.begin(); i != _tasks.end();)
+        {
+            if (i->done())
+            {
+                CTask<void> finished = std::move(*i);
+                i = _tasks.erase(i);
+                finished.result();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+//********************************************************************
+//    created:    2026-10-18 09:00 PM
+//    file:       csessionexecutor.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CSESSIONEXECUTOR_H
+#define LLRPLAPS_CSESSIONEXECUTOR_H
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <vector>
+
+#include "ctask.h"
+
+namespace LLRPLaps
+{
+    /*
+     * Runs reader sessions on one thread. Coroutines wait for a
+     * socket to become readable or writable, or for a deadline, and
+     * the executor resumes them from a single poll() over every
+     * socket waited on. Nothing blocks, so one thread drives as many
+     * readers as it has sockets for.
+     *
+     * Everything except stop() must be called on the executor thread.
+     */
+    class CSessionExecutor
+    {
+    public:
+        class CWait
+        {
+        public:
+            CWait(CSessionExecutor &executor, std::intptr_t socket, short events, std::uint64_t deadlineNSec)
+                    : _executor(executor), _socket(socket), _events(events), _deadlineNSec(deadlineNSec), _ready(false)
+            {
+            }
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle);
+
+            // true if the socket is ready, false if the deadline passed first
+            bool await_resume() const noexcept { return _ready; }
+
+        private:
+            friend class CSessionExecutor;
+
+            CSessionExecutor &_executor;
+            std::intptr_t _socket;
+            short _events;
+            std::uint64_t _deadlineNSec;
+            bool _ready;
+            std::coroutine_handle<> _handle;
+        };
+
+        CSessionExecutor();
+
+        CSessionExecutor(const CSessionExecutor &) = delete;
+
+        CSessionExecutor &operator=(const CSessionExecutor &) = delete;
+
+        // deadlineNSec is CLatencyRecorder::nowNSec() based, 0 waits forever
+        CWait readable(std::intptr_t socket, std::uint64_t deadlineNSec);
+
+        CWait writable(std::intptr_t socket, std::uint64_t deadlineNSec);
+
+        CWait sleepUntil(std::uint64_t deadlineNSec);
+
+        CWait sleepMS(unsigned int ms);
+
+        void spawn(CTask<void> task);
+
+        void run();
+
+        bool runOnce(int maxWaitMS);
+
+        void stop() { _stopped.store(true, std::memory_order_release); }
+
+        bool isStopped() const { return _stopped.load(std::memory_order_acquire); }
+
+        std::size_t getTaskCount() const { return _tasks.size(); }
+
+        const static int MAX_POLL_MS;
+
+    private:
+        void reapTasks();
+
+        std::vector<CWait *> _waits;
+        std::vector<CTask<void>> _tasks;
+        std::atomic<bool> _stopped;
+    };
+}
+#endif //LLRPLAPS_CSESSIONEXECUTOR_H
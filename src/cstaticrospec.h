@@ -0,0 +1,182 @@
+//********************************************************************
+//    created:    2026-10-18 02:45 PM
+//    file:       cstaticrospec.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CSTATICROSPEC_H
+#define LLRPLAPS_CSTATICROSPEC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "crospecconfig.h"
+
+namespace LLRPLaps
+{
+    /*
+     * Big endian LLRP encoding into a fixed size array, usable in
+     * constant expressions.
+     */
+    template <std::size_t N>
+    class CConstFrameWriter
+    {
+    public:
+        constexpr CConstFrameWriter() : _bytes(), _pos(0)
+        {
+        }
+
+        constexpr void u8(std::uint32_t value) { _bytes[_pos++] = static_cast<unsigned char>(value & 0xffu); }
+
+        constexpr void u16(std::uint32_t value) { u8(value >> 8); u8(value); }
+
+        constexpr void u32(std::uint32_t value) { u16(value >> 16); u16(value); }
+
+        // Rsvd(3) Ver(3)=1 Type(10), Length(32), MessageID(32)
+        constexpr void messageHeader(std::uint32_t type, std::uint32_t messageId) { u16((1u << 10) | type); u32(N); u32(messageId); }
+
+        constexpr void tlvHeader(std::uint32_t type, std::uint32_t length) { u16(type); u16(length); }
+
+        constexpr std::size_t size() const { return _pos; }
+
+        constexpr const std::array<unsigned char, N> &bytes() const { return _bytes; }
+
+    private:
+        std::array<unsigned char, N> _bytes;
+        std::size_t _pos;
+    };
+
+
+    /*
+     * The commands for a fixed ROSpec, encoded at compile time.
+     *
+     * Covers the common case of CROSpecConfig: one antenna (0 for
+     * all), a Gen2 inventory of AIDurationMS, a report every ReportN
+     * tags (0 = end of ROSpec) with antenna and first seen time.
+     * CReader uses these without touching LTK; anything else goes
+     * through CCommandFrames::build at run time.
+     *
+     * Message IDs are encoded as 0, CCommandFrame patches them.
+     */
+    template <std::uint32_t ROSpecID, std::uint32_t AIDurationMS, std::uint16_t ReportN = 0, std::uint16_t AntennaID = 0>
+    class CStaticROSpec
+    {
+        static_assert(0 != ROSpecID, "ROSpecID 0 means all ROSpecs");
+        static_assert(0 != AIDurationMS, "AISpec needs a duration");
+
+        enum : std::uint32_t
+        {
+            // Message types
+            SET_READER_CONFIG = 3, ADD_ROSPEC = 20, DELETE_ROSPEC = 21, START_ROSPEC = 22, ENABLE_ROSPEC = 24,
+
+            // Parameter types
+            ROSPEC = 177, RO_BOUNDARY_SPEC = 178, ROSPEC_START_TRIGGER = 179, ROSPEC_STOP_TRIGGER = 182, AISPEC = 183,
+            AISPEC_STOP_TRIGGER = 184, INVENTORY_PARAMETER_SPEC = 186, RO_REPORT_SPEC = 237, TAG_REPORT_CONTENT_SELECTOR = 238,
+
+            // Parameter sizes
+            START_TRIGGER_SIZE = 4 + 1, STOP_TRIGGER_SIZE = 4 + 1 + 4, BOUNDARY_SIZE = 4 + START_TRIGGER_SIZE + STOP_TRIGGER_SIZE,
+            AI_STOP_TRIGGER_SIZE = 4 + 1 + 4, INVENTORY_SIZE = 4 + 2 + 1,
+            AISPEC_SIZE = 4 + 2 + 2 + AI_STOP_TRIGGER_SIZE + INVENTORY_SIZE,
+            SELECTOR_SIZE = 4 + 2, REPORT_SPEC_SIZE = 4 + 1 + 2 + SELECTOR_SIZE,
+            ROSPEC_SIZE = 4 + 4 + 1 + 1 + BOUNDARY_SIZE + AISPEC_SIZE + REPORT_SPEC_SIZE
+        };
+
+        static constexpr std::uint32_t INVENTORY_PARAMETER_SPEC_ID = 1234;
+
+        static constexpr std::array<unsigned char, 14> roSpecIdCommand(std::uint32_t type, std::uint32_t roSpecId)
+        {
+            CConstFrameWriter<14> w;
+            w.messageHeader(type, 0);
+            w.u32(roSpecId);
+            return w.bytes();
+        }
+
+        static constexpr std::array<unsigned char, 10 + ROSPEC_SIZE> encodeAddROSpec()
+        {
+            CConstFrameWriter<10 + ROSPEC_SIZE> w;
+            w.messageHeader(ADD_ROSPEC, 0);
+
+            w.tlvHeader(ROSPEC, ROSPEC_SIZE);
+            w.u32(ROSpecID);
+            w.u8(0);                                    // Priority
+            w.u8(0);                                    // CurrentState Disabled
+
+            w.tlvHeader(RO_BOUNDARY_SPEC, BOUNDARY_SIZE);
+            w.tlvHeader(ROSPEC_START_TRIGGER, START_TRIGGER_SIZE);
+            w.u8(0);                                    // Null, wait for START_ROSPEC
+            w.tlvHeader(ROSPEC_STOP_TRIGGER, STOP_TRIGGER_SIZE);
+            w.u8(0);                                    // Null
+            w.u32(0);                                   // DurationTriggerValue n/a
+
+            w.tlvHeader(AISPEC, AISPEC_SIZE);
+            w.u16(1);                                   // AntennaIDs count
+            w.u16(AntennaID);
+            w.tlvHeader(AISPEC_STOP_TRIGGER, AI_STOP_TRIGGER_SIZE);
+            w.u8(1);                                    // Duration
+            w.u32(AIDurationMS);
+            w.tlvHeader(INVENTORY_PARAMETER_SPEC, INVENTORY_SIZE);
+            w.u16(INVENTORY_PARAMETER_SPEC_ID);
+            w.u8(1);                                    // EPCGlobalClass1Gen2
+
+            w.tlvHeader(RO_REPORT_SPEC, REPORT_SPEC_SIZE);
+            w.u8(2);                                    // Upon_N_Tags_Or_End_Of_ROSpec
+            w.u16(ReportN);
+            w.tlvHeader(TAG_REPORT_CONTENT_SELECTOR, SELECTOR_SIZE);
+            w.u16((1u << 12) | (1u << 9));              // EnableAntennaID, EnableFirstSeenTimestamp
+            return w.bytes();
+        }
+
+        static constexpr std::array<unsigned char, 11> encodeResetToFactoryDefaults()
+        {
+            CConstFrameWriter<11> w;
+            w.messageHeader(SET_READER_CONFIG, 0);
+            w.u8(0x80);                                 // ResetToFactoryDefault
+            return w.bytes();
+        }
+
+    public:
+        static constexpr std::array<unsigned char, 10 + ROSPEC_SIZE> ADD = encodeAddROSpec();
+        static constexpr std::array<unsigned char, 14> ENABLE = roSpecIdCommand(ENABLE_ROSPEC, ROSpecID);
+        static constexpr std::array<unsigned char, 14> START = roSpecIdCommand(START_ROSPEC, ROSpecID);
+        static constexpr std::array<unsigned char, 14> DELETE_ALL = roSpecIdCommand(DELETE_ROSPEC, 0);
+        static constexpr std::array<unsigned char, 11> RESET = encodeResetToFactoryDefaults();
+
+        // The CROSpecConfig these frames are equivalent to
+        static CROSpecConfig config()
+        {
+            CROSpecConfig config;
+            config.roSpecId = ROSpecID;
+            config.priority = 0;
+            config.aiDurationMS = AIDurationMS;
+            config.antennaIds.assign(1, AntennaID);
+            config.inventoryParameterSpecId = INVENTORY_PARAMETER_SPEC_ID;
+            config.reportN = ReportN;
+            config.enableAntennaId = true;
+            config.enableChannelIndex = false;
+            config.enablePeakRSSI = false;
+            config.enableFirstSeenTimestamp = true;
+            config.enableLastSeenTimestamp = false;
+            config.enableTagSeenCount = false;
+            return config;
+        }
+    };
+
+
+    // What CReader has always used: ROSpec 123, 500ms of inventory on all antennas
+    typedef CStaticROSpec<123, 500> CDefaultROSpec;
+}
+#endif //LLRPLAPS_CSTATICROSPEC_H
@@ -0,0 +1,242 @@
+//********************************************************************
+//    created:    2026-10-18 11:55 PM
+//    file:       ctagdispatcher.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+
+#include <QMetaObject>
+#include <QThread>
+
+#include "ctagdispatcher.h"
+
+namespace LLRPLaps
+{
+    const std::size_t CTagDispatcher::DEFAULT_CAPACITY = 4096;
+
+    CTagStage::CTagStage(const QString &name, std::size_t capacity, OverloadPolicy policy, QObject *parent)
+            : QObject(parent), _name(name), _capacity(std::max<std::size_t>(capacity, 1)), _policy(policy),
+              _indexed(false), _drainPending(false), _counters()
+    {
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Queue a read for the consumer, or apply the overload policy
+ **
+ ** Waiting for room on the stage's own thread would wait forever,
+ ** there the waiting reads are handed out in place instead.
+ **
+ *****************************************************************************/
+
+    bool CTagStage::offer(const CTagInfo &tagInfo, bool shedding)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _counters.offered++;
+
+        if (shedding && (Shed == _policy))
+        {
+            _counters.shed++;
+            return false;
+        }
+
+        bool waited = false;
+        while (_queue.size() >= _capacity)
+        {
+            if ((Block != _policy) && coalesce(tagInfo))
+            {
+                _counters.coalesced++;
+                return false;
+            }
+
+            if (Shed == _policy)
+            {
+                _counters.dropped++;
+                return false;
+            }
+
+            if (!waited)
+            {
+                _counters.blocked++;
+                waited = true;
+            }
+
+            if (QThread::currentThread() == thread())
+            {
+                lock.unlock();
+                drain();
+                lock.lock();
+                continue;
+            }
+
+            _notFull.wait(lock, [this]
+            { return _queue.size() < _capacity; });
+        }
+
+        _queue.push_back(tagInfo);
+        if (_indexed)
+        {
+            _queuedEpcs[tagInfo.data] = _queue.size() - 1;
+        }
+        _counters.maxDepth = std::max(_counters.maxDepth, _queue.size());
+
+        bool post = !_drainPending;
+        _drainPending = true;
+        lock.unlock();
+
+        if (post)
+        {
+            QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+        }
+        return true;
+    }
+
+
+    bool CTagStage::coalesce(const CTagInfo &tagInfo)
+    {
+        /* Below capacity nobody looks for duplicates, index the queue the first time it fills */
+        if (!_indexed)
+        {
+            for (std::size_t i = 0; i < _queue.size(); i++)
+            {
+                _queuedEpcs[_queue[i].data] = i;
+            }
+            _indexed = true;
+        }
+
+        auto queued = _queuedEpcs.find(tagInfo.data);
+        if (_queuedEpcs.end() == queued)
+        {
+            return false;
+        }
+
+        _queue[queued->second] = tagInfo;
+        return true;
+    }
+
+
+    bool CTagStage::isFull() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _queue.size() >= _capacity;
+    }
+
+
+    CTagStage::Counters CTagStage::getCounters() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        Counters counters = _counters;
+        counters.depth = _queue.size();
+        return counters;
+    }
+
+
+    void CTagStage::drain()
+    {
+        std::vector<CTagInfo> batch;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _drainPending = false;
+            batch.swap(_queue);
+            _queuedEpcs.clear();
+            _indexed = false;
+        }
+        _notFull.notify_all();
+
+        for (const CTagInfo &tagInfo : batch)
+        {
+            emit newTag(tagInfo);
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _counters.delivered += batch.size();
+
+        /* Hand the memory back for the next batch */
+        if (_queue.empty())
+        {
+            batch.clear();
+            _queue.swap(batch);
+        }
+    }
+
+
+    CTagDispatcher::CTagDispatcher(QObject *parent) : QObject(parent)
+    {
+    }
+
+
+    CTagDispatcher::~CTagDispatcher()
+    {
+        /* Stages live in their consumers' threads, those must be done with them by now */
+        for (CTagStage *stage : _stages)
+        {
+            delete stage;
+        }
+    }
+
+
+    CTagStage *CTagDispatcher::addStage(const QString &name, std::size_t capacity, CTagStage::OverloadPolicy policy,
+                                        QObject *consumer)
+    {
+        auto stage = new CTagStage(name, capacity, policy);
+        stage->moveToThread(consumer->thread());
+        _stages.push_back(stage);
+        return stage;
+    }
+
+
+    void CTagDispatcher::onNewTag(const LLRPLaps::CTagInfo &tagInfo)
+    {
+        bool shedding = false;
+        for (CTagStage *stage : _stages)
+        {
+            if ((CTagStage::Shed != stage->getPolicy()) && stage->isFull())
+            {
+                shedding = true;
+                break;
+            }
+        }
+
+        for (CTagStage *stage : _stages)
+        {
+            stage->offer(tagInfo, shedding);
+        }
+    }
+
+
+    QString CTagDispatcher::report() const
+    {
+        QString report;
+        for (const CTagStage *stage : _stages)
+        {
+            CTagStage::Counters counters = stage->getCounters();
+            report += QString("%1: offered %2 delivered %3 coalesced %4 dropped %5 shed %6 blocked %7 depth %8/%9 max %10\n")
+                    .arg(stage->getName())
+                    .arg(counters.offered)
+                    .arg(counters.delivered)
+                    .arg(counters.coalesced)
+                    .arg(counters.dropped)
+                    .arg(counters.shed)
+                    .arg(counters.blocked)
+                    .arg(counters.depth)
+                    .arg(stage->getCapacity())
+                    .arg(counters.maxDepth);
+        }
+        return report;
+    }
+}
@@ -0,0 +1,153 @@
+//********************************************************************
+//    created:    2026-10-18 11:55 PM
+//    file:       ctagdispatcher.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CTAGDISPATCHER_H
+#define LLRPLAPS_CTAGDISPATCHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    /*
+     * A bounded queue of tag reads in front of one consumer.
+     *
+     * Reads are offered from the reader's thread and handed out by
+     * the newTag signal on the thread the stage lives in, the
+     * consumer's, in batches: one queued call drains whatever has
+     * built up. Once capacity reads are waiting the policy decides:
+     *
+     *   Block     the reader waits for room. Nothing is lost, the
+     *             reader's socket backs up instead. For the lap
+     *             counter.
+     *   Coalesce  a read replaces the waiting read of the same EPC,
+     *             the reader waits if there is none. Every chip gets
+     *             through, not every read. For output sinks.
+     *   Shed      as Coalesce, but a read with nothing to replace is
+     *             dropped. Also drops everything while another stage
+     *             is full. For the display.
+     */
+    class CTagStage : public QObject
+    {
+    Q_OBJECT
+    public:
+        enum OverloadPolicy
+        {
+            Block,
+            Coalesce,
+            Shed
+        };
+        Q_ENUM(OverloadPolicy)
+
+        struct Counters
+        {
+            std::uint64_t offered;
+            std::uint64_t delivered;
+            std::uint64_t coalesced;        // replaced a waiting read of the same EPC
+            std::uint64_t dropped;          // Shed stage full, nothing to replace
+            std::uint64_t shed;             // dropped while another stage was full
+            std::uint64_t blocked;          // times the reader had to wait for room
+            std::size_t depth;
+            std::size_t maxDepth;
+        };
+
+        CTagStage(const QString &name, std::size_t capacity, OverloadPolicy policy, QObject *parent = nullptr);
+
+        const QString &getName() const { return _name; }
+
+        OverloadPolicy getPolicy() const { return _policy; }
+
+        std::size_t getCapacity() const { return _capacity; }
+
+        // Any thread. false if the read was coalesced, dropped or shed
+        bool offer(const CTagInfo &tagInfo, bool shedding);
+
+        bool isFull() const;
+
+        Counters getCounters() const;
+
+    signals:
+
+        void newTag(const LLRPLaps::CTagInfo &);
+
+    private slots:
+
+        void drain();
+
+    private:
+        bool coalesce(const CTagInfo &tagInfo);
+
+        QString _name;
+        std::size_t _capacity;
+        OverloadPolicy _policy;
+        mutable std::mutex _lock;
+        std::condition_variable _notFull;
+        std::vector<CTagInfo> _queue;
+        std::map<std::vector<unsigned char>, std::size_t> _queuedEpcs;     // built once the queue is full
+        bool _indexed;
+        bool _drainPending;
+        Counters _counters;
+    };
+
+
+    /*
+     * Fans the reads of one or more readers out to bounded stages.
+     * Connect CReader::newTag to onNewTag directly, the consumers to
+     * the stages addStage() returns.
+     *
+     * While a Block or Coalesce stage is full, Shed stages drop every
+     * read, taking the load of the display off a pipeline that is
+     * falling behind.
+     */
+    class CTagDispatcher : public QObject
+    {
+    Q_OBJECT
+    public:
+        explicit CTagDispatcher(QObject *parent = nullptr);
+
+        ~CTagDispatcher() override;
+
+        // Lives in the consumer's thread, add every stage before the first read
+        CTagStage *addStage(const QString &name, std::size_t capacity, CTagStage::OverloadPolicy policy,
+                            QObject *consumer);
+
+        const std::vector<CTagStage *> &getStages() const { return _stages; }
+
+        // One line of counters per stage
+        QString report() const;
+
+        const static std::size_t DEFAULT_CAPACITY;
+
+    public slots:
+
+        void onNewTag(const LLRPLaps::CTagInfo &tagInfo);
+
+    private:
+        std::vector<CTagStage *> _stages;
+    };
+}
+#endif //LLRPLAPS_CTAGDISPATCHER_H
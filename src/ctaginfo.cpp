@@ -17,10 +17,14 @@
 //*********************************************************************
 
 #include "ctaginfo.h"
+#include "crosterindex.h"
 
 namespace LLRPLaps
 {
-    CTagInfo::CTagInfo(void) : _timeStampUSec(0LL), AntennaId(0)
+    const std::uint32_t CTagInfo::NO_EPC_ID = 0xFFFFFFFF;
+
+    CTagInfo::CTagInfo(void) : AntennaId(0), _timeStampUSec(0LL), _hostReceivedNSec(0LL), _epcId(NO_EPC_ID),
+                               _riderId(CRosterIndex::NOT_REGISTERED), _peakRSSI(0)
     {
         data.clear();
     }
@@ -30,6 +34,10 @@ namespace LLRPLaps
     {
         data.clear();
         _timeStampUSec = 0;
+        _hostReceivedNSec = 0;
+        _epcId = NO_EPC_ID;
+        _riderId = CRosterIndex::NOT_REGISTERED;
+        _peakRSSI = 0;
         AntennaId = 0;
     }
 
@@ -40,10 +40,36 @@ namespace LLRPLaps
 
         void setTimeStampUSec(u_int64_t timeStampUSec) { _timeStampUSec = timeStampUSec; }
 
+        // Host monotonic time (CLatencyRecorder::nowNSec) the frame carrying this tag was read
+        u_int64_t getHostReceivedNSec() const { return _hostReceivedNSec; }
+
+        void setHostReceivedNSec(u_int64_t hostReceivedNSec) { _hostReceivedNSec = hostReceivedNSec; }
+
+        // Dense id of data from the reader's CEpcInterner, NO_EPC_ID when it has none
+        std::uint32_t getEpcId() const { return _epcId; }
+
+        void setEpcId(std::uint32_t epcId) { _epcId = epcId; }
+
+        // dBm, 0 when the reader did not report it
+        std::int8_t getPeakRSSI() const { return _peakRSSI; }
+
+        void setPeakRSSI(std::int8_t peakRSSI) { _peakRSSI = peakRSSI; }
+
+        // Rider of the chip in the reader's CChipRegistry, CRosterIndex::NOT_REGISTERED when not known
+        std::int64_t getRiderId() const { return _riderId; }
+
+        void setRiderId(std::int64_t riderId) { _riderId = riderId; }
+
+        const static std::uint32_t NO_EPC_ID;
+
         std::vector<unsigned char> data;
 
     private:
         u_int64_t _timeStampUSec;
+        u_int64_t _hostReceivedNSec;
+        std::uint32_t _epcId;
+        std::int64_t _riderId;
+        std::int8_t _peakRSSI;
     };
 }
 #endif //LLRPLAPS_CTAGINFO_H
@@ -0,0 +1,178 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ctagjournal.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "ctagjournal.h"
+#include "ctaginfo.h"
+#include "clatencyrecorder.h"
+
+namespace LLRPLaps
+{
+    const char CTagJournal::MAGIC[8] = { 'L', 'A', 'P', 'S', 'J', 'R', 'N', '\0' };
+    const std::uint32_t CTagJournal::VERSION = 1;
+    const unsigned int CTagJournal::HEADER_SIZE = 16;
+    const unsigned int CTagJournal::RECORD_HEADER_SIZE = 10;
+    const std::uint64_t CTagJournal::DEFAULT_FLUSH_INTERVAL_NSEC = 20000000ULL;
+
+    namespace
+    {
+        const std::size_t WRITE_BUFFER_SIZE = 64u * 1024u;
+
+        // An EPC is at most 496 bits, longer data would not fit the length byte anyway
+        const std::size_t MAX_EPC_BYTES = 255;
+
+        void putU32(unsigned char *p, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void putU64(unsigned char *p, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                p[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+    }
+
+    CTagJournal::CTagJournal() : _file(nullptr), _offset(0), _recordCount(0),
+                                 _flushIntervalNSec(DEFAULT_FLUSH_INTERVAL_NSEC), _lastFlushNSec(0)
+    {
+    }
+
+
+    CTagJournal::~CTagJournal()
+    {
+        close();
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Start a journal, or carry on with one after a restart
+ **
+ ** Carrying on, validSize is where CTagJournalReader found the last
+ ** whole record. Anything after it is a record torn by the crash and
+ ** is cut off before appending.
+ **
+ *****************************************************************************/
+
+    bool CTagJournal::open(const std::string &path, std::uint64_t recordCount, std::uint64_t validSize)
+    {
+        close();
+
+        if (0 == validSize)
+        {
+            _file = std::fopen(path.c_str(), "wb");
+            if (nullptr == _file)
+            {
+                return false;
+            }
+
+            unsigned char header[HEADER_SIZE];
+            std::copy(MAGIC, MAGIC + sizeof MAGIC, header);
+            putU32(header + 8, VERSION);
+            putU32(header + 12, 0);
+            std::fwrite(header, 1, sizeof header, _file);
+
+            _offset = HEADER_SIZE;
+            _recordCount = 0;
+        }
+        else
+        {
+            std::error_code error;
+            std::filesystem::resize_file(path, validSize, error);
+            if (error)
+            {
+                return false;
+            }
+
+            _file = std::fopen(path.c_str(), "ab");
+            if (nullptr == _file)
+            {
+                return false;
+            }
+
+            _offset = validSize;
+            _recordCount = recordCount;
+        }
+
+        std::setvbuf(_file, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+        std::fflush(_file);
+        _lastFlushNSec = CLatencyRecorder::nowNSec();
+        return true;
+    }
+
+
+    void CTagJournal::close()
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        std::fclose(_file);
+        _file = nullptr;
+    }
+
+
+    void CTagJournal::append(const CTagInfo &tagInfo)
+    {
+        if (nullptr == _file)
+        {
+            return;
+        }
+
+        std::size_t epcLength = std::min(tagInfo.data.size(), MAX_EPC_BYTES);
+
+        unsigned char recordHeader[RECORD_HEADER_SIZE];
+        putU64(recordHeader, tagInfo.getTimeStampUSec());
+        recordHeader[8] = static_cast<unsigned char>(tagInfo.AntennaId);
+        recordHeader[9] = static_cast<unsigned char>(epcLength);
+
+        std::fwrite(recordHeader, 1, sizeof recordHeader, _file);
+        std::fwrite(tagInfo.data.data(), 1, epcLength, _file);
+
+        _offset += RECORD_HEADER_SIZE + epcLength;
+        _recordCount++;
+
+        std::uint64_t nowNSec = CLatencyRecorder::nowNSec();
+        if (nowNSec - _lastFlushNSec >= _flushIntervalNSec)
+        {
+            std::fflush(_file);
+            _lastFlushNSec = nowNSec;
+        }
+    }
+
+
+    void CTagJournal::flush()
+    {
+        if (nullptr != _file)
+        {
+            std::fflush(_file);
+            _lastFlushNSec = CLatencyRecorder::nowNSec();
+        }
+    }
+}
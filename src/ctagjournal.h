@@ -0,0 +1,83 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ctagjournal.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CTAGJOURNAL_H
+#define LLRPLAPS_CTAGJOURNAL_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace LLRPLaps
+{
+    class CTagInfo;
+
+    /*
+     * Every tag read the lap counter has been given, in order, so a
+     * restart can replay what came after the last snapshot. All
+     * integers are little endian.
+     *
+     *  header   "LAPSJRN\0", u32 version, u32 reserved
+     *  record   u64 reader timestamp us, u8 antenna, u8 EPC length,
+     *           EPC bytes
+     *
+     * Writes are buffered and flushed every flush interval, a crash
+     * loses at most that much. A torn final record is dropped by
+     * CTagJournalReader.
+     */
+    class CTagJournal
+    {
+    public:
+        CTagJournal();
+
+        ~CTagJournal();
+
+        // validSize 0 starts a new journal, else the journal is cut to validSize and appended to
+        bool open(const std::string &path, std::uint64_t recordCount = 0, std::uint64_t validSize = 0);
+
+        void close();
+
+        bool isOpen() const { return nullptr != _file; }
+
+        void append(const CTagInfo &tagInfo);
+
+        void flush();
+
+        std::uint64_t getRecordCount() const { return _recordCount; }
+
+        // Where the next record goes, what a snapshot replays from
+        std::uint64_t getOffset() const { return _offset; }
+
+        void setFlushIntervalNSec(std::uint64_t intervalNSec) { _flushIntervalNSec = intervalNSec; }
+
+        static const char MAGIC[8];
+        static const std::uint32_t VERSION;
+        static const unsigned int HEADER_SIZE;
+        static const unsigned int RECORD_HEADER_SIZE;
+        static const std::uint64_t DEFAULT_FLUSH_INTERVAL_NSEC;
+
+    private:
+        std::FILE *_file;
+        std::uint64_t _offset;
+        std::uint64_t _recordCount;
+        std::uint64_t _flushIntervalNSec;
+        std::uint64_t _lastFlushNSec;
+    };
+}
+#endif //LLRPLAPS_CTAGJOURNAL_H
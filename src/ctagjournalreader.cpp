@@ -0,0 +1,146 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ctagjournalreader.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "ctagjournalreader.h"
+#include "ctagjournal.h"
+#include "ctaginfo.h"
+
+#include <cstring>
+
+namespace LLRPLaps
+{
+    namespace
+    {
+        std::uint32_t getU32(const unsigned char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        std::uint64_t getU64(const unsigned char *p)
+        {
+            std::uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+    }
+
+    CTagJournalReader::CTagJournalReader() : _data(nullptr), _size(0)
+    {
+    }
+
+
+    CTagJournalReader::~CTagJournalReader()
+    {
+        close();
+    }
+
+
+    void CTagJournalReader::close()
+    {
+        if (nullptr != _data)
+        {
+            _file.unmap(const_cast<uchar *>(_data));
+        }
+        _file.close();
+        _data = nullptr;
+        _size = 0;
+    }
+
+
+    bool CTagJournalReader::open(const QString &path)
+    {
+        close();
+
+        _file.setFileName(path);
+        if (!_file.open(QIODevice::ReadOnly))
+        {
+            _errorString = _file.errorString();
+            return false;
+        }
+
+        _size = static_cast<std::uint64_t>(_file.size());
+        if (_size < CTagJournal::HEADER_SIZE)
+        {
+            _errorString = "Not a tag journal: too short";
+            close();
+            return false;
+        }
+
+        _data = _file.map(0, _file.size());
+        if (nullptr == _data)
+        {
+            _errorString = _file.errorString();
+            close();
+            return false;
+        }
+
+        if (0 != std::memcmp(_data, CTagJournal::MAGIC, sizeof CTagJournal::MAGIC) ||
+            CTagJournal::VERSION != getU32(_data + 8))
+        {
+            _errorString = "Not a tag journal: bad header";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+
+    bool CTagJournalReader::next(std::uint64_t &offset, CTagInfo &tagInfo) const
+    {
+        if (offset < CTagJournal::HEADER_SIZE)
+        {
+            return false;
+        }
+        return parseRecord(_data, _size, offset, tagInfo);
+    }
+
+
+    bool CTagJournalReader::parseRecord(const unsigned char *data, std::uint64_t size, std::uint64_t &offset,
+                                        CTagInfo &tagInfo)
+    {
+        if (offset + CTagJournal::RECORD_HEADER_SIZE > size)
+        {
+            return false;
+        }
+
+        const unsigned char *record = data + offset;
+        unsigned int epcLength = record[9];
+        if (offset + CTagJournal::RECORD_HEADER_SIZE + epcLength > size)
+        {
+            // Torn final record, the process died mid write
+            return false;
+        }
+
+        tagInfo.clear();
+        tagInfo.setTimeStampUSec(getU64(record));
+        tagInfo.AntennaId = record[8];
+        tagInfo.data.assign(record + CTagJournal::RECORD_HEADER_SIZE,
+                            record + CTagJournal::RECORD_HEADER_SIZE + epcLength);
+
+        offset += CTagJournal::RECORD_HEADER_SIZE + epcLength;
+        return true;
+    }
+}
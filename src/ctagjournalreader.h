@@ -0,0 +1,65 @@
+//********************************************************************
+//    created:    2026-10-19 12:20 AM
+//    file:       ctagjournalreader.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CTAGJOURNALREADER_H
+#define LLRPLAPS_CTAGJOURNALREADER_H
+
+#include <cstdint>
+
+#include <QFile>
+#include <QString>
+
+namespace LLRPLaps
+{
+    class CTagInfo;
+
+    /*
+     * Memory mapped view of a CTagJournal file, walked forward from
+     * any record boundary, such as the one a snapshot was taken at.
+     */
+    class CTagJournalReader
+    {
+    public:
+        CTagJournalReader();
+
+        ~CTagJournalReader();
+
+        bool open(const QString &path);
+
+        void close();
+
+        const QString &getErrorString() const { return _errorString; }
+
+        std::uint64_t getSize() const { return _size; }
+
+        // Reads the record at offset and moves offset past it. false at the end or at a torn record
+        bool next(std::uint64_t &offset, CTagInfo &tagInfo) const;
+
+        // As next(), over size bytes of journal records, offset relative to data
+        static bool parseRecord(const unsigned char *data, std::uint64_t size, std::uint64_t &offset,
+                                CTagInfo &tagInfo);
+
+    private:
+        QFile _file;
+        const unsigned char *_data;
+        std::uint64_t _size;
+        QString _errorString;
+    };
+}
+#endif //LLRPLAPS_CTAGJOURNALREADER_H
@@ -0,0 +1,194 @@
+//********************************************************************
+//    created:    2026-10-18 09:00 PM
+//    file:       ctask.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CTASK_H
+#define LLRPLAPS_CTASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace LLRPLaps
+{
+    template <class T>
+    class CTask;
+
+    namespace Detail
+    {
+        /*
+         * When a task finishes, resume whoever co_awaited it, or
+         * nobody for a task the executor started.
+         */
+        struct CFinalAwaiter
+        {
+            std::coroutine_handle<> continuation;
+
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<>) const noexcept
+            {
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        struct CPromiseBase
+        {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            CFinalAwaiter final_suspend() const noexcept { return CFinalAwaiter{continuation}; }
+
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        template <class T>
+        struct CPromise : CPromiseBase
+        {
+            std::optional<T> value;
+
+            CTask<T> get_return_object();
+
+            void return_value(T result) { value.emplace(std::move(result)); }
+
+            T take()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct CPromise<void> : CPromiseBase
+        {
+            CTask<void> get_return_object();
+
+            void return_void()
+            {
+            }
+
+            void take()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+        };
+    }
+
+
+    /*
+     * A lazily started coroutine returning T. co_await on it runs it
+     * until it suspends on I/O, and the awaiting coroutine carries on
+     * with the result once it is done. Control passes straight from
+     * one to the other, so deep chains of tasks do not grow the stack.
+     *
+     * Top level tasks are handed to CSessionExecutor::spawn().
+     */
+    template <class T = void>
+    class CTask
+    {
+    public:
+        typedef Detail::CPromise<T> promise_type;
+
+        CTask() = default;
+
+        explicit CTask(std::coroutine_handle<promise_type> handle) : _handle(handle)
+        {
+        }
+
+        CTask(CTask &&other) noexcept : _handle(std::exchange(other._handle, nullptr))
+        {
+        }
+
+        CTask &operator=(CTask &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                _handle = std::exchange(other._handle, nullptr);
+            }
+            return *this;
+        }
+
+        CTask(const CTask &) = delete;
+
+        CTask &operator=(const CTask &) = delete;
+
+        ~CTask() { reset(); }
+
+        bool valid() const { return static_cast<bool>(_handle); }
+
+        bool done() const { return _handle && _handle.done(); }
+
+        // Run a top level task up to its first suspension
+        void start() { _handle.resume(); }
+
+        // Result of a finished top level task, rethrows what escaped it
+        T result() { return _handle.promise().take(); }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            _handle.promise().continuation = awaiting;
+            return _handle;
+        }
+
+        T await_resume() { return _handle.promise().take(); }
+
+    private:
+        void reset()
+        {
+            if (_handle)
+            {
+                _handle.destroy();
+                _handle = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> _handle;
+    };
+
+
+    namespace Detail
+    {
+        template <class T>
+        CTask<T> CPromise<T>::get_return_object()
+        {
+            return CTask<T>(std::coroutine_handle<CPromise<T>>::from_promise(*this));
+        }
+
+        inline CTask<void> CPromise<void>::get_return_object()
+        {
+            return CTask<void>(std::coroutine_handle<CPromise<void>>::from_promise(*this));
+        }
+    }
+}
+#endif //LLRPLAPS_CTASK_H
@@ -0,0 +1,320 @@
+//********************************************************************
+//    created:    2026-10-18 10:15 PM
+//    file:       ctimingwheel.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+#include "ctimingwheel.h"
+
+namespace LLRPLaps
+{
+    // Fine enough for lap timing events, coarse enough that a
+    // second of wheel time is only 100 ticks
+    const std::uint64_t CTimingWheel::DEFAULT_TICK_USEC = 10000;
+
+    namespace
+    {
+        const unsigned int LEVELS = 4;
+        const unsigned int SLOT_BITS = 8;
+        const unsigned int SLOTS = 1u << SLOT_BITS;
+        const std::uint64_t SLOT_MASK = SLOTS - 1;
+
+        const std::int32_t NIL = -1;
+        const std::int32_t FREE = -1;
+        const std::int32_t UNPLACED = -2;
+
+        // Further out than the top level reaches, park in its last slot and place again on the way down
+        const std::uint64_t MAX_DELTA_TICKS = (1ull << (SLOT_BITS * LEVELS)) - (1ull << (SLOT_BITS * (LEVELS - 1)));
+
+        CTimingWheel::TimerId makeId(std::int32_t index, std::uint32_t generation)
+        {
+            return (static_cast<std::uint64_t>(generation) << 32) | static_cast<std::uint32_t>(index + 1);
+        }
+    }
+
+    CTimingWheel::CTimingWheel(std::uint64_t tickUSec) : _tickUSec(tickUSec ? tickUSec : 1), _nowTick(0), _nowUSec(0),
+                                                         _started(false), _count(0), _slots(LEVELS * SLOTS, NIL),
+                                                         _levelCounts(LEVELS, 0), _free(NIL)
+    {
+    }
+
+
+    CTimingWheel::TimerId CTimingWheel::arm(std::uint64_t expiryUSec, std::uint64_t cookie)
+    {
+        std::int32_t index;
+
+        if (NIL != _free)
+        {
+            index = _free;
+            _free = _nodes[index].next;
+        }
+        else
+        {
+            index = static_cast<std::int32_t>(_nodes.size());
+            _nodes.push_back(Node());
+            _nodes[index].generation = 0;
+        }
+
+        Node &node = _nodes[index];
+        node.expiryUSec = expiryUSec;
+        node.cookie = cookie;
+        node.generation++;
+        _count++;
+
+        if (_started)
+        {
+            insert(index);
+        }
+        else
+        {
+            node.slot = UNPLACED;
+            _unplaced.push_back(index);
+        }
+        return makeId(index, node.generation);
+    }
+
+
+    bool CTimingWheel::cancel(TimerId id)
+    {
+        auto index = static_cast<std::int32_t>(static_cast<std::uint32_t>(id)) - 1;
+
+        if (index < 0 || static_cast<std::size_t>(index) >= _nodes.size())
+        {
+            return false;
+        }
+
+        Node &node = _nodes[index];
+        if (FREE == node.slot || node.generation != static_cast<std::uint32_t>(id >> 32))
+        {
+            return false;
+        }
+
+        /*
+         * An unplaced node stays in _unplaced, the first advance()
+         * skips it as free.
+         */
+
+        if (UNPLACED != node.slot)
+        {
+            unlink(index);
+        }
+        node.slot = FREE;
+        node.next = _free;
+        _free = index;
+        _count--;
+        return true;
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Put a node in the slot for its expiry
+ **
+ ** Level L holds the timers 256^L to 256^(L+1) ticks out, in the
+ ** slot picked by their expiry's L-th byte. A timer already due
+ ** goes in the slot of the next tick processed.
+ **
+ *****************************************************************************/
+
+    void CTimingWheel::insert(std::int32_t index)
+    {
+        Node &node = _nodes[index];
+        std::uint64_t expiryTick = tickOf(node.expiryUSec);
+
+        if (expiryTick < _nowTick)
+        {
+            expiryTick = _nowTick;
+        }
+        if (expiryTick - _nowTick > MAX_DELTA_TICKS)
+        {
+            expiryTick = _nowTick + MAX_DELTA_TICKS;
+        }
+
+        std::uint64_t delta = expiryTick - _nowTick;
+        unsigned int level = 0;
+        while (level + 1 < LEVELS && delta >= (1ull << (SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+
+        auto slot = static_cast<std::int32_t>(level * SLOTS + ((expiryTick >> (SLOT_BITS * level)) & SLOT_MASK));
+        node.slot = slot;
+        node.prev = NIL;
+        node.next = _slots[slot];
+        if (NIL != node.next)
+        {
+            _nodes[node.next].prev = index;
+        }
+        _slots[slot] = index;
+        _levelCounts[level]++;
+    }
+
+
+    void CTimingWheel::unlink(std::int32_t index)
+    {
+        Node &node = _nodes[index];
+
+        if (NIL != node.prev)
+        {
+            _nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            _slots[node.slot] = node.next;
+        }
+        if (NIL != node.next)
+        {
+            _nodes[node.next].prev = node.prev;
+        }
+        _levelCounts[node.slot / SLOTS]--;
+    }
+
+
+    // Move the timers of a higher level slot that is now due down the levels
+    void CTimingWheel::cascade(unsigned int level)
+    {
+        auto slot = static_cast<std::int32_t>(level * SLOTS + ((_nowTick >> (SLOT_BITS * level)) & SLOT_MASK));
+        std::int32_t index = _slots[slot];
+
+        _slots[slot] = NIL;
+        while (NIL != index)
+        {
+            std::int32_t next = _nodes[index].next;
+            _levelCounts[level]--;
+            insert(index);
+            index = next;
+        }
+    }
+
+
+/**
+ *****************************************************************************
+ **
+ ** @brief  Move time forward to nowUSec, collecting what expired
+ **
+ ** Time never goes backwards, an earlier nowUSec does nothing.
+ ** With nothing armed the wheel jumps straight to nowUSec, so a
+ ** quiet hour costs nothing.
+ **
+ *****************************************************************************/
+
+    void CTimingWheel::advance(std::uint64_t nowUSec, std::vector<Expired> &expired)
+    {
+        std::uint64_t targetTick = nowUSec / _tickUSec;
+
+        if (!_started)
+        {
+            _started = true;
+            _nowTick = targetTick;
+            for (std::int32_t index : _unplaced)
+            {
+                if (UNPLACED == _nodes[index].slot)
+                {
+                    insert(index);
+                }
+            }
+            _unplaced.clear();
+        }
+
+        if (nowUSec > _nowUSec)
+        {
+            _nowUSec = nowUSec;
+        }
+
+        while (_nowTick <= targetTick)
+        {
+            if (0 == _count)
+            {
+                _nowTick = targetTick + 1;
+                break;
+            }
+
+            /*
+             * Top level first, what comes down from it may land in
+             * a lower level slot that is due now too.
+             */
+
+            unsigned int top = 0;
+            while (top + 1 < LEVELS && 0 == (_nowTick & ((1ull << (SLOT_BITS * (top + 1))) - 1)))
+            {
+                top++;
+            }
+            for (unsigned int level = top; level > 0; level--)
+            {
+                cascade(level);
+            }
+
+            /*
+             * Nothing in the levels below the lowest one holding a
+             * timer, so nothing happens before its next boundary.
+             */
+
+            unsigned int lowest = 0;
+            while (0 == _levelCounts[lowest])
+            {
+                lowest++;
+            }
+            if (lowest > 0)
+            {
+                std::uint64_t boundary = (_nowTick | ((1ull << (SLOT_BITS * lowest)) - 1)) + 1;
+                _nowTick = (boundary <= targetTick) ? boundary : targetTick + 1;
+                continue;
+            }
+
+            auto slot = static_cast<std::int32_t>(_nowTick & SLOT_MASK);
+            std::int32_t index = _slots[slot];
+            _slots[slot] = NIL;
+
+            while (NIL != index)
+            {
+                Node &node = _nodes[index];
+                std::int32_t next = node.next;
+
+                Expired timer;
+                timer.id = makeId(index, node.generation);
+                timer.cookie = node.cookie;
+                timer.expiryUSec = node.expiryUSec;
+                expired.push_back(timer);
+
+                node.slot = FREE;
+                node.next = _free;
+                _free = index;
+                _count--;
+                _levelCounts[0]--;
+                index = next;
+            }
+
+            _nowTick++;
+        }
+    }
+
+
+    // Generations are kept so ids from before the clear stay stale
+    void CTimingWheel::clear()
+    {
+        _free = NIL;
+        for (auto index = static_cast<std::int32_t>(_nodes.size()) - 1; index >= 0; index--)
+        {
+            _nodes[index].slot = FREE;
+            _nodes[index].next = _free;
+            _free = index;
+        }
+        _unplaced.clear();
+        _slots.assign(LEVELS * SLOTS, NIL);
+        _levelCounts.assign(LEVELS, 0);
+        _count = 0;
+    }
+}
@@ -0,0 +1,108 @@
+//********************************************************************
+//    created:    2026-10-18 10:15 PM
+//    file:       ctimingwheel.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_CTIMINGWHEEL_H
+#define LLRPLAPS_CTIMINGWHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+namespace LLRPLaps
+{
+    /*
+     * Hierarchical timing wheel for the lap engine's timers.
+     *
+     * Time is whatever the caller says it is, in microseconds, and
+     * only moves when advance() is called. Live that is the reader
+     * timebase of the latest tag, in replay the recorded timestamps,
+     * so a replay at any speed fires the same timers in the same
+     * order.
+     *
+     * Four levels of 256 slots cover 2^32 ticks. arm() and cancel()
+     * are O(1). advance() skips ahead to the next slot boundary of
+     * the lowest level holding a timer, so its cost is in the timers
+     * it fires or moves down a level, not in the time passed. A
+     * timer fires no earlier than its expiry and at most one tick
+     * after it.
+     */
+    class CTimingWheel
+    {
+    public:
+        typedef std::uint64_t TimerId;
+
+        struct Expired
+        {
+            TimerId id;
+            std::uint64_t cookie;
+            std::uint64_t expiryUSec;
+        };
+
+        explicit CTimingWheel(std::uint64_t tickUSec = DEFAULT_TICK_USEC);
+
+        // Fires at the first advance() to expiryUSec or later, the cookie comes back with it.
+        // Timers armed before the first advance() are placed by it.
+        TimerId arm(std::uint64_t expiryUSec, std::uint64_t cookie);
+
+        // false if the timer already fired or was cancelled
+        bool cancel(TimerId id);
+
+        // Move time forward, appending the timers that expired in expiry tick order
+        void advance(std::uint64_t nowUSec, std::vector<Expired> &expired);
+
+        void clear();
+
+        std::uint64_t getNowUSec() const { return _nowUSec; }
+
+        std::size_t size() const { return _count; }
+
+        const static std::uint64_t DEFAULT_TICK_USEC;
+        const static TimerId NO_TIMER = 0;
+
+    private:
+        struct Node
+        {
+            std::uint64_t expiryUSec;
+            std::uint64_t cookie;
+            std::int32_t prev;
+            std::int32_t next;
+            std::int32_t slot;          // FREE, UNPLACED or the slot the node is in
+            std::uint32_t generation;
+        };
+
+        void insert(std::int32_t index);
+
+        void unlink(std::int32_t index);
+
+        void cascade(unsigned int level);
+
+        std::uint64_t tickOf(std::uint64_t usec) const { return (usec + _tickUSec - 1) / _tickUSec; }
+
+        std::uint64_t _tickUSec;
+        std::uint64_t _nowTick;         // next tick to process
+        std::uint64_t _nowUSec;
+        bool _started;
+        std::size_t _count;
+        std::vector<Node> _nodes;
+        std::vector<std::int32_t> _slots;
+        std::vector<std::size_t> _levelCounts;
+        std::int32_t _free;
+        std::vector<std::int32_t> _unplaced;
+    };
+}
+#endif //LLRPLAPS_CTIMINGWHEEL_H
@@ -88,4 +88,19 @@ namespace LLRPLaps
     {
 
     }
+
+    void CReaderError::raise() const
+    {
+        switch (code)
+        {
+            case ReaderErrorCode::ErrorDetails:
+                throw ReaderErrorDetailsException(message);
+            case ReaderErrorCode::Connection:
+                throw ReaderConnectionException(message);
+            case ReaderErrorCode::Timeout:
+                throw ReaderTimeoutException(message);
+            default:
+                throw ReaderException(message);
+        }
+    }
 }
@@ -55,5 +55,37 @@ namespace LLRPLaps
         explicit ReaderTimeoutException(const char* what);
     };
 
+    /*
+     * The exception categories above as error codes, for calls where
+     * failing is part of normal operation and a CResult is returned
+     * instead of throwing.
+     */
+    enum class ReaderErrorCode
+    {
+        None = 0,
+        Reader,             // ReaderException
+        ErrorDetails,       // ReaderErrorDetailsException
+        Connection,         // ReaderConnectionException
+        Timeout             // ReaderTimeoutException
+    };
+
+    class CReaderError
+    {
+    public:
+        CReaderError() : code(ReaderErrorCode::None)
+        {
+        }
+
+        CReaderError(ReaderErrorCode code, const std::string &message) : code(code), message(message)
+        {
+        }
+
+        // Throw the exception of this error's category
+        [[noreturn]] void raise() const;
+
+        ReaderErrorCode code;
+        std::string message;
+    };
+
 }
 #endif //LLRPLAPS_EXCEPTIONS_H
@@ -2,7 +2,10 @@
 //
 
 #include <QTimer>
+#include <QFileDialog>
+#include <QMenu>
 #include <QMessageBox>
+#include <QtConcurrent>
 
 
 #include "creader.h"
@@ -16,6 +19,18 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    QMenu *fileMenu = ui->menuBar->addMenu(tr("&File"));
+    fileMenu->addAction(tr("&Export laps..."), this, &MainWindow::onExportLaps);
+    connect(&exportWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::onExportFinished);
+    QMenu *viewMenu = ui->menuBar->addMenu(tr("&View"));
+    viewMenu->addAction(tr("&Antennas..."), this, &MainWindow::onShowAntennas);
+
+    // Judged on the reader threads, shown here
+    connect(&antennaAnalytics, &LLRPLaps::CAntennaAnalytics::antennaDegraded, this, &MainWindow::onAntennaDegraded,
+            Qt::QueuedConnection);
+    connect(&antennaAnalytics, &LLRPLaps::CAntennaAnalytics::antennaRecovered, this, &MainWindow::onAntennaRecovered,
+            Qt::QueuedConnection);
+
     try {
 
         // Open connection to reader
@@ -23,6 +38,8 @@ MainWindow::MainWindow(QWidget *parent) :
         int verbose = 9;
         readerList.append(new CReader("192.168.36.210", verbose));
         for (int i=0; i<readerList.size(); i++) {
+            readerList[i]->setEpcInterner(&epcInterner);
+            antennaAnalytics.addReader(readerList[i]);
             connect(readerList[0], &CReader::newTag, this, &MainWindow::onNewTag);
             connect(readerList[0], &CReader::newLogMessage, this, &MainWindow::onNewLogMessage);
         }
@@ -45,6 +62,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    exporter.cancel();
+    exportWatcher.waitForFinished();
     delete ui;
     for (int i=0; i<readerList.size(); i++) {
         delete readerList[i];
@@ -56,14 +75,87 @@ MainWindow::~MainWindow()
 void MainWindow::onReaderCheckTimeout(void) {
     readerCheckTimer.stop();
     for (int i=0; i<readerList.size(); i++) {
-        readerList[i]->ProcessRecentChipsSeen();
+        LLRPLaps::CResult<void> result = readerList[i]->ProcessRecentChipsSeen();
+        // A quiet track times out every cycle, anything else wants seeing
+        if (!result && LLRPLaps::ReaderErrorCode::Timeout != result.code()) {
+            QString message = tr("%1: %2").arg(readerList[i]->getHostName(), QString::fromStdString(result.error().message));
+            ui->statusBar->showMessage(message);
+            onNewLogMessage(message);
+        }
     }
     readerCheckTimer.start();
 }
 
 
+// Exports run on the thread pool, the database is read over a connection of their own
+void MainWindow::onExportLaps(void) {
+    if (exportWatcher.isRunning()) {
+        return;
+    }
+
+    QString database = QFileDialog::getOpenFileName(this, tr("Lap database"), QString(), tr("Lap databases (*.sqlite)"));
+    if (database.isEmpty()) {
+        return;
+    }
+    QString output = QFileDialog::getSaveFileName(this, tr("Export laps to"), QString(),
+                                                  tr("CSV (*.csv);;Columnar (*.lapcol)"));
+    if (output.isEmpty()) {
+        return;
+    }
+
+    LLRPLaps::CLapExporter::Format format = LLRPLaps::CLapExporter::formatForPath(output);
+    ui->statusBar->showMessage(tr("Exporting laps to %1").arg(output));
+    exportWatcher.setFuture(QtConcurrent::run([this, database, output, format]() {
+        return exporter.exportLaps(database, output, format);
+    }));
+}
+
+
+void MainWindow::onExportFinished(void) {
+    if (exportWatcher.result()) {
+        ui->statusBar->showMessage(tr("%1 laps exported").arg(exporter.getExportedCount()));
+    }
+    else {
+        ui->statusBar->showMessage(tr("Export failed: %1").arg(exporter.getErrorString()));
+    }
+}
+
+
+void MainWindow::onShowAntennas(void) {
+    QString text = tr("Over the last %1 s:\n\n").arg(LLRPLaps::CAntennaAnalytics::WINDOW_BUCKETS *
+                                                     LLRPLaps::CAntennaAnalytics::BUCKET_USEC / 1000000ULL);
+    std::vector<LLRPLaps::CAntennaAnalytics::CAntennaStats> stats = antennaAnalytics.getStats();
+    if (stats.empty()) {
+        text += tr("No reads yet.");
+    }
+    for (const LLRPLaps::CAntennaAnalytics::CAntennaStats &antenna : stats) {
+        text += tr("%1 antenna %2: %3 reads/s, %4 passes, %5 reads a pass (p50 %6, p90 %7), RSSI %8/%9/%10 dBm")
+                .arg(antenna.reader).arg(antenna.antennaId)
+                .arg(antenna.readsPerSec, 0, 'f', 1).arg(antenna.passes)
+                .arg(antenna.meanReadsPerPass, 0, 'f', 1).arg(antenna.readsPerPassP50).arg(antenna.readsPerPassP90)
+                .arg(antenna.rssiP10).arg(antenna.rssiP50).arg(antenna.rssiP90);
+        if (antenna.degraded) {
+            text += tr(" - DEGRADED: %1").arg(antenna.reason);
+        }
+        text += "\n";
+    }
+    QMessageBox::information(this, tr("Antennas"), text);
+}
+
+
+void MainWindow::onAntennaDegraded(const QString& reader, int antennaId, const QString& reason) {
+    ui->statusBar->showMessage(tr("%1 antenna %2 degraded: %3").arg(reader).arg(antennaId).arg(reason));
+}
+
+
+void MainWindow::onAntennaRecovered(const QString& reader, int antennaId) {
+    ui->statusBar->showMessage(tr("%1 antenna %2 recovered").arg(reader).arg(antennaId));
+}
+
+
 void MainWindow::onNewTag(const CTagInfo& tagInfo) {
-    printf("%d %llu: %02x %02x %02x %02x %02x %02x\n", tagInfo.AntennaId, tagInfo.getTimeStampUSec(), tagInfo.data[0], tagInfo.data[1], tagInfo.data[2], tagInfo.data[3], tagInfo.data[4], tagInfo.data[5]);
+    // The interner formatted the hex once per chip, nothing is formatted per read
+    printf("%d %llu: %s\n", tagInfo.AntennaId, tagInfo.getTimeStampUSec(), epcInterner.getHex(tagInfo.getEpcId()).c_str());
     fflush(stdout);
 }
 
@@ -1,9 +1,13 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QFutureWatcher>
 #include <QMainWindow>
 #include <QTimer>
 
+#include "cantennaanalytics.h"
+#include "cepcinterner.h"
+#include "clapexporter.h"
 #include "creader.h"
 
 namespace Ui {
@@ -20,8 +24,17 @@ private:
     Ui::MainWindow *ui;
     QTimer readerCheckTimer;
     QList<LLRPLaps::CReader *> readerList;
+    LLRPLaps::CEpcInterner epcInterner;
+    LLRPLaps::CAntennaAnalytics antennaAnalytics;
+    LLRPLaps::CLapExporter exporter;
+    QFutureWatcher<bool> exportWatcher;
 private slots:
     void onReaderCheckTimeout(void);
+    void onExportLaps(void);
+    void onExportFinished(void);
+    void onShowAntennas(void);
+    void onAntennaDegraded(const QString& reader, int antennaId, const QString& reason);
+    void onAntennaRecovered(const QString& reader, int antennaId);
     void onNewTag(const CTagInfo& tagInfo);
     void onNewLogMessage(const QString& message);
 };
@@ -0,0 +1,222 @@
+//********************************************************************
+//    created:    2026-10-19 03:10 PM
+//    file:       antennaanalyticstest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Where CAntennaAnalytics draws the line: an antenna at exactly
+ * PEER_RATIO of its peers' reads or passes is healthy and one just
+ * under is degraded, nothing is judged before MIN_PASSES, and one
+ * without peers is degraded once it falls under BASELINE_RATIO of
+ * what it learnt, and recovers.
+ */
+
+#include <vector>
+
+#include <QSignalSpy>
+#include <QtTest>
+
+#include "cantennaanalytics.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CAntennaAnalyticsTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void peerReadsPerPass();
+        void peerPasses();
+        void minPasses();
+        void baseline();
+
+    private:
+        // One bucket of reads: antenna i + 1 sees riders[i] riders, reads[i] times a pass. Closes the bucket before
+        static void feed(CAntennaAnalytics &analytics, int readerIndex, int bucket, const std::vector<int> &reads,
+                         const std::vector<int> &riders);
+
+        static CAntennaAnalytics::CAntennaStats statsOf(const CAntennaAnalytics &analytics, int antennaId);
+
+        const static int RIDERS;
+    };
+
+    const int CAntennaAnalyticsTest::RIDERS = 12;
+
+
+    void CAntennaAnalyticsTest::feed(CAntennaAnalytics &analytics, int readerIndex, int bucket,
+                                     const std::vector<int> &reads, const std::vector<int> &riders)
+    {
+        /* Riders 400 ms apart, each pass over in well under PASS_GAP_USEC and long before the bucket ends */
+        u_int64_t bucketUSec = CTestTags::START_USEC + bucket * CAntennaAnalytics::BUCKET_USEC;
+        for (int rider = 0; rider < RIDERS; rider++)
+        {
+            for (int read = 0; read < 10; read++)
+            {
+                for (std::size_t i = 0; i < reads.size(); i++)
+                {
+                    if (rider < riders[i] && read < reads[i])
+                    {
+                        analytics.record(readerIndex, CTestTags::read(static_cast<unsigned char>(rider),
+                                                                      bucketUSec + rider * 400000ULL + read * 10000ULL,
+                                                                      static_cast<int>(i) + 1));
+                    }
+                }
+            }
+        }
+    }
+
+
+    CAntennaAnalytics::CAntennaStats CAntennaAnalyticsTest::statsOf(const CAntennaAnalytics &analytics, int antennaId)
+    {
+        for (const CAntennaAnalytics::CAntennaStats &stats : analytics.getStats())
+        {
+            if (stats.antennaId == antennaId)
+            {
+                return stats;
+            }
+        }
+        return CAntennaAnalytics::CAntennaStats();
+    }
+
+
+    void CAntennaAnalyticsTest::peerReadsPerPass()
+    {
+        CAntennaAnalytics analytics;
+        int reader = analytics.addReaderName("reader1");
+        QSignalSpy degraded(&analytics, &CAntennaAnalytics::antennaDegraded);
+
+        /* Half of its peers' 10 reads a pass is still enough */
+        for (int bucket = 0; bucket < 6; bucket++)
+        {
+            feed(analytics, reader, bucket, { 10, 10, 5 }, { RIDERS, RIDERS, RIDERS });
+        }
+        CAntennaAnalytics::CAntennaStats stats = statsOf(analytics, 3);
+        QCOMPARE(stats.passes, static_cast<std::uint32_t>(5 * RIDERS));
+        QCOMPARE(stats.meanReadsPerPass, 5.0);
+        QCOMPARE(stats.peerReadsPerPass, 10.0);
+        QCOMPARE(stats.baselineReadsPerPass, 5.0);
+        QVERIFY(!stats.degraded);
+        QCOMPARE(degraded.count(), 0);
+
+        /* One bucket under it is not */
+        feed(analytics, reader, 6, { 10, 10, 4 }, { RIDERS, RIDERS, RIDERS });
+        feed(analytics, reader, 7, { 10, 10, 4 }, { RIDERS, RIDERS, RIDERS });
+        stats = statsOf(analytics, 3);
+        QVERIFY(stats.degraded);
+        QCOMPARE(stats.reason, QString("4.9 reads a pass, its peers 10.0"));
+        QCOMPARE(degraded.count(), 1);
+        QCOMPARE(degraded[0][0].toString(), QString("reader1"));
+        QCOMPARE(degraded[0][1].toInt(), 3);
+        QVERIFY(!statsOf(analytics, 1).degraded);
+        QVERIFY(!statsOf(analytics, 2).degraded);
+    }
+
+
+    void CAntennaAnalyticsTest::peerPasses()
+    {
+        CAntennaAnalytics analytics;
+        int reader = analytics.addReaderName("reader1");
+        QSignalSpy degraded(&analytics, &CAntennaAnalytics::antennaDegraded);
+
+        /* Half the riders its peers see, each read as well */
+        for (int bucket = 0; bucket < 4; bucket++)
+        {
+            feed(analytics, reader, bucket, { 10, 10, 10 }, { RIDERS, RIDERS, RIDERS / 2 });
+        }
+        QCOMPARE(statsOf(analytics, 3).passes, static_cast<std::uint32_t>(3 * RIDERS / 2));
+        QVERIFY(!statsOf(analytics, 3).degraded);
+
+        /* One rider fewer */
+        feed(analytics, reader, 4, { 10, 10, 10 }, { RIDERS, RIDERS, RIDERS / 2 - 1 });
+        feed(analytics, reader, 5, { 10, 10, 10 }, { RIDERS, RIDERS, RIDERS / 2 });
+        CAntennaAnalytics::CAntennaStats stats = statsOf(analytics, 3);
+        QVERIFY(stats.degraded);
+        QCOMPARE(stats.reason, QString("29 passes, its peers 60"));
+        QCOMPARE(stats.meanReadsPerPass, 10.0);
+        QCOMPARE(degraded.count(), 1);
+    }
+
+
+    void CAntennaAnalyticsTest::minPasses()
+    {
+        CAntennaAnalytics analytics;
+        int reader = analytics.addReaderName("reader1");
+        QSignalSpy degraded(&analytics, &CAntennaAnalytics::antennaDegraded);
+
+        /* Three riders a bucket: 9 passes after three buckets, too few to judge by */
+        for (int bucket = 0; bucket < 4; bucket++)
+        {
+            feed(analytics, reader, bucket, { 10, 10, 2 }, { 3, 3, 3 });
+        }
+        CAntennaAnalytics::CAntennaStats stats = statsOf(analytics, 3);
+        QCOMPARE(stats.passes, static_cast<std::uint32_t>(9));
+        QCOMPARE(stats.peerReadsPerPass, 0.0);
+        QCOMPARE(stats.baselineReadsPerPass, 0.0);
+        QVERIFY(!stats.degraded);
+
+        feed(analytics, reader, 4, { 10, 10, 2 }, { 3, 3, 3 });
+        stats = statsOf(analytics, 3);
+        QVERIFY(stats.degraded);
+        QCOMPARE(stats.reason, QString("2.0 reads a pass, its peers 10.0"));
+        QCOMPARE(degraded.count(), 1);
+    }
+
+
+    void CAntennaAnalyticsTest::baseline()
+    {
+        CAntennaAnalytics analytics;
+        int reader = analytics.addReaderName("reader1");
+        QSignalSpy degraded(&analytics, &CAntennaAnalytics::antennaDegraded);
+        QSignalSpy recovered(&analytics, &CAntennaAnalytics::antennaRecovered);
+
+        int bucket = 0;
+        for (; bucket < 11; bucket++)
+        {
+            feed(analytics, reader, bucket, { 10 }, { RIDERS });
+        }
+        QCOMPARE(statsOf(analytics, 1).baselineReadsPerPass, 10.0);
+
+        /* The only antenna of its reader: judged against what it learnt, as it was before each bucket */
+        double baseline = 10.0;
+        for (; 0 == degraded.count() && bucket < 11 + CAntennaAnalytics::WINDOW_BUCKETS; bucket++)
+        {
+            feed(analytics, reader, bucket, { 1 }, { RIDERS });
+
+            CAntennaAnalytics::CAntennaStats stats = statsOf(analytics, 1);
+            QCOMPARE(stats.degraded, stats.meanReadsPerPass < CAntennaAnalytics::BASELINE_RATIO * baseline);
+            QVERIFY(stats.degraded || stats.baselineReadsPerPass <= baseline);
+            baseline = stats.baselineReadsPerPass;
+        }
+        QCOMPARE(degraded.count(), 1);
+        QVERIFY(degraded[0][2].toString().contains("reads a pass, usually"));
+
+        /* While degraded it learns nothing */
+        feed(analytics, reader, bucket++, { 1 }, { RIDERS });
+        QCOMPARE(statsOf(analytics, 1).baselineReadsPerPass, baseline);
+
+        for (int until = bucket + CAntennaAnalytics::WINDOW_BUCKETS; 0 == recovered.count() && bucket < until; bucket++)
+        {
+            feed(analytics, reader, bucket, { 10 }, { RIDERS });
+        }
+        QCOMPARE(recovered.count(), 1);
+        QVERIFY(statsOf(analytics, 1).meanReadsPerPass >= CAntennaAnalytics::BASELINE_RATIO * baseline);
+        QCOMPARE(degraded.count(), 1);
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CAntennaAnalyticsTest)
+
+#include "antennaanalyticstest.moc"
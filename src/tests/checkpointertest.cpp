@@ -0,0 +1,200 @@
+//********************************************************************
+//    created:    2026-10-19 10:40 AM
+//    file:       checkpointertest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * A restart loads the last snapshot and replays the journal after
+ * it. These check the counter comes back in the state a counter
+ * given every read in one go ends up in, and that a journal record
+ * torn by the crash is dropped and written over.
+ */
+
+#include <filesystem>
+#include <vector>
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "ccheckpointer.h"
+#include "clapcounter.h"
+#include "ctaginfo.h"
+#include "ctagjournal.h"
+#include "ctagjournalreader.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CCheckpointerTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void snapshotAndJournalTail();
+        void tornFinalRecord();
+
+    private:
+        static std::vector<CTagInfo> race();
+
+        static std::vector<unsigned char> stateAfter(const std::vector<CTagInfo> &reads, std::size_t count);
+
+        static void runWithSnapshot(const QString &journalPath, const QString &snapshotPath,
+                                    const std::vector<CTagInfo> &reads, std::size_t snapshotAt);
+
+        const static int RIDERS;
+        const static int LAPS;
+    };
+
+    const int CCheckpointerTest::RIDERS = 4;
+    const int CCheckpointerTest::LAPS = 10;
+
+
+    // Three reads a crossing, a lap every 30 s, the riders half a second apart
+    std::vector<CTagInfo> CCheckpointerTest::race()
+    {
+        std::vector<CTagInfo> reads;
+        for (int lap = 0; lap < LAPS; lap++)
+        {
+            for (int rider = 0; rider < RIDERS; rider++)
+            {
+                for (int read = 0; read < 3; read++)
+                {
+                    reads.push_back(CTestTags::read(static_cast<unsigned char>(rider + 1),
+                                                    CTestTags::START_USEC + lap * 30000000ULL + rider * 500000ULL +
+                                                    read * 100000ULL, 1 + read % 2));
+                }
+            }
+        }
+        return reads;
+    }
+
+
+    std::vector<unsigned char> CCheckpointerTest::stateAfter(const std::vector<CTagInfo> &reads, std::size_t count)
+    {
+        CLapCounter lapCounter;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            lapCounter.onNewTag(reads[i]);
+        }
+
+        std::vector<unsigned char> state;
+        lapCounter.saveState(state);
+        return state;
+    }
+
+
+    // A counter journaling every read, with a snapshot taken after the first snapshotAt of them
+    void CCheckpointerTest::runWithSnapshot(const QString &journalPath, const QString &snapshotPath,
+                                            const std::vector<CTagInfo> &reads, std::size_t snapshotAt)
+    {
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        CCheckpointer checkpointer(lapCounter, journal, snapshotPath);
+        QVERIFY2(checkpointer.restore(journalPath), qPrintable(checkpointer.getErrorString()));
+
+        for (std::size_t i = 0; i < reads.size(); i++)
+        {
+            if (snapshotAt == i)
+            {
+                checkpointer.checkpoint();
+            }
+            lapCounter.onNewTag(reads[i]);
+        }
+
+        /* The writer thread saves the snapshot before the checkpointer is gone */
+    }
+
+
+    void CCheckpointerTest::snapshotAndJournalTail()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString journalPath = dir.filePath("tags.jrn");
+        QString snapshotPath = dir.filePath("laps.snap");
+
+        std::vector<CTagInfo> reads = race();
+        std::size_t snapshotAt = reads.size() * 2 / 3;
+        runWithSnapshot(journalPath, snapshotPath, reads, snapshotAt);
+        QVERIFY(QFile::exists(snapshotPath));
+
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        CCheckpointer checkpointer(lapCounter, journal, snapshotPath);
+        QVERIFY2(checkpointer.restore(journalPath), qPrintable(checkpointer.getErrorString()));
+
+        /* Only the reads after the snapshot come from the journal */
+        QCOMPARE(checkpointer.getReplayedCount(), static_cast<std::uint64_t>(reads.size() - snapshotAt));
+
+        std::vector<unsigned char> state;
+        lapCounter.saveState(state);
+        QVERIFY(stateAfter(reads, reads.size()) == state);
+        for (int rider = 0; rider < RIDERS; rider++)
+        {
+            QCOMPARE(lapCounter.getLapCount(CTestTags::epc(static_cast<unsigned char>(rider + 1))), LAPS - 1);
+        }
+    }
+
+
+    void CCheckpointerTest::tornFinalRecord()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString journalPath = dir.filePath("tags.jrn");
+        QString snapshotPath = dir.filePath("laps.snap");
+
+        std::vector<CTagInfo> reads = race();
+        std::size_t snapshotAt = reads.size() / 2;
+        runWithSnapshot(journalPath, snapshotPath, reads, snapshotAt);
+
+        /* The crash came part way through writing the last read */
+        std::uint64_t size = std::filesystem::file_size(journalPath.toStdString());
+        std::filesystem::resize_file(journalPath.toStdString(), size - 3);
+
+        {
+            CLapCounter lapCounter;
+            CTagJournal journal;
+            CCheckpointer checkpointer(lapCounter, journal, snapshotPath);
+            QVERIFY2(checkpointer.restore(journalPath), qPrintable(checkpointer.getErrorString()));
+            QCOMPARE(checkpointer.getReplayedCount(), static_cast<std::uint64_t>(reads.size() - snapshotAt - 1));
+
+            std::vector<unsigned char> state;
+            lapCounter.saveState(state);
+            QVERIFY(stateAfter(reads, reads.size() - 1) == state);
+
+            /* The read comes again and takes the torn record's place */
+            lapCounter.onNewTag(reads.back());
+            QCOMPARE(journal.getRecordCount(), static_cast<std::uint64_t>(reads.size()));
+        }
+
+        CTagJournalReader reader;
+        QVERIFY2(reader.open(journalPath), qPrintable(reader.getErrorString()));
+        std::uint64_t offset = CTagJournal::HEADER_SIZE;
+        CTagInfo tagInfo;
+        std::size_t records = 0;
+        while (reader.next(offset, tagInfo))
+        {
+            QVERIFY(records < reads.size());
+            QCOMPARE(tagInfo.getTimeStampUSec(), reads[records].getTimeStampUSec());
+            QVERIFY(tagInfo.data == reads[records].data);
+            records++;
+        }
+        QCOMPARE(records, reads.size());
+        QCOMPARE(offset, reader.getSize());
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CCheckpointerTest)
+
+#include "checkpointertest.moc"
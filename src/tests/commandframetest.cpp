@@ -0,0 +1,194 @@
+//********************************************************************
+//    created:    2026-10-19 09:10 AM
+//    file:       commandframetest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * The EPC filters of a ROSpec go in an InventoryCommand that takes
+ * the place of the one SET_READER_CONFIG gave the antenna. These
+ * check the filtered ROSpec keeps each antenna's session, target
+ * and mode, so the reader config is not undone by the filters.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QtTest>
+
+#include <ltkcpp.h>
+#include "ccommandframe.h"
+
+namespace LLRPLaps
+{
+    class CCommandFrameTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void filtersKeepAntennaSettings();
+        void filtersWithoutReaderConfig();
+        void filtersOutsideReaderConfig();
+        void noFiltersNoAntennaConfiguration();
+
+    private:
+        static CROSpecConfig filteredConfig();
+
+        static LLRP::CInventoryParameterSpec *inventoryParameterSpec(LLRP::CADD_ROSPEC *addROSpec);
+
+        static LLRP::CC1G2InventoryCommand *inventoryCommand(LLRP::CAntennaConfiguration *antennaConfiguration);
+    };
+
+
+    CROSpecConfig CCommandFrameTest::filteredConfig()
+    {
+        CROSpecConfig config;
+        config.epcFilters.push_back({ { 0x30, 0x14, 0x36 }, 20 });
+        config.epcFilters.push_back({ { 0xe2, 0x80 }, 16 });
+        return config;
+    }
+
+
+    LLRP::CInventoryParameterSpec *CCommandFrameTest::inventoryParameterSpec(LLRP::CADD_ROSPEC *addROSpec)
+    {
+        auto *pAISpec = dynamic_cast<LLRP::CAISpec *>(*addROSpec->getROSpec()->beginSpecParameter());
+        return (nullptr == pAISpec) ? nullptr : *pAISpec->beginInventoryParameterSpec();
+    }
+
+
+    LLRP::CC1G2InventoryCommand *CCommandFrameTest::inventoryCommand(LLRP::CAntennaConfiguration *antennaConfiguration)
+    {
+        return dynamic_cast<LLRP::CC1G2InventoryCommand *>(*antennaConfiguration->beginAirProtocolInventoryCommandSettings());
+    }
+
+
+    void CCommandFrameTest::filtersKeepAntennaSettings()
+    {
+        CReaderConfig readerConfig = CReaderConfig::fastMovingTags({ 1, 2, 3 });
+        readerConfig.antennas[1].session = 2;
+        readerConfig.antennas[1].target = CAntennaConfig::TargetB;
+        readerConfig.antennas[1].modeIndex = 3;
+
+        CROSpecConfig config = filteredConfig();
+        config.antennaIds = { 1, 2 };
+
+        std::unique_ptr<LLRP::CADD_ROSPEC> addROSpec(CCommandFrames::makeAddROSpec(config, readerConfig));
+        LLRP::CInventoryParameterSpec *pInventoryParameterSpec = inventoryParameterSpec(addROSpec.get());
+        QVERIFY(nullptr != pInventoryParameterSpec);
+
+        /* Only the antennas of the AISpec, each with its own settings */
+        QCOMPARE(pInventoryParameterSpec->countAntennaConfiguration(), 2);
+
+        int i = 0;
+        for (auto it = pInventoryParameterSpec->beginAntennaConfiguration();
+             it != pInventoryParameterSpec->endAntennaConfiguration(); ++it, ++i)
+        {
+            const CAntennaConfig &antenna = readerConfig.antennas[i];
+            QCOMPARE(static_cast<int>((*it)->getAntennaID()), static_cast<int>(antenna.antennaId));
+
+            LLRP::CC1G2InventoryCommand *pInventoryCommand = inventoryCommand(*it);
+            QVERIFY(nullptr != pInventoryCommand);
+            QCOMPARE(static_cast<bool>(pInventoryCommand->getTagInventoryStateAware()),
+                     CAntennaConfig::TargetDefault != antenna.target);
+            QCOMPARE(pInventoryCommand->countC1G2Filter(), 2);
+
+            QVERIFY(nullptr != pInventoryCommand->getC1G2RFControl());
+            QCOMPARE(static_cast<int>(pInventoryCommand->getC1G2RFControl()->getModeIndex()), antenna.modeIndex);
+
+            LLRP::CC1G2SingulationControl *pSingulationControl = pInventoryCommand->getC1G2SingulationControl();
+            QVERIFY(nullptr != pSingulationControl);
+            QCOMPARE(static_cast<int>(pSingulationControl->getSession()), antenna.session);
+            QCOMPARE(static_cast<int>(pSingulationControl->getTagPopulation()), antenna.tagPopulation);
+
+            /* A state aware inventory needs state aware filter actions */
+            for (auto filter = pInventoryCommand->beginC1G2Filter(); filter != pInventoryCommand->endC1G2Filter(); ++filter)
+            {
+                bool stateAware = CAntennaConfig::TargetDefault != antenna.target;
+                QCOMPARE(nullptr != (*filter)->getC1G2TagInventoryStateAwareFilterAction(), stateAware);
+                QCOMPARE(nullptr != (*filter)->getC1G2TagInventoryStateUnawareFilterAction(), !stateAware);
+            }
+
+            if (CAntennaConfig::TargetDefault != antenna.target)
+            {
+                QVERIFY(nullptr != pSingulationControl->getC1G2TagInventoryStateAwareSingulationAction());
+            }
+        }
+    }
+
+
+    void CCommandFrameTest::filtersWithoutReaderConfig()
+    {
+        std::unique_ptr<LLRP::CADD_ROSPEC> addROSpec(CCommandFrames::makeAddROSpec(filteredConfig()));
+        LLRP::CInventoryParameterSpec *pInventoryParameterSpec = inventoryParameterSpec(addROSpec.get());
+        QVERIFY(nullptr != pInventoryParameterSpec);
+        QCOMPARE(pInventoryParameterSpec->countAntennaConfiguration(), 1);
+
+        /* All antennas, nothing but the filters */
+        LLRP::CAntennaConfiguration *pAntennaConfiguration = *pInventoryParameterSpec->beginAntennaConfiguration();
+        QCOMPARE(static_cast<int>(pAntennaConfiguration->getAntennaID()), 0);
+
+        LLRP::CC1G2InventoryCommand *pInventoryCommand = inventoryCommand(pAntennaConfiguration);
+        QVERIFY(nullptr != pInventoryCommand);
+        QVERIFY(!pInventoryCommand->getTagInventoryStateAware());
+        QCOMPARE(pInventoryCommand->countC1G2Filter(), 2);
+        QVERIFY(nullptr == pInventoryCommand->getC1G2RFControl());
+        QVERIFY(nullptr == pInventoryCommand->getC1G2SingulationControl());
+    }
+
+
+    void CCommandFrameTest::filtersOutsideReaderConfig()
+    {
+        CReaderConfig readerConfig = CReaderConfig::fastMovingTags({ 1 });
+        CROSpecConfig config = filteredConfig();
+        config.antennaIds = { 4, 1 };
+
+        std::unique_ptr<LLRP::CADD_ROSPEC> addROSpec(CCommandFrames::makeAddROSpec(config, readerConfig));
+        LLRP::CInventoryParameterSpec *pInventoryParameterSpec = inventoryParameterSpec(addROSpec.get());
+        QVERIFY(nullptr != pInventoryParameterSpec);
+        QCOMPARE(pInventoryParameterSpec->countAntennaConfiguration(), 2);
+
+        /* Antenna 4 is not set up, it is filtered all the same and keeps the reader's settings */
+        auto it = pInventoryParameterSpec->beginAntennaConfiguration();
+        QCOMPARE(static_cast<int>((*it)->getAntennaID()), 4);
+        LLRP::CC1G2InventoryCommand *pInventoryCommand = inventoryCommand(*it);
+        QVERIFY(nullptr != pInventoryCommand);
+        QCOMPARE(pInventoryCommand->countC1G2Filter(), 2);
+        QVERIFY(nullptr == pInventoryCommand->getC1G2RFControl());
+        QVERIFY(nullptr == pInventoryCommand->getC1G2SingulationControl());
+
+        ++it;
+        QCOMPARE(static_cast<int>((*it)->getAntennaID()), 1);
+        pInventoryCommand = inventoryCommand(*it);
+        QVERIFY(nullptr != pInventoryCommand);
+        QCOMPARE(pInventoryCommand->countC1G2Filter(), 2);
+        QVERIFY(nullptr != pInventoryCommand->getC1G2SingulationControl());
+    }
+
+
+    void CCommandFrameTest::noFiltersNoAntennaConfiguration()
+    {
+        CCommandFrames frames = CCommandFrames::build(CROSpecConfig(), CReaderConfig::fastMovingTags({ 1, 2 }));
+        std::unique_ptr<LLRP::CADD_ROSPEC> addROSpec(CCommandFrames::makeAddROSpec(frames.config, frames.readerConfig));
+
+        /* Unfiltered, the reader config is all there is */
+        LLRP::CInventoryParameterSpec *pInventoryParameterSpec = inventoryParameterSpec(addROSpec.get());
+        QVERIFY(nullptr != pInventoryParameterSpec);
+        QCOMPARE(pInventoryParameterSpec->countAntennaConfiguration(), 0);
+        QVERIFY(!frames.setReaderConfig.empty());
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CCommandFrameTest)
+
+#include "commandframetest.moc"
@@ -0,0 +1,181 @@
+//********************************************************************
+//    created:    2026-10-19 12:10 PM
+//    file:       epcinternertest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Dense ids in order of first sight, the cached hex and display
+ * strings, and lookups that take no lock still finding every EPC
+ * while another thread grows the table under them.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <QtTest>
+
+#include "cepcinterner.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CEpcInternerTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void internAndLookup();
+        void displayNames();
+        void growthUnderConcurrentReader();
+
+    private:
+        // The n-th of more chips than CTestTags::epc() numbers
+        static std::vector<unsigned char> epc(std::uint32_t n);
+    };
+
+
+    std::vector<unsigned char> CEpcInternerTest::epc(std::uint32_t n)
+    {
+        std::vector<unsigned char> bytes = CTestTags::epc(0);
+        for (int i = 0; i < 4; i++)
+        {
+            bytes[bytes.size() - 1 - i] = static_cast<unsigned char>(n >> (8 * i));
+        }
+        return bytes;
+    }
+
+
+    void CEpcInternerTest::internAndLookup()
+    {
+        CEpcInterner interner;
+        std::vector<unsigned char> first = CTestTags::epc(7);
+        std::vector<unsigned char> second = CTestTags::epc(8);
+
+        QCOMPARE(interner.find(first.data(), first.size()), CTagInfo::NO_EPC_ID);
+        QCOMPARE(interner.intern(first), static_cast<std::uint32_t>(0));
+        QCOMPARE(interner.intern(second), static_cast<std::uint32_t>(1));
+        QCOMPARE(interner.intern(first), static_cast<std::uint32_t>(0));
+        QCOMPARE(interner.find(second.data(), second.size()), static_cast<std::uint32_t>(1));
+        QCOMPARE(interner.size(), static_cast<std::size_t>(2));
+
+        /* A prefix of a known EPC is another EPC */
+        QCOMPARE(interner.find(first.data(), first.size() - 1), CTagInfo::NO_EPC_ID);
+
+        QVERIFY(interner.getEpc(1) == second);
+        QCOMPARE(interner.getHex(0), std::string("e28011052000000000000007"));
+        QCOMPARE(interner.getDisplayName(0), QString("e28011052000000000000007"));
+
+        QVERIFY(interner.getEpc(2).empty());
+        QVERIFY(interner.getHex(CTagInfo::NO_EPC_ID).empty());
+        QVERIFY(interner.getDisplayName(2).isEmpty());
+    }
+
+
+    void CEpcInternerTest::displayNames()
+    {
+        CEpcInterner interner;
+        std::uint32_t epcId = interner.intern(CTestTags::epc(1));
+
+        const QString &hex = interner.getDisplayName(epcId);
+        QVERIFY(interner.setDisplayName(CTestTags::epc(1), "Anna"));
+        QCOMPARE(interner.getDisplayName(epcId), QString("Anna"));
+
+        /* A reference taken before the rename still reads what it did */
+        const QString &anna = interner.getDisplayName(epcId);
+        QVERIFY(interner.setDisplayName(CTestTags::epc(1), "Zoe"));
+        QCOMPARE(interner.getDisplayName(epcId), QString("Zoe"));
+        QCOMPARE(anna, QString("Anna"));
+        QCOMPARE(hex, QString("e28011052000000000000001"));
+
+        /* Released, the hex again */
+        QVERIFY(interner.setDisplayName(CTestTags::epc(1), QString()));
+        QCOMPARE(interner.getDisplayName(epcId), QString("e28011052000000000000001"));
+
+        /* A chip named before it was ever read is interned on the way */
+        QVERIFY(interner.setDisplayName(CTestTags::epc(2), "Ben"));
+        QCOMPARE(interner.size(), static_cast<std::size_t>(2));
+        QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(2))), QString("Ben"));
+    }
+
+
+    void CEpcInternerTest::growthUnderConcurrentReader()
+    {
+        const std::uint32_t known = 100;
+        const std::uint32_t total = 20000;
+
+        CEpcInterner interner;
+        std::vector<std::vector<unsigned char>> epcs;
+        for (std::uint32_t n = 0; n < total; n++)
+        {
+            epcs.push_back(epc(n));
+        }
+        for (std::uint32_t n = 0; n < known; n++)
+        {
+            QCOMPARE(interner.intern(epcs[n]), n);
+        }
+
+        /* The first EPCs are looked up without the lock the whole time the table grows */
+        std::atomic<bool> stop(false);
+        std::atomic<std::uint64_t> lookups(0);
+        std::atomic<std::uint64_t> misses(0);
+        std::thread reader([&]
+        {
+            while (!stop.load(std::memory_order_acquire))
+            {
+                for (std::uint32_t n = 0; n < known; n++)
+                {
+                    if (n != interner.find(epcs[n].data(), epcs[n].size()) || interner.getHex(n).size() != 24)
+                    {
+                        misses++;
+                    }
+                    lookups++;
+                }
+
+                /* Any id counted already has its strings */
+                std::size_t size = interner.size();
+                if (size > 0 && interner.getDisplayName(static_cast<std::uint32_t>(size - 1)).isEmpty())
+                {
+                    misses++;
+                }
+            }
+        });
+
+        while (0 == lookups.load())
+        {
+            std::this_thread::yield();
+        }
+
+        std::uint32_t wrongIds = 0;
+        for (std::uint32_t n = known; n < total; n++)
+        {
+            wrongIds += (n != interner.intern(epcs[n])) ? 1 : 0;
+        }
+        stop.store(true, std::memory_order_release);
+        reader.join();
+
+        QCOMPARE(wrongIds, static_cast<std::uint32_t>(0));
+        QCOMPARE(misses.load(), static_cast<std::uint64_t>(0));
+        for (std::uint32_t n = 0; n < total; n++)
+        {
+            QCOMPARE(interner.find(epcs[n].data(), epcs[n].size()), n);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CEpcInternerTest)
+
+#include "epcinternertest.moc"
@@ -0,0 +1,246 @@
+//********************************************************************
+//    created:    2026-10-19 02:10 PM
+//    file:       lapdatabasetest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Writes queued to CLapDatabase wait for the writer's batch, flush()
+ * and close() commit them, a write that fails is counted without
+ * taking its batch down, and riders' names reach the EPC interner
+ * for chips assigned before and after it is set, in this run or an
+ * earlier one.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "cepcinterner.h"
+#include "clapdatabase.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CLapDatabaseTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void batchedUntilFlush();
+        void fullBatch();
+        void failedWriteSkipped();
+        void closeCommitsQueue();
+        void riderNamesInInterner();
+
+    private:
+        static CLapInfo lap(unsigned char chip, int lapNumber, std::uint64_t crossingUSec);
+    };
+
+
+    CLapInfo CLapDatabaseTest::lap(unsigned char chip, int lapNumber, std::uint64_t crossingUSec)
+    {
+        CLapInfo lapInfo;
+        lapInfo.epc = CTestTags::epc(chip);
+        lapInfo.lapNumber = lapNumber;
+        lapInfo.antennaId = 1;
+        lapInfo.crossingUSec = CTestTags::START_USEC + crossingUSec;
+        lapInfo.lapTimeUSec = 30000000ULL;
+        return lapInfo;
+    }
+
+
+    void CLapDatabaseTest::batchedUntilFlush()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        CLapDatabase database;
+        QVERIFY2(database.open(dir.filePath("laps.db")), qPrintable(database.getErrorString()));
+
+        /* Queued out of crossing order, read back in it */
+        QElapsedTimer queueing;
+        queueing.start();
+        qint64 session = database.startSession("Heat 1", CTestTags::START_USEC);
+        for (int i = 0; i < 100; i++)
+        {
+            database.addLap(session, lap(static_cast<unsigned char>(i % 4), 1 + i / 4, (99 - i) * 1000000ULL));
+        }
+
+        /* The writer holds the batch open for the commit interval, unless this thread was held up that long */
+        if (queueing.elapsed() < CLapDatabase::COMMIT_INTERVAL_MS / 2)
+        {
+            QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(0));
+        }
+
+        database.flush();
+        QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(101));
+        QCOMPARE(database.getFailedCount(), static_cast<std::uint64_t>(0));
+
+        std::vector<CLapInfo> laps;
+        QVERIFY(database.getLaps(session, laps));
+        QCOMPARE(laps.size(), static_cast<std::size_t>(100));
+        for (std::size_t i = 0; i < laps.size(); i++)
+        {
+            QCOMPARE(laps[i].crossingUSec, CTestTags::START_USEC + i * 1000000ULL);
+        }
+        QVERIFY(laps[0].epc == CTestTags::epc(3));
+        QCOMPARE(laps[0].lapNumber, 25);
+
+        /* Nothing queued, nothing to wait for */
+        database.flush();
+        QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(101));
+    }
+
+
+    void CLapDatabaseTest::fullBatch()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        CLapDatabase database;
+        QVERIFY2(database.open(dir.filePath("laps.db")), qPrintable(database.getErrorString()));
+
+        /* A full batch goes in without waiting for a flush, the rest with it */
+        qint64 session = database.startSession("Heat 1", CTestTags::START_USEC);
+        std::size_t count = CLapDatabase::MAX_BATCH + 10;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            database.addLap(session, lap(static_cast<unsigned char>(i % 200), 1 + static_cast<int>(i / 200), i));
+        }
+        QTRY_VERIFY_WITH_TIMEOUT(database.getWrittenCount() >= CLapDatabase::MAX_BATCH, 5000);
+
+        database.flush();
+        QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(count + 1));
+
+        std::vector<CLapInfo> laps;
+        QVERIFY(database.getLaps(session, laps));
+        QCOMPARE(laps.size(), count);
+    }
+
+
+    void CLapDatabaseTest::failedWriteSkipped()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        CLapDatabase database;
+        QVERIFY2(database.open(dir.filePath("laps.db")), qPrintable(database.getErrorString()));
+
+        /* A rider's name cannot be NULL, the laps around it still go in */
+        qint64 session = database.startSession("Heat 1", CTestTags::START_USEC);
+        database.addLap(session, lap(1, 1, 0));
+        database.addRider(QString());
+        database.addLap(session, lap(1, 2, 30000000ULL));
+        database.flush();
+
+        QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(3));
+        QCOMPARE(database.getFailedCount(), static_cast<std::uint64_t>(1));
+        QVERIFY(!database.getWriteError().isEmpty());
+
+        std::vector<CLapInfo> laps;
+        QVERIFY(database.getLaps(session, laps));
+        QCOMPARE(laps.size(), static_cast<std::size_t>(2));
+    }
+
+
+    void CLapDatabaseTest::closeCommitsQueue()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("laps.db");
+
+        qint64 session;
+        qint64 anna;
+        {
+            CLapDatabase database;
+            QVERIFY2(database.open(path), qPrintable(database.getErrorString()));
+            anna = database.addRider("Anna");
+            database.assignChip(CTestTags::epc(1), anna);
+            session = database.startSession("Heat 1", CTestTags::START_USEC);
+            for (int i = 0; i < 10; i++)
+            {
+                database.addLap(session, lap(1, 1 + i, i * 30000000ULL));
+            }
+            database.close();
+            QVERIFY(!database.isOpen());
+
+            /* Closed, writes are dropped */
+            database.addLap(session, lap(1, 11, 300000000ULL));
+            QCOMPARE(database.getWrittenCount(), static_cast<std::uint64_t>(13));
+        }
+
+        CLapDatabase database;
+        QVERIFY2(database.open(path), qPrintable(database.getErrorString()));
+        std::vector<CLapInfo> laps;
+        QVERIFY(database.getLaps(session, laps));
+        QCOMPARE(laps.size(), static_cast<std::size_t>(10));
+        QCOMPARE(database.findRider(CTestTags::epc(1)), anna);
+
+        /* Ids carry on after the ones in the file */
+        QCOMPARE(database.addRider("Ben"), anna + 1);
+        QCOMPARE(database.startSession("Heat 2", CTestTags::START_USEC), session + 1);
+    }
+
+
+    void CLapDatabaseTest::riderNamesInInterner()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("laps.db");
+        const QString hex("e28011052000000000000003");
+
+        {
+            CLapDatabase database;
+            QVERIFY2(database.open(path), qPrintable(database.getErrorString()));
+            qint64 anna = database.addRider("Anna");
+            qint64 zoe = database.addRider(QString::fromUtf8("Zo\xc3\xab"));
+            database.assignChip(CTestTags::epc(1), anna);
+
+            /* Assigned before the interner is set, still queued: named when it is */
+            CEpcInterner interner;
+            QVERIFY(database.setEpcInterner(&interner));
+            QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(1))), QString("Anna"));
+
+            /* From now on as chips are assigned, moved and released */
+            database.assignChip(CTestTags::epc(2), zoe);
+            QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(2))), QString::fromUtf8("Zo\xc3\xab"));
+            database.assignChip(CTestTags::epc(1), zoe);
+            QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(1))), QString::fromUtf8("Zo\xc3\xab"));
+            database.assignChip(CTestTags::epc(3), anna);
+            database.releaseChip(CTestTags::epc(3));
+            QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(3))), hex);
+
+            database.setEpcInterner(nullptr);
+            database.assignChip(CTestTags::epc(3), anna);
+            QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(3))), hex);
+        }
+
+        /* A later run names the chips in the file, and chips given to riders from the earlier run */
+        CLapDatabase database;
+        QVERIFY2(database.open(path), qPrintable(database.getErrorString()));
+        CEpcInterner interner;
+        QVERIFY(database.setEpcInterner(&interner));
+        QCOMPARE(interner.size(), static_cast<std::size_t>(3));
+        QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(1))), QString::fromUtf8("Zo\xc3\xab"));
+        QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(3))), QString("Anna"));
+
+        database.assignChip(CTestTags::epc(4), database.findRider(CTestTags::epc(3)));
+        QCOMPARE(interner.getDisplayName(interner.intern(CTestTags::epc(4))), QString("Anna"));
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CLapDatabaseTest)
+
+#include "lapdatabasetest.moc"
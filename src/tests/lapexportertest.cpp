@@ -0,0 +1,321 @@
+//********************************************************************
+//    created:    2026-10-19 11:10 AM
+//    file:       lapexportertest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * A small CLapDatabase exported as .lapcol and the columns read back
+ * the way numpy or pyarrow would take them: the header's names and
+ * types, then per row group each column's buffers, offsets first for
+ * text and bytes, ending with a group of no rows.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <QFile>
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "clapdatabase.h"
+#include "clapexporter.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CLapExporterTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void columnsReadBack();
+        void emptyRange();
+
+    private:
+        struct CColumn
+        {
+            QByteArray name;
+            int type;
+            std::vector<qint64> ints;           // Int32 and Int64
+            std::vector<QByteArray> values;     // Utf8 and Binary
+        };
+
+        static CLapInfo lap(unsigned char chip, int lapNumber, int antennaId, std::uint64_t crossingUSec,
+                            std::uint64_t lapTimeUSec);
+
+        static bool createDatabase(const QString &path);
+
+        // Every row group of a .lapcol file appended to columns, false if it does not parse to the end
+        static bool readColumnar(const QByteArray &file, std::vector<CColumn> &columns);
+    };
+
+    CLapInfo CLapExporterTest::lap(unsigned char chip, int lapNumber, int antennaId, std::uint64_t crossingUSec,
+                                   std::uint64_t lapTimeUSec)
+    {
+        CLapInfo lapInfo;
+        lapInfo.epc = CTestTags::epc(chip);
+        lapInfo.lapNumber = lapNumber;
+        lapInfo.antennaId = antennaId;
+        lapInfo.crossingUSec = crossingUSec;
+        lapInfo.lapTimeUSec = lapTimeUSec;
+        return lapInfo;
+    }
+
+
+    // Two riders with a chip each, a third chip nobody has, laps added out of crossing order
+    bool CLapExporterTest::createDatabase(const QString &path)
+    {
+        CLapDatabase database;
+        if (!database.open(path))
+        {
+            return false;
+        }
+
+        qint64 anna = database.addRider("Anna");
+        qint64 zoe = database.addRider(QString::fromUtf8("Zo\xc3\xab \"Flash\", Jr."));
+        database.assignChip(CTestTags::epc(1), anna);
+        database.assignChip(CTestTags::epc(2), zoe);
+
+        qint64 session = database.startSession("Heat 1", CTestTags::START_USEC);
+        database.addLap(session, lap(1, 1, 1, CTestTags::START_USEC + 30000000ULL, 30000000ULL));
+        database.addLap(session, lap(2, 1, 2, CTestTags::START_USEC + 31000000ULL, 31000000ULL));
+        database.addLap(session, lap(3, 1, 9, CTestTags::START_USEC + 29000000ULL, 29000000ULL));
+        database.addLap(session, lap(1, 2, 1, CTestTags::START_USEC + 61000000ULL, 31000000ULL));
+        database.flush();
+
+        bool written = (0 == database.getFailedCount());
+        database.close();
+        return written;
+    }
+
+
+    bool CLapExporterTest::readColumnar(const QByteArray &file, std::vector<CColumn> &columns)
+    {
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(file.constData());
+        std::size_t size = static_cast<std::size_t>(file.size());
+        std::size_t at = 0;
+
+        auto getU = [&](int bytes, std::uint64_t &value)
+        {
+            if (at + bytes > size)
+            {
+                return false;
+            }
+            value = 0;
+            for (int i = bytes - 1; i >= 0; i--)
+            {
+                value = (value << 8) | data[at + i];
+            }
+            at += bytes;
+            return true;
+        };
+        auto pad = [&]()
+        {
+            at = (at + 7) & ~static_cast<std::size_t>(7);
+        };
+
+        std::uint64_t version;
+        std::uint64_t columnCount;
+        if (size < sizeof CLapExporter::MAGIC ||
+            0 != std::memcmp(data, CLapExporter::MAGIC, sizeof CLapExporter::MAGIC))
+        {
+            return false;
+        }
+        at = sizeof CLapExporter::MAGIC;
+        if (!getU(4, version) || CLapExporter::VERSION != version || !getU(4, columnCount))
+        {
+            return false;
+        }
+
+        columns.resize(columnCount);
+        for (CColumn &column : columns)
+        {
+            std::uint64_t type;
+            std::uint64_t length;
+            if (!getU(1, type) || !getU(1, length) || at + length > size)
+            {
+                return false;
+            }
+            column.type = static_cast<int>(type);
+            column.name = QByteArray(reinterpret_cast<const char *>(data + at), static_cast<int>(length));
+            at += length;
+        }
+        pad();
+
+        for (;;)
+        {
+            std::uint64_t rows;
+            std::uint64_t zero;
+            if (!getU(4, rows) || !getU(4, zero) || 0 != zero)
+            {
+                return false;
+            }
+            if (0 == rows)
+            {
+                return at == size;
+            }
+
+            for (CColumn &column : columns)
+            {
+                std::vector<std::uint32_t> offsets;
+                std::uint64_t length;
+                if (CLapExporter::Utf8 == column.type || CLapExporter::Binary == column.type)
+                {
+                    if (!getU(8, length) || (rows + 1) * 4 != length)
+                    {
+                        return false;
+                    }
+                    for (std::uint64_t i = 0; i <= rows; i++)
+                    {
+                        std::uint64_t offset;
+                        if (!getU(4, offset) || (!offsets.empty() && offset < offsets.back()))
+                        {
+                            return false;
+                        }
+                        offsets.push_back(static_cast<std::uint32_t>(offset));
+                    }
+                    pad();
+                }
+
+                if (!getU(8, length) || at + length > size)
+                {
+                    return false;
+                }
+                const unsigned char *values = data + at;
+                if (CLapExporter::Int32 == column.type || CLapExporter::Int64 == column.type)
+                {
+                    std::size_t width = (CLapExporter::Int32 == column.type) ? 4 : 8;
+                    if (rows * width != length)
+                    {
+                        return false;
+                    }
+                    for (std::uint64_t row = 0; row < rows; row++)
+                    {
+                        std::uint64_t value = 0;
+                        for (std::size_t i = width; i > 0; i--)
+                        {
+                            value = (value << 8) | values[row * width + i - 1];
+                        }
+                        column.ints.push_back((4 == width) ? static_cast<std::int32_t>(value)
+                                                           : static_cast<qint64>(value));
+                    }
+                }
+                else
+                {
+                    if (offsets.back() != length)
+                    {
+                        return false;
+                    }
+                    for (std::uint64_t row = 0; row < rows; row++)
+                    {
+                        column.values.emplace_back(reinterpret_cast<const char *>(values + offsets[row]),
+                                                   static_cast<int>(offsets[row + 1] - offsets[row]));
+                    }
+                }
+                at += length;
+                pad();
+            }
+        }
+    }
+
+
+    void CLapExporterTest::columnsReadBack()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString databasePath = dir.filePath("laps.db");
+        QString outputPath = dir.filePath("laps.lapcol");
+        QVERIFY(createDatabase(databasePath));
+
+        CLapExporter exporter;
+        QVERIFY(CLapExporter::Columnar == CLapExporter::formatForPath(outputPath));
+        QVERIFY2(exporter.exportLaps(databasePath, outputPath, CLapExporter::Columnar),
+                 qPrintable(exporter.getErrorString()));
+        QCOMPARE(exporter.getExportedCount(), static_cast<std::uint64_t>(4));
+
+        QFile file(outputPath);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        std::vector<CColumn> columns;
+        QVERIFY(readColumnar(file.readAll(), columns));
+
+        const char *names[] = { "session_id", "session", "rider_id", "rider", "epc", "lap_number", "antenna_id",
+                                "crossing_usec", "lap_time_usec" };
+        const int types[] = { CLapExporter::Int64, CLapExporter::Utf8, CLapExporter::Int64, CLapExporter::Utf8,
+                              CLapExporter::Binary, CLapExporter::Int32, CLapExporter::Int32, CLapExporter::Int64,
+                              CLapExporter::Int64 };
+        QCOMPARE(columns.size(), sizeof names / sizeof names[0]);
+        for (std::size_t i = 0; i < columns.size(); i++)
+        {
+            QCOMPARE(columns[i].name, QByteArray(names[i]));
+            QCOMPARE(columns[i].type, types[i]);
+        }
+
+        /* In crossing order, the chip nobody has first */
+        const unsigned char chips[] = { 3, 1, 2, 1 };
+        const QByteArray riders[] = { "", "Anna", "Zo\xc3\xab \"Flash\", Jr.", "Anna" };
+        const qint64 laps[] = { 1, 1, 1, 2 };
+        const qint64 antennas[] = { 9, 1, 2, 1 };
+        const qint64 crossings[] = { 29000000, 30000000, 31000000, 61000000 };
+        const qint64 lapTimes[] = { 29000000, 30000000, 31000000, 31000000 };
+        for (std::size_t row = 0; row < 4; row++)
+        {
+            std::vector<unsigned char> chip = CTestTags::epc(chips[row]);
+            QCOMPARE(columns[0].ints[row], columns[0].ints[0]);
+            QCOMPARE(columns[1].values[row], QByteArray("Heat 1"));
+            QCOMPARE(columns[2].ints[row] == 0, 3 == chips[row]);
+            QCOMPARE(columns[3].values[row], riders[row]);
+            QCOMPARE(columns[4].values[row], QByteArray(reinterpret_cast<const char *>(chip.data()),
+                                                        static_cast<int>(chip.size())));
+            QCOMPARE(columns[5].ints[row], laps[row]);
+            QCOMPARE(columns[6].ints[row], antennas[row]);
+            QCOMPARE(columns[7].ints[row], static_cast<qint64>(CTestTags::START_USEC) + crossings[row]);
+            QCOMPARE(columns[8].ints[row], lapTimes[row]);
+        }
+        QCOMPARE(columns[2].ints[1], columns[2].ints[3]);
+        QVERIFY(columns[2].ints[1] != columns[2].ints[2]);
+    }
+
+
+    void CLapExporterTest::emptyRange()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString databasePath = dir.filePath("laps.db");
+        QString outputPath = dir.filePath("laps.lapcol");
+        QVERIFY(createDatabase(databasePath));
+
+        /* Before the first crossing: the header and the end group only */
+        CLapExporter exporter;
+        exporter.setTimeRange(CTestTags::START_USEC, CTestTags::START_USEC + 29000000ULL);
+        QVERIFY2(exporter.exportLaps(databasePath, outputPath, CLapExporter::Columnar),
+                 qPrintable(exporter.getErrorString()));
+        QCOMPARE(exporter.getExportedCount(), static_cast<std::uint64_t>(0));
+
+        QFile file(outputPath);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        std::vector<CColumn> columns;
+        QVERIFY(readColumnar(file.readAll(), columns));
+        QCOMPARE(columns.size(), static_cast<std::size_t>(9));
+        for (const CColumn &column : columns)
+        {
+            QVERIFY(column.ints.empty() && column.values.empty());
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CLapExporterTest)
+
+#include "lapexportertest.moc"
@@ -0,0 +1,254 @@
+//********************************************************************
+//    created:    2026-10-19 10:10 AM
+//    file:       readtimelinetest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * What CReadTimeline writes, CReadTimelineReader reads back: every
+ * read of every chip with its time, antenna and RSSI, from full
+ * blocks and from partial ones written at their used length. A
+ * block torn by a crash is left out by the reader and cut off by a
+ * writer carrying on with the file.
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "creadtimeline.h"
+#include "creadtimelinereader.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CReadTimelineTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void roundTrip();
+        void partialBlockAtUsedLength();
+        void tornBlockCutOff();
+        void paddedVersion1();
+
+    private:
+        typedef std::map<std::vector<unsigned char>, std::vector<CTimelineRead>> CReadsByEpc;
+
+        static void append(CReadTimeline &timeline, CReadsByEpc &expected, const std::vector<unsigned char> &epc,
+                           std::uint64_t timeStampUSec, int antennaId, std::int8_t peakRSSI);
+
+        static void verify(const QString &path, const CReadsByEpc &expected);
+    };
+
+
+    void CReadTimelineTest::append(CReadTimeline &timeline, CReadsByEpc &expected,
+                                   const std::vector<unsigned char> &epc, std::uint64_t timeStampUSec, int antennaId,
+                                   std::int8_t peakRSSI)
+    {
+        CTagInfo tagInfo;
+        tagInfo.data = epc;
+        tagInfo.setTimeStampUSec(timeStampUSec);
+        tagInfo.AntennaId = antennaId;
+        tagInfo.setPeakRSSI(peakRSSI);
+        timeline.append(tagInfo);
+
+        expected[epc].push_back({ timeStampUSec, antennaId, peakRSSI });
+    }
+
+
+    void CReadTimelineTest::verify(const QString &path, const CReadsByEpc &expected)
+    {
+        CReadTimelineReader reader;
+        QVERIFY2(reader.open(path), qPrintable(reader.getErrorString()));
+        QCOMPARE(reader.getEpcs().size(), expected.size());
+
+        for (const auto &chip : expected)
+        {
+            std::vector<CTimelineRead> wanted = chip.second;
+            std::stable_sort(wanted.begin(), wanted.end(), [](const CTimelineRead &a, const CTimelineRead &b)
+            { return a.timeStampUSec < b.timeStampUSec; });
+
+            std::vector<CTimelineRead> reads;
+            QVERIFY2(reader.read(chip.first, 0, UINT64_MAX, reads), qPrintable(reader.getErrorString()));
+            QCOMPARE(reader.getReadCount(chip.first), static_cast<std::uint64_t>(wanted.size()));
+            QCOMPARE(reads.size(), wanted.size());
+            for (std::size_t i = 0; i < reads.size(); i++)
+            {
+                QCOMPARE(reads[i].timeStampUSec, wanted[i].timeStampUSec);
+                QCOMPARE(reads[i].antennaId, wanted[i].antennaId);
+                QCOMPARE(reads[i].peakRSSI, wanted[i].peakRSSI);
+            }
+        }
+    }
+
+
+    void CReadTimelineTest::roundTrip()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("reads.lapstml");
+
+        CReadTimeline timeline;
+        QVERIFY(timeline.open(path.toStdString()));
+
+        /* Enough reads of one chip for several full blocks, a few of the others */
+        CReadsByEpc expected;
+        std::uint64_t timeStampUSec = CTestTags::START_USEC;
+        for (int i = 0; i < 3000; i++)
+        {
+            timeStampUSec += 1000 + static_cast<std::uint64_t>(i % 7) * 113;
+            append(timeline, expected, CTestTags::epc(1), timeStampUSec, 1 + i % 4,
+                   static_cast<std::int8_t>(-40 - i % 30));
+            if (0 == i % 100)
+            {
+                append(timeline, expected, CTestTags::epc(2), timeStampUSec + 7, 12, -71);
+            }
+        }
+
+        /* A second reader's reads arriving a little late */
+        append(timeline, expected, CTestTags::epc(3), timeStampUSec, 7, 0);
+        append(timeline, expected, CTestTags::epc(3), timeStampUSec - 250000, 8, -55);
+        append(timeline, expected, CTestTags::epc(3), timeStampUSec + 3, 300, 12);
+        timeline.close();
+
+        std::uint64_t blocks = timeline.getBlockCount();
+        QVERIFY(blocks > 3);
+        QVERIFY(std::filesystem::file_size(path.toStdString()) <
+                CReadTimeline::HEADER_SIZE + blocks * CReadTimeline::BLOCK_SIZE);
+
+        verify(path, expected);
+
+        CReadTimelineReader reader;
+        QVERIFY(reader.open(path));
+        QCOMPARE(reader.getBlockCount(), blocks);
+    }
+
+
+    void CReadTimelineTest::partialBlockAtUsedLength()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("reads.lapstml");
+
+        CReadTimeline timeline;
+        QVERIFY(timeline.open(path.toStdString()));
+
+        CReadsByEpc expected;
+        append(timeline, expected, CTestTags::epc(1), CTestTags::START_USEC, 2, -60);
+        append(timeline, expected, CTestTags::epc(1), CTestTags::START_USEC + 1000ULL, 9, -61);
+        timeline.flush();
+        QCOMPARE(timeline.getBlockCount(), static_cast<std::uint64_t>(1));
+
+        /* Header, EPC, then 1 + 1 bytes for the first read and 2 + 1 + 1 for the second */
+        std::uint64_t size = CReadTimeline::HEADER_SIZE + CReadTimeline::BLOCK_HEADER_SIZE +
+                             CTestTags::epc(1).size() + 2 + 4;
+        QCOMPARE(static_cast<std::uint64_t>(std::filesystem::file_size(path.toStdString())), size);
+
+        /* Reads after a flush start a new block right behind it */
+        append(timeline, expected, CTestTags::epc(1), CTestTags::START_USEC + 9000ULL, 3, -62);
+        timeline.close();
+        QCOMPARE(timeline.getBlockCount(), static_cast<std::uint64_t>(2));
+
+        verify(path, expected);
+    }
+
+
+    void CReadTimelineTest::tornBlockCutOff()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("reads.lapstml");
+
+        CReadsByEpc expected;
+        CReadsByEpc torn;
+        {
+            CReadTimeline timeline;
+            QVERIFY(timeline.open(path.toStdString()));
+            append(timeline, expected, CTestTags::epc(1), CTestTags::START_USEC, 1, -50);
+            append(timeline, expected, CTestTags::epc(2), CTestTags::START_USEC + 1000ULL, 2, -51);
+            timeline.flush();
+            append(timeline, torn, CTestTags::epc(1), CTestTags::START_USEC + 2000ULL, 1, -52);
+            timeline.close();
+        }
+
+        /* The writer died part way through the last block */
+        std::uint64_t size = std::filesystem::file_size(path.toStdString());
+        std::filesystem::resize_file(path.toStdString(), size - 2);
+        verify(path, expected);
+
+        {
+            CReadTimeline timeline;
+            QVERIFY(timeline.open(path.toStdString()));
+            QCOMPARE(timeline.getBlockCount(), static_cast<std::uint64_t>(2));
+            append(timeline, expected, CTestTags::epc(2), CTestTags::START_USEC + 3000ULL, 4, -53);
+            timeline.close();
+        }
+        verify(path, expected);
+    }
+
+
+    void CReadTimelineTest::paddedVersion1()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("reads.lapstml");
+
+        CReadsByEpc expected;
+        {
+            CReadTimeline timeline;
+            QVERIFY(timeline.open(path.toStdString()));
+            append(timeline, expected, CTestTags::epc(1), CTestTags::START_USEC, 1, -50);
+            timeline.flush();
+            append(timeline, expected, CTestTags::epc(2), CTestTags::START_USEC + 1000ULL, 12, -51);
+            timeline.close();
+        }
+
+        /* The same blocks as version 1 wrote them, each zero filled to BLOCK_SIZE */
+        std::ifstream in(path.toStdString(), std::ios::binary);
+        std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        std::vector<char> padded(file.begin(), file.begin() + CReadTimeline::HEADER_SIZE);
+        padded[8] = 1;
+        std::size_t offset = CReadTimeline::HEADER_SIZE;
+        while (offset < file.size())
+        {
+            std::size_t length = CReadTimeline::getBlockLength(reinterpret_cast<unsigned char *>(&file[offset]));
+            padded.insert(padded.end(), file.begin() + offset, file.begin() + offset + length);
+            padded.resize(padded.size() + CReadTimeline::BLOCK_SIZE - length, 0);
+            offset += length;
+        }
+        std::ofstream out(path.toStdString(), std::ios::binary | std::ios::trunc);
+        out.write(padded.data(), static_cast<std::streamsize>(padded.size()));
+        out.close();
+
+        verify(path, expected);
+
+        /* Appending would mix the two layouts */
+        CReadTimeline timeline;
+        QVERIFY(!timeline.open(path.toStdString()));
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CReadTimelineTest)
+
+#include "readtimelinetest.moc"
@@ -0,0 +1,298 @@
+//********************************************************************
+//    created:    2026-10-19 12:40 PM
+//    file:       replicationtest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * A primary and a standby over a loopback connection. The standby's
+ * counter ends up in the primary's state from the journal alone, from
+ * a snapshot and the journal after it, and again once the primary's
+ * journal is started over. Failover fires only for a standby that
+ * synced, and the journal it takes over carries on from every read
+ * replicated.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QTcpServer>
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "ccheckpointer.h"
+#include "clapcounter.h"
+#include "creplication.h"
+#include "ctagjournal.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CReplicationTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void journalOnly();
+        void snapshotThenJournal();
+        void journalStartedOver();
+        void failoverOnlyOnceSynced();
+
+    private:
+        static std::vector<CTagInfo> race(unsigned char firstChip, int riders, int laps);
+
+        static std::vector<unsigned char> stateOf(const CLapCounter &lapCounter);
+
+        const static int TIMEOUT_MS;
+    };
+
+    const int CReplicationTest::TIMEOUT_MS = 5000;
+
+
+    // A read a crossing, a lap every 30 s, the riders half a second apart
+    std::vector<CTagInfo> CReplicationTest::race(unsigned char firstChip, int riders, int laps)
+    {
+        std::vector<CTagInfo> reads;
+        for (int lap = 0; lap < laps; lap++)
+        {
+            for (int rider = 0; rider < riders; rider++)
+            {
+                reads.push_back(CTestTags::read(static_cast<unsigned char>(firstChip + rider),
+                                                CTestTags::START_USEC + lap * 30000000ULL + rider * 500000ULL));
+            }
+        }
+        return reads;
+    }
+
+
+    std::vector<unsigned char> CReplicationTest::stateOf(const CLapCounter &lapCounter)
+    {
+        std::vector<unsigned char> state;
+        lapCounter.saveState(state);
+        return state;
+    }
+
+
+    void CReplicationTest::journalOnly()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        QVERIFY(journal.open(dir.filePath("primary.jrn").toStdString()));
+        lapCounter.setJournal(&journal);
+
+        std::vector<CTagInfo> reads = race(1, 4, 10);
+        for (std::size_t i = 0; i < reads.size() / 2; i++)
+        {
+            lapCounter.onNewTag(reads[i]);
+        }
+        journal.flush();
+
+        CReplicationPrimary primary(dir.filePath("primary.jrn"), dir.filePath("primary.snap"));
+        QVERIFY2(primary.listen(0, QHostAddress::LocalHost), qPrintable(primary.getErrorString()));
+
+        CLapCounter standbyCounter;
+        CReplicationStandby standby(standbyCounter, dir.filePath("standby.jrn"), dir.filePath("standby.snap"));
+        standby.connectToPrimary("127.0.0.1", primary.getPort());
+
+        QTRY_VERIFY_WITH_TIMEOUT(standby.isSynced(), TIMEOUT_MS);
+        QTRY_COMPARE_WITH_TIMEOUT(standby.getAppliedCount(), static_cast<std::uint64_t>(reads.size() / 2), TIMEOUT_MS);
+        QVERIFY(stateOf(standbyCounter) == stateOf(lapCounter));
+
+        /* Reads after the standby joined come in as the journal grows */
+        for (std::size_t i = reads.size() / 2; i < reads.size(); i++)
+        {
+            lapCounter.onNewTag(reads[i]);
+        }
+        journal.flush();
+
+        QTRY_COMPARE_WITH_TIMEOUT(standby.getAppliedCount(), static_cast<std::uint64_t>(reads.size()), TIMEOUT_MS);
+        QVERIFY(stateOf(standbyCounter) == stateOf(lapCounter));
+        QVERIFY(!QFile::exists(dir.filePath("standby.snap")));
+    }
+
+
+    void CReplicationTest::snapshotThenJournal()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        CCheckpointer checkpointer(lapCounter, journal, dir.filePath("primary.snap"));
+        QVERIFY2(checkpointer.restore(dir.filePath("primary.jrn")), qPrintable(checkpointer.getErrorString()));
+
+        std::vector<CTagInfo> reads = race(1, 4, 10);
+        std::size_t snapshotAt = reads.size() * 2 / 3;
+        for (std::size_t i = 0; i < reads.size(); i++)
+        {
+            if (snapshotAt == i)
+            {
+                checkpointer.checkpoint();
+            }
+            lapCounter.onNewTag(reads[i]);
+        }
+        journal.flush();
+        QTRY_COMPARE_WITH_TIMEOUT(checkpointer.getSnapshotCount(), static_cast<std::uint64_t>(1), TIMEOUT_MS);
+
+        CReplicationPrimary primary(dir.filePath("primary.jrn"), dir.filePath("primary.snap"));
+        QVERIFY2(primary.listen(0, QHostAddress::LocalHost), qPrintable(primary.getErrorString()));
+
+        CLapCounter standbyCounter;
+        CReplicationStandby standby(standbyCounter, dir.filePath("standby.jrn"), dir.filePath("standby.snap"));
+        standby.connectToPrimary("127.0.0.1", primary.getPort());
+
+        /* Only the reads after the snapshot come from the journal */
+        QTRY_COMPARE_WITH_TIMEOUT(standby.getAppliedCount(), static_cast<std::uint64_t>(reads.size() - snapshotAt),
+                                  TIMEOUT_MS);
+        QVERIFY(stateOf(standbyCounter) == stateOf(lapCounter));
+        QVERIFY(QFile::exists(dir.filePath("standby.snap")));
+
+        /* The mirrored files restore to the same counter */
+        CLapCounter restoredCounter;
+        CTagJournal restoredJournal;
+        CCheckpointer restored(restoredCounter, restoredJournal, dir.filePath("standby.snap"));
+        QVERIFY2(restored.restore(dir.filePath("standby.jrn")), qPrintable(restored.getErrorString()));
+        QCOMPARE(restored.getReplayedCount(), static_cast<std::uint64_t>(reads.size() - snapshotAt));
+        QVERIFY(stateOf(restoredCounter) == stateOf(lapCounter));
+    }
+
+
+    void CReplicationTest::journalStartedOver()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString journalPath = dir.filePath("primary.jrn");
+        QString snapshotPath = dir.filePath("primary.snap");
+
+        CReplicationPrimary primary(journalPath, snapshotPath);
+        QVERIFY2(primary.listen(0, QHostAddress::LocalHost), qPrintable(primary.getErrorString()));
+
+        CLapCounter standbyCounter;
+        CReplicationStandby standby(standbyCounter, dir.filePath("standby.jrn"), dir.filePath("standby.snap"));
+
+        std::vector<CTagInfo> reads = race(1, 4, 10);
+        std::size_t snapshotAt = reads.size() / 2;
+        {
+            CLapCounter lapCounter;
+            CTagJournal journal;
+            CCheckpointer checkpointer(lapCounter, journal, snapshotPath);
+            QVERIFY2(checkpointer.restore(journalPath), qPrintable(checkpointer.getErrorString()));
+            for (std::size_t i = 0; i < reads.size(); i++)
+            {
+                if (snapshotAt == i)
+                {
+                    checkpointer.checkpoint();
+                }
+                lapCounter.onNewTag(reads[i]);
+            }
+            journal.flush();
+            QTRY_COMPARE_WITH_TIMEOUT(checkpointer.getSnapshotCount(), static_cast<std::uint64_t>(1), TIMEOUT_MS);
+
+            standby.connectToPrimary("127.0.0.1", primary.getPort());
+            QTRY_COMPARE_WITH_TIMEOUT(standby.getAppliedCount(), static_cast<std::uint64_t>(reads.size() - snapshotAt),
+                                      TIMEOUT_MS);
+            QVERIFY(stateOf(standbyCounter) == stateOf(lapCounter));
+            QVERIFY(QFile::exists(dir.filePath("standby.snap")));
+        }
+
+        /*
+         * The primary's files are gone and it starts a new journal, past
+         * where the old snapshot pointed but short of the old journal. The
+         * snapshot cached for the old journal must not be sent.
+         */
+        QVERIFY(QFile::remove(snapshotPath));
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        QVERIFY(journal.open(journalPath.toStdString()));
+        lapCounter.setJournal(&journal);
+
+        std::vector<CTagInfo> others = race(11, 3, 10);
+        others.resize(reads.size() * 3 / 4);
+        for (const CTagInfo &tagInfo : others)
+        {
+            lapCounter.onNewTag(tagInfo);
+        }
+        journal.flush();
+
+        QTRY_VERIFY_WITH_TIMEOUT(stateOf(standbyCounter) == stateOf(lapCounter), TIMEOUT_MS);
+        QVERIFY(standby.isSynced());
+        QCOMPARE(standbyCounter.getRiderCount(), static_cast<std::size_t>(3));
+        QVERIFY(!QFile::exists(dir.filePath("standby.snap")));
+    }
+
+
+    void CReplicationTest::failoverOnlyOnceSynced()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        /* A port nobody listens on */
+        quint16 closedPort;
+        {
+            QTcpServer server;
+            QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+            closedPort = server.serverPort();
+        }
+
+        {
+            CLapCounter standbyCounter;
+            CReplicationStandby standby(standbyCounter, dir.filePath("never.jrn"), dir.filePath("never.snap"));
+            QSignalSpy lost(&standby, &CReplicationStandby::primaryLost);
+            standby.connectToPrimary("127.0.0.1", closedPort);
+
+            QTest::qWait(3 * CReplicationStandby::FAILOVER_TIMEOUT_MS);
+            QVERIFY(!standby.isSynced());
+            QCOMPARE(lost.count(), 0);
+        }
+
+        CLapCounter lapCounter;
+        CTagJournal journal;
+        QVERIFY(journal.open(dir.filePath("primary.jrn").toStdString()));
+        lapCounter.setJournal(&journal);
+        std::vector<CTagInfo> reads = race(1, 4, 10);
+        for (const CTagInfo &tagInfo : reads)
+        {
+            lapCounter.onNewTag(tagInfo);
+        }
+        journal.flush();
+
+        CLapCounter standbyCounter;
+        CReplicationStandby standby(standbyCounter, dir.filePath("standby.jrn"), dir.filePath("standby.snap"));
+        QSignalSpy lost(&standby, &CReplicationStandby::primaryLost);
+        {
+            CReplicationPrimary primary(dir.filePath("primary.jrn"), dir.filePath("primary.snap"));
+            QVERIFY2(primary.listen(0, QHostAddress::LocalHost), qPrintable(primary.getErrorString()));
+            standby.connectToPrimary("127.0.0.1", primary.getPort());
+            QTRY_COMPARE_WITH_TIMEOUT(standby.getAppliedCount(), static_cast<std::uint64_t>(reads.size()), TIMEOUT_MS);
+            QCOMPARE(lost.count(), 0);
+        }
+
+        /* The standby tries to reconnect and still has the primary's state when it gives up */
+        QTRY_COMPARE_WITH_TIMEOUT(lost.count(), 1, TIMEOUT_MS);
+        QVERIFY(standby.isSynced());
+
+        CTagJournal standbyJournal;
+        QVERIFY2(standby.takeOver(standbyJournal), qPrintable(standby.getErrorString()));
+        QCOMPARE(standbyJournal.getRecordCount(), static_cast<std::uint64_t>(reads.size()));
+        QVERIFY(stateOf(standbyCounter) == stateOf(lapCounter));
+        standbyCounter.setJournal(nullptr);
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CReplicationTest)
+
+#include "replicationtest.moc"
@@ -0,0 +1,243 @@
+//********************************************************************
+//    created:    2026-10-19 02:40 PM
+//    file:       rosterindextest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Every chip registered with CRosterIndex is found, one at a time and
+ * through resolve(), so the Bloom filter never turns a registered chip
+ * away. Chips that fill their bucket spill into the next ones, round
+ * the end of the table too, and are still found there, while chips
+ * that are not registered stop at the end of the run.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <QtTest>
+
+#include "croaccessreportdecoder.h"
+#include "crosterindex.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CRosterIndexTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void empty();
+        void noFalseNegatives();
+        void otherEpcLengths();
+        void bucketOverflow();
+
+    private:
+        static CTagRecord record(const std::vector<unsigned char> &epc);
+
+        // find() and resolve() agree with the map, for its chips and the ones given
+        static void check(const CRosterIndex &index, const std::map<std::vector<unsigned char>, std::int64_t> &chips,
+                          const std::vector<std::vector<unsigned char>> &unregistered);
+
+        // The bucket CRosterIndex puts a 96-bit EPC in, of a table of bucketCount
+        static std::uint64_t bucketOf(const std::vector<unsigned char> &epc, std::uint64_t bucketCount);
+    };
+
+
+    CTagRecord CRosterIndexTest::record(const std::vector<unsigned char> &epc)
+    {
+        CTagRecord tagRecord = CTagRecord();
+        tagRecord.epc = epc.data();
+        tagRecord.epcBits = static_cast<std::uint16_t>(epc.size() * 8);
+        return tagRecord;
+    }
+
+
+    void CRosterIndexTest::check(const CRosterIndex &index,
+                                 const std::map<std::vector<unsigned char>, std::int64_t> &chips,
+                                 const std::vector<std::vector<unsigned char>> &unregistered)
+    {
+        std::vector<CTagRecord> records;
+        std::vector<std::int64_t> expected;
+        for (const auto &chip : chips)
+        {
+            QCOMPARE(index.find(chip.first.data(), chip.first.size()), chip.second);
+            records.push_back(record(chip.first));
+            expected.push_back(chip.second);
+        }
+        for (const std::vector<unsigned char> &epc : unregistered)
+        {
+            QCOMPARE(index.find(epc.data(), epc.size()), CRosterIndex::NOT_REGISTERED);
+            records.push_back(record(epc));
+            expected.push_back(CRosterIndex::NOT_REGISTERED);
+        }
+
+        /* Registered and unregistered interleaved, across several runs of the resolver */
+        std::mt19937 shuffle(7);
+        std::vector<std::size_t> order(records.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), shuffle);
+
+        std::vector<CTagRecord> shuffled;
+        for (std::size_t i : order)
+        {
+            shuffled.push_back(records[i]);
+        }
+        std::vector<std::int64_t> riderIds(shuffled.size(), 12345);
+        QCOMPARE(index.resolve(shuffled.data(), shuffled.size(), riderIds.data()), chips.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            QCOMPARE(riderIds[i], expected[order[i]]);
+        }
+    }
+
+
+    std::uint64_t CRosterIndexTest::bucketOf(const std::vector<unsigned char> &epc, std::uint64_t bucketCount)
+    {
+        /* A copy of the index's hash, only used to pick chips that share a bucket */
+        std::uint64_t high;
+        std::uint32_t low;
+        std::memcpy(&high, epc.data(), sizeof(high));
+        std::memcpy(&low, epc.data() + sizeof(high), sizeof(low));
+
+        std::uint64_t hash = high ^ (static_cast<std::uint64_t>(low) * 0x9e3779b97f4a7c15ULL);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return (hash >> 20) & (bucketCount - 1);
+    }
+
+
+    void CRosterIndexTest::empty()
+    {
+        std::map<std::vector<unsigned char>, std::int64_t> none;
+        CRosterIndex index;
+        QVERIFY(index.empty());
+        check(index, none, { CTestTags::epc(1), { 0x30, 0x00 } });
+
+        CRosterIndex built(none);
+        QVERIFY(built.empty());
+        check(built, none, { CTestTags::epc(1) });
+    }
+
+
+    void CRosterIndexTest::noFalseNegatives()
+    {
+        /* A box of chips numbered in order, and a few from other batches */
+        std::map<std::vector<unsigned char>, std::int64_t> chips;
+        std::vector<std::vector<unsigned char>> unregistered;
+        std::mt19937 generator(2026);
+        for (std::uint32_t n = 0; n < 20000; n++)
+        {
+            std::vector<unsigned char> epc = CTestTags::epc(0);
+            for (int i = 0; i < 4; i++)
+            {
+                epc[epc.size() - 1 - i] = static_cast<unsigned char>(n >> (8 * i));
+            }
+
+            /* Every other serial is registered, the ones between are not */
+            if (n % 2)
+            {
+                unregistered.push_back(epc);
+                continue;
+            }
+            chips[epc] = static_cast<std::int64_t>(n % 7);      // rider 0 is a chip with no rider
+        }
+        for (int n = 0; n < 2000; n++)
+        {
+            std::vector<unsigned char> epc(12);
+            for (unsigned char &byte : epc)
+            {
+                byte = static_cast<unsigned char>(generator());
+            }
+            chips[epc] = 1000 + n;
+        }
+
+        CRosterIndex index(chips);
+        QCOMPARE(index.size(), chips.size());
+        check(index, chips, unregistered);
+    }
+
+
+    void CRosterIndexTest::otherEpcLengths()
+    {
+        std::map<std::vector<unsigned char>, std::int64_t> chips;
+        chips[CTestTags::epc(1)] = 1;
+        chips[{ 0x30, 0x00, 0x12, 0x34 }] = 2;
+        chips[std::vector<unsigned char>(16, 0xe2)] = 3;
+
+        /* The 96-bit EPC's first eight bytes are another chip */
+        std::vector<unsigned char> prefix = CTestTags::epc(1);
+        prefix.resize(8);
+
+        CRosterIndex index(chips);
+        QCOMPARE(index.size(), static_cast<std::size_t>(3));
+        check(index, chips, { prefix, { 0x30, 0x00, 0x12 }, std::vector<unsigned char>(16, 0xe3) });
+    }
+
+
+    void CRosterIndexTest::bucketOverflow()
+    {
+        /* 24 chips get 8 buckets of 8: the last one is given 20, 12 of them carry on round to the first */
+        const std::uint64_t bucketCount = 8;
+        std::map<std::vector<unsigned char>, std::int64_t> chips;
+        std::vector<std::vector<unsigned char>> unregistered;
+        for (std::uint32_t n = 0; chips.size() < 24 || unregistered.size() < 10; n++)
+        {
+            std::vector<unsigned char> epc = CTestTags::epc(0);
+            for (int i = 0; i < 4; i++)
+            {
+                epc[epc.size() - 1 - i] = static_cast<unsigned char>(n >> (8 * i));
+            }
+
+            std::uint64_t bucket = bucketOf(epc, bucketCount);
+            std::size_t crowded = 0;
+            for (const auto &chip : chips)
+            {
+                crowded += (bucketCount - 1 == bucketOf(chip.first, bucketCount));
+            }
+
+            if (bucketCount - 1 == bucket && crowded < 20)
+            {
+                chips[epc] = 1 + n;
+            }
+            else if (bucketCount - 1 != bucket && 1 != bucket && chips.size() - crowded < 4)
+            {
+                chips[epc] = 1 + n;
+            }
+            else if (bucketCount - 1 == bucket && 20 == crowded && unregistered.size() < 10)
+            {
+                unregistered.push_back(epc);
+            }
+        }
+
+        CRosterIndex index(chips);
+        QCOMPARE(index.size(), static_cast<std::size_t>(24));
+        check(index, chips, unregistered);
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CRosterIndexTest)
+
+#include "rosterindextest.moc"
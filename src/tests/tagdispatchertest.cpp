@@ -0,0 +1,225 @@
+//********************************************************************
+//    created:    2026-10-19 01:40 PM
+//    file:       tagdispatchertest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * The overload policies of a full CTagStage: Block holds the reader
+ * back and loses nothing, Coalesce keeps the latest read of each chip
+ * waiting, Shed drops what it cannot coalesce and everything while a
+ * stage of the dispatcher's that matters is full.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QtTest>
+
+#include "ctagdispatcher.h"
+#include "testtags.h"
+
+namespace LLRPLaps
+{
+    class CTagDispatcherTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void blockFromReaderThread();
+        void blockOnOwnThread();
+        void coalesce();
+        void shed();
+        void shedWhileAnotherStageIsFull();
+
+    private:
+        // Every read the stage hands out, in order
+        static void collect(CTagStage &stage, std::vector<CTagInfo> &delivered);
+
+        const static int TIMEOUT_MS;
+    };
+
+    const int CTagDispatcherTest::TIMEOUT_MS = 5000;
+
+
+    void CTagDispatcherTest::collect(CTagStage &stage, std::vector<CTagInfo> &delivered)
+    {
+        connect(&stage, &CTagStage::newTag, [&delivered](const LLRPLaps::CTagInfo &tagInfo)
+        { delivered.push_back(tagInfo); });
+    }
+
+
+    void CTagDispatcherTest::blockFromReaderThread()
+    {
+        const int reads = 1000;
+        CTagStage stage("laps", 4, CTagStage::Block);
+        std::vector<CTagInfo> delivered;
+        collect(stage, delivered);
+
+        std::atomic<int> accepted(0);
+        std::thread reader([&]
+        {
+            for (int i = 0; i < reads; i++)
+            {
+                accepted += stage.offer(CTestTags::read(static_cast<unsigned char>(i % 3),
+                                                        CTestTags::START_USEC + i), false) ? 1 : 0;
+            }
+        });
+
+        /* Nothing is drained until the stage has filled, the reader has to wait */
+        while (!stage.isFull())
+        {
+            std::this_thread::yield();
+        }
+        for (int waited = 0; delivered.size() < static_cast<std::size_t>(reads) && waited < TIMEOUT_MS; waited += 10)
+        {
+            QTest::qWait(10);
+        }
+        reader.join();
+
+        QCOMPARE(delivered.size(), static_cast<std::size_t>(reads));
+        QCOMPARE(accepted.load(), reads);
+        for (int i = 0; i < reads; i++)
+        {
+            QCOMPARE(delivered[i].getTimeStampUSec(), CTestTags::START_USEC + i);
+        }
+
+        CTagStage::Counters counters = stage.getCounters();
+        QCOMPARE(counters.offered, static_cast<std::uint64_t>(reads));
+        QCOMPARE(counters.delivered, static_cast<std::uint64_t>(reads));
+        QVERIFY(counters.blocked > 0);
+        QCOMPARE(counters.coalesced + counters.dropped + counters.shed, static_cast<std::uint64_t>(0));
+        QCOMPARE(counters.maxDepth, static_cast<std::size_t>(4));
+        QCOMPARE(counters.depth, static_cast<std::size_t>(0));
+    }
+
+
+    void CTagDispatcherTest::blockOnOwnThread()
+    {
+        CTagStage stage("laps", 2, CTagStage::Block);
+        std::vector<CTagInfo> delivered;
+        collect(stage, delivered);
+
+        /* A full stage offered to on its own thread hands out what waits in place instead of waiting */
+        for (int i = 0; i < 3; i++)
+        {
+            QVERIFY(stage.offer(CTestTags::read(1, CTestTags::START_USEC + i), false));
+        }
+        QCOMPARE(delivered.size(), static_cast<std::size_t>(2));
+        QCOMPARE(stage.getCounters().blocked, static_cast<std::uint64_t>(1));
+
+        QTRY_COMPARE_WITH_TIMEOUT(delivered.size(), static_cast<std::size_t>(3), TIMEOUT_MS);
+        QCOMPARE(delivered[2].getTimeStampUSec(), CTestTags::START_USEC + 2);
+    }
+
+
+    void CTagDispatcherTest::coalesce()
+    {
+        CTagStage stage("output", 3, CTagStage::Coalesce);
+        std::vector<CTagInfo> delivered;
+        collect(stage, delivered);
+
+        for (unsigned char chip = 1; chip <= 3; chip++)
+        {
+            QVERIFY(stage.offer(CTestTags::read(chip, CTestTags::START_USEC + chip), false));
+        }
+
+        /* Full: a chip already waiting has its read replaced where it is */
+        QVERIFY(!stage.offer(CTestTags::read(2, CTestTags::START_USEC + 20, 4), false));
+        QVERIFY(!stage.offer(CTestTags::read(2, CTestTags::START_USEC + 21, 5), false));
+        QCOMPARE(stage.getCounters().coalesced, static_cast<std::uint64_t>(2));
+        QVERIFY(delivered.empty());
+
+        /* A chip not waiting gets through, once what waits is handed out */
+        QVERIFY(stage.offer(CTestTags::read(4, CTestTags::START_USEC + 30), false));
+        QTRY_COMPARE_WITH_TIMEOUT(delivered.size(), static_cast<std::size_t>(4), TIMEOUT_MS);
+
+        const unsigned char chips[] = { 1, 2, 3, 4 };
+        const std::uint64_t times[] = { 1, 21, 3, 30 };
+        for (std::size_t i = 0; i < 4; i++)
+        {
+            QVERIFY(delivered[i].data == CTestTags::epc(chips[i]));
+            QCOMPARE(delivered[i].getTimeStampUSec(), CTestTags::START_USEC + times[i]);
+        }
+        QCOMPARE(delivered[1].AntennaId, 5);
+
+        CTagStage::Counters counters = stage.getCounters();
+        QCOMPARE(counters.offered, static_cast<std::uint64_t>(6));
+        QCOMPARE(counters.delivered, static_cast<std::uint64_t>(4));
+        QCOMPARE(counters.blocked, static_cast<std::uint64_t>(1));
+        QCOMPARE(counters.dropped, static_cast<std::uint64_t>(0));
+    }
+
+
+    void CTagDispatcherTest::shed()
+    {
+        CTagStage stage("display", 2, CTagStage::Shed);
+        std::vector<CTagInfo> delivered;
+        collect(stage, delivered);
+
+        QVERIFY(stage.offer(CTestTags::read(1, CTestTags::START_USEC), false));
+        QVERIFY(stage.offer(CTestTags::read(2, CTestTags::START_USEC + 1), false));
+        QVERIFY(!stage.offer(CTestTags::read(1, CTestTags::START_USEC + 2), false));
+        QVERIFY(!stage.offer(CTestTags::read(3, CTestTags::START_USEC + 3), false));
+
+        QTRY_COMPARE_WITH_TIMEOUT(delivered.size(), static_cast<std::size_t>(2), TIMEOUT_MS);
+
+        /* Below capacity, shedding still drops */
+        QVERIFY(!stage.offer(CTestTags::read(3, CTestTags::START_USEC + 4), true));
+
+        QCOMPARE(delivered[0].getTimeStampUSec(), CTestTags::START_USEC + 2);
+        QVERIFY(delivered[1].data == CTestTags::epc(2));
+
+        CTagStage::Counters counters = stage.getCounters();
+        QCOMPARE(counters.offered, static_cast<std::uint64_t>(5));
+        QCOMPARE(counters.coalesced, static_cast<std::uint64_t>(1));
+        QCOMPARE(counters.dropped, static_cast<std::uint64_t>(1));
+        QCOMPARE(counters.shed, static_cast<std::uint64_t>(1));
+        QCOMPARE(counters.blocked, static_cast<std::uint64_t>(0));
+        QCOMPARE(counters.depth, static_cast<std::size_t>(0));
+    }
+
+
+    void CTagDispatcherTest::shedWhileAnotherStageIsFull()
+    {
+        CTagDispatcher dispatcher;
+        CTagStage *laps = dispatcher.addStage("laps", 2, CTagStage::Block, this);
+        CTagStage *display = dispatcher.addStage("display", 16, CTagStage::Shed, this);
+        std::vector<CTagInfo> lapReads;
+        std::vector<CTagInfo> displayReads;
+        collect(*laps, lapReads);
+        collect(*display, displayReads);
+
+        dispatcher.onNewTag(CTestTags::read(1, CTestTags::START_USEC));
+        dispatcher.onNewTag(CTestTags::read(2, CTestTags::START_USEC + 1));
+
+        /* The lap counter's stage is full, the display gets nothing until it drains */
+        QVERIFY(laps->isFull());
+        dispatcher.onNewTag(CTestTags::read(3, CTestTags::START_USEC + 2));
+        QCOMPARE(display->getCounters().shed, static_cast<std::uint64_t>(1));
+
+        QTRY_COMPARE_WITH_TIMEOUT(lapReads.size(), static_cast<std::size_t>(3), TIMEOUT_MS);
+        dispatcher.onNewTag(CTestTags::read(4, CTestTags::START_USEC + 3));
+        QTRY_COMPARE_WITH_TIMEOUT(lapReads.size(), static_cast<std::size_t>(4), TIMEOUT_MS);
+        QTRY_COMPARE_WITH_TIMEOUT(displayReads.size(), static_cast<std::size_t>(3), TIMEOUT_MS);
+
+        QVERIFY(displayReads[2].data == CTestTags::epc(4));
+        QVERIFY(dispatcher.report().contains("display: offered 4 delivered 3 coalesced 0 dropped 0 shed 1"));
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CTagDispatcherTest)
+
+#include "tagdispatchertest.moc"
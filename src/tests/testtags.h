@@ -0,0 +1,54 @@
+//********************************************************************
+//    created:    2026-10-19 11:40 AM
+//    file:       testtags.h
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+
+#ifndef LLRPLAPS_TESTTAGS_H
+#define LLRPLAPS_TESTTAGS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ctaginfo.h"
+
+namespace LLRPLaps
+{
+    /*
+     * The chips and race clock the tests share: 96-bit EPCs that
+     * differ in their last byte and a start time on a race evening.
+     */
+    class CTestTags
+    {
+    public:
+        static std::vector<unsigned char> epc(unsigned char chip)
+        {
+            return { 0xe2, 0x80, 0x11, 0x05, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, chip };
+        }
+
+        static CTagInfo read(unsigned char chip, std::uint64_t timeStampUSec, int antennaId = 1)
+        {
+            CTagInfo tagInfo;
+            tagInfo.data = epc(chip);
+            tagInfo.setTimeStampUSec(timeStampUSec);
+            tagInfo.AntennaId = antennaId;
+            return tagInfo;
+        }
+
+        static constexpr std::uint64_t START_USEC = 1777660200000000ULL;    // 2026-05-01 18:30 UTC
+    };
+}
+#endif //LLRPLAPS_TESTTAGS_H
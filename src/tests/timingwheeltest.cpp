@@ -0,0 +1,219 @@
+//********************************************************************
+//    created:    2026-10-19 01:10 PM
+//    file:       timingwheeltest.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Timers on every level of the wheel firing at their expiry and not
+ * before, on the way down and when one advance() skips over all of
+ * them. A timer past what the top level reaches is parked and still
+ * fires on time, and clear() leaves no timer and no id that works.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <QtTest>
+
+#include "ctimingwheel.h"
+
+namespace LLRPLaps
+{
+    class CTimingWheelTest : public QObject
+    {
+    Q_OBJECT
+    private slots:
+        void cascadeAcrossLevels();
+        void oneAdvanceOverEveryLevel();
+        void boundarySkip();
+        void maxDeltaClamped();
+        void clear();
+
+    private:
+        // The cookies of what advance() to nowUSec fired, in order
+        static std::vector<std::uint64_t> advance(CTimingWheel &wheel, std::uint64_t nowUSec);
+
+        // Expiries one level each, a tick being a microsecond
+        const static std::uint64_t EXPIRIES[4];
+    };
+
+    const std::uint64_t CTimingWheelTest::EXPIRIES[4] = { 200, 40000, 9000000, 3000000000ULL };
+
+
+    std::vector<std::uint64_t> CTimingWheelTest::advance(CTimingWheel &wheel, std::uint64_t nowUSec)
+    {
+        std::vector<CTimingWheel::Expired> expired;
+        wheel.advance(nowUSec, expired);
+
+        std::vector<std::uint64_t> cookies;
+        for (const CTimingWheel::Expired &timer : expired)
+        {
+            cookies.push_back(timer.cookie);
+        }
+        return cookies;
+    }
+
+
+    void CTimingWheelTest::cascadeAcrossLevels()
+    {
+        CTimingWheel wheel(1);
+        QVERIFY(advance(wheel, 0).empty());
+
+        CTimingWheel::TimerId ids[4];
+        for (std::uint64_t level = 0; level < 4; level++)
+        {
+            ids[level] = wheel.arm(EXPIRIES[level], level);
+        }
+        CTimingWheel::TimerId cancelled = wheel.arm(EXPIRIES[2] + 1, 99);
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(5));
+        QVERIFY(wheel.cancel(cancelled));
+        QVERIFY(!wheel.cancel(cancelled));
+
+        /* Each comes down from its level and fires on the tick it is due, not one before */
+        for (std::uint64_t level = 0; level < 4; level++)
+        {
+            QVERIFY(advance(wheel, EXPIRIES[level] - 1).empty());
+
+            std::vector<CTimingWheel::Expired> expired;
+            wheel.advance(EXPIRIES[level], expired);
+            QCOMPARE(expired.size(), static_cast<std::size_t>(1));
+            QCOMPARE(expired[0].cookie, level);
+            QCOMPARE(expired[0].id, ids[level]);
+            QCOMPARE(expired[0].expiryUSec, EXPIRIES[level]);
+            QVERIFY(!wheel.cancel(ids[level]));
+        }
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(0));
+        QCOMPARE(wheel.getNowUSec(), EXPIRIES[3]);
+    }
+
+
+    void CTimingWheelTest::oneAdvanceOverEveryLevel()
+    {
+        CTimingWheel wheel;
+
+        /* Armed before the first advance(), placed by it */
+        for (std::uint64_t level = 4; level > 0; level--)
+        {
+            wheel.arm(EXPIRIES[level - 1] * CTimingWheel::DEFAULT_TICK_USEC, level - 1);
+        }
+        wheel.arm((EXPIRIES[1] - 1) * CTimingWheel::DEFAULT_TICK_USEC - 1, 10);
+
+        QVERIFY(advance(wheel, 0).empty());
+        std::vector<std::uint64_t> cookies = advance(wheel, EXPIRIES[3] * CTimingWheel::DEFAULT_TICK_USEC);
+        QVERIFY((std::vector<std::uint64_t>{ 0, 10, 1, 2, 3 }) == cookies);
+    }
+
+
+    void CTimingWheelTest::boundarySkip()
+    {
+        CTimingWheel wheel(1);
+        QVERIFY(advance(wheel, 0).empty());
+
+        /* Only a level 2 timer: the wheel skips to its level 1 boundaries, stopping where it is told */
+        wheel.arm(EXPIRIES[2], 2);
+        std::uint64_t midWindow = EXPIRIES[2] - 1000;
+        QVERIFY(advance(wheel, midWindow).empty());
+        QCOMPARE(wheel.getNowUSec(), midWindow);
+
+        /* A timer armed after the skip is due from where the skip stopped, not the boundary after */
+        wheel.arm(midWindow + 1, 0);
+        wheel.arm(midWindow + 300, 1);
+        QVERIFY((std::vector<std::uint64_t>{ 0 }) == advance(wheel, midWindow + 1));
+        QVERIFY(advance(wheel, midWindow + 299).empty());
+        QVERIFY((std::vector<std::uint64_t>{ 1 }) == advance(wheel, midWindow + 300));
+        QVERIFY((std::vector<std::uint64_t>{ 2 }) == advance(wheel, EXPIRIES[2]));
+
+        /* Time never goes backwards, a timer already due fires on the next advance() */
+        QVERIFY(advance(wheel, 5).empty());
+        QCOMPARE(wheel.getNowUSec(), EXPIRIES[2]);
+        wheel.arm(EXPIRIES[2] - 500, 3);
+        QVERIFY((std::vector<std::uint64_t>{ 3 }) == advance(wheel, EXPIRIES[2] + 1));
+
+        /* Nothing armed, a long quiet stretch is one jump */
+        QVERIFY(advance(wheel, EXPIRIES[3] * 100).empty());
+        wheel.arm(EXPIRIES[3] * 100 + 1, 4);
+        QVERIFY((std::vector<std::uint64_t>{ 4 }) == advance(wheel, EXPIRIES[3] * 100 + 1));
+    }
+
+
+    void CTimingWheelTest::maxDeltaClamped()
+    {
+        CTimingWheel wheel(1);
+        QVERIFY(advance(wheel, 0).empty());
+
+        /* Beyond the 2^32 ticks of the top level */
+        const std::uint64_t farUSec = 1ULL << 40;
+        const std::uint64_t nearUSec = 1ULL << 33;
+        wheel.arm(farUSec, 1);
+        wheel.arm(nearUSec, 0);
+
+        QVERIFY(advance(wheel, 1ULL << 32).empty());
+        QVERIFY(advance(wheel, nearUSec - 1).empty());
+        QVERIFY((std::vector<std::uint64_t>{ 0 }) == advance(wheel, nearUSec));
+
+        /* Parked and placed again each time it comes down, never early */
+        for (std::uint64_t at = nearUSec; at < farUSec; at += 1ULL << 35)
+        {
+            QVERIFY(advance(wheel, at).empty());
+        }
+        QVERIFY(advance(wheel, farUSec - 1).empty());
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(1));
+
+        std::vector<CTimingWheel::Expired> expired;
+        wheel.advance(farUSec, expired);
+        QCOMPARE(expired.size(), static_cast<std::size_t>(1));
+        QCOMPARE(expired[0].cookie, static_cast<std::uint64_t>(1));
+        QCOMPARE(expired[0].expiryUSec, farUSec);
+    }
+
+
+    void CTimingWheelTest::clear()
+    {
+        CTimingWheel wheel(1);
+        QVERIFY(advance(wheel, 0).empty());
+
+        std::vector<CTimingWheel::TimerId> ids;
+        for (std::uint64_t level = 0; level < 4; level++)
+        {
+            ids.push_back(wheel.arm(EXPIRIES[level], level));
+        }
+        wheel.clear();
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(0));
+
+        /* Ids from before are stale, also once their nodes are used again */
+        CTimingWheel::TimerId reused = wheel.arm(EXPIRIES[1], 7);
+        for (CTimingWheel::TimerId id : ids)
+        {
+            QVERIFY(id != reused);
+            QVERIFY(!wheel.cancel(id));
+        }
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(1));
+
+        QVERIFY((std::vector<std::uint64_t>{ 7 }) == advance(wheel, EXPIRIES[3]));
+        QCOMPARE(wheel.size(), static_cast<std::size_t>(0));
+
+        /* Cleared before the first advance(), nothing is placed */
+        CTimingWheel unstarted(1);
+        unstarted.arm(10, 1);
+        unstarted.clear();
+        unstarted.arm(20, 2);
+        QVERIFY((std::vector<std::uint64_t>{ 2 }) == advance(unstarted, 30));
+    }
+}
+
+QTEST_GUILESS_MAIN(LLRPLaps::CTimingWheelTest)
+
+#include "timingwheeltest.moc"
@@ -0,0 +1,213 @@
+//********************************************************************
+//    created:    2026-10-18 01:20 PM
+//    file:       capdecode.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Offline decoder for raw LLRP capture files (CFrameCapture).
+ *
+ * The capture is memory mapped and split into chunks of records that
+ * are decoded with LTK on all cores. The per chunk summaries are then
+ * merged: message counts per type and direction, tags reported,
+ * decode errors and the time span covered. --xml instead prints every
+ * message as XML in capture order, for a closer look at a few frames.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <ltkcpp.h>
+#include "cframecapture.h"
+#include "cframecapturereader.h"
+
+namespace
+{
+    const std::size_t RECORDS_PER_CHUNK = 4096;
+
+    struct CChunk
+    {
+        std::size_t first;
+        std::size_t last;
+    };
+
+    struct CSummary
+    {
+        std::map<std::string, std::uint64_t> messages[2];      // by CFrameCapture::Direction
+        std::uint64_t tags = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t decodeErrors = 0;
+        std::uint64_t firstNSec = ~0ULL;
+        std::uint64_t lastNSec = 0;
+    };
+
+    const LLRPLaps::CFrameCaptureReader *theCapture = nullptr;
+    const LLRP::CTypeRegistry *theTypeRegistry = nullptr;
+
+
+    CSummary decodeChunk(const CChunk &chunk)
+    {
+        CSummary summary;
+
+        for (std::size_t i = chunk.first; i < chunk.last; i++)
+        {
+            LLRPLaps::CFrameCaptureReader::Record record = theCapture->getRecord(i);
+            unsigned int direction = record.direction ? 1u : 0u;
+
+            summary.bytes += record.length;
+            summary.firstNSec = std::min(summary.firstNSec, record.hostNSec);
+            summary.lastNSec = std::max(summary.lastNSec, record.hostNSec);
+
+            LLRP::CFrameDecoder decoder(theTypeRegistry, const_cast<unsigned char *>(record.frame), record.length);
+            std::unique_ptr<LLRP::CMessage> message(decoder.decodeMessage());
+            if (nullptr == message.get())
+            {
+                summary.decodeErrors++;
+                continue;
+            }
+
+            summary.messages[direction][message->m_pType->m_pName]++;
+
+            if (&LLRP::CRO_ACCESS_REPORT::s_typeDescriptor == message->m_pType)
+            {
+                auto *report = dynamic_cast<LLRP::CRO_ACCESS_REPORT *>(message.get());
+                summary.tags += static_cast<std::uint64_t>(std::distance(report->beginTagReportData(), report->endTagReportData()));
+            }
+        }
+        return summary;
+    }
+
+
+    void mergeSummary(CSummary &total, const CSummary &chunk)
+    {
+        for (int direction = 0; direction < 2; direction++)
+        {
+            for (const auto &entry : chunk.messages[direction])
+            {
+                total.messages[direction][entry.first] += entry.second;
+            }
+        }
+        total.tags += chunk.tags;
+        total.bytes += chunk.bytes;
+        total.decodeErrors += chunk.decodeErrors;
+        total.firstNSec = std::min(total.firstNSec, chunk.firstNSec);
+        total.lastNSec = std::max(total.lastNSec, chunk.lastNSec);
+    }
+
+
+    int dumpXML(const LLRPLaps::CFrameCaptureReader &capture)
+    {
+        std::vector<char> xml(1024u * 1024u);
+
+        for (std::size_t i = 0; i < capture.getRecordCount(); i++)
+        {
+            LLRPLaps::CFrameCaptureReader::Record record = capture.getRecord(i);
+            LLRP::CFrameDecoder decoder(theTypeRegistry, const_cast<unsigned char *>(record.frame), record.length);
+            std::unique_ptr<LLRP::CMessage> message(decoder.decodeMessage());
+
+            std::printf("<!-- #%zu %s %llu ns, %u bytes -->\n", i,
+                        (LLRPLaps::CFrameCapture::Outbound == record.direction) ? "host->reader" : "reader->host",
+                        static_cast<unsigned long long>(record.hostNSec), record.length);
+            if (nullptr == message.get())
+            {
+                std::printf("<!-- decode error: %s -->\n",
+                            decoder.m_ErrorDetails.m_pWhatStr ? decoder.m_ErrorDetails.m_pWhatStr : "no reason given");
+                continue;
+            }
+            message->toXMLString(xml.data(), static_cast<int>(xml.size()));
+            std::printf("%s", xml.data());
+        }
+        return 0;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Decode an LLRP capture file");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "Capture file written by CReader::setCaptureFile.");
+    parser.addOption({"threads", "Decode threads, default all cores.", "n", "0"});
+    parser.addOption({"xml", "Print every message as XML instead of a summary."});
+    parser.process(app);
+
+    if (1 != parser.positionalArguments().size())
+    {
+        parser.showHelp(1);
+    }
+
+    LLRPLaps::CFrameCaptureReader capture;
+    if (!capture.open(parser.positionalArguments().first()))
+    {
+        std::fprintf(stderr, "%s\n", capture.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    std::unique_ptr<LLRP::CTypeRegistry> typeRegistry(LLRP::getTheTypeRegistry());
+    theTypeRegistry = typeRegistry.get();
+    theCapture = &capture;
+
+    if (!capture.hasIndex())
+    {
+        std::fprintf(stderr, "warning: capture was not closed cleanly, index rebuilt\n");
+    }
+
+    if (parser.isSet("xml"))
+    {
+        return dumpXML(capture);
+    }
+
+    int threads = parser.value("threads").toInt();
+    if (threads > 0)
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    }
+
+    QVector<CChunk> chunks;
+    for (std::size_t first = 0; first < capture.getRecordCount(); first += RECORDS_PER_CHUNK)
+    {
+        chunks.append({ first, std::min(first + RECORDS_PER_CHUNK, capture.getRecordCount()) });
+    }
+
+    CSummary total = QtConcurrent::blockingMappedReduced<CSummary>(chunks, decodeChunk, mergeSummary);
+
+    double spanSec = (total.lastNSec > total.firstNSec) ? (total.lastNSec - total.firstNSec) / 1e9 : 0.0;
+    std::printf("%zu frames, %llu bytes, %.3f s, %llu tags, %llu decode errors\n", capture.getRecordCount(),
+                static_cast<unsigned long long>(total.bytes), spanSec,
+                static_cast<unsigned long long>(total.tags), static_cast<unsigned long long>(total.decodeErrors));
+
+    static const char *directionNames[] = { "reader->host", "host->reader" };
+    for (int direction = 0; direction < 2; direction++)
+    {
+        for (const auto &entry : total.messages[direction])
+        {
+            std::printf("  %-12s %-32s %10llu\n", directionNames[direction], entry.first.c_str(),
+                        static_cast<unsigned long long>(entry.second));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+//********************************************************************
+//    created:    2026-10-19 02:15 AM
+//    file:       export.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Bulk export of laps from a CLapDatabase, for spreadsheets or for
+ * analysis elsewhere:
+ *
+ *      laps_export --from 2026-01-01 --to 2027-01-01 laps.sqlite season.csv
+ *      laps_export --session 12 laps.sqlite race.lapcol
+ *
+ * The format follows the output name (see CLapExporter). Safe to run
+ * against the database of a live timing session.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+#include "clapexporter.h"
+
+namespace
+{
+    // A date or a date and time, UTC, to reader timebase microseconds
+    bool parseTime(const QString &text, u_int64_t &timeUSec)
+    {
+        QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+        if (!time.isValid())
+        {
+            return false;
+        }
+        if (Qt::LocalTime == time.timeSpec())
+        {
+            time.setTimeSpec(Qt::UTC);
+        }
+        timeUSec = static_cast<u_int64_t>(time.toMSecsSinceEpoch()) * 1000ULL;
+        return true;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Export laps to CSV or to the columnar format");
+    parser.addHelpOption();
+    parser.addPositionalArgument("database", "Lap database written by CLapDatabase.");
+    parser.addPositionalArgument("output", "Output file, .lapcol for columnar, CSV otherwise.");
+    parser.addOption({"from", "First crossing time, UTC, e.g. 2026-01-01.", "time"});
+    parser.addOption({"to", "Crossings before this time, UTC.", "time"});
+    parser.addOption({"session", "Only this session.", "id", "0"});
+    parser.addOption({"csv", "Write CSV whatever the output name."});
+    parser.process(app);
+
+    if (2 != parser.positionalArguments().size())
+    {
+        parser.showHelp(1);
+    }
+
+    LLRPLaps::CLapExporter exporter;
+    u_int64_t fromUSec = 0;
+    u_int64_t toUSec = UINT64_MAX;
+    if ((parser.isSet("from") && !parseTime(parser.value("from"), fromUSec)) ||
+        (parser.isSet("to") && !parseTime(parser.value("to"), toUSec)))
+    {
+        std::fprintf(stderr, "Times are ISO 8601, e.g. 2026-05-01 or 2026-05-01T18:30:00\n");
+        return 1;
+    }
+    exporter.setTimeRange(fromUSec, toUSec);
+    exporter.setSession(parser.value("session").toLongLong());
+
+    QString output = parser.positionalArguments().at(1);
+    LLRPLaps::CLapExporter::Format format = parser.isSet("csv") ? LLRPLaps::CLapExporter::Csv
+                                                                : LLRPLaps::CLapExporter::formatForPath(output);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    if (!exporter.exportLaps(parser.positionalArguments().at(0), output, format))
+    {
+        std::fprintf(stderr, "%s\n", exporter.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    std::printf("%llu laps in %.3f s\n", static_cast<unsigned long long>(exporter.getExportedCount()),
+                elapsed.nsecsElapsed() / 1e9);
+    return 0;
+}
@@ -0,0 +1,178 @@
+//********************************************************************
+//    created:    2026-10-19 01:10 AM
+//    file:       replica.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Primary and standby of lap stream replication in one tool, to try
+ * failover with two processes on one box:
+ *
+ *      laps_replica --primary --dir /tmp/a
+ *      laps_replica --standby 127.0.0.1 --dir /tmp/b
+ *
+ * The primary counts laps of synthetic riders, journals and
+ * checkpoints them and serves the standby. Kill the primary and the
+ * standby takes over, carrying on with the same synthetic riders
+ * where a real standby would connect to the readers. Both print the
+ * lap total every second, the standby's follows the primary's.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QTimer>
+
+#include "ccheckpointer.h"
+#include "clapcounter.h"
+#include "creplication.h"
+#include "ctaginfo.h"
+#include "ctagjournal.h"
+
+namespace
+{
+    /*
+     * Stands in for the readers: riders pass the line in turn, each
+     * read a few times per pass.
+     */
+    class CSyntheticRiders : public QObject
+    {
+    public:
+        CSyntheticRiders(LLRPLaps::CLapCounter &lapCounter, int riders, int readsPerSecond)
+                : _lapCounter(lapCounter), _riders(riders), _next(0)
+        {
+            connect(&_timer, &QTimer::timeout, this, &CSyntheticRiders::onTimeout);
+            _timer.start(1000 / std::max(1, readsPerSecond));
+        }
+
+    private:
+        void onTimeout()
+        {
+            LLRPLaps::CTagInfo tagInfo;
+            tagInfo.data = { 0xE2, 0x80, 0x11, 0x05, static_cast<unsigned char>(_next / 3 % _riders) };
+            tagInfo.AntennaId = 1 + (_next & 3);
+            tagInfo.setTimeStampUSec(static_cast<u_int64_t>(QDateTime::currentMSecsSinceEpoch()) * 1000ULL);
+            _lapCounter.onNewTag(tagInfo);
+            _next++;
+        }
+
+        LLRPLaps::CLapCounter &_lapCounter;
+        int _riders;
+        int _next;
+        QTimer _timer;
+    };
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Lap stream replication, primary or standby");
+    parser.addHelpOption();
+    parser.addOption({"primary", "Count laps and serve standbys."});
+    parser.addOption({"standby", "Follow the primary on host.", "host"});
+    parser.addOption({"port", "Replication port.", "port", QString::number(LLRPLaps::CReplicationPrimary::DEFAULT_PORT)});
+    parser.addOption({"dir", "Directory for the journal and snapshot.", "dir", "."});
+    parser.addOption({"riders", "Synthetic riders.", "n", "20"});
+    parser.addOption({"rate", "Synthetic reads per second.", "n", "200"});
+    parser.process(app);
+
+    if (parser.isSet("primary") == parser.isSet("standby"))
+    {
+        parser.showHelp(1);
+    }
+
+    QDir dir(parser.value("dir"));
+    QString journalPath = dir.filePath("laps.journal");
+    QString snapshotPath = dir.filePath("laps.snapshot");
+    quint16 port = static_cast<quint16>(parser.value("port").toUInt());
+    int riders = parser.value("riders").toInt();
+    int rate = parser.value("rate").toInt();
+
+    /* Short laps so a few seconds of synthetic riders make some */
+    LLRPLaps::CLapCounter lapCounter(1000000ULL);
+    LLRPLaps::CTagJournal journal;
+    std::unique_ptr<LLRPLaps::CCheckpointer> checkpointer;
+    std::unique_ptr<LLRPLaps::CReplicationPrimary> primary;
+    std::unique_ptr<LLRPLaps::CReplicationStandby> standby;
+    std::unique_ptr<CSyntheticRiders> synthetic;
+    quint64 laps = 0;
+
+    QObject::connect(&lapCounter, &LLRPLaps::CLapCounter::newLap, [&laps](const LLRPLaps::CLapInfo &)
+    { laps++; });
+
+    auto becomePrimary = [&]()
+    {
+        checkpointer.reset(new LLRPLaps::CCheckpointer(lapCounter, journal, snapshotPath));
+        checkpointer->start();
+        synthetic.reset(new CSyntheticRiders(lapCounter, riders, rate));
+    };
+
+    if (parser.isSet("primary"))
+    {
+        checkpointer.reset(new LLRPLaps::CCheckpointer(lapCounter, journal, snapshotPath));
+        if (!checkpointer->restore(journalPath))
+        {
+            std::fprintf(stderr, "%s\n", checkpointer->getErrorString().toLocal8Bit().constData());
+            return 1;
+        }
+        std::printf("restored, %llu reads replayed\n", static_cast<unsigned long long>(checkpointer->getReplayedCount()));
+        checkpointer->start();
+        synthetic.reset(new CSyntheticRiders(lapCounter, riders, rate));
+
+        primary.reset(new LLRPLaps::CReplicationPrimary(journalPath, snapshotPath));
+        if (!primary->listen(port))
+        {
+            std::fprintf(stderr, "%s\n", primary->getErrorString().toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    else
+    {
+        standby.reset(new LLRPLaps::CReplicationStandby(lapCounter, journalPath, snapshotPath));
+        QObject::connect(standby.get(), &LLRPLaps::CReplicationStandby::synced, []()
+        { std::printf("synced with the primary\n"); });
+        QObject::connect(standby.get(), &LLRPLaps::CReplicationStandby::primaryLost, [&]()
+        {
+            if (!standby->takeOver(journal))
+            {
+                std::fprintf(stderr, "%s\n", standby->getErrorString().toLocal8Bit().constData());
+                app.exit(1);
+                return;
+            }
+            std::printf("primary lost, took over after %llu replicated reads\n",
+                        static_cast<unsigned long long>(standby->getAppliedCount()));
+            becomePrimary();
+        });
+        standby->connectToPrimary(parser.value("standby"), port);
+    }
+
+    QTimer status;
+    QObject::connect(&status, &QTimer::timeout, [&]()
+    {
+        std::printf("%llu laps this run, %zu riders\n", static_cast<unsigned long long>(laps), lapCounter.getRiderCount());
+        std::fflush(stdout);
+    });
+    status.start(1000);
+
+    return app.exec();
+}
@@ -0,0 +1,85 @@
+//********************************************************************
+//    created:    2026-10-19 02:50 AM
+//    file:       riderapi.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Rider history over HTTP from a lap database, next to the timing
+ * process writing it:
+ *
+ *      laps_riderapi --port 8085 laps.sqlite
+ *      curl http://localhost:8085/leaderboards/week
+ *
+ * See CRiderApi for the endpoints.
+ */
+
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTimer>
+
+#include "clapaggregates.h"
+#include "clapdatabase.h"
+#include "criderapi.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Serve rider history and leaderboards over HTTP");
+    parser.addHelpOption();
+    parser.addPositionalArgument("database", "Lap database written by CLapDatabase.");
+    parser.addOption({"port", "HTTP port.", "port", QString::number(LLRPLaps::CRiderApi::DEFAULT_PORT)});
+    parser.process(app);
+
+    if (1 != parser.positionalArguments().size())
+    {
+        parser.showHelp(1);
+    }
+
+    LLRPLaps::CLapDatabase database;
+    if (!database.open(parser.positionalArguments().first()))
+    {
+        std::fprintf(stderr, "%s\n", database.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    LLRPLaps::CLapAggregates aggregates(database);
+    if (!aggregates.load())
+    {
+        std::fprintf(stderr, "%s\n", aggregates.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    LLRPLaps::CRiderApi api(aggregates);
+    if (!api.listen(static_cast<quint16>(parser.value("port").toUInt())))
+    {
+        std::fprintf(stderr, "%s\n", api.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    /* The timing process writes the database, nothing here signals its commits */
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &api, &LLRPLaps::CRiderApi::onCommitted);
+    poll.start(LLRPLaps::CRiderApi::UPDATE_INTERVAL_MS);
+
+    std::printf("%zu riders, serving on port %s\n", aggregates.getRiders().size(),
+                parser.value("port").toLocal8Bit().constData());
+    std::fflush(stdout);
+    return app.exec();
+}
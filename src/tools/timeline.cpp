@@ -0,0 +1,166 @@
+//********************************************************************
+//    created:    2026-10-19 04:10 AM
+//    file:       timeline.cpp
+//  (C) Copyright 2017 Forestcity Velodrome
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//*********************************************************************
+
+/*
+ * Per chip read timelines (CReadTimeline) for analysis after the race:
+ *
+ *      laps_timeline --journal tags.jrn season.lapstml
+ *      laps_timeline season.lapstml
+ *      laps_timeline --epc e28011052000000000000007 --from 2026-05-01T18:30:00 season.lapstml
+ *
+ * --journal appends every read of a tag journal to the timeline; the
+ * journal has no RSSI, those reads get 0. With --epc the reads of one
+ * chip are printed as CSV, otherwise how much the timeline holds and
+ * what it costs a read.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#include <QByteArray>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+
+#include "creadtimeline.h"
+#include "creadtimelinereader.h"
+#include "ctaginfo.h"
+#include "ctagjournal.h"
+#include "ctagjournalreader.h"
+
+namespace
+{
+    // A date or a date and time, UTC, to reader timebase microseconds
+    bool parseTime(const QString &text, u_int64_t &timeUSec)
+    {
+        QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+        if (!time.isValid())
+        {
+            return false;
+        }
+        if (Qt::LocalTime == time.timeSpec())
+        {
+            time.setTimeSpec(Qt::UTC);
+        }
+        timeUSec = static_cast<u_int64_t>(time.toMSecsSinceEpoch()) * 1000ULL;
+        return true;
+    }
+
+
+    int appendJournal(const QString &journalPath, const QString &timelinePath)
+    {
+        LLRPLaps::CTagJournalReader journal;
+        if (!journal.open(journalPath))
+        {
+            std::fprintf(stderr, "%s\n", journal.getErrorString().toLocal8Bit().constData());
+            return 1;
+        }
+
+        LLRPLaps::CReadTimeline timeline;
+        if (!timeline.open(timelinePath.toStdString()))
+        {
+            std::fprintf(stderr, "Cannot open %s as a read timeline\n", timelinePath.toLocal8Bit().constData());
+            return 1;
+        }
+
+        LLRPLaps::CTagInfo tagInfo;
+        std::uint64_t offset = LLRPLaps::CTagJournal::HEADER_SIZE;
+        while (journal.next(offset, tagInfo))
+        {
+            timeline.append(tagInfo);
+        }
+        timeline.close();
+
+        std::printf("%llu reads, %llu blocks\n", static_cast<unsigned long long>(timeline.getReadCount()),
+                    static_cast<unsigned long long>(timeline.getBlockCount()));
+        return 0;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Build and query per chip read timelines");
+    parser.addHelpOption();
+    parser.addPositionalArgument("timeline", "Read timeline written by CReadTimeline.");
+    parser.addOption({"journal", "Append the reads of this tag journal.", "path"});
+    parser.addOption({"epc", "Print the reads of this chip, hex.", "epc"});
+    parser.addOption({"from", "First read time, UTC, e.g. 2026-05-01.", "time"});
+    parser.addOption({"to", "Reads before this time, UTC.", "time"});
+    parser.process(app);
+
+    if (1 != parser.positionalArguments().size())
+    {
+        parser.showHelp(1);
+    }
+    QString path = parser.positionalArguments().first();
+
+    if (parser.isSet("journal"))
+    {
+        return appendJournal(parser.value("journal"), path);
+    }
+
+    LLRPLaps::CReadTimelineReader timeline;
+    if (!timeline.open(path))
+    {
+        std::fprintf(stderr, "%s\n", timeline.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    if (!parser.isSet("epc"))
+    {
+        std::uint64_t reads = 0;
+        std::vector<std::vector<unsigned char>> epcs = timeline.getEpcs();
+        for (const auto &epc : epcs)
+        {
+            reads += timeline.getReadCount(epc);
+        }
+        std::printf("%zu chips, %llu reads in %llu blocks, %.2f bytes a read\n", epcs.size(),
+                    static_cast<unsigned long long>(reads), static_cast<unsigned long long>(timeline.getBlockCount()),
+                    reads ? static_cast<double>(timeline.getSize()) / reads : 0.0);
+        return 0;
+    }
+
+    u_int64_t fromUSec = 0;
+    u_int64_t toUSec = UINT64_MAX;
+    if ((parser.isSet("from") && !parseTime(parser.value("from"), fromUSec)) ||
+        (parser.isSet("to") && !parseTime(parser.value("to"), toUSec)))
+    {
+        std::fprintf(stderr, "Times are ISO 8601, e.g. 2026-05-01 or 2026-05-01T18:30:00\n");
+        return 1;
+    }
+
+    QByteArray epc = QByteArray::fromHex(parser.value("epc").toLatin1());
+    std::vector<LLRPLaps::CTimelineRead> reads;
+    if (!timeline.read(std::vector<unsigned char>(epc.begin(), epc.end()), fromUSec, toUSec, reads))
+    {
+        std::fprintf(stderr, "%s\n", timeline.getErrorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    std::printf("time_usec,antenna,peak_rssi\n");
+    for (const LLRPLaps::CTimelineRead &read : reads)
+    {
+        std::printf("%llu,%d,%d\n", static_cast<unsigned long long>(read.timeStampUSec), read.antennaId,
+                    read.peakRSSI);
+    }
+    return 0;
+}